@@ -15,8 +15,13 @@
 #ifndef PLANSYS2_BT_ACTIONS__BTACTIONNODE_HPP_
 #define PLANSYS2_BT_ACTIONS__BTACTIONNODE_HPP_
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
 
 #include "behaviortree_cpp/action_node.h"
 #include "rclcpp/rclcpp.hpp"
@@ -28,6 +33,15 @@ namespace plansys2
 
 using namespace std::chrono_literals;  // NOLINT
 
+// Action clients of the BtActionNodes sharing a blackboard, by action type and server name
+struct ActionClientCache
+{
+  using Ptr = std::shared_ptr<ActionClientCache>;
+
+  std::mutex mutex;
+  std::map<std::pair<std::type_index, std::string>, std::shared_ptr<void>> clients;
+};
+
 template<class ActionT>
 class BtActionNode : public BT::ActionNodeBase
 {
@@ -64,26 +78,35 @@ public:
   {
   }
 
-  // Create instance of an action server
+  // Get the action client for this node and server name. Clients are created once and
+  // shared by every BtActionNode using the same blackboard, so the server discovery done
+  // by a client is not repeated each time a tree is created or a leaf is activated.
   bool createActionClient(const std::string & action_name)
   {
-    // Now that we have the ROS node to use, create the action client for this BT action
-    action_client_ = rclcpp_action::create_client<ActionT>(node_, action_name);
+    action_client_ = getCachedActionClient(config().blackboard, node_, action_name);
+    return action_client_ != nullptr;
+  }
 
-    // Make sure the server is actually there before continuing
-    RCLCPP_INFO(node_->get_logger(), "Waiting for \"%s\" action server", action_name.c_str());
+  static typename std::shared_ptr<rclcpp_action::Client<ActionT>> getCachedActionClient(
+    BT::Blackboard::Ptr blackboard,
+    rclcpp_lifecycle::LifecycleNode::SharedPtr node,
+    const std::string & action_name)
+  {
+    // The cache is set in the blackboard when it is created, by the node running the trees
+    ActionClientCache::Ptr cache;
+    if (!blackboard->get("action_client_cache", cache) || cache == nullptr) {
+      RCLCPP_ERROR(node->get_logger(), "Failed to get 'action_client_cache' from the blackboard");
+      return nullptr;
+    }
 
-    bool success_waiting = action_client_->wait_for_action_server(server_timeout_);
+    std::lock_guard<std::mutex> lock(cache->mutex);
 
-    if (!success_waiting) {
-      RCLCPP_ERROR(
-        node_->get_logger(),
-        "Timeout (%ld secs) waiting for \"%s\" action server",
-        server_timeout_.count() * 1000,
-        action_name.c_str());
+    auto & client = cache->clients[{std::type_index(typeid(ActionT)), action_name}];
+    if (client == nullptr) {
+      client = rclcpp_action::create_client<ActionT>(node, action_name);
     }
 
-    return success_waiting;
+    return std::static_pointer_cast<rclcpp_action::Client<ActionT>>(client);
   }
 
   // Any subclass of BtActionNode that accepts parameters must provide a providedPorts method
@@ -170,15 +193,34 @@ public:
             return BT::NodeStatus::FAILURE;
           }
 
-          // User defined tick
-          auto user_status = on_tick();
-          if (user_status != BT::NodeStatus::RUNNING) {
-            return user_status;
+          if (!action_client_->action_server_is_ready()) {
+            RCLCPP_INFO(
+              node_->get_logger(), "Waiting for \"%s\" action server", action_name_.c_str());
+            server_wait_ts_ = node_->now();
+            state_ = WAITING_SERVER;
+            return BT::NodeStatus::RUNNING;
           }
 
-          on_new_goal_received();
+          return start_goal();
+        }
+        break;
+
+      case WAITING_SERVER:
+        {
+          RCLCPP_DEBUG(node_->get_logger(), "%s WAITING_SERVER", node_->get_name());
+          if (action_client_->action_server_is_ready()) {
+            return start_goal();
+          }
 
-          state_ = GOAL_SENT;
+          if ((node_->now() - server_wait_ts_) > server_timeout_) {
+            RCLCPP_ERROR(
+              node_->get_logger(),
+              "Timeout (%ld secs) waiting for \"%s\" action server",
+              server_timeout_.count() / 1000,
+              action_name_.c_str());
+            state_ = IDLE;
+            return BT::NodeStatus::FAILURE;
+          }
 
           return BT::NodeStatus::RUNNING;
         }
@@ -314,6 +356,22 @@ public:
   }
 
 protected:
+  BT::NodeStatus start_goal()
+  {
+    // User defined tick
+    auto user_status = on_tick();
+    if (user_status != BT::NodeStatus::RUNNING) {
+      state_ = IDLE;
+      return user_status;
+    }
+
+    on_new_goal_received();
+
+    state_ = GOAL_SENT;
+
+    return BT::NodeStatus::RUNNING;
+  }
+
   void cancel_goal()
   {
     future_cancer_handle_ = action_client_->async_cancel_goal(goal_handle_);
@@ -322,7 +380,7 @@ protected:
   bool should_cancel_goal()
   {
     // Shut the node down if it is currently running
-    if (status() != BT::NodeStatus::RUNNING) {
+    if (status() != BT::NodeStatus::RUNNING || goal_handle_ == nullptr) {
       return false;
     }
 
@@ -383,6 +441,7 @@ protected:
   std::shared_future<typename ActionT::Impl::CancelGoalService::Response::SharedPtr>
   future_cancer_handle_;
   rclcpp::Time goal_sent_ts_;
+  rclcpp::Time server_wait_ts_;
   typename rclcpp_action::ClientGoalHandle<ActionT>::SharedPtr goal_handle_;
   typename rclcpp_action::ClientGoalHandle<ActionT>::WrappedResult result_;
 
@@ -400,6 +459,7 @@ protected:
   static const int GOAL_CANCELLING = 4;
   static const int GOAL_FINISHED = 5;
   static const int GOAL_FAILURE = 6;
+  static const int WAITING_SERVER = 7;
 
   int state_ {IDLE};
 };
@@ -24,6 +24,7 @@
 
 #include "behaviortree_cpp/utils/shared_library.h"
 #include "plansys2_bt_actions/BTAction.hpp"
+#include "plansys2_bt_actions/BTActionNode.hpp"
 
 namespace plansys2
 {
@@ -62,6 +63,7 @@ BTAction::on_configure(const rclcpp_lifecycle::State & previous_state)
 
   blackboard_ = BT::Blackboard::create();
   blackboard_->set("node", shared_from_this());
+  blackboard_->set("action_client_cache", std::make_shared<ActionClientCache>());
 
   return ActionExecutorClient::on_configure(previous_state);
 }
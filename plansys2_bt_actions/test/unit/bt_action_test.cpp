@@ -135,6 +135,7 @@ TEST(bt_actions, load_plugins)
 
   auto blackboard = BT::Blackboard::create();
   blackboard->set("node", node);
+  blackboard->set("action_client_cache", std::make_shared<plansys2::ActionClientCache>());
   BT::Tree tree = factory.createTreeFromFile(xml_file, blackboard);
 
   rclcpp::Rate rate(10);
@@ -168,6 +169,7 @@ TEST(bt_actions, on_tick_failure)
   BT::assignDefaultRemapping<plansys2_bt_tests::OnTickFail>(config);
   auto bb = BT::Blackboard::create();
   bb->set("node", node);
+  bb->set("action_client_cache", std::make_shared<plansys2::ActionClientCache>());
   config.blackboard = bb;
 
   plansys2_bt_tests::OnTickFail failure_node("OnTickFail", "move", config);
@@ -205,6 +207,7 @@ TEST(bt_actions, on_feedback_failure)
   BT::assignDefaultRemapping<plansys2_bt_tests::OnFeedbackFail>(config);
   auto bb = BT::Blackboard::create();
   bb->set("node", node);
+  bb->set("action_client_cache", std::make_shared<plansys2::ActionClientCache>());
   config.blackboard = bb;
 
   plansys2_bt_tests::OnFeedbackFail failure_node("OnFeedbackFail",
@@ -226,6 +229,97 @@ TEST(bt_actions, on_feedback_failure)
   t.join();
 }
 
+// Exposes the action client, to check that it is shared
+class LateMove : public plansys2::BtActionNode<test_msgs::action::Fibonacci>
+{
+public:
+  LateMove(const std::string & xml_tag_name, const BT::NodeConfig & conf)
+  : plansys2::BtActionNode<test_msgs::action::Fibonacci>(xml_tag_name, "move", conf) {}
+
+  BT::NodeStatus on_tick() override
+  {
+    goal_.order = 10;
+    return BT::NodeStatus::RUNNING;
+  }
+
+  std::shared_ptr<rclcpp_action::Client<test_msgs::action::Fibonacci>> get_action_client()
+  {
+    return action_client_;
+  }
+};
+
+TEST(bt_actions, late_server)
+{
+  auto node = rclcpp_lifecycle::LifecycleNode::make_shared("test_node");
+  auto move_server_node = std::make_shared<MoveServer>();
+
+  bool finished = false;
+  std::thread t([&]() {
+      while (!finished) {
+        rclcpp::spin_some(move_server_node);
+        rclcpp::spin_some(node->get_node_base_interface());
+      }
+    });
+
+  BT::NodeConfig config;
+  BT::assignDefaultRemapping<LateMove>(config);
+  auto bb = BT::Blackboard::create();
+  bb->set("node", node);
+  bb->set("action_client_cache", std::make_shared<plansys2::ActionClientCache>());
+  config.blackboard = bb;
+
+  LateMove move_node("LateMove", config);
+
+  // Without the server, the tick does not wait for it
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(move_node.executeTick(), BT::NodeStatus::RUNNING);
+  ASSERT_LT(std::chrono::steady_clock::now() - start, 1s);
+  ASSERT_NE(move_node.get_action_client(), nullptr);
+
+  rclcpp::Rate rate(10);
+  for (int i = 0; i < 5; i++) {
+    start = std::chrono::steady_clock::now();
+    ASSERT_EQ(move_node.executeTick(), BT::NodeStatus::RUNNING);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, 1s);
+    rate.sleep();
+  }
+
+  move_server_node->start_server();
+
+  BT::NodeStatus status = BT::NodeStatus::RUNNING;
+  start = std::chrono::steady_clock::now();
+  while (rclcpp::ok() && status == BT::NodeStatus::RUNNING &&
+    std::chrono::steady_clock::now() - start < 15s)
+  {
+    status = move_node.executeTick();
+    rate.sleep();
+  }
+  ASSERT_EQ(status, BT::NodeStatus::SUCCESS);
+
+  // The nodes sharing the blackboard share the client, other nodes have their own
+  LateMove other_move_node("LateMove", config);
+  ASSERT_TRUE(other_move_node.createActionClient("move"));
+  ASSERT_EQ(other_move_node.get_action_client(), move_node.get_action_client());
+
+  auto other_node = rclcpp_lifecycle::LifecycleNode::make_shared("other_test_node");
+  BT::NodeConfig other_config = config;
+  other_config.blackboard = BT::Blackboard::create();
+  other_config.blackboard->set("node", other_node);
+
+  // Without a cache in the blackboard, no client is created
+  LateMove move_node_without_cache("LateMove", other_config);
+  ASSERT_FALSE(move_node_without_cache.createActionClient("move"));
+
+  other_config.blackboard->set(
+    "action_client_cache", std::make_shared<plansys2::ActionClientCache>());
+  LateMove move_node_of_other("LateMove", other_config);
+  ASSERT_TRUE(move_node_of_other.createActionClient("move"));
+  ASSERT_NE(move_node_of_other.get_action_client(), move_node.get_action_client());
+
+  finished = true;
+  t.join();
+}
+
 TEST(bt_actions, bt_action)
 {
   std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_bt_actions");
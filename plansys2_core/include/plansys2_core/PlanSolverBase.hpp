@@ -57,6 +57,25 @@ public:
     const std::string & node_namespace = "",
     const rclcpp::Duration solver_timeout = 15s) = 0;
 
+  /**
+   * @brief Returns a plan given a PDDL domain and problem definition, and a plan for a
+   *        similar problem, as the previous plan when replanning, to seed the search.
+   *        Solvers that can not use the hint ignore it.
+   * @param domain The PDDL domain as a string.
+   * @param problem The PDDL problem definition as a string.
+   * @param hint A plan for a similar problem, not necessarily valid for this one.
+   * @param node_namespace The node namespace.
+   * @return An optional containing the resulting plan, if one was found.
+  */
+  virtual std::optional<plansys2_msgs::msg::Plan> getPlanWithHint(
+    const std::string & domain, const std::string & problem,
+    const plansys2_msgs::msg::Plan & hint,
+    const std::string & node_namespace = "",
+    const rclcpp::Duration solver_timeout = 15s)
+  {
+    return getPlan(domain, problem, node_namespace, solver_timeout);
+  }
+
   /**
    * @brief Exposes a capability to validate a PDDL domain.
    * @param domain The PDDL domain as a string.
@@ -0,0 +1,363 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef PLANSYS2_CORE__SERVICEMULTIPLEXER_HPP_
+#define PLANSYS2_CORE__SERVICEMULTIPLEXER_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "plansys2_msgs/srv/expert_call.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+
+namespace plansys2
+{
+
+template<class MsgT>
+void serialize_message(const MsgT & msg, std::vector<uint8_t> & data)
+{
+  rclcpp::SerializedMessage serialized;
+  rclcpp::Serialization<MsgT>().serialize_message(&msg, &serialized);
+
+  const auto & raw = serialized.get_rcl_serialized_message();
+  data.assign(raw.buffer, raw.buffer + raw.buffer_length);
+}
+
+template<class MsgT>
+void deserialize_message(const std::vector<uint8_t> & data, MsgT & msg)
+{
+  rclcpp::SerializedMessage serialized(data.size());
+
+  auto & raw = serialized.get_rcl_serialized_message();
+  std::copy(data.begin(), data.end(), raw.buffer);
+  raw.buffer_length = data.size();
+
+  rclcpp::Serialization<MsgT>().deserialize_message(&serialized, &msg);
+}
+
+/// Server side of the multiplexed endpoint of an expert.
+/**
+ * The endpoint is the single service <prefix>/call. Each of its requests names one of the
+ * services of the expert, the operation, and carries its request serialized, which is
+ * dispatched to the callback of that service. The services may still be offered one by
+ * one, the legacy services, for the clients that do not know the endpoint.
+ *
+ * A request may also name a context of the expert, which is selected with the context
+ * selector while its operation runs. Only the endpoint knows the contexts; the legacy
+ * services always run in the default one.
+ */
+class ServiceMultiplexer
+{
+public:
+  /// Create the endpoint.
+  /**
+   * \param[in] node The node offering the services.
+   * \param[in] prefix The prefix of the names of the services, as "problem_expert".
+   * \param[in] legacy_services If the services are also offered one by one.
+   */
+  template<class NodeT>
+  ServiceMultiplexer(NodeT * node, const std::string & prefix, bool legacy_services)
+  : prefix_(prefix),
+    legacy_services_(legacy_services)
+  {
+    call_service_ = node->template create_service<plansys2_msgs::srv::ExpertCall>(
+      prefix_ + "/call",
+      [this](const std::shared_ptr<rmw_request_id_t> request_header,
+      const std::shared_ptr<plansys2_msgs::srv::ExpertCall::Request> request,
+      const std::shared_ptr<plansys2_msgs::srv::ExpertCall::Response> response) {
+        call(request_header, *request, *response);
+      });
+  }
+
+  /// Add a service of the expert.
+  /**
+   * \param[in] node The node offering the services.
+   * \param[in] operation The name of the service, relative to the prefix.
+   * \param[in] callback The callback of the service.
+   * \return The legacy service, or nullptr if they are not offered.
+   */
+  template<class ServiceT, class NodeT, class CallbackT>
+  typename rclcpp::Service<ServiceT>::SharedPtr
+  add(NodeT * node, const std::string & operation, CallbackT callback)
+  {
+    operations_[operation] =
+      [callback](const std::shared_ptr<rmw_request_id_t> request_header,
+        const std::vector<uint8_t> & serialized_request,
+        std::vector<uint8_t> & serialized_response) {
+        auto request = std::make_shared<typename ServiceT::Request>();
+        auto response = std::make_shared<typename ServiceT::Response>();
+
+        deserialize_message(serialized_request, *request);
+        callback(request_header, request, response);
+        serialize_message(*response, serialized_response);
+      };
+
+    if (!legacy_services_) {
+      return nullptr;
+    }
+
+    return node->template create_service<ServiceT>(prefix_ + "/" + operation, callback);
+  }
+
+  /// Set the selector of the contexts of the expert.
+  /**
+   * \param[in] selector Called with the context of a request before running its operation,
+   *            and with the empty context, the default one, after it. It returns false if
+   *            the context does not exist.
+   */
+  void set_context_selector(std::function<bool(const std::string &)> selector)
+  {
+    context_selector_ = selector;
+  }
+
+private:
+  void call(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const plansys2_msgs::srv::ExpertCall::Request & request,
+    plansys2_msgs::srv::ExpertCall::Response & response)
+  {
+    auto it = operations_.find(request.operation);
+    if (it == operations_.end()) {
+      response.success = false;
+      response.error_info = "Unknown operation " + request.operation;
+      return;
+    }
+
+    if (!request.context.empty() &&
+      (!context_selector_ || !context_selector_(request.context)))
+    {
+      response.success = false;
+      response.error_info = "Unknown context " + request.context;
+      return;
+    }
+
+    try {
+      it->second(request_header, request.request, response.response);
+      response.success = true;
+    } catch (const std::exception & e) {
+      response.success = false;
+      response.error_info = "Error in operation " + request.operation + ": " + e.what();
+    }
+
+    if (!request.context.empty()) {
+      context_selector_("");
+    }
+  }
+
+  std::string prefix_;
+  bool legacy_services_;
+
+  std::map<std::string, std::function<void(
+      const std::shared_ptr<rmw_request_id_t>,
+      const std::vector<uint8_t> &, std::vector<uint8_t> &)>> operations_;
+  std::function<bool(const std::string &)> context_selector_;
+  rclcpp::Service<plansys2_msgs::srv::ExpertCall>::SharedPtr call_service_;
+};
+
+template<class ServiceT>
+class MultiplexedClient;
+
+/// Client side of the multiplexed endpoint of an expert, shared by its MultiplexedClients.
+/**
+ * The endpoint is selected the first time a service is waited for, if it appears in a
+ * second. Otherwise, the expert only offers the legacy services, and each MultiplexedClient
+ * creates the client of its own service.
+ */
+class MultiplexedEndpoint : public std::enable_shared_from_this<MultiplexedEndpoint>
+{
+public:
+  enum Mode {UNKNOWN, MULTIPLEXED, LEGACY};
+
+  MultiplexedEndpoint(rclcpp::Node::SharedPtr node, const std::string & prefix)
+  : node_(node),
+    prefix_(prefix),
+    mode_(UNKNOWN)
+  {
+    call_client_ = node_->create_client<plansys2_msgs::srv::ExpertCall>(prefix_ + "/call");
+  }
+
+  template<class ServiceT>
+  std::shared_ptr<MultiplexedClient<ServiceT>>
+  create_client(const std::string & operation);
+
+  rclcpp::Node::SharedPtr get_node() const {return node_;}
+  const std::string & get_prefix() const {return prefix_;}
+  Mode get_mode() const {return mode_;}
+
+  /// Select the context of the expert in which the next requests run.
+  /**
+   * \param[in] context The context, or empty for the default one. Other contexts are only
+   *            reachable through the endpoint, not through the legacy services.
+   */
+  void set_context(const std::string & context) {context_ = context;}
+  const std::string & get_context() const {return context_;}
+
+  /// Wait for the endpoint, selecting it if its mode is unknown.
+  /**
+   * \param[in] timeout The time to wait if the endpoint is already selected.
+   * \return If the endpoint is selected and ready.
+   */
+  bool wait_for_endpoint(std::chrono::nanoseconds timeout)
+  {
+    if (mode_ == LEGACY) {
+      return false;
+    }
+
+    auto wait = mode_ == MULTIPLEXED ? timeout : std::chrono::seconds(1);
+    if (call_client_->wait_for_service(wait)) {
+      mode_ = MULTIPLEXED;
+      return true;
+    }
+
+    return false;
+  }
+
+  /// Select the legacy services, once one of them is ready and the endpoint is not.
+  void select_legacy()
+  {
+    if (mode_ == UNKNOWN) {
+      mode_ = LEGACY;
+    }
+  }
+
+  rclcpp::Client<plansys2_msgs::srv::ExpertCall>::SharedPtr get_call_client() const
+  {
+    return call_client_;
+  }
+
+private:
+  rclcpp::Node::SharedPtr node_;
+  std::string prefix_;
+  std::string context_;
+  Mode mode_;
+  rclcpp::Client<plansys2_msgs::srv::ExpertCall>::SharedPtr call_client_;
+};
+
+/// Client of a service of an expert, through its multiplexed endpoint if it has one.
+/**
+ * It offers the part of the interface of rclcpp::Client used by the expert clients, so
+ * they use it in the same way.
+ */
+template<class ServiceT>
+class MultiplexedClient
+{
+public:
+  using SharedResponse = typename ServiceT::Response::SharedPtr;
+  using SharedFuture = std::shared_future<SharedResponse>;
+
+  MultiplexedClient(
+    std::shared_ptr<MultiplexedEndpoint> endpoint, const std::string & operation)
+  : endpoint_(endpoint),
+    operation_(operation),
+    service_name_(endpoint->get_prefix() + "/" + operation)
+  {
+  }
+
+  bool wait_for_service(std::chrono::nanoseconds timeout)
+  {
+    if (endpoint_->wait_for_endpoint(timeout)) {
+      return true;
+    }
+    if (endpoint_->get_mode() == MultiplexedEndpoint::MULTIPLEXED) {
+      return false;
+    }
+
+    if (client_ == nullptr) {
+      client_ = endpoint_->get_node()->template create_client<ServiceT>(service_name_);
+    }
+
+    if (client_->wait_for_service(timeout)) {
+      endpoint_->select_legacy();
+      return endpoint_->get_mode() == MultiplexedEndpoint::LEGACY;
+    }
+
+    return false;
+  }
+
+  SharedFuture async_send_request(typename ServiceT::Request::SharedPtr request)
+  {
+    if (endpoint_->get_mode() != MultiplexedEndpoint::MULTIPLEXED) {
+      if (!endpoint_->get_context().empty()) {
+        RCLCPP_ERROR_STREAM(
+          endpoint_->get_node()->get_logger(),
+          operation_ << ": context " << endpoint_->get_context() <<
+            " requires the multiplexed endpoint");
+        std::promise<SharedResponse> promise;
+        promise.set_value(std::make_shared<typename ServiceT::Response>());
+        return promise.get_future().share();
+      }
+      return client_->async_send_request(request).future.share();
+    }
+
+    auto call = std::make_shared<plansys2_msgs::srv::ExpertCall::Request>();
+    call->operation = operation_;
+    call->context = endpoint_->get_context();
+    serialize_message(*request, call->request);
+
+    auto promise = std::make_shared<std::promise<SharedResponse>>();
+    auto logger = endpoint_->get_node()->get_logger();
+
+    endpoint_->get_call_client()->async_send_request(
+      call,
+      [promise, logger, operation = operation_](
+        rclcpp::Client<plansys2_msgs::srv::ExpertCall>::SharedFuture future) {
+        auto result = future.get();
+        auto response = std::make_shared<typename ServiceT::Response>();
+
+        if (!result->success) {
+          RCLCPP_ERROR_STREAM(logger, operation << ": " << result->error_info);
+        } else {
+          try {
+            deserialize_message(result->response, *response);
+          } catch (const std::exception & e) {
+            RCLCPP_ERROR_STREAM(logger, operation << ": " << e.what());
+            response = std::make_shared<typename ServiceT::Response>();
+          }
+        }
+        promise->set_value(response);
+      });
+
+    return promise->get_future().share();
+  }
+
+  const char * get_service_name() const {return service_name_.c_str();}
+
+private:
+  std::shared_ptr<MultiplexedEndpoint> endpoint_;
+  std::string operation_;
+  std::string service_name_;
+  typename rclcpp::Client<ServiceT>::SharedPtr client_;
+};
+
+template<class ServiceT>
+std::shared_ptr<MultiplexedClient<ServiceT>>
+MultiplexedEndpoint::create_client(const std::string & operation)
+{
+  return std::make_shared<MultiplexedClient<ServiceT>>(shared_from_this(), operation);
+}
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_CORE__SERVICEMULTIPLEXER_HPP_
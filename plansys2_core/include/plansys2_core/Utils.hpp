@@ -16,6 +16,7 @@
 #define PLANSYS2_CORE__UTILS_HPP_
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace plansys2
@@ -32,7 +33,7 @@ std::vector<std::string> tokenize(const std::string & string, const std::string
  * @return a substring without empty lines
  */
 std::string substr_without_empty_lines(
-  std::string string,
+  std::string_view string,
   std::size_t init_pos,
   std::size_t end_pos);
 
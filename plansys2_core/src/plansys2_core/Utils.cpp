@@ -14,6 +14,7 @@
 
 #include <string>
 #include <sstream>
+#include <string_view>
 #include <vector>
 
 #include "plansys2_core/Utils.hpp"
@@ -41,11 +42,11 @@ std::vector<std::string> tokenize(const std::string & string, const std::string
 }
 
 std::string substr_without_empty_lines(
-  std::string string,
+  std::string_view string,
   std::size_t init_pos,
   std::size_t end_pos)
 {
-  std::stringstream stream_in(string.substr(init_pos, end_pos - init_pos));
+  std::stringstream stream_in(std::string(string.substr(init_pos, end_pos - init_pos)));
   std::stringstream stream_out;
   std::string line;
   bool first = true;
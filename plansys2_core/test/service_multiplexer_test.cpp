@@ -0,0 +1,257 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "plansys2_core/ServiceMultiplexer.hpp"
+#include "plansys2_msgs/srv/add_problem.hpp"
+#include "plansys2_msgs/srv/expert_call.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+#include "rcutils/logging.h"
+
+using namespace std::chrono_literals;
+
+using AddProblem = plansys2_msgs::srv::AddProblem;
+
+// Answers with the problem it receives, so the tests know the request got through
+void add_problem_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<AddProblem::Request> request,
+  const std::shared_ptr<AddProblem::Response> response)
+{
+  response->success = true;
+  response->error_info = request->problem;
+}
+
+std::vector<std::string> error_logs;
+
+void capture_error_logs(
+  const rcutils_log_location_t * location, int severity, const char * name,
+  rcutils_time_point_value_t timestamp, const char * format, va_list * args)
+{
+  if (severity == RCUTILS_LOG_SEVERITY_ERROR) {
+    char message[1024];
+    va_list args_copy;
+    va_copy(args_copy, *args);
+    vsnprintf(message, sizeof(message), format, args_copy);
+    va_end(args_copy);
+    error_logs.push_back(message);
+  }
+}
+
+AddProblem::Response::SharedPtr add_problem(
+  plansys2::MultiplexedClient<AddProblem> & client, const std::string & problem)
+{
+  auto request = std::make_shared<AddProblem::Request>();
+  request->problem = problem;
+
+  auto future = client.async_send_request(request);
+  if (future.wait_for(5s) != std::future_status::ready) {
+    return nullptr;
+  }
+  return future.get();
+}
+
+TEST(service_multiplexer, multiplexed)
+{
+  auto server_node = rclcpp::Node::make_shared("server_node");
+  auto client_node = rclcpp::Node::make_shared("client_node");
+
+  plansys2::ServiceMultiplexer multiplexer(server_node.get(), "expert_multiplexed", true);
+  auto legacy_service = multiplexer.add<AddProblem>(
+    server_node.get(), "add_problem", add_problem_callback);
+  ASSERT_NE(legacy_service, nullptr);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(server_node);
+  exe.add_node(client_node);
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  auto endpoint = std::make_shared<plansys2::MultiplexedEndpoint>(
+    client_node, "expert_multiplexed");
+  auto client = endpoint->create_client<AddProblem>("add_problem");
+  ASSERT_STREQ(client->get_service_name(), "expert_multiplexed/add_problem");
+
+  ASSERT_TRUE(client->wait_for_service(1s));
+  ASSERT_EQ(endpoint->get_mode(), plansys2::MultiplexedEndpoint::MULTIPLEXED);
+
+  auto response = add_problem(*client, "(problem)");
+  ASSERT_NE(response, nullptr);
+  ASSERT_TRUE(response->success);
+  ASSERT_EQ(response->error_info, "(problem)");
+
+  // Without a context selector, only the default context exists
+  endpoint->set_context("other");
+  response = add_problem(*client, "(problem)");
+  ASSERT_NE(response, nullptr);
+  ASSERT_FALSE(response->success);
+
+  finish = true;
+  t.join();
+}
+
+TEST(service_multiplexer, legacy_fallback)
+{
+  auto server_node = rclcpp::Node::make_shared("server_node");
+  auto client_node = rclcpp::Node::make_shared("client_node");
+
+  // An expert without the endpoint, offering only its services one by one
+  auto service = server_node->create_service<AddProblem>(
+    "expert_legacy/add_problem", add_problem_callback);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(server_node);
+  exe.add_node(client_node);
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  auto endpoint = std::make_shared<plansys2::MultiplexedEndpoint>(client_node, "expert_legacy");
+  auto client = endpoint->create_client<AddProblem>("add_problem");
+
+  ASSERT_TRUE(client->wait_for_service(1s));
+  ASSERT_EQ(endpoint->get_mode(), plansys2::MultiplexedEndpoint::LEGACY);
+
+  auto response = add_problem(*client, "(problem)");
+  ASSERT_NE(response, nullptr);
+  ASSERT_TRUE(response->success);
+  ASSERT_EQ(response->error_info, "(problem)");
+
+  // Contexts need the endpoint: the request is not sent and the response is the default one
+  auto output_handler = rcutils_logging_get_output_handler();
+  rcutils_logging_set_output_handler(capture_error_logs);
+  error_logs.clear();
+
+  endpoint->set_context("other");
+  response = add_problem(*client, "(problem)");
+  rcutils_logging_set_output_handler(output_handler);
+
+  ASSERT_NE(response, nullptr);
+  ASSERT_FALSE(response->success);
+  ASSERT_EQ(response->error_info, "");
+  ASSERT_EQ(error_logs.size(), 1u);
+  ASSERT_EQ(error_logs[0], "add_problem: context other requires the multiplexed endpoint");
+
+  endpoint->set_context("");
+  response = add_problem(*client, "(problem)");
+  ASSERT_NE(response, nullptr);
+  ASSERT_TRUE(response->success);
+
+  finish = true;
+  t.join();
+}
+
+TEST(service_multiplexer, no_legacy_services)
+{
+  auto server_node = rclcpp::Node::make_shared("server_node");
+  auto client_node = rclcpp::Node::make_shared("client_node");
+
+  plansys2::ServiceMultiplexer multiplexer(server_node.get(), "expert_no_legacy", false);
+  auto legacy_service = multiplexer.add<AddProblem>(
+    server_node.get(), "add_problem", add_problem_callback);
+  ASSERT_EQ(legacy_service, nullptr);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(server_node);
+  exe.add_node(client_node);
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  auto legacy_client = client_node->create_client<AddProblem>("expert_no_legacy/add_problem");
+  ASSERT_FALSE(legacy_client->wait_for_service(500ms));
+
+  auto endpoint = std::make_shared<plansys2::MultiplexedEndpoint>(
+    client_node, "expert_no_legacy");
+  auto client = endpoint->create_client<AddProblem>("add_problem");
+
+  ASSERT_TRUE(client->wait_for_service(1s));
+  ASSERT_EQ(endpoint->get_mode(), plansys2::MultiplexedEndpoint::MULTIPLEXED);
+
+  auto response = add_problem(*client, "(problem)");
+  ASSERT_NE(response, nullptr);
+  ASSERT_TRUE(response->success);
+  ASSERT_EQ(response->error_info, "(problem)");
+
+  finish = true;
+  t.join();
+}
+
+TEST(service_multiplexer, unknown_operation)
+{
+  auto server_node = rclcpp::Node::make_shared("server_node");
+  auto client_node = rclcpp::Node::make_shared("client_node");
+
+  plansys2::ServiceMultiplexer multiplexer(server_node.get(), "expert_unknown", false);
+  multiplexer.add<AddProblem>(server_node.get(), "add_problem", add_problem_callback);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(server_node);
+  exe.add_node(client_node);
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  auto call_client = client_node->create_client<plansys2_msgs::srv::ExpertCall>(
+    "expert_unknown/call");
+  ASSERT_TRUE(call_client->wait_for_service(1s));
+
+  auto call = std::make_shared<plansys2_msgs::srv::ExpertCall::Request>();
+  call->operation = "remove_problem";
+  auto future = call_client->async_send_request(call).future;
+  ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+  auto result = future.get();
+  ASSERT_FALSE(result->success);
+  ASSERT_EQ(result->error_info, "Unknown operation remove_problem");
+
+  // Through a client, the error gives the default response
+  auto endpoint = std::make_shared<plansys2::MultiplexedEndpoint>(client_node, "expert_unknown");
+  auto client = endpoint->create_client<AddProblem>("remove_problem");
+  ASSERT_TRUE(client->wait_for_service(1s));
+
+  auto response = add_problem(*client, "(problem)");
+  ASSERT_NE(response, nullptr);
+  ASSERT_FALSE(response->success);
+  ASSERT_EQ(response->error_info, "");
+
+  finish = true;
+  t.join();
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  rclcpp::init(argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -16,6 +16,7 @@
 #define PLANSYS2_DOMAIN_EXPERT__DOMAINEXPERT_HPP_
 
 #include <optional>
+#include <set>
 #include <string>
 #include <vector>
 #include <memory>
@@ -144,6 +145,32 @@ public:
     const std::string & action,
     const std::vector<std::string> & params = {});
 
+  /// Get the static predicates of the domain, those not changed by any action.
+  /**
+   * \return The vector containing the static predicates.
+   */
+  std::vector<plansys2::Predicate> getStaticPredicates();
+
+  /// Get the static functions of the domain, those not changed by any action.
+  /**
+   * \return The vector containing the static functions.
+   */
+  std::vector<plansys2::Function> getStaticFunctions();
+
+  /// Determine if a predicate is static, not changed by any action.
+  /**
+   * \param[in] predicate The name of the predicate.
+   * \return true if the predicate exists and is static.
+   */
+  bool isStaticPredicate(const std::string & predicate);
+
+  /// Determine if a function is static, not changed by any action.
+  /**
+   * \param[in] function The name of the function.
+   * \return true if the function exists and is static.
+   */
+  bool isStaticFunction(const std::string & function);
+
   /// Get the current domain, ready to be saved to file, or to initialize another domain.
   /**
    * \return A string containing the domain.
@@ -158,8 +185,12 @@ public:
   bool existDomain(const std::string & domain_name);
 
 private:
+  void findStaticSymbols();
+
   std::shared_ptr<parser::pddl::Domain> domain_;
   DomainReader domains_;
+  std::set<std::string> static_predicates_;
+  std::set<std::string> static_functions_;
 };
 
 }  // namespace plansys2
@@ -20,6 +20,7 @@
 #include <vector>
 #include <memory>
 
+#include "plansys2_core/ServiceMultiplexer.hpp"
 #include "plansys2_core/Types.hpp"
 #include "plansys2_domain_expert/DomainExpertInterface.hpp"
 
@@ -153,6 +154,18 @@ public:
     const std::string & action,
     const std::vector<std::string> & params = {});
 
+  /// Get the static predicates of the domain, those not changed by any action.
+  /**
+   * \return The vector containing the static predicates.
+   */
+  std::vector<plansys2::Predicate> getStaticPredicates();
+
+  /// Get the static functions of the domain, those not changed by any action.
+  /**
+   * \return The vector containing the static functions.
+   */
+  std::vector<plansys2::Function> getStaticFunctions();
+
   /// Get the current domain, ready to be saved to file, or to initialize another domain.
   /**
    * \return A string containing the domain.
@@ -169,22 +182,29 @@ public:
 
 private:
   rclcpp::Node::SharedPtr node_;
-
-  rclcpp::Client<plansys2_msgs::srv::GetDomain>::SharedPtr get_domain_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainName>::SharedPtr get_name_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainTypes>::SharedPtr get_types_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainConstants>::SharedPtr get_constants_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetStates>::SharedPtr get_predicates_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetStates>::SharedPtr get_functions_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetStates>::SharedPtr get_derived_predicates_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainDerivedPredicateDetails>::SharedPtr
+  std::shared_ptr<MultiplexedEndpoint> endpoint_;
+
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomain>> get_domain_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainName>> get_name_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainTypes>> get_types_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainConstants>> get_constants_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetStates>> get_predicates_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetStates>> get_functions_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetStates>> get_derived_predicates_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetStates>> get_static_predicates_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetStates>> get_static_functions_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainDerivedPredicateDetails>>
     get_derived_predicate_details_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainActions>::SharedPtr get_actions_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainActions>::SharedPtr get_durative_actions_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetNodeDetails>::SharedPtr get_predicate_details_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetNodeDetails>::SharedPtr get_function_details_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainActionDetails>::SharedPtr get_action_details_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetDomainDurativeActionDetails>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainActions>> get_actions_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainActions>>
+    get_durative_actions_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetNodeDetails>>
+    get_predicate_details_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetNodeDetails>>
+    get_function_details_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainActionDetails>>
+    get_action_details_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetDomainDurativeActionDetails>>
     get_durative_action_details_client_;
   rclcpp::Subscription<std_msgs::msg::String>::SharedPtr domain_sub_;
 };
@@ -135,6 +135,21 @@ public:
     const std::string & durative_action, const std::vector<std::string> & params) =
   0;
 
+  /// Get the static predicates of the domain, those not changed by any action.
+  /**
+   * Static predicates keep the value set in the problem, so they do not need to be copied
+   * or compared between the states of a plan. Derived predicates are never static.
+   *
+   * \return The vector containing the static predicates.
+   */
+  virtual std::vector<plansys2::Predicate> getStaticPredicates() = 0;
+
+  /// Get the static functions of the domain, those not changed by any action.
+  /**
+   * \return The vector containing the static functions.
+   */
+  virtual std::vector<plansys2::Function> getStaticFunctions() = 0;
+
   /// Get the current domain, ready to be saved to file, or to initialize another domain.
   /**
    * \return A string containing the domain.
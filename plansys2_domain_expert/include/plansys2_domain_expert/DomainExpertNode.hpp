@@ -18,6 +18,7 @@
 #include <optional>
 #include <memory>
 
+#include "plansys2_core/ServiceMultiplexer.hpp"
 #include "plansys2_domain_expert/DomainExpert.hpp"
 #include "plansys2_popf_plan_solver/popf_plan_solver.hpp"
 
@@ -160,6 +161,28 @@ public:
     const std::shared_ptr<plansys2_msgs::srv::GetDomainDurativeActionDetails::Request> request,
     const std::shared_ptr<plansys2_msgs::srv::GetDomainDurativeActionDetails::Response> response);
 
+  /// Receives the result of the GetDomainStaticPredicates service call
+  /**
+   * \param[in] request_header The header of the request
+   * \param[in] request The request
+   * \param[out] request The response
+   */
+  void get_domain_static_predicates_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::GetStates::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::GetStates::Response> response);
+
+  /// Receives the result of the GetDomainStaticFunctions service call
+  /**
+   * \param[in] request_header The header of the request
+   * \param[in] request The request
+   * \param[out] request The response
+   */
+  void get_domain_static_functions_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::GetStates::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::GetStates::Response> response);
+
   /// Receives the result of the GetDomainPredicates service call
   /**
    * \param[in] request_header The header of the request
@@ -240,6 +263,7 @@ public:
 private:
   std::shared_ptr<DomainExpert> domain_expert_;
 
+  std::shared_ptr<ServiceMultiplexer> multiplexer_;
   rclcpp::Service<plansys2_msgs::srv::GetDomainName>::SharedPtr get_name_service_;
   rclcpp::Service<plansys2_msgs::srv::GetDomainTypes>::SharedPtr get_types_service_;
   rclcpp::Service<plansys2_msgs::srv::GetDomainActions>::SharedPtr get_domain_actions_service_;
@@ -261,6 +285,10 @@ private:
     get_domain_derived_predicates_service_;
   rclcpp::Service<plansys2_msgs::srv::GetDomainDerivedPredicateDetails>::SharedPtr
     get_domain_derived_predicate_details_service_;
+  rclcpp::Service<plansys2_msgs::srv::GetStates>::SharedPtr
+    get_domain_static_predicates_service_;
+  rclcpp::Service<plansys2_msgs::srv::GetStates>::SharedPtr
+    get_domain_static_functions_service_;
   rclcpp::Service<plansys2_msgs::srv::GetDomain>::SharedPtr get_domain_service_;
 
   rclcpp::Client<plansys2_msgs::srv::ValidateDomain>::SharedPtr
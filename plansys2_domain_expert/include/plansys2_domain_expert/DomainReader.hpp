@@ -16,6 +16,7 @@
 #define PLANSYS2_DOMAIN_EXPERT__DOMAINREADER_HPP_
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace plansys2
@@ -33,6 +34,24 @@ struct Domain
   std::vector<std::string> actions;
 };
 
+/// Sections of a domain, as views over the scanned text.
+/**
+ * Single sections (name, requirements, types, ...) hold the text between the keyword and
+ * the closing parenthesis. Derived predicates and actions hold the whole block, from the
+ * keyword to the closing parenthesis included. Empty views mean the section is missing.
+ */
+struct DomainSections
+{
+  std::string_view name;
+  std::string_view requirements;
+  std::string_view types;
+  std::string_view constants;
+  std::string_view predicates;
+  std::string_view functions;
+  std::vector<std::string_view> derived_predicates;
+  std::vector<std::string_view> actions;
+};
+
 class DomainReader
 {
 public:
@@ -43,7 +62,8 @@ public:
   std::vector<Domain> get_domains() {return domains_;}
 
 protected:
-  int get_end_block(const std::string & domain, std::size_t init_pos);
+  int get_end_block(std::string_view domain, std::size_t init_pos);
+  DomainSections scan_sections(std::string_view domain);
 
   std::string get_name(std::string & domain);
   std::string get_requirements(std::string & domain);
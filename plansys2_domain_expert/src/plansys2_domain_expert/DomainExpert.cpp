@@ -16,6 +16,7 @@
 
 #include <optional>
 #include <algorithm>
+#include <set>
 #include <string>
 #include <vector>
 #include <memory>
@@ -42,6 +43,56 @@ DomainExpert::extendDomain(const std::string & domain)
     std::cerr << "\n^^^^^^^^^^^^^^^^^^^^^^^^^^^^^\nError parsing PDDL: " << e.what() << std::endl;
     std::cerr << "Error parsing PDDL: " << e.what() << std::endl;
   }
+
+  findStaticSymbols();
+}
+
+void
+DomainExpert::findStaticSymbols()
+{
+  std::set<std::string> modified_predicates;
+  std::set<std::string> modified_functions;
+
+  // Only the predicates and the function set by a modifier are changed by an effect. Other
+  // functions in an effect are operands, which are only read.
+  auto add_modified = [&](const plansys2_msgs::msg::Tree & effects) {
+      for (const auto & node : effects.nodes) {
+        if (node.node_type == plansys2_msgs::msg::Node::PREDICATE) {
+          modified_predicates.insert(node.name);
+        } else if (node.node_type == plansys2_msgs::msg::Node::FUNCTION_MODIFIER &&
+          !node.children.empty())
+        {
+          modified_functions.insert(effects.nodes[node.children[0]].name);
+        }
+      }
+    };
+
+  for (const auto & action : getActions()) {
+    add_modified(getAction(action)->effects);
+  }
+  for (const auto & action : getDurativeActions()) {
+    auto durative_action = getDurativeAction(action);
+    add_modified(durative_action->at_start_effects);
+    add_modified(durative_action->at_end_effects);
+  }
+
+  for (unsigned i = 0; i < domain_->derived.size(); i++) {
+    modified_predicates.insert(domain_->derived[i]->name);
+  }
+
+  static_predicates_.clear();
+  for (unsigned i = 0; i < domain_->preds.size(); i++) {
+    if (modified_predicates.find(domain_->preds[i]->name) == modified_predicates.end()) {
+      static_predicates_.insert(domain_->preds[i]->name);
+    }
+  }
+
+  static_functions_.clear();
+  for (unsigned i = 0; i < domain_->funcs.size(); i++) {
+    if (modified_functions.find(domain_->funcs[i]->name) == modified_functions.end()) {
+      static_functions_.insert(domain_->funcs[i]->name);
+    }
+  }
 }
 
 std::string
@@ -372,6 +423,54 @@ DomainExpert::getDurativeAction(const std::string & action, const std::vector<st
   }
 }
 
+std::vector<plansys2::Predicate>
+DomainExpert::getStaticPredicates()
+{
+  std::vector<plansys2::Predicate> ret;
+  for (const auto & name : static_predicates_) {
+    plansys2_msgs::msg::Node pred;
+    pred.node_type = plansys2_msgs::msg::Node::PREDICATE;
+    pred.name = name;
+    ret.push_back(pred);
+  }
+  return ret;
+}
+
+std::vector<plansys2::Function>
+DomainExpert::getStaticFunctions()
+{
+  std::vector<plansys2::Function> ret;
+  for (const auto & name : static_functions_) {
+    plansys2_msgs::msg::Node func;
+    func.node_type = plansys2_msgs::msg::Node::FUNCTION;
+    func.name = name;
+    ret.push_back(func);
+  }
+  return ret;
+}
+
+bool
+DomainExpert::isStaticPredicate(const std::string & predicate)
+{
+  std::string predicate_search = predicate;
+  std::transform(
+    predicate_search.begin(), predicate_search.end(),
+    predicate_search.begin(), ::tolower);
+
+  return static_predicates_.find(predicate_search) != static_predicates_.end();
+}
+
+bool
+DomainExpert::isStaticFunction(const std::string & function)
+{
+  std::string function_search = function;
+  std::transform(
+    function_search.begin(), function_search.end(),
+    function_search.begin(), ::tolower);
+
+  return static_functions_.find(function_search) != static_functions_.end();
+}
+
 std::string
 DomainExpert::getDomain()
 {
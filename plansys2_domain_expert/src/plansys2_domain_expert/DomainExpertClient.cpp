@@ -26,39 +26,45 @@ namespace plansys2
 DomainExpertClient::DomainExpertClient()
 {
   node_ = rclcpp::Node::make_shared("domain_expert_client");
-
-  get_domain_client_ = node_->create_client<plansys2_msgs::srv::GetDomain>(
-    "domain_expert/get_domain");
-  get_name_client_ = node_->create_client<plansys2_msgs::srv::GetDomainName>(
-    "domain_expert/get_domain_name");
-  get_types_client_ = node_->create_client<plansys2_msgs::srv::GetDomainTypes>(
-    "domain_expert/get_domain_types");
-  get_constants_client_ = node_->create_client<plansys2_msgs::srv::GetDomainConstants>(
-    "domain_expert/get_domain_constants");
-  get_predicates_client_ = node_->create_client<plansys2_msgs::srv::GetStates>(
-    "domain_expert/get_domain_predicates");
-  get_functions_client_ = node_->create_client<plansys2_msgs::srv::GetStates>(
-    "domain_expert/get_domain_functions");
-  get_derived_predicates_client_ = node_->create_client<plansys2_msgs::srv::GetStates>(
-    "domain_expert/get_domain_derived_predicates");
+  endpoint_ = std::make_shared<MultiplexedEndpoint>(node_, "domain_expert");
+
+  get_domain_client_ = endpoint_->create_client<plansys2_msgs::srv::GetDomain>(
+    "get_domain");
+  get_name_client_ = endpoint_->create_client<plansys2_msgs::srv::GetDomainName>(
+    "get_domain_name");
+  get_types_client_ = endpoint_->create_client<plansys2_msgs::srv::GetDomainTypes>(
+    "get_domain_types");
+  get_constants_client_ = endpoint_->create_client<plansys2_msgs::srv::GetDomainConstants>(
+    "get_domain_constants");
+  get_predicates_client_ = endpoint_->create_client<plansys2_msgs::srv::GetStates>(
+    "get_domain_predicates");
+  get_functions_client_ = endpoint_->create_client<plansys2_msgs::srv::GetStates>(
+    "get_domain_functions");
+  get_derived_predicates_client_ = endpoint_->create_client<plansys2_msgs::srv::GetStates>(
+    "get_domain_derived_predicates");
+  get_static_predicates_client_ = endpoint_->create_client<plansys2_msgs::srv::GetStates>(
+    "get_domain_static_predicates");
+  get_static_functions_client_ = endpoint_->create_client<plansys2_msgs::srv::GetStates>(
+    "get_domain_static_functions");
   get_derived_predicate_details_client_ =
-    node_->create_client<plansys2_msgs::srv::GetDomainDerivedPredicateDetails>(
-    "domain_expert/get_domain_derived_predicate_details");
-  get_actions_client_ = node_->create_client<plansys2_msgs::srv::GetDomainActions>(
-    "domain_expert/get_domain_actions");
-  get_durative_actions_client_ = node_->create_client<plansys2_msgs::srv::GetDomainActions>(
-    "domain_expert/get_domain_durative_actions");
+    endpoint_->create_client<plansys2_msgs::srv::GetDomainDerivedPredicateDetails>(
+    "get_domain_derived_predicate_details");
+  get_actions_client_ = endpoint_->create_client<plansys2_msgs::srv::GetDomainActions>(
+    "get_domain_actions");
+  get_durative_actions_client_ = endpoint_->create_client<plansys2_msgs::srv::GetDomainActions>(
+    "get_domain_durative_actions");
   get_predicate_details_client_ =
-    node_->create_client<plansys2_msgs::srv::GetNodeDetails>(
-    "domain_expert/get_domain_predicate_details");
+    endpoint_->create_client<plansys2_msgs::srv::GetNodeDetails>(
+    "get_domain_predicate_details");
   get_function_details_client_ =
-    node_->create_client<plansys2_msgs::srv::GetNodeDetails>(
-    "domain_expert/get_domain_function_details");
-  get_action_details_client_ = node_->create_client<plansys2_msgs::srv::GetDomainActionDetails>(
-    "domain_expert/get_domain_action_details");
+    endpoint_->create_client<plansys2_msgs::srv::GetNodeDetails>(
+    "get_domain_function_details");
+  get_action_details_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::GetDomainActionDetails>(
+    "get_domain_action_details");
   get_durative_action_details_client_ =
-    node_->create_client<plansys2_msgs::srv::GetDomainDurativeActionDetails>(
-    "domain_expert/get_domain_durative_action_details");
+    endpoint_->create_client<plansys2_msgs::srv::GetDomainDurativeActionDetails>(
+    "get_domain_durative_action_details");
 
   domain_sub_ = node_->create_subscription<std_msgs::msg::String>(
     "domain_expert/domain",
@@ -532,6 +538,72 @@ DomainExpertClient::getDurativeAction(
   }
 }
 
+std::vector<plansys2::Predicate>
+DomainExpertClient::getStaticPredicates()
+{
+  std::vector<plansys2::Predicate> ret;
+
+  while (!get_static_predicates_client_->wait_for_service(std::chrono::seconds(1))) {
+    if (!rclcpp::ok()) {
+      return ret;
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      get_static_predicates_client_->get_service_name() <<
+        " service client: waiting for service to appear...");
+  }
+
+  auto request = std::make_shared<plansys2_msgs::srv::GetStates::Request>();
+
+  auto future_result = get_static_predicates_client_->async_send_request(request);
+
+  if (rclcpp::spin_until_future_complete(node_, future_result, std::chrono::seconds(1)) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+  {
+    return ret;
+  }
+
+  auto result = *future_result.get();
+
+  ret = plansys2::convertVector<plansys2::Predicate, plansys2_msgs::msg::Node>(
+    result.states);
+
+  return ret;
+}
+
+std::vector<plansys2::Function>
+DomainExpertClient::getStaticFunctions()
+{
+  std::vector<plansys2::Function> ret;
+
+  while (!get_static_functions_client_->wait_for_service(std::chrono::seconds(1))) {
+    if (!rclcpp::ok()) {
+      return ret;
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      get_static_functions_client_->get_service_name() <<
+        " service client: waiting for service to appear...");
+  }
+
+  auto request = std::make_shared<plansys2_msgs::srv::GetStates::Request>();
+
+  auto future_result = get_static_functions_client_->async_send_request(request);
+
+  if (rclcpp::spin_until_future_complete(node_, future_result, std::chrono::seconds(1)) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+  {
+    return ret;
+  }
+
+  auto result = *future_result.get();
+
+  ret = plansys2::convertVector<plansys2::Function, plansys2_msgs::msg::Node>(
+    result.states);
+
+  return ret;
+}
+
 std::string
 DomainExpertClient::getDomain(bool use_cache)
 {
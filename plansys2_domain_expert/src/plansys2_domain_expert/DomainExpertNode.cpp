@@ -30,80 +30,94 @@ DomainExpertNode::DomainExpertNode()
 {
   declare_parameter("model_file", "");
   declare_parameter("validate_using_planner_node", false);
+  declare_parameter("legacy_services", true);
 
   validate_domain_callback_group_ = create_callback_group(rclcpp::CallbackGroupType::Reentrant);
 
-  get_name_service_ = create_service<plansys2_msgs::srv::GetDomainName>(
-    "domain_expert/get_domain_name",
+  multiplexer_ = std::make_shared<ServiceMultiplexer>(
+    this, "domain_expert", get_parameter("legacy_services").as_bool());
+
+  get_name_service_ = multiplexer_->add<plansys2_msgs::srv::GetDomainName>(
+    this, "get_domain_name",
     std::bind(
       &DomainExpertNode::get_domain_name_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
-  get_types_service_ = create_service<plansys2_msgs::srv::GetDomainTypes>(
-    "domain_expert/get_domain_types",
+  get_types_service_ = multiplexer_->add<plansys2_msgs::srv::GetDomainTypes>(
+    this, "get_domain_types",
     std::bind(
       &DomainExpertNode::get_domain_types_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
-  get_domain_actions_service_ = create_service<plansys2_msgs::srv::GetDomainActions>(
-    "domain_expert/get_domain_actions",
+  get_domain_actions_service_ = multiplexer_->add<plansys2_msgs::srv::GetDomainActions>(
+    this, "get_domain_actions",
     std::bind(
       &DomainExpertNode::get_domain_actions_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
   get_domain_action_details_service_ =
-    create_service<plansys2_msgs::srv::GetDomainActionDetails>(
-    "domain_expert/get_domain_action_details", std::bind(
+    multiplexer_->add<plansys2_msgs::srv::GetDomainActionDetails>(
+    this, "get_domain_action_details", std::bind(
       &DomainExpertNode::get_domain_action_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
-  get_domain_durative_actions_service_ = create_service<plansys2_msgs::srv::GetDomainActions>(
-    "domain_expert/get_domain_durative_actions",
+  get_domain_durative_actions_service_ = multiplexer_->add<plansys2_msgs::srv::GetDomainActions>(
+    this, "get_domain_durative_actions",
     std::bind(
       &DomainExpertNode::get_domain_durative_actions_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
   get_domain_durative_action_details_service_ =
-    create_service<plansys2_msgs::srv::GetDomainDurativeActionDetails>(
-    "domain_expert/get_domain_durative_action_details", std::bind(
+    multiplexer_->add<plansys2_msgs::srv::GetDomainDurativeActionDetails>(
+    this, "get_domain_durative_action_details", std::bind(
       &DomainExpertNode::get_domain_durative_action_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
-  get_domain_predicates_service_ = create_service<plansys2_msgs::srv::GetStates>(
-    "domain_expert/get_domain_predicates", std::bind(
+  get_domain_predicates_service_ = multiplexer_->add<plansys2_msgs::srv::GetStates>(
+    this, "get_domain_predicates", std::bind(
       &DomainExpertNode::get_domain_predicates_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
   get_domain_predicate_details_service_ =
-    create_service<plansys2_msgs::srv::GetNodeDetails>(
-    "domain_expert/get_domain_predicate_details", std::bind(
+    multiplexer_->add<plansys2_msgs::srv::GetNodeDetails>(
+    this, "get_domain_predicate_details", std::bind(
       &DomainExpertNode::get_domain_predicate_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
-  get_domain_functions_service_ = create_service<plansys2_msgs::srv::GetStates>(
-    "domain_expert/get_domain_functions", std::bind(
+  get_domain_functions_service_ = multiplexer_->add<plansys2_msgs::srv::GetStates>(
+    this, "get_domain_functions", std::bind(
       &DomainExpertNode::get_domain_functions_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
   get_domain_function_details_service_ =
-    create_service<plansys2_msgs::srv::GetNodeDetails>(
-    "domain_expert/get_domain_function_details", std::bind(
+    multiplexer_->add<plansys2_msgs::srv::GetNodeDetails>(
+    this, "get_domain_function_details", std::bind(
       &DomainExpertNode::get_domain_function_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
-  get_domain_derived_predicates_service_ = create_service<plansys2_msgs::srv::GetStates>(
-    "domain_expert/get_domain_derived_predicates", std::bind(
+  get_domain_derived_predicates_service_ = multiplexer_->add<plansys2_msgs::srv::GetStates>(
+    this, "get_domain_derived_predicates", std::bind(
       &DomainExpertNode::get_domain_derived_predicates_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
   get_domain_derived_predicate_details_service_ =
-    create_service<plansys2_msgs::srv::GetDomainDerivedPredicateDetails>(
-    "domain_expert/get_domain_derived_predicate_details", std::bind(
+    multiplexer_->add<plansys2_msgs::srv::GetDomainDerivedPredicateDetails>(
+    this, "get_domain_derived_predicate_details", std::bind(
       &DomainExpertNode::get_domain_derived_predicate_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
-  get_domain_service_ = create_service<plansys2_msgs::srv::GetDomain>(
-    "domain_expert/get_domain", std::bind(
+  get_domain_static_predicates_service_ = multiplexer_->add<plansys2_msgs::srv::GetStates>(
+    this, "get_domain_static_predicates", std::bind(
+      &DomainExpertNode::get_domain_static_predicates_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+  get_domain_static_functions_service_ = multiplexer_->add<plansys2_msgs::srv::GetStates>(
+    this, "get_domain_static_functions", std::bind(
+      &DomainExpertNode::get_domain_static_functions_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+  get_domain_service_ = multiplexer_->add<plansys2_msgs::srv::GetDomain>(
+    this, "get_domain", std::bind(
       &DomainExpertNode::get_domain_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
@@ -369,6 +383,40 @@ DomainExpertNode::get_domain_predicates_service_callback(
   }
 }
 
+void
+DomainExpertNode::get_domain_static_predicates_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::GetStates::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::GetStates::Response> response)
+{
+  if (domain_expert_ == nullptr) {
+    response->success = false;
+    response->error_info = "Requesting service in non-active state";
+    RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
+  } else {
+    response->success = true;
+    response->states = plansys2::convertVector<plansys2_msgs::msg::Node, plansys2::Predicate>(
+      domain_expert_->getStaticPredicates());
+  }
+}
+
+void
+DomainExpertNode::get_domain_static_functions_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::GetStates::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::GetStates::Response> response)
+{
+  if (domain_expert_ == nullptr) {
+    response->success = false;
+    response->error_info = "Requesting service in non-active state";
+    RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
+  } else {
+    response->success = true;
+    response->states = plansys2::convertVector<plansys2_msgs::msg::Node, plansys2::Function>(
+      domain_expert_->getStaticFunctions());
+  }
+}
+
 void
 DomainExpertNode::get_domain_predicate_details_service_callback(
   const std::shared_ptr<rmw_request_id_t> request_header,
@@ -15,6 +15,7 @@
 #include "plansys2_domain_expert/DomainReader.hpp"
 
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 #include <algorithm>
@@ -27,6 +28,38 @@
 namespace plansys2
 {
 
+namespace
+{
+
+std::string section_text(std::string_view section)
+{
+  return substr_without_empty_lines(section, 0, section.length());
+}
+
+std::string name_text(std::string_view section)
+{
+  auto ret = section_text(section);
+
+  // remove spaces
+  ret.erase(std::remove(ret.begin(), ret.end(), ' '), ret.end());
+
+  return ret;
+}
+
+std::vector<std::string> blocks_text(const std::vector<std::string_view> & blocks)
+{
+  std::vector<std::string> ret;
+  ret.reserve(blocks.size());
+
+  for (const auto & block : blocks) {
+    ret.push_back("(" + section_text(block));
+  }
+
+  return ret;
+}
+
+}  // namespace
+
 DomainReader::DomainReader()
 {
 }
@@ -48,14 +81,16 @@ DomainReader::add_domain(const std::string & domain)
 
   lc_domain = remove_comments(lc_domain);
 
-  new_domain.name = get_name(lc_domain);
-  new_domain.requirements = get_requirements(lc_domain);
-  new_domain.types = get_types(lc_domain);
-  new_domain.constants = get_constants(lc_domain);
-  new_domain.predicates = get_predicates(lc_domain);
-  new_domain.functions = get_functions(lc_domain);
-  new_domain.derived_predicates = get_derived_predicates(lc_domain);
-  new_domain.actions = get_actions(lc_domain);
+  auto sections = scan_sections(lc_domain);
+
+  new_domain.name = name_text(sections.name);
+  new_domain.requirements = section_text(sections.requirements);
+  new_domain.types = section_text(sections.types);
+  new_domain.constants = section_text(sections.constants);
+  new_domain.predicates = section_text(sections.predicates);
+  new_domain.functions = section_text(sections.functions);
+  new_domain.derived_predicates = blocks_text(sections.derived_predicates);
+  new_domain.actions = blocks_text(sections.actions);
 
   domains_.push_back(new_domain);
 }
@@ -164,7 +199,7 @@ DomainReader::get_joint_domain() const
 }
 
 int
-DomainReader::get_end_block(const std::string & domain, std::size_t init_pos)
+DomainReader::get_end_block(std::string_view domain, std::size_t init_pos)
 {
   std::size_t domain_length = domain.length();
 
@@ -189,202 +224,126 @@ DomainReader::get_end_block(const std::string & domain, std::size_t init_pos)
   }
 }
 
-std::string
-DomainReader::get_name(std::string & domain)
+DomainSections
+DomainReader::scan_sections(std::string_view domain)
 {
-  const std::string pattern("domain");
+  DomainSections ret;
 
-  std::size_t init_pos = domain.find(pattern);
-  if (init_pos == std::string::npos) {
-    return "";
-  }
-  init_pos += pattern.length();
+  const char * blanks = " \t\r\n";
+  const char * delimiters = " \t\r\n()";
+
+  std::size_t pos = domain.find('(');
+  while (pos != std::string_view::npos) {
+    std::size_t key_pos = domain.find_first_not_of(blanks, pos + 1);
+    if (key_pos == std::string_view::npos) {
+      break;
+    }
+    std::size_t key_end = std::min(domain.find_first_of(delimiters, key_pos), domain.length());
+    std::string_view keyword = domain.substr(key_pos, key_end - key_pos);
+
+    std::string_view * section = nullptr;
+    std::vector<std::string_view> * blocks = nullptr;
+
+    if (keyword == "domain") {
+      section = &ret.name;
+    } else if (keyword == ":requirements") {
+      section = &ret.requirements;
+    } else if (keyword == ":types") {
+      section = &ret.types;
+    } else if (keyword == ":constants") {
+      section = &ret.constants;
+    } else if (keyword == ":predicates") {
+      section = &ret.predicates;
+    } else if (keyword == ":functions") {
+      section = &ret.functions;
+    } else if (keyword == ":derived") {
+      blocks = &ret.derived_predicates;
+    } else if (keyword == ":action" || keyword == ":durative-action") {
+      blocks = &ret.actions;
+    }
 
-  auto end_pos = get_end_block(domain, init_pos);
+    if (section == nullptr && blocks == nullptr) {
+      // Not a section, so its content could contain sections (i.e. define)
+      pos = domain.find('(', pos + 1);
+      continue;
+    }
 
-  if (end_pos >= 0) {
-    auto ret = substr_without_empty_lines(domain, init_pos, end_pos);
+    auto end_pos = get_end_block(domain, key_end);
+    if (end_pos < 0) {
+      // Unbalanced block: the rest of the domain belongs to it
+      break;
+    }
 
-    // remove spaces
-    ret.erase(std::remove(ret.begin(), ret.end(), ' '), ret.end());
+    if (section != nullptr) {
+      if (section->empty()) {
+        *section = domain.substr(key_end, end_pos - key_end);
+      }
+    } else {
+      blocks->push_back(domain.substr(key_pos, end_pos + 1 - key_pos));
+    }
 
-    return ret;
-  } else {
-    return "";
+    pos = domain.find('(', end_pos + 1);
   }
+
+  return ret;
+}
+
+std::string
+DomainReader::get_name(std::string & domain)
+{
+  return name_text(scan_sections(domain).name);
 }
 
 std::string
 DomainReader::get_requirements(std::string & domain)
 {
-  const std::string pattern(":requirements");
+  auto requirements = scan_sections(domain).requirements;
 
-  std::size_t init_pos = domain.find(pattern);
-  if (init_pos == std::string::npos) {
+  if (requirements.empty()) {
     return "";
   }
-  init_pos += pattern.length();
 
-  auto end_pos = get_end_block(domain, init_pos);
+  auto ret = section_text(requirements);
+  // We remove the requirements part for not interfering with next analysis
+  domain.erase(requirements.data() - domain.data(), requirements.length());
 
-  if (end_pos >= 0) {
-    auto ret = substr_without_empty_lines(domain, init_pos, end_pos);
-    // We remove the requirements part for not interfering with next analysis
-    domain.replace(init_pos, end_pos - init_pos, "");
-
-    return ret;
-  } else {
-    return "";
-  }
+  return ret;
 }
 
 std::string
 DomainReader::get_types(const std::string & domain)
 {
-  const std::string pattern(":types");
-
-  std::size_t init_pos = domain.find(pattern);
-  if (init_pos == std::string::npos) {
-    return "";
-  }
-  init_pos += pattern.length();
-
-  auto end_pos = get_end_block(domain, init_pos);
-
-  if (end_pos >= 0) {
-    std::string ret = substr_without_empty_lines(domain, init_pos, end_pos);
-    return ret;
-  } else {
-    return "";
-  }
+  return section_text(scan_sections(domain).types);
 }
 
-
 std::string
 DomainReader::get_constants(const std::string & domain)
 {
-  const std::string pattern(":constants");
-
-  std::size_t init_pos = domain.find(pattern);
-  if (init_pos == std::string::npos) {
-    return "";
-  }
-  init_pos += pattern.length();
-
-  auto end_pos = get_end_block(domain, init_pos);
-
-  if (end_pos >= 0) {
-    std::string ret = substr_without_empty_lines(domain, init_pos, end_pos);
-    return ret;
-  } else {
-    return "";
-  }
+  return section_text(scan_sections(domain).constants);
 }
 
-
 std::string
 DomainReader::get_predicates(const std::string & domain)
 {
-  const std::string pattern(":predicates");
-
-  std::size_t init_pos = domain.find(pattern);
-  if (init_pos == std::string::npos) {
-    return "";
-  }
-  init_pos += pattern.length();
-
-  auto end_pos = get_end_block(domain, init_pos);
-
-  if (end_pos >= 0) {
-    std::string ret = substr_without_empty_lines(domain, init_pos, end_pos);
-    return ret;
-  } else {
-    return "";
-  }
+  return section_text(scan_sections(domain).predicates);
 }
 
 std::string
 DomainReader::get_functions(const std::string & domain)
 {
-  const std::string pattern(":functions");
-
-  std::size_t init_pos = domain.find(pattern);
-  if (init_pos == std::string::npos) {
-    return "";
-  }
-  init_pos += pattern.length();
-
-  auto end_pos = get_end_block(domain, init_pos);
-
-  if (end_pos >= 0) {
-    std::string ret = substr_without_empty_lines(domain, init_pos, end_pos);
-    return ret;
-  } else {
-    return "";
-  }
+  return section_text(scan_sections(domain).functions);
 }
 
 std::vector<std::string>
 DomainReader::get_derived_predicates(const std::string & domain)
 {
-  std::vector<std::string> ret;
-
-  const std::string derived_pattern(":derived");
-
-  auto ldomain = domain;
-
-  size_t pos = std::string::npos;
-  do {
-    pos = ldomain.find(derived_pattern);
-
-    if (pos != std::string::npos) {
-      auto end_pos = get_end_block(ldomain, pos + 1);
-
-      if (end_pos == -1) {
-        break;
-      }
-
-      std::string lines = substr_without_empty_lines(ldomain, pos, end_pos + 1);
-      ret.push_back("(" + lines);
-      ldomain = ldomain.substr(end_pos + 1);
-    }
-  } while (!ldomain.empty() && pos != std::string::npos);
-
-  return ret;
+  return blocks_text(scan_sections(domain).derived_predicates);
 }
 
 std::vector<std::string>
 DomainReader::get_actions(const std::string & domain)
 {
-  std::vector<std::string> ret;
-
-  const std::string da_pattern(":durative-action");
-  const std::string a_pattern(":action");
-
-  auto ldomain = domain;
-
-  size_t pos = std::string::npos;
-  do {
-    std::size_t da_pos = ldomain.find(da_pattern);
-    std::size_t a_pos = ldomain.find(a_pattern);
-
-    pos = std::min(da_pos, a_pos);
-
-    if (pos != std::string::npos) {
-      auto end_pos = get_end_block(ldomain, pos + 1);
-
-      if (end_pos == -1) {
-        break;
-      }
-
-      std::string lines = substr_without_empty_lines(ldomain, pos, end_pos + 1);
-      ret.push_back("(" + lines);
-      ldomain = ldomain.substr(end_pos + 1);
-    }
-  } while (!ldomain.empty() && pos != std::string::npos);
-
-  return ret;
+  return blocks_text(scan_sections(domain).actions);
 }
 
-
 }  // namespace plansys2
@@ -273,6 +273,40 @@ TEST(domain_expert, get_function_params)
   ASSERT_EQ(params_3.value().parameters[1].type, "waypoint");
 }
 
+TEST(domain_expert, get_static_symbols)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_domain_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_charging.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  plansys2::DomainExpert domain_expert(domain_str);
+
+  std::vector<plansys2::Predicate> predicates = domain_expert.getStaticPredicates();
+  std::vector<std::string> predicates_names {"charger_at", "connected"};
+
+  ASSERT_EQ(predicates.size(), predicates_names.size());
+  for (unsigned i = 0; i < predicates.size(); i++) {
+    ASSERT_EQ(predicates[i].name, predicates_names[i]);
+  }
+
+  // Functions only read in effects, as distance in move, are static too
+  std::vector<plansys2::Function> functions = domain_expert.getStaticFunctions();
+  std::vector<std::string> functions_names {"distance", "max_range", "speed"};
+
+  ASSERT_EQ(functions.size(), functions_names.size());
+  for (unsigned i = 0; i < functions.size(); i++) {
+    ASSERT_EQ(functions[i].name, functions_names[i]);
+  }
+
+  ASSERT_TRUE(domain_expert.isStaticPredicate("CONNECTED"));
+  ASSERT_FALSE(domain_expert.isStaticPredicate("robot_at"));
+  ASSERT_FALSE(domain_expert.isStaticPredicate("unknown"));
+  ASSERT_TRUE(domain_expert.isStaticFunction("speed"));
+  ASSERT_FALSE(domain_expert.isStaticFunction("state_of_charge"));
+}
+
 TEST(domain_expert, get_derived_predicates)
 {
   std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_domain_expert");
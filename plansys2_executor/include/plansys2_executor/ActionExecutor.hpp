@@ -26,6 +26,7 @@
 #include "plansys2_msgs/msg/param.hpp"
 #include "plansys2_msgs/msg/plan_item.hpp"
 #include "plansys2_pddl_parser/Utils.hpp"
+#include "plansys2_executor/EventQueue.hpp"
 #include "behaviortree_cpp/behavior_tree.h"
 
 #include "rclcpp/rclcpp.hpp"
@@ -34,6 +35,13 @@
 namespace plansys2
 {
 
+/// Requester side of the protocol to execute an action by an action performer.
+/**
+ * The messages of the actions hub are received in the thread spinning the node, and are
+ * only queued there. All the state is owned by the thread ticking the executor, which
+ * processes the queued messages at the start of each tick, so the state is never accessed
+ * concurrently.
+ */
 class ActionExecutor
 {
 public:
@@ -98,7 +106,17 @@ protected:
     action_hub_pub_;
   rclcpp::Subscription<plansys2_msgs::msg::ActionExecution>::SharedPtr action_hub_sub_;
 
+  struct HubEvent
+  {
+    plansys2_msgs::msg::ActionExecution::SharedPtr msg;
+    rclcpp::Time stamp;
+  };
+
+  EventQueue<HubEvent> hub_events_;
+
   void action_hub_callback(const plansys2_msgs::msg::ActionExecution::SharedPtr msg);
+  void process_hub_events();
+  void process_hub_event(const HubEvent & event);
   void request_for_performers();
   void confirm_performer(const std::string & node_id);
   void reject_performer(const std::string & node_id);
@@ -106,8 +124,8 @@ protected:
   std::string get_name(const std::string & action_expr);
   std::vector<std::string> get_params(const std::string & action_expr);
 
-  void wait_timeout();
-  rclcpp::TimerBase::SharedPtr waiting_timer_;
+  // When performers were last requested, to request them again while dealing
+  rclcpp::Time request_time_;
 };
 
 struct ActionVariant
@@ -0,0 +1,125 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef PLANSYS2_EXECUTOR__ASYNCPROBLEMCLIENT_HPP_
+#define PLANSYS2_EXECUTOR__ASYNCPROBLEMCLIENT_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "plansys2_problem_expert/ProblemExpertClient.hpp"
+
+namespace plansys2
+{
+
+/// Runs requests to the problem expert in a background thread.
+/**
+ * The requests are queued and run in order, one at a time, on a ProblemExpertClient used
+ * only by the background thread, so the thread ticking a behavior tree never waits for the
+ * problem expert.
+ */
+class AsyncProblemClient
+{
+public:
+  /// Create the client and start its thread.
+  /**
+   * \param[in] problem_client The client the requests run on. If it is null, a new one is
+   *            created. It must not be used by any other thread.
+   */
+  explicit AsyncProblemClient(std::shared_ptr<ProblemExpertClient> problem_client = nullptr);
+  ~AsyncProblemClient();
+
+  AsyncProblemClient(const AsyncProblemClient &) = delete;
+  AsyncProblemClient & operator=(const AsyncProblemClient &) = delete;
+
+  /// Queue a request.
+  /**
+   * \param[in] request The request, called from the background thread with the client.
+   * \return The future result of the request.
+   */
+  template<class T>
+  std::future<T> submit(std::function<T(std::shared_ptr<ProblemExpertClient>)> request)
+  {
+    auto task = std::make_shared<std::packaged_task<T()>>(
+      [this, request = std::move(request)]() {return request(problem_client_);});
+    auto result = task->get_future();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back([task]() {(*task)();});
+    }
+    cv_.notify_one();
+
+    return result;
+  }
+
+private:
+  void run();
+
+  std::shared_ptr<ProblemExpertClient> problem_client_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> requests_;
+  bool stop_;
+
+  std::thread thread_;
+};
+
+/// Run a request to the problem expert from the ticks of a behavior tree node.
+/**
+ * The first call submits the request to async_client, and the following calls poll its
+ * result without blocking. Once the result is returned, pending is reset and the next call
+ * submits the request again. Without async_client, the request runs in place on
+ * problem_client.
+ *
+ * \param[in,out] pending The request in progress, kept by the node between ticks.
+ * \param[in] async_client The client to submit the request to. It may be null.
+ * \param[in] problem_client The client to run the request on if there is no async_client.
+ * \param[in] request The request.
+ * \return The result of the request, or nothing while it is in progress.
+ */
+template<class T>
+std::optional<T> poll_request(
+  std::future<T> & pending,
+  const std::shared_ptr<AsyncProblemClient> & async_client,
+  const std::shared_ptr<ProblemExpertClient> & problem_client,
+  std::function<T(std::shared_ptr<ProblemExpertClient>)> request)
+{
+  if (!pending.valid()) {
+    if (async_client == nullptr) {
+      return request(problem_client);
+    }
+    pending = async_client->submit<T>(std::move(request));
+  }
+
+  if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return {};
+  }
+
+  return pending.get();
+}
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_EXECUTOR__ASYNCPROBLEMCLIENT_HPP_
@@ -21,6 +21,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "plansys2_executor/ActionExecutor.hpp"
 #include "plansys2_msgs/msg/plan.hpp"
@@ -75,6 +76,35 @@ struct Graph
   std::list<Node::Ptr> nodes;
 };
 
+/// Minimal partial order of the actions of a plan, see deorder_plan.
+struct PartialOrderPlan
+{
+  enum struct LinkType
+  {
+    CAUSAL,   // from may achieve a condition of to
+    THREAT,   // to may invalidate a condition or an effect of from
+    NUMERIC   // from and to access a function that at least one of them modifies
+  };
+
+  struct Link
+  {
+    size_t from;
+    size_t to;
+    LinkType type;
+    std::string fact;
+  };
+
+  plansys2_msgs::msg::Plan plan;
+  std::vector<ActionStamped> actions;  // In the order of the plan
+
+  // Every ordering found, with the fact that causes it
+  std::vector<Link> links;
+
+  // Transitive reduction of the links, by action index
+  std::vector<std::vector<size_t>> predecessors;
+  std::vector<std::vector<size_t>> successors;
+};
+
 class BTBuilder
 {
 public:
@@ -86,6 +116,14 @@ public:
     int precision = 3) = 0;
 
   virtual std::string get_tree(const plansys2_msgs::msg::Plan & current_plan) = 0;
+
+  /// Build the tree of a plan already lifted to a partial order.
+  /**
+   * Builders that infer the parallelism of the plan by themselves just build the tree of
+   * plan.plan.
+   */
+  virtual std::string get_tree(const PartialOrderPlan & plan) {return get_tree(plan.plan);}
+
   virtual Graph::Ptr get_graph() = 0;
   virtual bool propagate(Graph::Ptr graph) = 0;
   virtual std::string get_dotgraph(
@@ -0,0 +1,100 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_EXECUTOR__EVENTQUEUE_HPP_
+#define PLANSYS2_EXECUTOR__EVENTQUEUE_HPP_
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace plansys2
+{
+
+/// Lock-free multiple-producer single-consumer queue.
+/**
+ * Any number of threads may push, but only one thread, the consumer, may pop. Push is
+ * wait-free and pop never blocks: an event whose push is still in progress is returned by
+ * a later pop.
+ *
+ * The queue is a linked list whose first node is a sentinel. Producers exchange the head,
+ * and the consumer advances the tail.
+ */
+template<class T>
+class EventQueue
+{
+public:
+  EventQueue()
+  : head_(new Node()), tail_(head_.load(std::memory_order_relaxed))
+  {
+  }
+
+  ~EventQueue()
+  {
+    while (pop()) {}
+    delete tail_;
+  }
+
+  EventQueue(const EventQueue &) = delete;
+  EventQueue & operator=(const EventQueue &) = delete;
+
+  void push(T event)
+  {
+    Node * node = new Node();
+    node->event = std::move(event);
+
+    Node * prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  /// Pop the oldest event. Only called from the consumer thread.
+  std::optional<T> pop()
+  {
+    Node * tail = tail_;
+    Node * next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return {};
+    }
+
+    std::optional<T> ret = std::move(next->event);
+    next->event.reset();
+    tail_ = next;
+    delete tail;
+
+    return ret;
+  }
+
+  /// Pop all the events, calling handler with each one. Only called from the consumer thread.
+  template<class Handler>
+  void drain(Handler && handler)
+  {
+    while (auto event = pop()) {
+      handler(std::move(event.value()));
+    }
+  }
+
+private:
+  struct Node
+  {
+    std::atomic<Node *> next {nullptr};
+    std::optional<T> event;
+  };
+
+  std::atomic<Node *> head_;
+  Node * tail_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_EXECUTOR__EVENTQUEUE_HPP_
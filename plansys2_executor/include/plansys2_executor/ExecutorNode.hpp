@@ -25,6 +25,7 @@
 #include "plansys2_problem_expert/ProblemExpertClient.hpp"
 #include "plansys2_planner/PlannerClient.hpp"
 #include "plansys2_executor/ActionExecutor.hpp"
+#include "plansys2_executor/AsyncProblemClient.hpp"
 #include "plansys2_executor/BTBuilder.hpp"
 
 #include "lifecycle_msgs/msg/state.hpp"
@@ -114,6 +115,7 @@ protected:
 
   std::shared_ptr<plansys2::DomainExpertClient> domain_client_;
   std::shared_ptr<plansys2::ProblemExpertClient> problem_client_;
+  std::shared_ptr<plansys2::AsyncProblemClient> async_problem_client_;
   std::shared_ptr<plansys2::PlannerClient> planner_client_;
 
   rclcpp_lifecycle::LifecyclePublisher<plansys2_msgs::msg::ActionExecutionInfo>::SharedPtr
@@ -0,0 +1,62 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_EXECUTOR__PLANDEORDERING_HPP_
+#define PLANSYS2_EXECUTOR__PLANDEORDERING_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "plansys2_executor/ActionExecutor.hpp"
+#include "plansys2_executor/BTBuilder.hpp"
+#include "plansys2_msgs/msg/plan.hpp"
+
+namespace plansys2
+{
+
+/// Lift a plan to the minimal partial order of its actions that keeps it valid.
+/**
+ * Each action is ordered only after the actions it depends on: the last producer of each
+ * fact it requires (causal links), the actions whose conditions or opposite effects its
+ * effects would invalidate (threats), and the previous accesses to the functions it
+ * modifies or reads. The producers and consumers of each fact are indexed while traversing
+ * the plan once, so no state is simulated. Facts in disjunctive or quantified conditions
+ * keep the order of every action changing a fact of the same predicate.
+ *
+ * Actions are considered as a whole, as the behavior trees wait for the end of the previous
+ * actions: the conditions of a durative action achieved by its own at start effects are not
+ * required from other actions.
+ *
+ * \param[in] plan The plan.
+ * \param[in] actions The ground actions of the plan, in the same order.
+ * \return The partial order, with the transitively redundant orderings removed.
+ */
+PartialOrderPlan deorder_plan(
+  const plansys2_msgs::msg::Plan & plan,
+  const std::vector<ActionStamped> & actions);
+
+/// Lift a plan whose ground actions are in the action map of its execution.
+/**
+ * \param[in] plan The plan.
+ * \param[in] action_map The execution info of the actions, by BTBuilder::to_action_id(item, 3).
+ * \return The partial order, with the transitively redundant orderings removed.
+ */
+PartialOrderPlan deorder_plan(
+  const plansys2_msgs::msg::Plan & plan,
+  const std::map<std::string, ActionExecutionInfo> & action_map);
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_EXECUTOR__PLANDEORDERING_HPP_
@@ -15,6 +15,7 @@
 #ifndef PLANSYS2_EXECUTOR__BEHAVIOR_TREE__CHECK_ATEND_REQ_NODE_HPP_
 #define PLANSYS2_EXECUTOR__BEHAVIOR_TREE__CHECK_ATEND_REQ_NODE_HPP_
 
+#include <future>
 #include <map>
 #include <string>
 #include <memory>
@@ -23,6 +24,7 @@
 
 #include "plansys2_problem_expert/ProblemExpertClient.hpp"
 #include "plansys2_executor/ActionExecutor.hpp"
+#include "plansys2_executor/AsyncProblemClient.hpp"
 #include "plansys2_problem_expert/Utils.hpp"
 
 #include "plansys2_executor/behavior_tree/execute_action_node.hpp"
@@ -37,7 +39,7 @@ public:
     const std::string & xml_tag_name,
     const BT::NodeConfig & conf);
 
-  void halt() {}
+  void halt() {pending_ = {};}
   BT::NodeStatus tick() override;
 
   static BT::PortsList providedPorts()
@@ -51,6 +53,8 @@ public:
 private:
   std::shared_ptr<std::map<std::string, ActionExecutionInfo>> action_map_;
   std::shared_ptr<plansys2::ProblemExpertClient> problem_client_;
+  std::shared_ptr<plansys2::AsyncProblemClient> async_problem_client_;
+  std::future<bool> pending_;
 };
 
 }  // namespace plansys2
@@ -15,14 +15,17 @@
 #ifndef PLANSYS2_EXECUTOR__BEHAVIOR_TREE__WAIT_ATSTART_REQ_NODE_HPP_
 #define PLANSYS2_EXECUTOR__BEHAVIOR_TREE__WAIT_ATSTART_REQ_NODE_HPP_
 
+#include <future>
 #include <map>
 #include <string>
 #include <memory>
+#include <utility>
 
 #include "behaviortree_cpp/action_node.h"
 
 #include "plansys2_problem_expert/ProblemExpertClient.hpp"
 #include "plansys2_executor/ActionExecutor.hpp"
+#include "plansys2_executor/AsyncProblemClient.hpp"
 #include "plansys2_problem_expert/Utils.hpp"
 
 #include "plansys2_executor/behavior_tree/execute_action_node.hpp"
@@ -37,7 +40,7 @@ public:
     const std::string & xml_tag_name,
     const BT::NodeConfig & conf);
 
-  void halt() {}
+  void halt() {pending_ = {};}
   BT::NodeStatus tick() override;
 
   static BT::PortsList providedPorts()
@@ -51,6 +54,8 @@ public:
 private:
   std::shared_ptr<std::map<std::string, ActionExecutionInfo>> action_map_;
   std::shared_ptr<plansys2::ProblemExpertClient> problem_client_;
+  std::shared_ptr<plansys2::AsyncProblemClient> async_problem_client_;
+  std::future<std::pair<bool, bool>> pending_;
 };
 
 }  // namespace plansys2
@@ -75,6 +75,7 @@ public:
     int precision = 3);
 
   std::string get_tree(const plansys2_msgs::msg::Plan & current_plan);
+  std::string get_tree(const PartialOrderPlan & plan);
   Graph::Ptr get_graph() {return nullptr;}
   bool propagate(Graph::Ptr) {return true;}
   std::string get_dotgraph(
@@ -91,6 +92,8 @@ protected:
   std::string bt_action_;
 
   ActionGraph::Ptr get_graph(const plansys2_msgs::msg::Plan & current_plan);
+  ActionGraph::Ptr get_graph(const PartialOrderPlan & plan);
+  std::string get_tree_from_graph();
 
   std::vector<ActionStamped> get_plan_actions(const plansys2_msgs::msg::Plan & plan);
   void prune_backwards(ActionNode::Ptr new_node, ActionNode::Ptr node_satisfy);
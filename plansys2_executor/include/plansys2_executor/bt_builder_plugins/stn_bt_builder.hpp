@@ -50,6 +50,7 @@ public:
     const std::string & bt_action_2 = "",
     int precision = 3);
 
+  using BTBuilder::get_tree;
   std::string get_tree(const plansys2_msgs::msg::Plan & current_plan);
   Graph::Ptr get_graph() {return stn_;}
   bool propagate(const Graph::Ptr stn);
@@ -163,6 +164,8 @@ protected:
   std::shared_ptr<plansys2::ProblemExpertClient> problem_client_;
 
   Graph::Ptr stn_;
+  std::set<std::string> static_predicates_;
+  std::set<std::string> static_functions_;
   std::string bt_start_action_;
   std::string bt_end_action_;
   int action_time_precision_;
@@ -57,8 +57,6 @@ ActionExecutor::clean_up()
 void
 ActionExecutor::action_hub_callback(const plansys2_msgs::msg::ActionExecution::SharedPtr msg)
 {
-  last_msg = *msg;
-
   switch (msg->type) {
     case plansys2_msgs::msg::ActionExecution::REQUEST:
     case plansys2_msgs::msg::ActionExecution::CONFIRM:
@@ -67,34 +65,57 @@ ActionExecutor::action_hub_callback(const plansys2_msgs::msg::ActionExecution::S
       // These cases have no meaning requester
       break;
     case plansys2_msgs::msg::ActionExecution::RESPONSE:
-      if (msg->arguments == action_params_ && msg->action == action_name_) {
-        if (state_ == DEALING) {
-          confirm_performer(msg->node_id);
-          current_performer_id_ = msg->node_id;
-          state_ = RUNNING;
-          waiting_timer_ = nullptr;
-          start_execution_ = node_->now();
-          state_time_ = node_->now();
-        } else {
-          reject_performer(msg->node_id);
-        }
+    case plansys2_msgs::msg::ActionExecution::FEEDBACK:
+    case plansys2_msgs::msg::ActionExecution::FINISH:
+      // Only the immutable action name and params are used here. The rest is processed
+      // in the ticking thread
+      if (msg->action == action_name_ && msg->arguments == action_params_) {
+        hub_events_.push({msg, node_->now()});
+      }
+      break;
+    default:
+      RCLCPP_ERROR(
+        node_->get_logger(), "Msg %d type not recognized in %s executor requester",
+        msg->type, action_.c_str());
+      break;
+  }
+}
+
+void
+ActionExecutor::process_hub_events()
+{
+  hub_events_.drain([this](const HubEvent & event) {process_hub_event(event);});
+}
+
+void
+ActionExecutor::process_hub_event(const HubEvent & event)
+{
+  const auto & msg = event.msg;
+  last_msg = *msg;
+
+  switch (msg->type) {
+    case plansys2_msgs::msg::ActionExecution::RESPONSE:
+      if (state_ == DEALING) {
+        confirm_performer(msg->node_id);
+        current_performer_id_ = msg->node_id;
+        state_ = RUNNING;
+        start_execution_ = event.stamp;
+        state_time_ = event.stamp;
+      } else if (action_hub_pub_ != nullptr) {
+        reject_performer(msg->node_id);
       }
       break;
     case plansys2_msgs::msg::ActionExecution::FEEDBACK:
-      if (state_ != RUNNING || msg->arguments != action_params_ || msg->action != action_name_ ||
-        msg->node_id != current_performer_id_)
-      {
+      if (state_ != RUNNING || msg->node_id != current_performer_id_) {
         return;
       }
       feedback_ = msg->status;
       completion_ = msg->completion;
-      state_time_ = node_->now();
+      state_time_ = event.stamp;
 
       break;
     case plansys2_msgs::msg::ActionExecution::FINISH:
-      if (msg->arguments == action_params_ &&
-        msg->action == action_name_ && msg->node_id == current_performer_id_)
-      {
+      if (msg->node_id == current_performer_id_ && action_hub_pub_ != nullptr) {
         if (msg->success) {
           state_ = SUCCESS;
         } else {
@@ -104,7 +125,7 @@ ActionExecutor::action_hub_callback(const plansys2_msgs::msg::ActionExecution::S
         feedback_ = msg->status;
         completion_ = msg->completion;
 
-        state_time_ = node_->now();
+        state_time_ = event.stamp;
 
         action_hub_pub_->on_deactivate();
         action_hub_pub_ = nullptr;
@@ -112,9 +133,6 @@ ActionExecutor::action_hub_callback(const plansys2_msgs::msg::ActionExecution::S
       }
       break;
     default:
-      RCLCPP_ERROR(
-        node_->get_logger(), "Msg %d type not recognized in %s executor requester",
-        msg->type, action_.c_str());
       break;
   }
 }
@@ -187,6 +205,8 @@ ActionExecutor::is_finished()
 BT::NodeStatus
 ActionExecutor::tick(const rclcpp::Time & now)
 {
+  process_hub_events();
+
   switch (state_) {
     case IDLE:
       state_ = DEALING;
@@ -198,17 +218,23 @@ ActionExecutor::tick(const rclcpp::Time & now)
       feedback_ = "";
 
       request_for_performers();
-      waiting_timer_ = node_->create_wall_timer(
-        1s, std::bind(&ActionExecutor::wait_timeout, this));
+      request_time_ = state_time_;
       break;
     case DEALING:
       {
-        auto time_since_dealing = (node_->now() - state_time_).seconds();
+        auto current_time = node_->now();
+        auto time_since_dealing = (current_time - state_time_).seconds();
         if (time_since_dealing > 30.0) {
           RCLCPP_ERROR(
             node_->get_logger(),
             "Aborting %s. Timeout after requesting for 30 seconds", action_.c_str());
           state_ = FAILURE;
+        } else if ((current_time - request_time_).seconds() > 1.0) {
+          // Requests are repeated from the ticking thread, which owns the publisher
+          RCLCPP_WARN(
+            node_->get_logger(), "No action performer for %s. retrying", action_.c_str());
+          request_for_performers();
+          request_time_ = current_time;
         }
       }
       break;
@@ -276,11 +302,4 @@ ActionExecutor::get_params(const std::string & action_expr)
   return ret;
 }
 
-void
-ActionExecutor::wait_timeout()
-{
-  RCLCPP_WARN(node_->get_logger(), "No action performer for %s. retrying", action_.c_str());
-  request_for_performers();
-}
-
 }  // namespace plansys2
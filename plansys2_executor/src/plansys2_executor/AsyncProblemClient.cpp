@@ -0,0 +1,72 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "plansys2_executor/AsyncProblemClient.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace plansys2
+{
+
+AsyncProblemClient::AsyncProblemClient(std::shared_ptr<ProblemExpertClient> problem_client)
+: problem_client_(std::move(problem_client)),
+  stop_(false)
+{
+  if (problem_client_ == nullptr) {
+    problem_client_ = std::make_shared<ProblemExpertClient>();
+  }
+
+  thread_ = std::thread(&AsyncProblemClient::run, this);
+}
+
+AsyncProblemClient::~AsyncProblemClient()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+
+  thread_.join();
+}
+
+void
+AsyncProblemClient::run()
+{
+  while (true) {
+    std::function<void()> request;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] {return stop_ || !requests_.empty();});
+
+      // Pending requests are dropped, so their futures report a broken promise
+      if (stop_) {
+        requests_.clear();
+        return;
+      }
+
+      request = std::move(requests_.front());
+      requests_.pop_front();
+    }
+
+    request();
+  }
+}
+
+}  // namespace plansys2
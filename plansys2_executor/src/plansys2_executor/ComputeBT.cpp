@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "plansys2_executor/ComputeBT.hpp"
+#include "plansys2_executor/PlanDeordering.hpp"
 
 #include "behaviortree_cpp/behavior_tree.h"
 #include "behaviortree_cpp/bt_factory.h"
@@ -58,6 +59,7 @@ ComputeBT::ComputeBT()
   this->declare_parameter<std::string>("problem", "");
   this->declare_parameter<int>("action_time_precision", 3);
   this->declare_parameter<bool>("enable_dotgraph_legend", true);
+  this->declare_parameter<bool>("plan_deordering", false);
   this->declare_parameter<bool>("print_graph", true);
   this->declare_parameter("action_timeouts.actions", std::vector<std::string>{});
   // Declaring individual action parameters so they can be queried on the command line
@@ -308,7 +310,12 @@ ComputeBT::computeBTCallback(
     bt_builder->initialize(start_action_bt_xml_, end_action_bt_xml_, precision);
   }
 
-  auto bt_xml_tree = bt_builder->get_tree(plan.value());
+  std::string bt_xml_tree;
+  if (this->get_parameter("plan_deordering").as_bool()) {
+    bt_xml_tree = bt_builder->get_tree(deorder_plan(plan.value(), *action_map));
+  } else {
+    bt_xml_tree = bt_builder->get_tree(plan.value());
+  }
   if (bt_xml_tree.empty()) {
     RCLCPP_ERROR(get_logger(), "Error computing behavior tree!");
 
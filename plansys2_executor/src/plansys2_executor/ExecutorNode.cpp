@@ -25,7 +25,9 @@
 
 #include "plansys2_executor/ExecutorNode.hpp"
 #include "plansys2_executor/ActionExecutor.hpp"
+#include "plansys2_executor/AsyncProblemClient.hpp"
 #include "plansys2_executor/BTBuilder.hpp"
+#include "plansys2_executor/PlanDeordering.hpp"
 #include "plansys2_problem_expert/Utils.hpp"
 #include "plansys2_pddl_parser/Utils.hpp"
 
@@ -69,6 +71,7 @@ ExecutorNode::ExecutorNode()
   this->declare_parameter<std::string>("bt_builder_plugin", "");
   this->declare_parameter<int>("action_time_precision", 3);
   this->declare_parameter<bool>("enable_dotgraph_legend", true);
+  this->declare_parameter<bool>("plan_deordering", false);
   this->declare_parameter<bool>("print_graph", false);
   this->declare_parameter("action_timeouts.actions", std::vector<std::string>{});
   // Declaring individual action parameters so they can be queried on the command line
@@ -183,6 +186,7 @@ ExecutorNode::on_configure(const rclcpp_lifecycle::State & state)
 
   domain_client_ = std::make_shared<plansys2::DomainExpertClient>();
   problem_client_ = std::make_shared<plansys2::ProblemExpertClient>();
+  async_problem_client_ = std::make_shared<plansys2::AsyncProblemClient>();
   planner_client_ = std::make_shared<plansys2::PlannerClient>();
 
   RCLCPP_INFO(get_logger(), "[%s] Configured", get_name());
@@ -439,7 +443,13 @@ ExecutorNode::get_tree_from_plan(PlanRuntineInfo & runtime_info)
     // bt_builder->initialize(start_action_bt_xml_, end_action_bt_xml_, precision);
   }
 
-  auto bt_xml_tree = bt_builder->get_tree(runtime_info.complete_plan);
+  std::string bt_xml_tree;
+  if (this->get_parameter("plan_deordering").as_bool()) {
+    bt_xml_tree = bt_builder->get_tree(
+      deorder_plan(runtime_info.complete_plan, *runtime_info.action_map));
+  } else {
+    bt_xml_tree = bt_builder->get_tree(runtime_info.complete_plan);
+  }
   if (bt_xml_tree.empty()) {
     RCLCPP_ERROR(get_logger(), "Error computing behavior tree!");
     return false;
@@ -475,6 +485,7 @@ ExecutorNode::get_tree_from_plan(PlanRuntineInfo & runtime_info)
   blackboard->set("node", shared_from_this());
   blackboard->set("domain_client", domain_client_);
   blackboard->set("problem_client", problem_client_);
+  blackboard->set("async_problem_client", async_problem_client_);
   blackboard->set("bt_builder", bt_builder);
 
   runtime_info.current_tree = std::make_shared<TreeInfo>();
@@ -0,0 +1,384 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_executor/PlanDeordering.hpp"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace plansys2
+{
+
+namespace
+{
+
+// Facts accessed by an action. Predicates and functions are identified as "(name args)",
+// and the predicates of disjunctive or quantified conditions only by their name.
+struct ActionAccess
+{
+  std::set<std::string> positive_reads;
+  std::set<std::string> negative_reads;
+  std::set<std::string> adds;
+  std::set<std::string> deletes;
+  std::set<std::string> function_reads;
+  std::set<std::string> function_writes;
+  std::set<std::string> name_reads;
+  std::set<std::string> name_writes;
+};
+
+std::string fact_key(const plansys2_msgs::msg::Node & node)
+{
+  std::string key = "(" + node.name;
+  for (const auto & param : node.parameters) {
+    key += " " + param.name;
+  }
+  return key + ")";
+}
+
+void collect_conditions(
+  const plansys2_msgs::msg::Tree & tree, uint32_t node_id, bool negate, bool literal,
+  ActionAccess & access)
+{
+  if (node_id >= tree.nodes.size()) {
+    return;
+  }
+
+  const auto & node = tree.nodes[node_id];
+  switch (node.node_type) {
+    case plansys2_msgs::msg::Node::AND:
+      // A negated conjunction is a disjunction
+      for (auto child : node.children) {
+        collect_conditions(tree, child, negate, literal && !negate, access);
+      }
+      break;
+    case plansys2_msgs::msg::Node::OR:
+      for (auto child : node.children) {
+        collect_conditions(tree, child, negate, literal && negate, access);
+      }
+      break;
+    case plansys2_msgs::msg::Node::NOT:
+      for (auto child : node.children) {
+        collect_conditions(tree, child, !negate, literal, access);
+      }
+      break;
+    case plansys2_msgs::msg::Node::EXISTS:
+      for (auto child : node.children) {
+        collect_conditions(tree, child, negate, false, access);
+      }
+      break;
+    case plansys2_msgs::msg::Node::PREDICATE:
+      if (!literal) {
+        access.name_reads.insert(node.name);
+      } else if (negate) {
+        access.negative_reads.insert(fact_key(node));
+      } else {
+        access.positive_reads.insert(fact_key(node));
+      }
+      break;
+    case plansys2_msgs::msg::Node::FUNCTION:
+      if (literal) {
+        access.function_reads.insert(fact_key(node));
+      } else {
+        access.name_reads.insert(node.name);
+      }
+      break;
+    case plansys2_msgs::msg::Node::EXPRESSION:
+      for (auto child : node.children) {
+        collect_conditions(tree, child, false, literal, access);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void collect_effects(
+  const plansys2_msgs::msg::Tree & tree, uint32_t node_id, bool negate,
+  ActionAccess & access)
+{
+  if (node_id >= tree.nodes.size()) {
+    return;
+  }
+
+  const auto & node = tree.nodes[node_id];
+  switch (node.node_type) {
+    case plansys2_msgs::msg::Node::AND:
+    case plansys2_msgs::msg::Node::NOT:
+      for (auto child : node.children) {
+        collect_effects(
+          tree, child, negate ^ (node.node_type == plansys2_msgs::msg::Node::NOT), access);
+      }
+      break;
+    case plansys2_msgs::msg::Node::PREDICATE:
+      (negate ? access.deletes : access.adds).insert(fact_key(node));
+      access.name_writes.insert(node.name);
+      break;
+    case plansys2_msgs::msg::Node::FUNCTION_MODIFIER:
+      for (size_t i = 0; i < node.children.size(); i++) {
+        const auto & child = tree.nodes[node.children[i]];
+        if (i == 0 && child.node_type == plansys2_msgs::msg::Node::FUNCTION) {
+          access.function_writes.insert(fact_key(child));
+          access.name_writes.insert(child.name);
+        } else {
+          collect_conditions(tree, node.children[i], false, true, access);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+ActionAccess get_access(const ActionStamped & action)
+{
+  ActionAccess access;
+  collect_conditions(action.action.get_at_start_requirements(), 0, false, true, access);
+
+  ActionAccess start_effects;
+  collect_effects(action.action.get_at_start_effects(), 0, false, start_effects);
+
+  // Conditions achieved by the action itself are not required from the rest
+  ActionAccess later;
+  collect_conditions(action.action.get_overall_requirements(), 0, false, true, later);
+  collect_conditions(action.action.get_at_end_requirements(), 0, false, true, later);
+  for (const auto & fact : later.positive_reads) {
+    if (start_effects.adds.count(fact) == 0) {
+      access.positive_reads.insert(fact);
+    }
+  }
+  for (const auto & fact : later.negative_reads) {
+    if (start_effects.deletes.count(fact) == 0) {
+      access.negative_reads.insert(fact);
+    }
+  }
+  access.function_reads.insert(later.function_reads.begin(), later.function_reads.end());
+  access.name_reads.insert(later.name_reads.begin(), later.name_reads.end());
+
+  collect_effects(action.action.get_at_start_effects(), 0, false, access);
+  collect_effects(action.action.get_at_end_effects(), 0, false, access);
+
+  return access;
+}
+
+// Producers and consumers of a fact. The effects on the fact form alternating runs of adds
+// and deletes: the actions of a run commute, but all of them follow the previous run.
+struct FactIndex
+{
+  bool adding = false;
+  std::vector<size_t> run;
+  std::vector<size_t> previous;
+  std::vector<size_t> positive_readers;  // since the last run of adds, or the first run
+  std::vector<size_t> negative_readers;  // since the last run of deletes, or the first run
+};
+
+struct FunctionIndex
+{
+  std::optional<size_t> writer;
+  std::vector<size_t> readers;  // since the last write
+};
+
+struct NameIndex
+{
+  std::vector<size_t> writers;
+  std::vector<size_t> readers;
+};
+
+class Deordering
+{
+public:
+  explicit Deordering(PartialOrderPlan & plan)
+  : plan_(plan) {}
+
+  void add_action(size_t action, const ActionAccess & access)
+  {
+    using LinkType = PartialOrderPlan::LinkType;
+
+    for (const auto & fact : access.positive_reads) {
+      auto & index = facts_[fact];
+      if (!index.run.empty()) {
+        order(index.run.back(), action, index.adding ? LinkType::CAUSAL : LinkType::THREAT, fact);
+      }
+      index.positive_readers.push_back(action);
+    }
+    for (const auto & fact : access.negative_reads) {
+      auto & index = facts_[fact];
+      if (!index.run.empty()) {
+        order(index.run.back(), action, index.adding ? LinkType::THREAT : LinkType::CAUSAL, fact);
+      }
+      index.negative_readers.push_back(action);
+    }
+    for (const auto & function : access.function_reads) {
+      auto & index = functions_[function];
+      if (index.writer) {
+        order(index.writer.value(), action, LinkType::NUMERIC, function);
+      }
+      index.readers.push_back(action);
+    }
+    for (const auto & name : access.name_reads) {
+      auto & index = names_[name];
+      for (auto writer : index.writers) {
+        order(writer, action, LinkType::CAUSAL, name);
+      }
+      index.readers.push_back(action);
+    }
+
+    for (const auto & fact : access.deletes) {
+      add_effect(action, fact, false);
+    }
+    for (const auto & fact : access.adds) {
+      add_effect(action, fact, true);
+    }
+    for (const auto & function : access.function_writes) {
+      auto & index = functions_[function];
+      if (index.writer) {
+        order(index.writer.value(), action, LinkType::NUMERIC, function);
+      }
+      for (auto reader : index.readers) {
+        order(reader, action, LinkType::NUMERIC, function);
+      }
+      index.writer = action;
+      index.readers.clear();
+    }
+    for (const auto & name : access.name_writes) {
+      auto & index = names_[name];
+      for (auto reader : index.readers) {
+        order(reader, action, LinkType::THREAT, name);
+      }
+      index.writers.push_back(action);
+    }
+  }
+
+private:
+  void add_effect(size_t action, const std::string & fact, bool add)
+  {
+    auto & index = facts_[fact];
+    if (index.run.empty() || index.adding != add) {
+      // The readers of the value this run sets again are ordered before the previous run, so
+      // they precede the new one. Without a previous run, they read the initial value, and
+      // still have to precede the next run of the opposite effect
+      if (!index.run.empty()) {
+        (add ? index.positive_readers : index.negative_readers).clear();
+      }
+      index.previous = std::move(index.run);
+      index.run.clear();
+      index.adding = add;
+    }
+
+    for (auto other : index.previous) {
+      order(other, action, PartialOrderPlan::LinkType::THREAT, fact);
+    }
+    for (auto reader : add ? index.negative_readers : index.positive_readers) {
+      order(reader, action, PartialOrderPlan::LinkType::THREAT, fact);
+    }
+    index.run.push_back(action);
+  }
+
+  void order(
+    size_t from, size_t to, PartialOrderPlan::LinkType type, const std::string & fact)
+  {
+    if (from == to || !added_.insert(std::make_tuple(from, to, fact)).second) {
+      return;
+    }
+    plan_.links.push_back({from, to, type, fact});
+  }
+
+  PartialOrderPlan & plan_;
+  std::unordered_map<std::string, FactIndex> facts_;
+  std::unordered_map<std::string, FunctionIndex> functions_;
+  std::unordered_map<std::string, NameIndex> names_;
+  std::set<std::tuple<size_t, size_t, std::string>> added_;
+};
+
+}  // namespace
+
+PartialOrderPlan deorder_plan(
+  const plansys2_msgs::msg::Plan & plan,
+  const std::vector<ActionStamped> & actions)
+{
+  PartialOrderPlan ret;
+  ret.plan = plan;
+  ret.actions = actions;
+
+  Deordering deordering(ret);
+  for (size_t i = 0; i < actions.size(); i++) {
+    deordering.add_action(i, get_access(actions[i]));
+  }
+
+  // Links always go forward in the plan, so the actions reachable from each action can be
+  // computed backwards, and a link is redundant if it is reachable through an earlier
+  // successor
+  size_t n = actions.size();
+  std::vector<std::vector<size_t>> direct(n);
+  for (const auto & link : ret.links) {
+    direct[link.from].push_back(link.to);
+  }
+
+  std::vector<std::vector<bool>> reachable(n, std::vector<bool>(n, false));
+  ret.predecessors.resize(n);
+  ret.successors.resize(n);
+
+  for (size_t i = n; i > 0; i--) {
+    size_t from = i - 1;
+    auto & successors = direct[from];
+    std::sort(successors.begin(), successors.end());
+    successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+
+    for (auto to : successors) {
+      if (!reachable[from][to]) {
+        ret.successors[from].push_back(to);
+        ret.predecessors[to].push_back(from);
+      }
+      reachable[from][to] = true;
+      for (size_t k = to + 1; k < n; k++) {
+        if (reachable[to][k]) {
+          reachable[from][k] = true;
+        }
+      }
+    }
+  }
+
+  for (auto & predecessors : ret.predecessors) {
+    std::sort(predecessors.begin(), predecessors.end());
+  }
+
+  return ret;
+}
+
+PartialOrderPlan deorder_plan(
+  const plansys2_msgs::msg::Plan & plan,
+  const std::map<std::string, ActionExecutionInfo> & action_map)
+{
+  std::vector<ActionStamped> actions;
+  for (const auto & item : plan.items) {
+    ActionStamped action;
+    action.time = item.time;
+    action.duration = item.duration;
+
+    auto it = action_map.find(BTBuilder::to_action_id(item, 3));
+    if (it != action_map.end()) {
+      action.action = it->second.action_info;
+    }
+    actions.push_back(action);
+  }
+
+  return deorder_plan(plan, actions);
+}
+
+}  // namespace plansys2
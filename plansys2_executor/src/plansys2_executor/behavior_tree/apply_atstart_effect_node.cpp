@@ -33,6 +33,12 @@ ApplyAtStartEffect::ApplyAtStartEffect(
   problem_client_ =
     config().blackboard->get<std::shared_ptr<plansys2::ProblemExpertClient>>(
     "problem_client");
+
+  if (config().blackboard->getEntry("async_problem_client") != nullptr) {
+    async_problem_client_ =
+      config().blackboard->get<std::shared_ptr<plansys2::AsyncProblemClient>>(
+      "async_problem_client");
+  }
 }
 
 BT::NodeStatus
@@ -47,10 +53,18 @@ ApplyAtStartEffect::tick()
 
   auto effect = (*action_map_)[action].action_info.get_at_start_effects();
 
-  if (!(*action_map_)[action].at_start_effects_applied) {
-    (*action_map_)[action].at_start_effects_applied = true;
-    apply(effect, problem_client_, 0);
+  if ((*action_map_)[action].at_start_effects_applied) {
+    return BT::NodeStatus::SUCCESS;
+  }
+
+  auto applied = poll_request<bool>(
+    pending_, async_problem_client_, problem_client_,
+    [effect](std::shared_ptr<ProblemExpertClient> client) {return apply(effect, client, 0);});
+
+  if (!applied) {
+    return BT::NodeStatus::RUNNING;
   }
+  (*action_map_)[action].at_start_effects_applied = true;
 
   return BT::NodeStatus::SUCCESS;
 }
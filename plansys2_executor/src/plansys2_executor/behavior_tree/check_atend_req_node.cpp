@@ -34,6 +34,12 @@ CheckAtEndReq::CheckAtEndReq(
   problem_client_ =
     config().blackboard->get<std::shared_ptr<plansys2::ProblemExpertClient>>(
     "problem_client");
+
+  if (config().blackboard->getEntry("async_problem_client") != nullptr) {
+    async_problem_client_ =
+      config().blackboard->get<std::shared_ptr<plansys2::AsyncProblemClient>>(
+      "async_problem_client");
+  }
 }
 
 BT::NodeStatus
@@ -50,7 +56,15 @@ CheckAtEndReq::tick()
 
   auto reqs = (*action_map_)[action].action_info.get_at_end_requirements();
 
-  if (!check(reqs, problem_client_)) {
+  auto checked = poll_request<bool>(
+    pending_, async_problem_client_, problem_client_,
+    [reqs](std::shared_ptr<ProblemExpertClient> client) {return check(reqs, client);});
+
+  if (!checked) {
+    return BT::NodeStatus::RUNNING;
+  }
+
+  if (!*checked) {
     (*action_map_)[action].execution_error_info = "Error checking at end requirements";
 
     RCLCPP_ERROR_STREAM(
@@ -35,6 +35,12 @@ CheckOverAllReq::CheckOverAllReq(
   problem_client_ =
     config().blackboard->get<std::shared_ptr<plansys2::ProblemExpertClient>>(
     "problem_client");
+
+  if (config().blackboard->getEntry("async_problem_client") != nullptr) {
+    async_problem_client_ =
+      config().blackboard->get<std::shared_ptr<plansys2::AsyncProblemClient>>(
+      "async_problem_client");
+  }
 }
 
 BT::NodeStatus
@@ -47,7 +53,18 @@ CheckOverAllReq::tick()
 
   auto reqs = (*action_map_)[action].action_info.get_overall_requirements();
 
-  if (!check(reqs, problem_client_)) {
+  auto checked = poll_request<bool>(
+    pending_, async_problem_client_, problem_client_,
+    [reqs](std::shared_ptr<ProblemExpertClient> client) {return check(reqs, client);});
+
+  // In a ReactiveSequence, RUNNING would halt the action that follows, so the last result
+  // stands until the new one arrives
+  if (!checked) {
+    return satisfied_ ? BT::NodeStatus::SUCCESS : BT::NodeStatus::RUNNING;
+  }
+  satisfied_ = *checked;
+
+  if (!satisfied_) {
     (*action_map_)[action].execution_error_info = "Error checking over all requirements";
 
     RCLCPP_ERROR_STREAM(
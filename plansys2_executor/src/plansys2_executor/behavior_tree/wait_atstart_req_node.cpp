@@ -16,6 +16,7 @@
 #include <map>
 #include <memory>
 #include <tuple>
+#include <utility>
 
 #include "plansys2_executor/behavior_tree/wait_atstart_req_node.hpp"
 #include "plansys2_msgs/msg/tree.hpp"
@@ -35,6 +36,12 @@ WaitAtStartReq::WaitAtStartReq(
   problem_client_ =
     config().blackboard->get<std::shared_ptr<plansys2::ProblemExpertClient>>(
     "problem_client");
+
+  if (config().blackboard->getEntry("async_problem_client") != nullptr) {
+    async_problem_client_ =
+      config().blackboard->get<std::shared_ptr<plansys2::AsyncProblemClient>>(
+      "async_problem_client");
+  }
 }
 
 BT::NodeStatus
@@ -54,7 +61,18 @@ WaitAtStartReq::tick()
   auto reqs_as = (*action_map_)[action].action_info.get_at_start_requirements();
   auto reqs_oa = (*action_map_)[action].action_info.get_overall_requirements();
 
-  bool check_as = check(reqs_as, problem_client_);
+  auto checked = poll_request<std::pair<bool, bool>>(
+    pending_, async_problem_client_, problem_client_,
+    [reqs_as, reqs_oa](std::shared_ptr<ProblemExpertClient> client) {
+      bool check_as = check(reqs_as, client);
+      return std::make_pair(check_as, check_as && check(reqs_oa, client));
+    });
+
+  if (!checked) {
+    return BT::NodeStatus::RUNNING;
+  }
+
+  auto [check_as, check_oa] = *checked;
   if (!check_as) {
     (*action_map_)[action].execution_error_info = "Error checking at start reqs";
 
@@ -66,7 +84,6 @@ WaitAtStartReq::tick()
     return BT::NodeStatus::RUNNING;
   }
 
-  bool check_oa = check(reqs_oa, problem_client_);
   if (!check_oa) {
     (*action_map_)[action].execution_error_info = "Error checking over all reqs";
 
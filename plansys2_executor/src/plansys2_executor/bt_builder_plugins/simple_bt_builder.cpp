@@ -453,11 +453,95 @@ SimpleBTBuilder::get_graph(const plansys2_msgs::msg::Plan & current_plan)
   return graph;
 }
 
+ActionGraph::Ptr
+SimpleBTBuilder::get_graph(const PartialOrderPlan & plan)
+{
+  int level_counter = 0;
+  auto graph = ActionGraph::make_shared();
+
+  auto init_predicates = problem_client_->getPredicates();
+  auto init_functions = problem_client_->getFunctions();
+
+  // The arcs are the orderings of the plan, no satisfying or contradicting nodes are searched
+  std::vector<ActionNode::Ptr> nodes;
+  for (size_t i = 0; i < plan.actions.size(); i++) {
+    auto new_node = ActionNode::make_shared();
+    new_node->action = plan.actions[i];
+    new_node->node_num = i;
+    new_node->level_num = 0;
+
+    for (auto predecessor : plan.predecessors[i]) {
+      new_node->in_arcs.push_back(nodes[predecessor]);
+      nodes[predecessor]->out_arcs.push_back(new_node);
+    }
+    nodes.push_back(new_node);
+
+    if (new_node->in_arcs.empty()) {
+      graph->roots.push_back(new_node);
+    } else {
+      float time = new_node->action.time;
+      auto level = graph->levels.find(time);
+      if (level == graph->levels.end()) {
+        level_counter++;
+        graph->levels.insert({time, {new_node}});
+      } else {
+        level->second.push_back(new_node);
+      }
+      new_node->level_num = level_counter;
+    }
+
+    // Compute the state up to the new node
+    // The effects of the new node are not applied
+    std::list<ActionNode::Ptr> used_nodes;
+    auto predicates = init_predicates;
+    auto functions = init_functions;
+    get_state(new_node, used_nodes, predicates, functions);
+    new_node->predicates = predicates;
+    new_node->functions = functions;
+
+    // The requirements after the start may be achieved by the node itself
+    std::vector<plansys2_msgs::msg::Tree> requirements;
+    if (!check(new_node->action.action.get_at_start_requirements(), predicates, functions)) {
+      requirements.push_back(new_node->action.action.get_at_start_requirements());
+    }
+    apply(new_node->action.action.get_at_start_effects(), predicates, functions);
+    if (!check(new_node->action.action.get_overall_requirements(), predicates, functions)) {
+      requirements.push_back(new_node->action.action.get_overall_requirements());
+    }
+    if (!check(new_node->action.action.get_at_end_requirements(), predicates, functions)) {
+      requirements.push_back(new_node->action.action.get_at_end_requirements());
+    }
+
+    for (const auto & req : requirements) {
+      std::cerr << "[ERROR] requirement not met: [" <<
+        parser::pddl::toString(req) << "]" << std::endl;
+    }
+
+    if (!requirements.empty()) {
+      return nullptr;
+    }
+  }
+
+  return graph;
+}
+
 std::string
 SimpleBTBuilder::get_tree(const plansys2_msgs::msg::Plan & current_plan)
 {
   graph_ = get_graph(current_plan);
+  return get_tree_from_graph();
+}
 
+std::string
+SimpleBTBuilder::get_tree(const PartialOrderPlan & plan)
+{
+  graph_ = get_graph(plan);
+  return get_tree_from_graph();
+}
+
+std::string
+SimpleBTBuilder::get_tree_from_graph()
+{
   // If graph was not generated, return an empty string.
   // This can be used to fails the serveice call
   if (!graph_) {
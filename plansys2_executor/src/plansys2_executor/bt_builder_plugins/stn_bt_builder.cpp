@@ -77,6 +77,16 @@ CHECK_PREV_ACTIONS
 std::string
 STNBTBuilder::get_tree(const plansys2_msgs::msg::Plan & plan)
 {
+  // Static predicates and functions are equal in every state, so diffs skip them
+  static_predicates_.clear();
+  for (const auto & predicate : domain_client_->getStaticPredicates()) {
+    static_predicates_.insert(predicate.name);
+  }
+  static_functions_.clear();
+  for (const auto & function : domain_client_->getStaticFunctions()) {
+    static_functions_.insert(function.name);
+  }
+
   stn_ = build_stn(plan);
 
   if (!propagate(stn_)) {
@@ -863,6 +873,9 @@ STNBTBuilder::get_diff(
 
   // Look for predicates in X_1 that are not in X_2
   for (const auto & p_1 : X_1.predicates) {
+    if (static_predicates_.count(p_1.name) > 0) {
+      continue;
+    }
     auto it = std::find_if(
       X_2.predicates.begin(), X_2.predicates.end(),
       [&](plansys2::Predicate p_2) {
@@ -875,6 +888,9 @@ STNBTBuilder::get_diff(
 
   // Look for predicates in X_2 that are not in X_1
   for (const auto & p_2 : X_2.predicates) {
+    if (static_predicates_.count(p_2.name) > 0) {
+      continue;
+    }
     auto it = std::find_if(
       X_1.predicates.begin(), X_1.predicates.end(),
       [&](plansys2::Predicate p_1) {
@@ -887,6 +903,9 @@ STNBTBuilder::get_diff(
 
   // Look for function changes
   for (const auto & f_1 : X_1.functions) {
+    if (static_functions_.count(f_1.name) > 0) {
+      continue;
+    }
     auto it = std::find_if(
       X_2.functions.begin(), X_2.functions.end(),
       [&](plansys2::Function f_2) {
@@ -19,6 +19,8 @@
 #include <memory>
 #include <fstream>
 #include <map>
+#include <thread>
+#include <utility>
 
 #include "ament_index_cpp/get_package_share_directory.hpp"
 
@@ -32,6 +34,7 @@
 
 #include "plansys2_executor/ActionExecutor.hpp"
 #include "plansys2_executor/ActionExecutorClient.hpp"
+#include "plansys2_executor/EventQueue.hpp"
 #include "plansys2_executor/ExecutorNode.hpp"
 #include "plansys2_executor/ExecutorClient.hpp"
 #include "plansys2_problem_expert/Utils.hpp"
@@ -346,6 +349,52 @@ TEST(action_execution, protocol_cancelation)
   t.join();
 }
 
+TEST(action_execution, event_queue)
+{
+  plansys2::EventQueue<std::pair<int, int>> queue;
+
+  ASSERT_FALSE(queue.pop());
+  queue.push({0, 0});
+  queue.push({0, 1});
+  ASSERT_EQ(queue.pop().value(), std::make_pair(0, 0));
+  ASSERT_EQ(queue.pop().value(), std::make_pair(0, 1));
+  ASSERT_FALSE(queue.pop());
+
+  const int producers = 4;
+  const int events = 10000;
+
+  std::vector<std::thread> threads;
+  for (int producer = 0; producer < producers; producer++) {
+    threads.emplace_back(
+      [&queue, producer]() {
+        for (int i = 0; i < events; i++) {
+          queue.push({producer, i});
+        }
+      });
+  }
+
+  // The events of each producer are received in order
+  std::vector<int> next(producers, 0);
+  int received = 0;
+  while (received < producers * events) {
+    queue.drain(
+      [&](const std::pair<int, int> & event) {
+        ASSERT_EQ(event.second, next[event.first]);
+        next[event.first]++;
+        received++;
+      });
+  }
+
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_FALSE(queue.pop());
+  for (int producer = 0; producer < producers; producer++) {
+    ASSERT_EQ(next[producer], events);
+  }
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
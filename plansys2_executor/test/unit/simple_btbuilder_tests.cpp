@@ -25,6 +25,7 @@
 
 #include "ament_index_cpp/get_package_share_directory.hpp"
 
+#include "plansys2_domain_expert/DomainExpert.hpp"
 #include "plansys2_domain_expert/DomainExpertNode.hpp"
 #include "plansys2_domain_expert/DomainExpertClient.hpp"
 #include "plansys2_executor/bt_builder_plugins/simple_bt_builder.hpp"
@@ -38,6 +39,7 @@
 #include "plansys2_executor/ActionExecutorClient.hpp"
 #include "plansys2_executor/ExecutorNode.hpp"
 #include "plansys2_executor/ExecutorClient.hpp"
+#include "plansys2_executor/PlanDeordering.hpp"
 
 #include "behaviortree_cpp/behavior_tree.h"
 #include "behaviortree_cpp/bt_factory.h"
@@ -1024,6 +1026,98 @@ TEST(simple_btbuilder_tests, test_plan_6)
   t.join();
 }
 
+TEST(simple_btbuilder_tests, plan_deordering)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_executor");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  plansys2::DomainExpert domain_expert(domain_str);
+
+  auto get_action = [&domain_expert](
+    const std::string & name, const std::vector<std::string> & params, float time) {
+      plansys2::ActionStamped action;
+      action.time = time;
+      action.duration = 5.0;
+      action.action = domain_expert.getDurativeAction(name, params);
+      return action;
+    };
+
+  // A total order where the second robot does not depend on the first one
+  std::vector<plansys2::ActionStamped> actions = {
+    get_action("move", {"r2d2", "kitchen", "bedroom"}, 0.0),
+    get_action("move", {"c3po", "kitchen", "corridor"}, 0.001),
+    get_action("approach", {"r2d2", "bedroom", "paco"}, 5.001),
+    get_action("move", {"c3po", "corridor", "bedroom"}, 5.002),
+    get_action("talk", {"r2d2", "r2d2", "paco", "m1"}, 10.002),
+    get_action("move", {"r2d2", "bedroom", "kitchen"}, 15.002),
+  };
+
+  auto partial_order = plansys2::deorder_plan(plansys2_msgs::msg::Plan(), actions);
+  ASSERT_EQ(partial_order.actions.size(), 6u);
+  ASSERT_TRUE(partial_order.predecessors[0].empty());
+  ASSERT_TRUE(partial_order.predecessors[1].empty());
+  ASSERT_EQ(partial_order.predecessors[2], std::vector<size_t>({0}));
+  ASSERT_EQ(partial_order.predecessors[3], std::vector<size_t>({1}));
+  ASSERT_EQ(partial_order.predecessors[4], std::vector<size_t>({2}));
+  // Leaving the bedroom would break the approach, talk only depends on it transitively
+  ASSERT_EQ(partial_order.predecessors[5], std::vector<size_t>({2}));
+  ASSERT_EQ(partial_order.successors[2], std::vector<size_t>({4, 5}));
+
+  auto threat = std::find_if(
+    partial_order.links.begin(), partial_order.links.end(),
+    [](const plansys2::PartialOrderPlan::Link & link) {
+      return link.from == 2 && link.to == 5;
+    });
+  ASSERT_NE(threat, partial_order.links.end());
+  ASSERT_EQ(threat->type, plansys2::PartialOrderPlan::LinkType::THREAT);
+  ASSERT_EQ(threat->fact, "(robot_at r2d2 bedroom)");
+}
+
+TEST(simple_btbuilder_tests, plan_deordering_initial_readers)
+{
+  auto get_action = [](
+    const std::string & name, const std::string & preconditions, const std::string & effects,
+    float time) {
+      auto action = std::make_shared<plansys2_msgs::msg::Action>();
+      action->name = name;
+      if (!preconditions.empty()) {
+        parser::pddl::fromString(action->preconditions, preconditions);
+      }
+      parser::pddl::fromString(action->effects, effects);
+
+      plansys2::ActionStamped stamped;
+      stamped.time = time;
+      stamped.action = action;
+      return stamped;
+    };
+
+  // The first action reads the initial value, the second one sets it again and the third
+  // one changes it, so the first action must precede the third one
+  std::vector<plansys2::ActionStamped> actions = {
+    get_action("approach", "(and (robot_at r2d2 bedroom))", "(and (robot_near paco))", 0.0),
+    get_action("arrive", "", "(and (robot_at r2d2 bedroom))", 1.0),
+    get_action("leave", "", "(and (not (robot_at r2d2 bedroom)))", 2.0),
+  };
+
+  auto partial_order = plansys2::deorder_plan(plansys2_msgs::msg::Plan(), actions);
+  ASSERT_TRUE(partial_order.predecessors[0].empty());
+  ASSERT_TRUE(partial_order.predecessors[1].empty());
+  ASSERT_EQ(partial_order.predecessors[2], std::vector<size_t>({0, 1}));
+
+  actions = {
+    get_action("enter", "(and (not (robot_at r2d2 bedroom)))", "(and (robot_in r2d2))", 0.0),
+    get_action("leave", "", "(and (not (robot_at r2d2 bedroom)))", 1.0),
+    get_action("arrive", "", "(and (robot_at r2d2 bedroom))", 2.0),
+  };
+
+  partial_order = plansys2::deorder_plan(plansys2_msgs::msg::Plan(), actions);
+  ASSERT_TRUE(partial_order.predecessors[0].empty());
+  ASSERT_TRUE(partial_order.predecessors[1].empty());
+  ASSERT_EQ(partial_order.predecessors[2], std::vector<size_t>({0, 1}));
+}
 
 int main(int argc, char ** argv)
 {
@@ -60,6 +60,15 @@ public:
     }
   }
 
+  // like getSubTypesNames, but also including the subtypes of the subtypes
+  void getAllSubTypesNames(std::vector<std::string> & typesNames) const
+  {
+    for (auto subtype : subtypes) {
+      typesNames.push_back(subtype->name);
+      subtype->getAllSubTypesNames(typesNames);
+    }
+  }
+
   void insertSubtype(Type * t)
   {
     subtypes.push_back(t);
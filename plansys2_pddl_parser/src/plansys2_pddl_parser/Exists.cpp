@@ -57,6 +57,10 @@ plansys2_msgs::msg::Node::SharedPtr Exists::getTree(
     } else {
       param.name = "?" + std::to_string(params[i]);
     }
+    if (i < types.size()) {
+      param.type = d.types[types[i]]->name;
+      d.types[types[i]]->getAllSubTypesNames(param.sub_types);
+    }
     node->parameters.push_back(param);
   }
 
@@ -75,6 +79,7 @@ void Exists::parse(Stringreader & f, TokenStruct<std::string> & ts, Domain & d)
   TokenStruct<std::string> es = f.parseTypedList(true, d.types);
   TokenStruct<std::string> estruct(ts);
   params = incvec(estruct.size(), estruct.size() + es.size());
+  types = d.convertTypes(es.types);
 
   estruct.append(es);
 
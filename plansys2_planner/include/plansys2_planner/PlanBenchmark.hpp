@@ -0,0 +1,82 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PLANNER__PLANBENCHMARK_HPP_
+#define PLANSYS2_PLANNER__PLANBENCHMARK_HPP_
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "plansys2_msgs/msg/plan.hpp"
+
+namespace plansys2
+{
+
+/// A domain and problem pair of a benchmark corpus.
+struct BenchmarkCase
+{
+  std::string name;  // path of the problem in the corpus, without extension
+  std::string domain_path;
+  std::string problem_path;
+};
+
+/// Result of running a plan solver plugin on a benchmark case.
+struct BenchmarkResult
+{
+  std::string plugin;
+  std::optional<std::string> arguments;  // not set if the plugin defaults were used
+  BenchmarkCase benchmark_case;
+
+  // solved, unsolved, timeout, cpu_limit, memory_limit, crashed or error
+  std::string status;
+  double solve_time = 0.0;  // seconds, wall time of getPlan
+  double cpu_time = 0.0;  // seconds, user and system time of the run, solver processes included
+  long peak_rss = 0;  // kB, of the largest process of the run
+  size_t plan_length = 0;
+  double makespan = 0.0;
+};
+
+/// Find the domain and problem pairs of a corpus.
+/**
+ * Every .pddl file whose name contains "domain" is a domain, and the rest are problems. Each
+ * problem is paired with the domain of its directory whose name, once "domain" and "problem"
+ * are removed, is the longest prefix of its own, so that domain.pddl goes with every problem,
+ * p01-domain.pddl with p01.pddl, and domain_simple.pddl with problem_simple_1.pddl.
+ * Subdirectories are searched recursively.
+ *
+ * \param[in] corpus_path The directory of the corpus.
+ * \return The cases, sorted by name. Problems without a domain are ignored.
+ */
+std::vector<BenchmarkCase> find_benchmark_cases(const std::string & corpus_path);
+
+/// Time at which the last action of a plan ends.
+double get_makespan(const plansys2_msgs::msg::Plan & plan);
+
+/// Report of a benchmark as CSV, with a header and a row per result.
+/**
+ * The plan length and makespan are left empty when no plan was found.
+ */
+std::string benchmark_report_csv(const std::vector<BenchmarkResult> & results);
+
+/// Report of a benchmark as a JSON array, with an object per result.
+/**
+ * The plan length and makespan are null when no plan was found, as the arguments when the
+ * plugin defaults were used.
+ */
+std::string benchmark_report_json(const std::vector<BenchmarkResult> & results);
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PLANNER__PLANBENCHMARK_HPP_
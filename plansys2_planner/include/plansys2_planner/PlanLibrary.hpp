@@ -0,0 +1,125 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PLANNER__PLANLIBRARY_HPP_
+#define PLANSYS2_PLANNER__PLANLIBRARY_HPP_
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "plansys2_domain_expert/DomainExpert.hpp"
+#include "plansys2_msgs/msg/plan.hpp"
+#include "plansys2_problem_expert/ProblemExpert.hpp"
+
+namespace plansys2
+{
+
+/// Library of solved cases, to reuse their plans in problems of the same kind.
+/**
+ * Plans are stored in lifted form: the objects of the problem are replaced by variables, and
+ * the domain constants are kept. Each case is indexed by the pattern of its goal, the names
+ * of its goal predicates, and keeps the facts of the initial state that its actions require,
+ * as "fetch ?x from ?a to ?b" requires the robot to be at ?a.
+ *
+ * To retrieve a plan, the cases with the goal pattern of a problem are matched against it,
+ * newest first: their goal must map onto the goal of the problem and their required facts
+ * onto its initial state, each variable to a different object of the same type. The plans
+ * instantiated by these bindings are validated from the initial state of the problem, and
+ * the first valid one is returned. Only goals that are conjunctions of predicates are stored.
+ *
+ * This class is thread-safe.
+ */
+class PlanLibrary
+{
+public:
+  explicit PlanLibrary(size_t capacity = 100);
+
+  /// Store a plan that solves a problem. The oldest case is dropped when the library is full.
+  /**
+   * \param[in] domain_expert The domain.
+   * \param[in] problem_expert The problem.
+   * \param[in] plan The plan, valid for the problem.
+   * \return false if the goal of the problem is not supported, or the plan was already stored.
+   */
+  bool store(
+    const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+    const plansys2_msgs::msg::Plan & plan);
+
+  /// Get a plan for a problem from the stored cases.
+  /**
+   * \param[in] domain_expert The domain.
+   * \param[in] problem_expert The problem.
+   * \return A valid plan for the problem, or nullopt if no case can be reused.
+   */
+  std::optional<plansys2_msgs::msg::Plan> retrieve(
+    const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert);
+
+  size_t size() const;
+  void clear();
+
+private:
+  struct Atom
+  {
+    std::string name;
+    std::vector<int> args;  // variable of each argument, -1 if it is a constant
+    std::vector<std::string> constants;
+  };
+
+  struct Step
+  {
+    Atom action;
+    float time;
+    float duration;
+  };
+
+  struct Case
+  {
+    std::vector<std::string> types;  // of each variable
+    std::vector<Atom> goal;
+    std::vector<Atom> requirements;
+    std::vector<Step> steps;
+    std::string signature;
+  };
+
+  struct Problem;
+
+  std::optional<std::string> get_pattern(
+    const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+    std::vector<std::vector<std::string>> & goal) const;
+
+  bool match(
+    const Case & lifted, size_t atom, Problem & problem,
+    std::optional<plansys2_msgs::msg::Plan> & plan) const;
+
+  bool bind(
+    const Case & lifted, const Atom & atom, const std::vector<std::string> & fact,
+    Problem & problem, std::vector<int> & bound) const;
+
+  size_t capacity_;
+  std::unordered_map<std::string, std::deque<Case>> cases_;  // by goal pattern, oldest first
+  std::deque<std::string> patterns_;  // of each case, oldest first
+  std::unordered_set<std::string> signatures_;
+
+  mutable std::mutex mutex_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PLANNER__PLANLIBRARY_HPP_
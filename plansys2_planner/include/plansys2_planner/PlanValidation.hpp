@@ -0,0 +1,83 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PLANNER__PLANVALIDATION_HPP_
+#define PLANSYS2_PLANNER__PLANVALIDATION_HPP_
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "plansys2_domain_expert/DomainExpert.hpp"
+#include "plansys2_msgs/msg/plan.hpp"
+#include "plansys2_msgs/msg/state_fingerprint.hpp"
+#include "plansys2_problem_expert/ProblemExpert.hpp"
+
+namespace plansys2
+{
+
+/// Check that a plan can be executed from the initial state of a problem and achieves its goal.
+/**
+ * The plan is simulated over the happenings of its actions in time order, the ends before the
+ * starts at the same time: the at start and at end conditions are checked when each action
+ * starts and ends, and the over all conditions after every happening while it runs.
+ * Derived predicates are not inferred, so plans relying on them are not valid.
+ *
+ * \param[in] domain_expert The domain.
+ * \param[in] problem_expert The problem.
+ * \param[in] plan The plan.
+ * \param[out] error_info Why the plan is not valid.
+ * \return true if the plan is valid.
+ */
+bool validate_plan(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  const plansys2_msgs::msg::Plan & plan, std::string & error_info);
+
+/// Check that a plan is valid, and get the fingerprint of the state it leads to.
+/**
+ * The fingerprint is hashed as the problem expert hashes its state, so it can be compared to
+ * the fingerprint of the problem expert once the plan is executed, if both use the same
+ * function quantum (the fingerprint_function_quantum parameter of the problem expert).
+ *
+ * \param[in] domain_expert The domain.
+ * \param[in] problem_expert The problem.
+ * \param[in] plan The plan.
+ * \param[out] error_info Why the plan is not valid.
+ * \param[out] final_state The fingerprint of the state at the end of the plan, if it is valid.
+ * \param[in] function_quantum The quantum of the function values, or 0 for exact values.
+ * \return true if the plan is valid.
+ */
+bool validate_plan(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  const plansys2_msgs::msg::Plan & plan, std::string & error_info,
+  plansys2_msgs::msg::StateFingerprint & final_state, double function_quantum = 0.0);
+
+/// Find the longest part of a plan that is still valid for a problem.
+/**
+ * When replanning after some actions of a plan have been executed, the remaining actions are
+ * often still a valid plan. The suffixes of the plan, in time order, are validated from the
+ * longest one, and the first valid one is returned with its times shifted to start at 0.
+ *
+ * \param[in] domain_expert The domain.
+ * \param[in] problem_expert The problem.
+ * \param[in] plan The plan.
+ * \return The longest valid suffix of the plan, or nullopt if there is none.
+ */
+std::optional<plansys2_msgs::msg::Plan> find_valid_suffix(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  const plansys2_msgs::msg::Plan & plan);
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PLANNER__PLANVALIDATION_HPP_
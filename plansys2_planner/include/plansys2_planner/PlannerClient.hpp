@@ -22,6 +22,7 @@
 #include "plansys2_planner/PlannerInterface.hpp"
 
 #include "plansys2_msgs/srv/get_plan.hpp"
+#include "plansys2_msgs/srv/get_plans.hpp"
 
 #include "rclcpp/rclcpp.hpp"
 
@@ -37,9 +38,36 @@ public:
     const std::string & domain, const std::string & problem,
     const std::string & node_namespace = "");
 
+  /// Get a plan, using a previous plan as a hint.
+  /**
+   * \param[in] domain The PDDL domain.
+   * \param[in] problem The PDDL problem.
+   * \param[in] hint A plan for a similar problem, as the previous plan when replanning. It is
+   *    returned, or the part of it still to be executed, if it is valid for the problem.
+   * \param[in] node_namespace The node namespace.
+   * \return The plan, or nullopt if no plan was found.
+   */
+  std::optional<plansys2_msgs::msg::Plan> getPlan(
+    const std::string & domain, const std::string & problem,
+    const plansys2_msgs::msg::Plan & hint, const std::string & node_namespace = "");
+
+  /// Solve variants of a problem concurrently in the planner.
+  /**
+   * \param[in] domain The PDDL domain.
+   * \param[in] problem The base PDDL problem.
+   * \param[in] variants The changes to the initial state and the goal of each variant.
+   * \param[in] costs_only If true, the plans are not returned, only their costs.
+   * \return The result of each variant, in the same order, or nullopt if the request failed.
+   */
+  std::optional<std::vector<plansys2_msgs::msg::PlanVariantResult>> getPlans(
+    const std::string & domain, const std::string & problem,
+    const std::vector<plansys2_msgs::msg::PlanVariant> & variants, bool costs_only = false);
+
 private:
   rclcpp::Client<plansys2_msgs::srv::GetPlan>::SharedPtr
     get_plan_client_;
+  rclcpp::Client<plansys2_msgs::srv::GetPlans>::SharedPtr
+    get_plans_client_;
 
   rclcpp::Node::SharedPtr node_;
   rclcpp::Duration solver_timeout_ = rclcpp::Duration(15, 0);
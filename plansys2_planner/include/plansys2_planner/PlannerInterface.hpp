@@ -17,8 +17,11 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "plansys2_msgs/msg/plan.hpp"
+#include "plansys2_msgs/msg/plan_variant.hpp"
+#include "plansys2_msgs/msg/plan_variant_result.hpp"
 
 namespace plansys2
 {
@@ -31,6 +34,14 @@ public:
   virtual std::optional<plansys2_msgs::msg::Plan> getPlan(
     const std::string & domain, const std::string & problem,
     const std::string & node_namespace) = 0;
+
+  virtual std::optional<plansys2_msgs::msg::Plan> getPlan(
+    const std::string & domain, const std::string & problem,
+    const plansys2_msgs::msg::Plan & hint, const std::string & node_namespace) = 0;
+
+  virtual std::optional<std::vector<plansys2_msgs::msg::PlanVariantResult>> getPlans(
+    const std::string & domain, const std::string & problem,
+    const std::vector<plansys2_msgs::msg::PlanVariant> & variants, bool costs_only) = 0;
 };
 
 }  // namespace plansys2
@@ -20,15 +20,19 @@
 #include <string>
 #include <vector>
 
+#include "plansys2_domain_expert/DomainExpert.hpp"
 #include "plansys2_domain_expert/DomainExpertClient.hpp"
+#include "plansys2_problem_expert/ProblemExpert.hpp"
 #include "plansys2_problem_expert/ProblemExpertClient.hpp"
 
 #include "plansys2_core/PlanSolverBase.hpp"
+#include "plansys2_planner/PlanLibrary.hpp"
 
 #include "std_msgs/msg/empty.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "lifecycle_msgs/msg/transition.hpp"
 #include "plansys2_msgs/srv/get_plan.hpp"
+#include "plansys2_msgs/srv/get_plans.hpp"
 #include "plansys2_msgs/srv/validate_domain.hpp"
 
 #include "rclcpp/rclcpp.hpp"
@@ -62,22 +66,39 @@ public:
     const std::shared_ptr<plansys2_msgs::srv::GetPlan::Request> request,
     const std::shared_ptr<plansys2_msgs::srv::GetPlan::Response> response);
 
+  void get_plans_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::GetPlans::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::GetPlans::Response> response);
+
   void validate_domain_service_callback(
     const std::shared_ptr<rmw_request_id_t> request_header,
     const std::shared_ptr<plansys2_msgs::srv::ValidateDomain::Request> request,
     const std::shared_ptr<plansys2_msgs::srv::ValidateDomain::Response> response);
 
 private:
+  void solve_variant(
+    const std::string & domain, const std::shared_ptr<DomainExpert> & domain_expert,
+    const ProblemExpert & base_problem, const plansys2_msgs::msg::PlanVariant & variant,
+    PlanSolverBase & solver, const std::string & solver_namespace, bool costs_only,
+    plansys2_msgs::msg::PlanVariantResult & result);
+
   pluginlib::ClassLoader<plansys2::PlanSolverBase> lp_loader_;
   SolverMap solvers_;
+  std::vector<PlanSolverBase::Ptr> worker_solvers_;  // of the get_plans workers
   std::vector<std::string> default_ids_;
   std::vector<std::string> default_types_;
   std::vector<std::string> solver_ids_;
   std::vector<std::string> solver_types_;
   rclcpp::Duration solver_timeout_;
+  bool reachability_check_;
+  int plan_workers_;
+  std::unique_ptr<PlanLibrary> plan_library_;
 
   rclcpp::Service<plansys2_msgs::srv::GetPlan>::SharedPtr
     get_plan_service_;
+  rclcpp::Service<plansys2_msgs::srv::GetPlans>::SharedPtr
+    get_plans_service_;
   rclcpp::Service<plansys2_msgs::srv::ValidateDomain>::SharedPtr
     validate_domain_service_;
 };
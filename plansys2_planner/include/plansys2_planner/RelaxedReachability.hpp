@@ -0,0 +1,128 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PLANNER__RELAXEDREACHABILITY_HPP_
+#define PLANSYS2_PLANNER__RELAXEDREACHABILITY_HPP_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "plansys2_msgs/msg/node.hpp"
+#include "plansys2_msgs/msg/param.hpp"
+#include "plansys2_msgs/msg/tree.hpp"
+
+namespace plansys2
+{
+
+class DomainExpert;
+class ProblemExpert;
+
+/// Delete-relaxation reachability analysis of the goal of a problem.
+/**
+ * Builds the relaxed planning graph of the problem, ignoring the delete effects, the negative
+ * and numeric conditions and the disjunctions of the actions, until the goal holds or no more
+ * facts are reachable. This over-approximates the reachable facts, so a goal atom that is not
+ * reached can not be achieved by any plan, and the solver does not need to be called.
+ *
+ * Actions are grounded by joining their positive preconditions with the facts reached so far,
+ * so only applicable groundings are built. Durative actions take the conditions not achieved
+ * by their own at start effects. Derived predicates are closed after each layer.
+ */
+class RelaxedReachability
+{
+public:
+  RelaxedReachability(const std::string & domain, const std::string & problem);
+
+  /// Analyze a problem already parsed, as the variants of a problem do.
+  RelaxedReachability(
+    const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert);
+
+  /// false if the domain or the problem could not be parsed, so nothing can be concluded.
+  bool isValid() const {return valid_;}
+
+  /// Why the domain or the problem could not be analyzed. Empty if it is valid.
+  const std::string & getError() const {return error_;}
+
+  bool isGoalReachable() const {return reachable_;}
+
+  /// Goal atoms not reached, as "(predicate arg1 arg2)". Empty if the goal is reachable.
+  const std::vector<std::string> & getUnreachableGoals() const {return unreachable_goals_;}
+
+  /// Layers of the relaxed planning graph needed to reach the goal, -1 if it is unreachable.
+  /**
+   * This is the h_max estimate of the problem, a lower bound of the sequential actions of
+   * any plan.
+   */
+  int getEstimate() const {return estimate_;}
+
+  size_t getNumReachedFacts() const {return levels_.size();}
+
+private:
+  struct Literal
+  {
+    std::string name;
+    std::vector<int> args;  // parameter index of each argument, -1 if it is an object
+    std::vector<std::string> objects;
+  };
+
+  struct Schema
+  {
+    std::vector<std::vector<std::string>> candidates;  // typed objects of each parameter
+    std::vector<Literal> preconditions;
+    std::vector<Literal> effects;
+  };
+
+  void analyze(const std::string & domain, const std::string & problem);
+  void analyze(
+    const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert);
+  Schema make_schema(
+    const std::vector<plansys2_msgs::msg::Param> & parameters,
+    const std::vector<plansys2_msgs::msg::Node> & preconditions,
+    const std::vector<plansys2_msgs::msg::Node> & effects);
+  Literal make_literal(
+    const plansys2_msgs::msg::Node & node,
+    const std::vector<plansys2_msgs::msg::Param> & parameters);
+
+  void expand(
+    const Schema & schema, size_t literal, std::vector<std::string> & values,
+    std::vector<std::vector<std::string>> & produced) const;
+  void emit(
+    const Schema & schema, size_t parameter, std::vector<std::string> & values,
+    std::vector<std::vector<std::string>> & produced) const;
+
+  bool add_fact(const std::vector<std::string> & fact, int level);
+  bool holds(const plansys2_msgs::msg::Tree & tree, uint32_t node_id) const;
+  void collect_unreached(const plansys2_msgs::msg::Tree & tree, uint32_t node_id);
+
+  std::unordered_map<std::string, std::vector<std::string>> objects_;  // by type
+  std::vector<Schema> actions_;
+  std::vector<Schema> derived_;
+
+  // Reached facts, as {name, args...}, by predicate name
+  std::unordered_map<std::string, std::vector<std::vector<std::string>>> facts_;
+  std::unordered_map<std::string, int> levels_;
+
+  bool valid_;
+  std::string error_;
+  bool reachable_;
+  std::vector<std::string> unreachable_goals_;
+  int estimate_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PLANNER__RELAXEDREACHABILITY_HPP_
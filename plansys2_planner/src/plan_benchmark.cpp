@@ -0,0 +1,394 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Runs plan solver plugins over a corpus of PDDL domain and problem pairs:
+//
+//   ros2 run plansys2_planner plan_benchmark <corpus dir> [options] [--ros-args ...]
+//
+// Each run is a process of its own, with its own resource limits, that loads the plugin and
+// configures it on a lifecycle node without services. Plugin parameters other than the
+// arguments can be set as ROS parameters of the "solver" plugin, as -p solver.output_dir:=...
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "plansys2_core/PlanSolverBase.hpp"
+#include "plansys2_planner/PlanBenchmark.hpp"
+
+#include "pluginlib/class_loader.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+
+namespace
+{
+
+const char kSolverId[] = "solver";
+
+struct Options
+{
+  std::string corpus;
+  std::vector<std::string> plugins;
+  std::vector<std::optional<std::string>> arguments;
+  size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  double timeout = 15.0;
+  double cpu_limit = 0.0;
+  double memory_limit = 0.0;
+  std::string output;
+  std::string format;
+};
+
+struct Run
+{
+  size_t result;
+  int fd;
+  std::chrono::steady_clock::time_point start;
+  bool killed;
+};
+
+volatile std::sig_atomic_t interrupted = 0;
+
+void print_usage()
+{
+  std::cerr <<
+    "Usage: plan_benchmark <corpus dir> [options] [--ros-args ...]\n"
+    "  --plugin TYPE         Plan solver plugin, can be repeated "
+    "(default plansys2/POPFPlanSolver)\n"
+    "  --arguments ARGS      Value of the arguments parameter of the plugins, can be repeated\n"
+    "  --jobs N              Runs in parallel (default: number of cores)\n"
+    "  --timeout S           Solver timeout of each run, in seconds (default 15)\n"
+    "  --cpu-limit S         CPU time limit of each solver process, in seconds\n"
+    "  --memory-limit MB     Address space limit of each solver process, in MB\n"
+    "  --output FILE         Report file (default: standard output)\n"
+    "  --format csv|json     Report format (default: from the output extension, or csv)\n";
+}
+
+bool parse_options(const std::vector<std::string> & args, Options & options)
+{
+  try {
+    for (size_t i = 1; i < args.size(); i++) {
+      const auto & arg = args[i];
+      bool has_value = i + 1 < args.size();
+
+      if (arg == "--plugin" && has_value) {
+        options.plugins.push_back(args[++i]);
+      } else if (arg == "--arguments" && has_value) {
+        options.arguments.push_back(args[++i]);
+      } else if (arg == "--jobs" && has_value) {
+        options.jobs = std::max(1, std::stoi(args[++i]));
+      } else if (arg == "--timeout" && has_value) {
+        options.timeout = std::stod(args[++i]);
+      } else if (arg == "--cpu-limit" && has_value) {
+        options.cpu_limit = std::stod(args[++i]);
+      } else if (arg == "--memory-limit" && has_value) {
+        options.memory_limit = std::stod(args[++i]);
+      } else if (arg == "--output" && has_value) {
+        options.output = args[++i];
+      } else if (arg == "--format" && has_value) {
+        options.format = args[++i];
+      } else if (arg.rfind("--", 0) != 0 && options.corpus.empty()) {
+        options.corpus = arg;
+      } else {
+        std::cerr << "Invalid option " << arg << std::endl;
+        return false;
+      }
+    }
+  } catch (const std::logic_error &) {
+    std::cerr << "Invalid numeric value" << std::endl;
+    return false;
+  }
+
+  if (options.plugins.empty()) {
+    options.plugins.push_back("plansys2/POPFPlanSolver");
+  }
+  if (options.arguments.empty()) {
+    options.arguments.push_back(std::nullopt);
+  }
+  if (options.format.empty()) {
+    auto dot = options.output.rfind('.');
+    options.format = dot != std::string::npos && options.output.substr(dot) == ".json" ?
+      "json" : "csv";
+  }
+
+  return !options.corpus.empty() && (options.format == "csv" || options.format == "json");
+}
+
+std::string read_file(const std::string & path)
+{
+  std::ifstream ifs(path);
+  return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+// Body of the process of a run. Writes "status solve_time plan_length makespan" to fd.
+void run_case(
+  int argc, char ** argv, const Options & options, const plansys2::BenchmarkResult & result,
+  size_t index, int fd)
+{
+  // Its own process group, so that the solver processes it starts can be killed with it
+  setpgid(0, 0);
+
+  if (options.cpu_limit > 0.0) {
+    rlimit limit;
+    limit.rlim_cur = static_cast<rlim_t>(options.cpu_limit + 0.5);
+    limit.rlim_max = limit.rlim_cur + 1;
+    setrlimit(RLIMIT_CPU, &limit);
+  }
+  if (options.memory_limit > 0.0) {
+    rlimit limit;
+    limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(options.memory_limit * 1024 * 1024);
+    setrlimit(RLIMIT_AS, &limit);
+  }
+
+  std::string status = "error";
+  double solve_time = 0.0;
+  size_t plan_length = 0;
+  double makespan = 0.0;
+
+  try {
+    rclcpp::init(argc, argv, rclcpp::InitOptions(), rclcpp::SignalHandlerOptions::None);
+
+    auto node = std::make_shared<rclcpp_lifecycle::LifecycleNode>(
+      "plan_benchmark_" + std::to_string(index));
+    pluginlib::ClassLoader<plansys2::PlanSolverBase> loader(
+      "plansys2_core", "plansys2::PlanSolverBase");
+
+    auto solver = loader.createUniqueInstance(result.plugin);
+    solver->configure(node, kSolverId);
+
+    if (result.arguments) {
+      std::string arguments_param = std::string(kSolverId) + ".arguments";
+      if (node->has_parameter(arguments_param)) {
+        node->set_parameter({arguments_param, result.arguments.value()});
+      } else {
+        RCLCPP_WARN(
+          node->get_logger(), "Plugin %s has no arguments parameter", result.plugin.c_str());
+      }
+    }
+
+    auto domain = read_file(result.benchmark_case.domain_path);
+    auto problem = read_file(result.benchmark_case.problem_path);
+
+    auto start = std::chrono::steady_clock::now();
+    auto plan = solver->getPlan(
+      domain, problem, "/plan_benchmark/run_" + std::to_string(index),
+      rclcpp::Duration::from_seconds(options.timeout));
+    solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    status = plan ? "solved" : "unsolved";
+    if (plan) {
+      plan_length = plan.value().items.size();
+      makespan = plansys2::get_makespan(plan.value());
+    }
+  } catch (const std::bad_alloc &) {
+    status = "memory_limit";
+  } catch (const pluginlib::PluginlibException & ex) {
+    std::cerr << "Failed to load plugin " << result.plugin << ": " << ex.what() << std::endl;
+  } catch (const std::exception & ex) {
+    std::cerr << "Run " << result.benchmark_case.name << " failed: " << ex.what() << std::endl;
+  }
+
+  auto line = status + " " + std::to_string(solve_time) + " " + std::to_string(plan_length) +
+    " " + std::to_string(makespan) + "\n";
+  [[maybe_unused]] auto written = write(fd, line.c_str(), line.size());
+  close(fd);
+
+  rclcpp::shutdown();
+}
+
+void collect_run(
+  const Run & run, int wait_status, const rusage & usage, const Options & options,
+  plansys2::BenchmarkResult & result)
+{
+  std::string output;
+  char buffer[256];
+  ssize_t n;
+  while ((n = read(run.fd, buffer, sizeof(buffer))) > 0) {
+    output.append(buffer, n);
+  }
+  close(run.fd);
+
+  result.cpu_time = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+    usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+  result.peak_rss = usage.ru_maxrss;
+
+  std::istringstream iss(output);
+  if (iss >> result.status >> result.solve_time >> result.plan_length >> result.makespan) {
+    return;
+  }
+
+  if (run.killed) {
+    result.status = "timeout";
+    result.solve_time = options.timeout;
+  } else if (WIFSIGNALED(wait_status) && options.cpu_limit > 0.0 &&  // NOLINT
+    (WTERMSIG(wait_status) == SIGXCPU || WTERMSIG(wait_status) == SIGKILL))  // NOLINT
+  {
+    result.status = "cpu_limit";
+  } else {
+    result.status = "crashed";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  // The runs are forked from this process, so ROS is only initialized in them
+  std::vector<std::string> args = rclcpp::remove_ros_arguments(argc, argv);
+
+  Options options;
+  if (!parse_options(args, options)) {
+    print_usage();
+    return 1;
+  }
+
+  auto cases = plansys2::find_benchmark_cases(options.corpus);
+  if (cases.empty()) {
+    std::cerr << "No domain and problem pairs found in " << options.corpus << std::endl;
+    return 1;
+  }
+
+  std::vector<plansys2::BenchmarkResult> results;
+  for (const auto & plugin : options.plugins) {
+    for (const auto & arguments : options.arguments) {
+      for (const auto & benchmark_case : cases) {
+        plansys2::BenchmarkResult result;
+        result.plugin = plugin;
+        result.arguments = arguments;
+        result.benchmark_case = benchmark_case;
+        results.push_back(result);
+      }
+    }
+  }
+
+  std::signal(SIGINT, [](int) {interrupted = 1;});
+  std::signal(SIGTERM, [](int) {interrupted = 1;});
+
+  std::map<pid_t, Run> running;
+  size_t next = 0;
+  size_t finished = 0;
+
+  while ((next < results.size() || !running.empty()) && !interrupted) {
+    while (running.size() < options.jobs && next < results.size()) {
+      int fds[2];
+      if (pipe2(fds, O_CLOEXEC) != 0) {
+        std::cerr << "Failed to create pipe" << std::endl;
+        return 1;
+      }
+
+      pid_t pid = fork();
+      if (pid == 0) {
+        close(fds[0]);
+        run_case(argc, argv, options, results[next], next, fds[1]);
+        _exit(0);
+      }
+      close(fds[1]);
+
+      if (pid < 0) {
+        close(fds[0]);
+        std::cerr << "Failed to start run" << std::endl;
+        return 1;
+      }
+
+      setpgid(pid, pid);
+      running[pid] = {next++, fds[0], std::chrono::steady_clock::now(), false};
+    }
+
+    int wait_status;
+    rusage usage;
+    pid_t pid = wait4(-1, &wait_status, WNOHANG, &usage);
+
+    if (pid > 0) {
+      auto it = running.find(pid);
+      if (it == running.end()) {
+        continue;
+      }
+
+      auto & result = results[it->second.result];
+      collect_run(it->second, wait_status, usage, options, result);
+      killpg(pid, SIGKILL);  // Solver processes left behind
+      running.erase(it);
+
+      std::cerr << "[" << ++finished << "/" << results.size() << "] " << result.plugin <<
+        " " << result.benchmark_case.name << ": " << result.status << " (" <<
+        result.solve_time << " s)" << std::endl;
+    } else {
+      // The solver is given one second beyond its timeout to give up by itself
+      auto now = std::chrono::steady_clock::now();
+      for (auto & [run_pid, run] : running) {
+        if (!run.killed &&
+          std::chrono::duration<double>(now - run.start).count() > options.timeout + 1.0)
+        {
+          killpg(run_pid, SIGKILL);
+          run.killed = true;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  if (interrupted) {
+    for (const auto & [pid, run] : running) {
+      killpg(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+      close(run.fd);
+    }
+    std::cerr << "Interrupted" << std::endl;
+    return 1;
+  }
+
+  // Summary of each configuration
+  std::map<std::pair<std::string, std::string>, std::pair<size_t, double>> solved;
+  for (const auto & result : results) {
+    auto & entry = solved[{result.plugin, result.arguments.value_or("<default>")}];
+    if (result.status == "solved") {
+      entry.first++;
+      entry.second += result.solve_time;
+    }
+  }
+  for (const auto & [config, entry] : solved) {
+    std::cerr << config.first << " [" << config.second << "]: " << entry.first << "/" <<
+      cases.size() << " solved in " << entry.second << " s" << std::endl;
+  }
+
+  auto report = options.format == "json" ?
+    plansys2::benchmark_report_json(results) : plansys2::benchmark_report_csv(results);
+
+  if (options.output.empty()) {
+    std::cout << report;
+  } else {
+    std::ofstream out(options.output);
+    out << report;
+    if (!out) {
+      std::cerr << "Failed to write " << options.output << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,218 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_planner/PlanBenchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace plansys2
+{
+
+namespace
+{
+
+// Name of a file without the "domain" or "problem" word and the separators around it
+std::string pairing_key(const std::string & stem, const std::string & word)
+{
+  std::string key = stem;
+  auto pos = key.find(word);
+  if (pos != std::string::npos) {
+    key.erase(pos, word.size());
+  }
+
+  const std::string separators = "_-. ";
+  auto first = key.find_first_not_of(separators);
+  if (first == std::string::npos) {
+    return "";
+  }
+  auto last = key.find_last_not_of(separators);
+  return key.substr(first, last - first + 1);
+}
+
+std::string csv_field(const std::string & value)
+{
+  if (value.find_first_of(",\"\n\r") == std::string::npos) {
+    return value;
+  }
+
+  std::string ret = "\"";
+  for (auto c : value) {
+    if (c == '"') {
+      ret += '"';
+    }
+    ret += c;
+  }
+  return ret + "\"";
+}
+
+std::string json_string(const std::string & value)
+{
+  std::string ret = "\"";
+  for (auto c : value) {
+    switch (c) {
+      case '"': ret += "\\\""; break;
+      case '\\': ret += "\\\\"; break;
+      case '\n': ret += "\\n"; break;
+      case '\r': ret += "\\r"; break;
+      case '\t': ret += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          ret += escaped;
+        } else {
+          ret += c;
+        }
+    }
+  }
+  return ret + "\"";
+}
+
+std::string number(double value)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.6g", value);
+  return buffer;
+}
+
+}  // namespace
+
+std::vector<BenchmarkCase> find_benchmark_cases(const std::string & corpus_path)
+{
+  namespace fs = std::filesystem;
+
+  std::vector<BenchmarkCase> ret;
+
+  std::error_code ec;
+  if (!fs::is_directory(corpus_path, ec)) {
+    return ret;
+  }
+
+  // Domains and problems of each directory, by their pairing key
+  std::map<fs::path, std::map<std::string, fs::path>> domains;
+  std::map<fs::path, std::vector<std::pair<std::string, fs::path>>> problems;
+
+  for (auto it = fs::recursive_directory_iterator(
+      corpus_path, fs::directory_options::follow_directory_symlink, ec);
+    !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+  {
+    const auto & path = it->path();
+    if (!it->is_regular_file(ec) || path.extension() != ".pddl") {
+      continue;
+    }
+
+    auto stem = path.stem().string();
+    if (stem.find("domain") != std::string::npos) {
+      domains[path.parent_path()][pairing_key(stem, "domain")] = path;
+    } else {
+      problems[path.parent_path()].push_back({pairing_key(stem, "problem"), path});
+    }
+  }
+
+  for (const auto & [directory, directory_problems] : problems) {
+    auto domains_it = domains.find(directory);
+    if (domains_it == domains.end()) {
+      continue;
+    }
+
+    for (const auto & [key, problem] : directory_problems) {
+      const fs::path * domain = nullptr;
+      size_t matched = 0;
+      for (const auto & [domain_key, domain_path] : domains_it->second) {
+        if (key.compare(0, domain_key.size(), domain_key) == 0 &&
+          (domain == nullptr || domain_key.size() > matched))
+        {
+          domain = &domain_path;
+          matched = domain_key.size();
+        }
+      }
+
+      if (domain != nullptr) {
+        auto name = fs::relative(problem, corpus_path, ec);
+        ret.push_back(
+          {(ec ? problem.stem() : name.replace_extension()).string(),
+            domain->string(), problem.string()});
+      }
+    }
+  }
+
+  std::sort(
+    ret.begin(), ret.end(), [](const BenchmarkCase & a, const BenchmarkCase & b) {
+      return a.name < b.name;
+    });
+
+  return ret;
+}
+
+double get_makespan(const plansys2_msgs::msg::Plan & plan)
+{
+  double ret = 0.0;
+  for (const auto & item : plan.items) {
+    ret = std::max(ret, static_cast<double>(item.time + item.duration));
+  }
+  return ret;
+}
+
+std::string benchmark_report_csv(const std::vector<BenchmarkResult> & results)
+{
+  std::string ret =
+    "plugin,arguments,problem,domain_file,problem_file,status,solve_time,cpu_time,peak_rss,"
+    "plan_length,makespan\n";
+
+  for (const auto & result : results) {
+    bool solved = result.status == "solved";
+    ret += csv_field(result.plugin) + "," + csv_field(result.arguments.value_or("")) + "," +
+      csv_field(result.benchmark_case.name) + "," +
+      csv_field(result.benchmark_case.domain_path) + "," +
+      csv_field(result.benchmark_case.problem_path) + "," + result.status + "," +
+      number(result.solve_time) + "," + number(result.cpu_time) + "," +
+      std::to_string(result.peak_rss) + "," +
+      (solved ? std::to_string(result.plan_length) : "") + "," +
+      (solved ? number(result.makespan) : "") + "\n";
+  }
+
+  return ret;
+}
+
+std::string benchmark_report_json(const std::vector<BenchmarkResult> & results)
+{
+  std::string ret = "[";
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto & result = results[i];
+    bool solved = result.status == "solved";
+    ret += std::string(i == 0 ? "" : ",") + "\n  {" +
+      "\"plugin\": " + json_string(result.plugin) + ", " +
+      "\"arguments\": " +
+      (result.arguments ? json_string(result.arguments.value()) : "null") + ", " +
+      "\"problem\": " + json_string(result.benchmark_case.name) + ", " +
+      "\"domain_file\": " + json_string(result.benchmark_case.domain_path) + ", " +
+      "\"problem_file\": " + json_string(result.benchmark_case.problem_path) + ", " +
+      "\"status\": " + json_string(result.status) + ", " +
+      "\"solve_time\": " + number(result.solve_time) + ", " +
+      "\"cpu_time\": " + number(result.cpu_time) + ", " +
+      "\"peak_rss\": " + std::to_string(result.peak_rss) + ", " +
+      "\"plan_length\": " + (solved ? std::to_string(result.plan_length) : "null") + ", " +
+      "\"makespan\": " + (solved ? number(result.makespan) : "null") + "}";
+  }
+
+  return ret + (results.empty() ? "]\n" : "\n]\n");
+}
+
+}  // namespace plansys2
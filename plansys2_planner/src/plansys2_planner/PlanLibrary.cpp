@@ -0,0 +1,420 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_planner/PlanLibrary.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "plansys2_planner/PlanValidation.hpp"
+#include "plansys2_problem_expert/Utils.hpp"
+
+namespace plansys2
+{
+
+namespace
+{
+
+// Instantiated plans validated at most in each retrieval, as bindings can be many
+constexpr size_t kMaxAttempts = 64;
+
+std::string fact_key(const std::vector<std::string> & fact)
+{
+  std::string ret = "(" + fact[0];
+  for (size_t i = 1; i < fact.size(); i++) {
+    ret += " " + fact[i];
+  }
+  return ret + ")";
+}
+
+// Positive predicates of a conjunction, which must hold for the tree to hold
+void collect_facts(
+  const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+  std::vector<std::vector<std::string>> & facts)
+{
+  if (node_id >= tree.nodes.size()) {
+    return;
+  }
+
+  const auto & node = tree.nodes[node_id];
+  if (node.node_type == plansys2_msgs::msg::Node::AND) {
+    for (auto child : node.children) {
+      collect_facts(tree, child, facts);
+    }
+  } else if (node.node_type == plansys2_msgs::msg::Node::PREDICATE && !node.negate) {
+    std::vector<std::string> fact = {node.name};
+    for (const auto & param : node.parameters) {
+      fact.push_back(param.name);
+    }
+    facts.push_back(fact);
+  }
+}
+
+}  // namespace
+
+// The problem a case is matched against, and the current binding of its variables
+struct PlanLibrary::Problem
+{
+  std::shared_ptr<DomainExpert> domain_expert;
+  ProblemExpert * problem_expert;
+  std::vector<std::vector<std::string>> goal;
+  std::unordered_map<std::string, std::vector<std::vector<std::string>>> facts;  // by name
+  std::unordered_map<std::string, std::string> types;  // of each object
+  std::unordered_map<std::string, std::vector<std::string>> objects;  // by type
+  std::vector<std::string> binding;  // object of each variable, empty if unbound
+  std::unordered_set<std::string> used;
+  size_t attempts = 0;
+};
+
+PlanLibrary::PlanLibrary(size_t capacity)
+: capacity_(capacity)
+{
+}
+
+std::optional<std::string>
+PlanLibrary::get_pattern(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  std::vector<std::vector<std::string>> & goal) const
+{
+  auto tree = problem_expert.getGoal();
+  if (tree.nodes.empty()) {
+    return {};
+  }
+
+  // Every node must be in the conjunction, or the goal has more than its predicates
+  collect_facts(tree, 0, goal);
+  size_t conjunctions = std::count_if(
+    tree.nodes.begin(), tree.nodes.end(), [](const plansys2_msgs::msg::Node & node) {
+      return node.node_type == plansys2_msgs::msg::Node::AND;
+    });
+  if (goal.empty() || goal.size() + conjunctions != tree.nodes.size()) {
+    return {};
+  }
+
+  std::vector<std::string> names;
+  for (const auto & fact : goal) {
+    names.push_back(fact[0]);
+  }
+  std::sort(names.begin(), names.end());
+
+  std::string pattern = domain_expert->getName() + ":";
+  for (const auto & name : names) {
+    pattern += " " + name;
+  }
+  return pattern;
+}
+
+bool
+PlanLibrary::store(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  const plansys2_msgs::msg::Plan & plan)
+{
+  std::vector<std::vector<std::string>> goal;
+  auto pattern = get_pattern(domain_expert, problem_expert, goal);
+  if (!pattern) {
+    return false;
+  }
+
+  std::unordered_map<std::string, std::string> types;
+  for (const auto & instance : problem_expert.getInstances()) {
+    types[instance.name] = instance.type;
+  }
+
+  std::unordered_set<std::string> init;
+  for (const auto & predicate : problem_expert.getPredicates()) {
+    std::vector<std::string> fact = {predicate.name};
+    for (const auto & param : predicate.parameters) {
+      fact.push_back(param.name);
+    }
+    init.insert(fact_key(fact));
+  }
+
+  Case lifted;
+  std::unordered_map<std::string, int> variables;
+  auto lift = [&](const std::vector<std::string> & fact) {
+      Atom atom;
+      atom.name = fact[0];
+      for (size_t i = 1; i < fact.size(); i++) {
+        auto type = types.find(fact[i]);
+        if (type == types.end()) {
+          atom.args.push_back(-1);
+          atom.constants.push_back(fact[i]);
+          continue;
+        }
+
+        auto variable = variables.find(fact[i]);
+        if (variable == variables.end()) {
+          variable = variables.insert({fact[i], lifted.types.size()}).first;
+          lifted.types.push_back(type->second);
+        }
+        atom.args.push_back(variable->second);
+        atom.constants.push_back("");
+      }
+      return atom;
+    };
+
+  for (const auto & fact : goal) {
+    lifted.goal.push_back(lift(fact));
+  }
+
+  std::unordered_set<std::string> required;
+  for (const auto & item : plan.items) {
+    std::vector<std::string> action = {get_action_name(item.action)};
+    auto params = get_action_params(item.action);
+    action.insert(action.end(), params.begin(), params.end());
+    lifted.steps.push_back({lift(action), item.time, item.duration});
+
+    // The facts of the initial state the action requires are what the case needs to apply
+    std::vector<std::vector<std::string>> requirements;
+    if (auto durative = domain_expert->getDurativeAction(action[0], params)) {
+      collect_facts(durative->at_start_requirements, 0, requirements);
+      collect_facts(durative->over_all_requirements, 0, requirements);
+      collect_facts(durative->at_end_requirements, 0, requirements);
+    } else if (auto instantaneous = domain_expert->getAction(action[0], params)) {
+      collect_facts(instantaneous->preconditions, 0, requirements);
+    } else {
+      return false;
+    }
+
+    for (const auto & fact : requirements) {
+      auto key = fact_key(fact);
+      if (init.count(key) && required.insert(key).second) {
+        lifted.requirements.push_back(lift(fact));
+      }
+    }
+  }
+
+  // The signature identifies the case regardless of the objects it was solved with
+  auto describe = [](const Atom & atom) {
+      std::string ret = " (" + atom.name;
+      for (size_t i = 0; i < atom.args.size(); i++) {
+        ret += " " + (atom.args[i] < 0 ? atom.constants[i] : "?" + std::to_string(atom.args[i]));
+      }
+      return ret + ")";
+    };
+
+  lifted.signature = pattern.value();
+  for (const auto & atom : lifted.requirements) {
+    lifted.signature += describe(atom);
+  }
+  for (const auto & step : lifted.steps) {
+    lifted.signature += describe(step.action) + ":" + std::to_string(step.time);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (capacity_ == 0 || !signatures_.insert(lifted.signature).second) {
+    return false;
+  }
+
+  cases_[pattern.value()].push_back(lifted);
+  patterns_.push_back(pattern.value());
+
+  while (patterns_.size() > capacity_) {
+    auto & oldest = cases_[patterns_.front()];
+    signatures_.erase(oldest.front().signature);
+    oldest.pop_front();
+    if (oldest.empty()) {
+      cases_.erase(patterns_.front());
+    }
+    patterns_.pop_front();
+  }
+
+  return true;
+}
+
+std::optional<plansys2_msgs::msg::Plan>
+PlanLibrary::retrieve(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert)
+{
+  Problem problem;
+  auto pattern = get_pattern(domain_expert, problem_expert, problem.goal);
+  if (!pattern) {
+    return {};
+  }
+
+  std::deque<Case> candidates;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cases_.find(pattern.value());
+    if (it == cases_.end()) {
+      return {};
+    }
+    candidates = it->second;
+  }
+
+  problem.domain_expert = domain_expert;
+  problem.problem_expert = &problem_expert;
+  for (const auto & instance : problem_expert.getInstances()) {
+    problem.types[instance.name] = instance.type;
+    problem.objects[instance.type].push_back(instance.name);
+  }
+  for (const auto & predicate : problem_expert.getPredicates()) {
+    std::vector<std::string> fact = {predicate.name};
+    for (const auto & param : predicate.parameters) {
+      fact.push_back(param.name);
+    }
+    problem.facts[predicate.name].push_back(fact);
+  }
+
+  for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+    problem.binding.assign(it->types.size(), "");
+    problem.used.clear();
+
+    std::optional<plansys2_msgs::msg::Plan> plan;
+    if (match(*it, 0, problem, plan)) {
+      return plan;
+    }
+  }
+
+  return {};
+}
+
+bool
+PlanLibrary::match(
+  const Case & lifted, size_t atom, Problem & problem,
+  std::optional<plansys2_msgs::msg::Plan> & plan) const
+{
+  // The goal is matched first, then the required facts, and then the variables left
+  size_t num_goal = lifted.goal.size();
+  size_t num_atoms = num_goal + lifted.requirements.size();
+
+  if (atom < num_atoms) {
+    const auto & current = atom < num_goal ? lifted.goal[atom] :
+      lifted.requirements[atom - num_goal];
+    const auto & facts = atom < num_goal ? problem.goal : problem.facts[current.name];
+
+    for (const auto & fact : facts) {
+      std::vector<int> bound;
+      if (bind(lifted, current, fact, problem, bound)) {
+        bool stop = match(lifted, atom + 1, problem, plan);
+        for (auto variable : bound) {
+          problem.used.erase(problem.binding[variable]);
+          problem.binding[variable].clear();
+        }
+        if (stop) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  size_t variable = atom - num_atoms;
+  if (variable < lifted.types.size()) {
+    if (!problem.binding[variable].empty()) {
+      return match(lifted, atom + 1, problem, plan);
+    }
+
+    for (const auto & object : problem.objects[lifted.types[variable]]) {
+      if (problem.used.count(object)) {
+        continue;
+      }
+      problem.binding[variable] = object;
+      problem.used.insert(object);
+      bool stop = match(lifted, atom + 1, problem, plan);
+      problem.used.erase(object);
+      problem.binding[variable].clear();
+      if (stop) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  plansys2_msgs::msg::Plan candidate;
+  for (const auto & step : lifted.steps) {
+    plansys2_msgs::msg::PlanItem item;
+    item.action = "(" + step.action.name;
+    for (size_t i = 0; i < step.action.args.size(); i++) {
+      item.action += " " + (step.action.args[i] < 0 ? step.action.constants[i] :
+        problem.binding[step.action.args[i]]);
+    }
+    item.action += ")";
+    item.time = step.time;
+    item.duration = step.duration;
+    candidate.items.push_back(item);
+  }
+
+  std::string error_info;
+  if (validate_plan(problem.domain_expert, *problem.problem_expert, candidate, error_info)) {
+    plan = candidate;
+    return true;
+  }
+
+  return ++problem.attempts >= kMaxAttempts;
+}
+
+bool
+PlanLibrary::bind(
+  const Case & lifted, const Atom & atom, const std::vector<std::string> & fact,
+  Problem & problem, std::vector<int> & bound) const
+{
+  bool ok = fact[0] == atom.name && fact.size() == atom.args.size() + 1;
+
+  for (size_t i = 0; ok && i < atom.args.size(); i++) {
+    const auto & object = fact[i + 1];
+    int variable = atom.args[i];
+
+    if (variable < 0) {
+      ok = atom.constants[i] == object;
+    } else if (!problem.binding[variable].empty()) {
+      ok = problem.binding[variable] == object;
+    } else {
+      auto type = problem.types.find(object);
+      ok = type != problem.types.end() && type->second == lifted.types[variable] &&
+        problem.used.count(object) == 0;
+      if (ok) {
+        problem.binding[variable] = object;
+        problem.used.insert(object);
+        bound.push_back(variable);
+      }
+    }
+  }
+
+  if (!ok) {
+    for (auto variable : bound) {
+      problem.used.erase(problem.binding[variable]);
+      problem.binding[variable].clear();
+    }
+    bound.clear();
+  }
+
+  return ok;
+}
+
+size_t
+PlanLibrary::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return patterns_.size();
+}
+
+void
+PlanLibrary::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  cases_.clear();
+  patterns_.clear();
+  signatures_.clear();
+}
+
+}  // namespace plansys2
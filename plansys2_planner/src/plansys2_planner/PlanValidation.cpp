@@ -0,0 +1,224 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_planner/PlanValidation.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "plansys2_problem_expert/ForkableState.hpp"
+#include "plansys2_problem_expert/StateFingerprint.hpp"
+#include "plansys2_problem_expert/Utils.hpp"
+
+namespace plansys2
+{
+
+namespace
+{
+
+// An action of the plan, grounded. Instantaneous actions only have start conditions and effects.
+struct GroundAction
+{
+  std::string expression;
+  bool durative;
+  double start;
+  double end;
+  plansys2_msgs::msg::Tree at_start_requirements;
+  plansys2_msgs::msg::Tree over_all_requirements;
+  plansys2_msgs::msg::Tree at_end_requirements;
+  plansys2_msgs::msg::Tree at_start_effects;
+  plansys2_msgs::msg::Tree at_end_effects;
+};
+
+struct Happening
+{
+  double time;
+  bool start;
+  size_t action;
+};
+
+// The actions of the plan in time order, or nullopt if some action is not in the domain
+std::optional<std::vector<GroundAction>> ground_plan(
+  const std::shared_ptr<DomainExpert> & domain_expert, const plansys2_msgs::msg::Plan & plan,
+  std::string & error_info)
+{
+  std::vector<GroundAction> ret;
+
+  for (const auto & item : plan.items) {
+    GroundAction action;
+    action.expression = item.action;
+    action.start = item.time;
+    action.end = item.time + item.duration;
+
+    auto name = get_action_name(item.action);
+    auto params = get_action_params(item.action);
+
+    if (auto durative = domain_expert->getDurativeAction(name, params)) {
+      action.durative = true;
+      action.at_start_requirements = durative->at_start_requirements;
+      action.over_all_requirements = durative->over_all_requirements;
+      action.at_end_requirements = durative->at_end_requirements;
+      action.at_start_effects = durative->at_start_effects;
+      action.at_end_effects = durative->at_end_effects;
+    } else if (auto instantaneous = domain_expert->getAction(name, params)) {
+      action.durative = false;
+      action.end = action.start;
+      action.at_start_requirements = instantaneous->preconditions;
+      action.at_start_effects = instantaneous->effects;
+    } else {
+      error_info = "Unknown action " + item.action;
+      return {};
+    }
+
+    ret.push_back(action);
+  }
+
+  std::stable_sort(
+    ret.begin(), ret.end(), [](const GroundAction & a, const GroundAction & b) {
+      return a.start < b.start;
+    });
+
+  return ret;
+}
+
+bool simulate(
+  ProblemExpert & problem_expert, const std::vector<GroundAction> & actions, size_t first,
+  std::string & error_info, plansys2_msgs::msg::StateFingerprint * final_state = nullptr,
+  double function_quantum = 0.0)
+{
+  ForkableState state(problem_expert.getPredicates(), problem_expert.getFunctions());
+
+  std::vector<Happening> happenings;
+  for (size_t i = first; i < actions.size(); i++) {
+    happenings.push_back({actions[i].start, true, i});
+    if (actions[i].durative) {
+      happenings.push_back({actions[i].end, false, i});
+    }
+  }
+
+  // Ends go before starts at the same time, so an action can use what the previous achieved
+  std::stable_sort(
+    happenings.begin(), happenings.end(), [](const Happening & a, const Happening & b) {
+      return a.time < b.time || (a.time == b.time && !a.start && b.start);
+    });
+
+  std::set<size_t> running;
+  for (const auto & happening : happenings) {
+    const auto & action = actions[happening.action];
+
+    if (happening.start) {
+      if (!state.check(action.at_start_requirements)) {
+        error_info = "At start requirements of " + action.expression + " not met";
+        return false;
+      }
+      if (!state.apply(action.at_start_effects)) {
+        error_info = "At start effects of " + action.expression + " failed";
+        return false;
+      }
+      if (action.durative) {
+        running.insert(happening.action);
+      }
+    } else {
+      if (!state.check(action.at_end_requirements)) {
+        error_info = "At end requirements of " + action.expression + " not met";
+        return false;
+      }
+      running.erase(happening.action);
+      if (!state.apply(action.at_end_effects)) {
+        error_info = "At end effects of " + action.expression + " failed";
+        return false;
+      }
+    }
+
+    for (auto other : running) {
+      if (!state.check(actions[other].over_all_requirements)) {
+        error_info = "Over all requirements of " + actions[other].expression + " not met";
+        return false;
+      }
+    }
+  }
+
+  if (!state.check(problem_expert.getGoal())) {
+    error_info = "Goal not achieved";
+    return false;
+  }
+
+  // The state keeps its fingerprint with exact values, a quantum needs a new hash
+  if (final_state != nullptr && function_quantum > 0.0) {
+    *final_state = StateFingerprint::compute(
+      state.getPredicates(), state.getFunctions(), function_quantum);
+  } else if (final_state != nullptr) {
+    *final_state = state.getFingerprint();
+  }
+
+  return true;
+}
+
+}  // namespace
+
+bool validate_plan(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  const plansys2_msgs::msg::Plan & plan, std::string & error_info)
+{
+  auto actions = ground_plan(domain_expert, plan, error_info);
+  return actions && simulate(problem_expert, actions.value(), 0, error_info);
+}
+
+bool validate_plan(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  const plansys2_msgs::msg::Plan & plan, std::string & error_info,
+  plansys2_msgs::msg::StateFingerprint & final_state, double function_quantum)
+{
+  auto actions = ground_plan(domain_expert, plan, error_info);
+  return actions &&
+         simulate(problem_expert, actions.value(), 0, error_info, &final_state, function_quantum);
+}
+
+std::optional<plansys2_msgs::msg::Plan> find_valid_suffix(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert,
+  const plansys2_msgs::msg::Plan & plan)
+{
+  std::string error_info;
+  auto actions = ground_plan(domain_expert, plan, error_info);
+  if (!actions) {
+    return {};
+  }
+
+  auto items = plan.items;
+  std::stable_sort(
+    items.begin(), items.end(),
+    [](const plansys2_msgs::msg::PlanItem & a, const plansys2_msgs::msg::PlanItem & b) {
+      return a.time < b.time;
+    });
+
+  for (size_t first = 0; first <= items.size(); first++) {
+    if (simulate(problem_expert, actions.value(), first, error_info)) {
+      plansys2_msgs::msg::Plan ret;
+      float offset = first < items.size() ? items[first].time : 0.0f;
+      for (size_t i = first; i < items.size(); i++) {
+        ret.items.push_back(items[i]);
+        ret.items.back().time -= offset;
+      }
+      return ret;
+    }
+  }
+
+  return {};
+}
+
+}  // namespace plansys2
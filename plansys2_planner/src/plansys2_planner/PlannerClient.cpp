@@ -28,6 +28,7 @@ PlannerClient::PlannerClient()
   node_ = rclcpp::Node::make_shared("planner_client");
 
   get_plan_client_ = node_->create_client<plansys2_msgs::srv::GetPlan>("planner/get_plan");
+  get_plans_client_ = node_->create_client<plansys2_msgs::srv::GetPlans>("planner/get_plans");
 
   double timeout;
   node_->declare_parameter("plan_solver_timeout", timeout);
@@ -43,6 +44,14 @@ std::optional<plansys2_msgs::msg::Plan>
 PlannerClient::getPlan(
   const std::string & domain, const std::string & problem,
   const std::string & node_namespace)
+{
+  return getPlan(domain, problem, plansys2_msgs::msg::Plan(), node_namespace);
+}
+
+std::optional<plansys2_msgs::msg::Plan>
+PlannerClient::getPlan(
+  const std::string & domain, const std::string & problem,
+  const plansys2_msgs::msg::Plan & hint, const std::string & node_namespace)
 {
   while (!get_plan_client_->wait_for_service(std::chrono::seconds(30))) {
     if (!rclcpp::ok()) {
@@ -67,6 +76,7 @@ PlannerClient::getPlan(
   auto request = std::make_shared<plansys2_msgs::srv::GetPlan::Request>();
   request->domain = domain;
   request->problem = problem;
+  request->hint = hint;
 
   auto future_result = get_plan_client_->async_send_request(request);
 
@@ -95,4 +105,54 @@ PlannerClient::getPlan(
   }
 }
 
+std::optional<std::vector<plansys2_msgs::msg::PlanVariantResult>>
+PlannerClient::getPlans(
+  const std::string & domain, const std::string & problem,
+  const std::vector<plansys2_msgs::msg::PlanVariant> & variants, bool costs_only)
+{
+  while (!get_plans_client_->wait_for_service(std::chrono::seconds(30))) {
+    if (!rclcpp::ok()) {
+      return {};
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      get_plans_client_->get_service_name() <<
+        " service  client: waiting for service to appear...");
+  }
+
+  auto request = std::make_shared<plansys2_msgs::srv::GetPlans::Request>();
+  request->domain = domain;
+  request->problem = problem;
+  request->variants = variants;
+  request->costs_only = costs_only;
+
+  // The variants are solved in parallel, but there may be more variants than workers
+  auto future_result = get_plans_client_->async_send_request(request);
+
+  auto outresult = rclcpp::spin_until_future_complete(
+    node_, future_result,
+    std::chrono::seconds(static_cast<int32_t>(solver_timeout_.seconds())) *
+    std::max<size_t>(variants.size(), 1));
+  if (outresult != rclcpp::FutureReturnCode::SUCCESS) {
+    if (outresult == rclcpp::FutureReturnCode::TIMEOUT) {
+      RCLCPP_ERROR(node_->get_logger(), "Get Plans service call timed out");
+    } else {
+      RCLCPP_ERROR(node_->get_logger(), "Get Plans service call failed");
+    }
+    return {};
+  }
+
+  auto result = *future_result.get();
+
+  if (result.success) {
+    return result.results;
+  } else {
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      get_plans_client_->get_service_name() << ": " <<
+        result.error_info);
+    return {};
+  }
+}
+
 }  // namespace plansys2
@@ -12,15 +12,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
 #include <string>
 #include <memory>
+#include <optional>
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <vector>
 
+#include "plansys2_planner/PlanBenchmark.hpp"
+#include "plansys2_planner/PlanLibrary.hpp"
+#include "plansys2_planner/PlanValidation.hpp"
 #include "plansys2_planner/PlannerNode.hpp"
+#include "plansys2_planner/RelaxedReachability.hpp"
 #include "plansys2_popf_plan_solver/popf_plan_solver.hpp"
 
 #include "lifecycle_msgs/msg/state.hpp"
+#include "rcl_interfaces/srv/list_parameters.hpp"
 
 using namespace std::chrono_literals;
 
@@ -32,11 +44,17 @@ PlannerNode::PlannerNode()
   lp_loader_("plansys2_core", "plansys2::PlanSolverBase"),
   default_ids_{},
   default_types_{},
-  solver_timeout_(15s)
+  solver_timeout_(15s),
+  reachability_check_(true),
+  plan_workers_(0)
 {
   declare_parameter("plan_solver_plugins", default_ids_);
   double timeout = solver_timeout_.seconds();
   declare_parameter("plan_solver_timeout", timeout);
+  declare_parameter("reachability_check", reachability_check_);
+  declare_parameter("plan_workers", plan_workers_);
+  declare_parameter("plan_library", false);
+  declare_parameter("plan_library_size", 100);
 }
 
 
@@ -53,6 +71,23 @@ PlannerNode::on_configure(const rclcpp_lifecycle::State & state)
 
   get_parameter("plan_solver_plugins", solver_ids_);
   get_parameter("plan_solver_timeout", timeout);
+  get_parameter("reachability_check", reachability_check_);
+  get_parameter("plan_workers", plan_workers_);
+
+  bool plan_library;
+  int plan_library_size;
+  get_parameter("plan_library", plan_library);
+  get_parameter("plan_library_size", plan_library_size);
+
+  if (plan_workers_ <= 0) {
+    plan_workers_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  if (plan_library) {
+    plan_library_ = std::make_unique<PlanLibrary>(std::max(plan_library_size, 0));
+  } else {
+    plan_library_ = nullptr;
+  }
 
   solver_timeout_ = rclcpp::Duration((int32_t)timeout, 0);
 
@@ -92,6 +127,38 @@ PlannerNode::on_configure(const rclcpp_lifecycle::State & state)
       "POPF", "plansys2/POPFPlanSolver");
   }
 
+  // The get_plans workers call the solver concurrently, and solvers are not required to be
+  // reentrant, so each worker has its own instance
+  const auto & worker_solver_id = solvers_.begin()->first;
+  auto worker_solver_it = std::find(solver_ids_.begin(), solver_ids_.end(), worker_solver_id);
+
+  worker_solvers_.clear();
+  for (int i = 0; i < plan_workers_; i++) {
+    plansys2::PlanSolverBase::Ptr solver;
+    if (worker_solver_it != solver_ids_.end()) {
+      solver = lp_loader_.createUniqueInstance(
+        solver_types_[worker_solver_it - solver_ids_.begin()]);
+    } else {
+      solver = std::make_shared<plansys2::POPFPlanSolver>();
+    }
+
+    // Plugins declare their parameters when configured, so each worker has its own name and
+    // takes the values of the parameters of the solver it copies
+    auto worker_id = worker_solver_id + ".worker_" + std::to_string(i);
+    solver->configure(node, worker_id);
+
+    auto worker_parameters = list_parameters(
+      {worker_id}, rcl_interfaces::srv::ListParameters::Request::DEPTH_RECURSIVE);
+    for (const auto & name : worker_parameters.names) {
+      auto source = worker_solver_id + name.substr(worker_id.size());
+      if (has_parameter(source)) {
+        set_parameter(rclcpp::Parameter(name, get_parameter(source).get_parameter_value()));
+      }
+    }
+
+    worker_solvers_.push_back(solver);
+  }
+
   RCLCPP_INFO(get_logger(), "[%s] Solver Timeout %g", get_name(), solver_timeout_.seconds());
 
   get_plan_service_ = create_service<plansys2_msgs::srv::GetPlan>(
@@ -101,6 +168,13 @@ PlannerNode::on_configure(const rclcpp_lifecycle::State & state)
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
+  get_plans_service_ = create_service<plansys2_msgs::srv::GetPlans>(
+    "planner/get_plans",
+    std::bind(
+      &PlannerNode::get_plans_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+
   validate_domain_service_ = create_service<plansys2_msgs::srv::ValidateDomain>(
     "planner/validate_domain",
     std::bind(
@@ -161,8 +235,80 @@ PlannerNode::get_plan_service_callback(
   const std::shared_ptr<plansys2_msgs::srv::GetPlan::Request> request,
   const std::shared_ptr<plansys2_msgs::srv::GetPlan::Response> response)
 {
-  auto plan = solvers_.begin()->second->getPlan(
-    request->domain, request->problem, get_namespace(), solver_timeout_);
+  std::shared_ptr<DomainExpert> domain_expert;
+  std::shared_ptr<ProblemExpert> problem_expert;
+
+  if (!request->hint.items.empty() || reachability_check_ || plan_library_) {
+    domain_expert = std::make_shared<DomainExpert>(request->domain);
+    problem_expert = std::make_shared<ProblemExpert>(domain_expert);
+
+    if (!problem_expert->addProblem(request->problem)) {
+      problem_expert = nullptr;
+    }
+  }
+
+  if (problem_expert) {
+    // After a small change of the state, the previous plan, or what remains of it, is
+    // usually still valid
+    if (!request->hint.items.empty()) {
+      if (auto plan = find_valid_suffix(domain_expert, *problem_expert, request->hint)) {
+        RCLCPP_DEBUG(
+          get_logger(), "Hint plan still valid, %zu of its actions skipped",
+          request->hint.items.size() - plan.value().items.size());
+        response->success = true;
+        response->plan = plan.value();
+        response->from_hint = true;
+        return;
+      }
+    }
+
+    if (plan_library_) {
+      if (auto plan = plan_library_->retrieve(domain_expert, *problem_expert)) {
+        RCLCPP_DEBUG(get_logger(), "Plan reused from the plan library");
+        response->success = true;
+        response->plan = plan.value();
+        return;
+      }
+    }
+
+    if (reachability_check_) {
+      // Goals unreachable even ignoring the delete effects would make the solver run until
+      // it fails or times out
+      RelaxedReachability reachability(domain_expert, *problem_expert);
+
+      if (reachability.isValid() && !reachability.isGoalReachable()) {
+        response->success = false;
+        response->error_info = "Goal unreachable:";
+        for (const auto & goal : reachability.getUnreachableGoals()) {
+          response->error_info += " " + goal;
+        }
+        RCLCPP_WARN_STREAM(get_logger(), response->error_info);
+        return;
+      }
+
+      if (reachability.isValid()) {
+        RCLCPP_DEBUG_STREAM(
+          get_logger(), "Goal reachable in " << reachability.getEstimate() <<
+            " relaxed layers (" << reachability.getNumReachedFacts() << " facts reached)");
+      } else {
+        RCLCPP_WARN(
+          get_logger(), "Reachability check skipped: %s", reachability.getError().c_str());
+      }
+    }
+  }
+
+  const auto & solver = solvers_.begin()->second;
+  std::optional<plansys2_msgs::msg::Plan> plan;
+  if (request->hint.items.empty()) {
+    plan = solver->getPlan(request->domain, request->problem, get_namespace(), solver_timeout_);
+  } else {
+    plan = solver->getPlanWithHint(
+      request->domain, request->problem, request->hint, get_namespace(), solver_timeout_);
+  }
+
+  if (plan && plan_library_ && problem_expert) {
+    plan_library_->store(domain_expert, *problem_expert, plan.value());
+  }
 
   if (plan) {
     response->success = true;
@@ -173,6 +319,122 @@ PlannerNode::get_plan_service_callback(
   }
 }
 
+void
+PlannerNode::get_plans_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::GetPlans::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::GetPlans::Response> response)
+{
+  // The domain and the base problem are parsed once, and each variant is built on a copy
+  auto domain_expert = std::make_shared<DomainExpert>(request->domain);
+  ProblemExpert base_problem(domain_expert);
+
+  if (!base_problem.addProblem(request->problem)) {
+    response->success = false;
+    response->error_info = "Problem not valid";
+    return;
+  }
+
+  response->results.resize(request->variants.size());
+
+  // Each worker has its own namespace, as solvers write their files in it
+  std::string base_namespace = get_namespace();
+  if (base_namespace.back() != '/') {
+    base_namespace += "/";
+  }
+
+  std::atomic<size_t> next_variant(0);
+  auto worker = [&](PlanSolverBase & solver, const std::string & solver_namespace) {
+      for (size_t i = next_variant++; i < request->variants.size(); i = next_variant++) {
+        solve_variant(
+          request->domain, domain_expert, base_problem, request->variants[i], solver,
+          solver_namespace, request->costs_only, response->results[i]);
+      }
+    };
+
+  size_t num_workers = std::min(worker_solvers_.size(), request->variants.size());
+  std::vector<std::future<void>> workers;
+  for (size_t i = 0; i < num_workers; i++) {
+    workers.push_back(
+      std::async(
+        std::launch::async, worker, std::ref(*worker_solvers_[i]),
+        base_namespace + "get_plans_" + std::to_string(i)));
+  }
+  for (auto & running_worker : workers) {
+    running_worker.get();
+  }
+
+  response->success = true;
+}
+
+void
+PlannerNode::solve_variant(
+  const std::string & domain, const std::shared_ptr<DomainExpert> & domain_expert,
+  const ProblemExpert & base_problem, const plansys2_msgs::msg::PlanVariant & variant,
+  PlanSolverBase & solver, const std::string & solver_namespace, bool costs_only,
+  plansys2_msgs::msg::PlanVariantResult & result)
+{
+  result.id = variant.id;
+  result.success = false;
+
+  ProblemExpert problem(base_problem);
+
+  if (!variant.changes.empty()) {
+    uint64_t revision;
+    if (problem.applyChangesIf(variant.changes, 0, plansys2_msgs::msg::Tree(), revision) !=
+      ConditionalUpdateResult::APPLIED)
+    {
+      result.error_info = "Invalid change";
+      return;
+    }
+  }
+
+  if (!variant.goal.nodes.empty() && !problem.setGoal(variant.goal)) {
+    result.error_info = "Invalid goal";
+    return;
+  }
+
+  if (reachability_check_) {
+    RelaxedReachability reachability(domain_expert, problem);
+
+    if (reachability.isValid() && !reachability.isGoalReachable()) {
+      result.error_info = "Goal unreachable:";
+      for (const auto & goal : reachability.getUnreachableGoals()) {
+        result.error_info += " " + goal;
+      }
+      return;
+    }
+
+    if (!reachability.isValid()) {
+      RCLCPP_WARN(
+        get_logger(), "Reachability check skipped: %s", reachability.getError().c_str());
+    }
+  }
+
+  std::optional<plansys2_msgs::msg::Plan> plan;
+  if (plan_library_) {
+    plan = plan_library_->retrieve(domain_expert, problem);
+  }
+
+  if (!plan) {
+    plan = solver.getPlan(domain, problem.getProblem(), solver_namespace, solver_timeout_);
+
+    if (plan && plan_library_) {
+      plan_library_->store(domain_expert, problem, plan.value());
+    }
+  }
+
+  if (plan) {
+    result.success = true;
+    result.cost = get_makespan(plan.value());
+    if (!costs_only) {
+      result.plan = plan.value();
+    }
+  } else {
+    result.error_info = "Plan not found";
+  }
+}
+
 void
 PlannerNode::validate_domain_service_callback(
   const std::shared_ptr<rmw_request_id_t> request_header,
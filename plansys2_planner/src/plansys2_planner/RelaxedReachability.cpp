@@ -0,0 +1,447 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_planner/RelaxedReachability.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "plansys2_domain_expert/DomainExpert.hpp"
+#include "plansys2_problem_expert/ProblemExpert.hpp"
+
+namespace plansys2
+{
+
+namespace
+{
+
+// Positive literals that have to hold for the expression to hold, those reachable from
+// node_id only through AND nodes. Everything else is relaxed away.
+void collect_literals(
+  const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+  std::vector<plansys2_msgs::msg::Node> & literals)
+{
+  if (node_id >= tree.nodes.size()) {
+    return;
+  }
+
+  const auto & node = tree.nodes[node_id];
+  if (node.node_type == plansys2_msgs::msg::Node::AND) {
+    for (auto child : node.children) {
+      collect_literals(tree, child, literals);
+    }
+  } else if (node.node_type == plansys2_msgs::msg::Node::PREDICATE) {
+    literals.push_back(node);
+  }
+}
+
+std::vector<plansys2_msgs::msg::Node> collect_literals(const plansys2_msgs::msg::Tree & tree)
+{
+  std::vector<plansys2_msgs::msg::Node> literals;
+  collect_literals(tree, 0, literals);
+  return literals;
+}
+
+bool same_literal(const plansys2_msgs::msg::Node & a, const plansys2_msgs::msg::Node & b)
+{
+  if (a.name != b.name || a.parameters.size() != b.parameters.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.parameters.size(); i++) {
+    if (a.parameters[i].name != b.parameters[i].name) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string fact_key(const std::string & name, const std::vector<std::string> & args)
+{
+  std::string key = "(" + name;
+  for (const auto & arg : args) {
+    key += " " + arg;
+  }
+  return key + ")";
+}
+
+}  // namespace
+
+RelaxedReachability::RelaxedReachability(const std::string & domain, const std::string & problem)
+: valid_(false),
+  reachable_(false),
+  estimate_(-1)
+{
+  try {
+    analyze(domain, problem);
+  } catch (const std::exception & e) {
+    error_ = e.what();
+    valid_ = false;
+  }
+}
+
+RelaxedReachability::RelaxedReachability(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert)
+: valid_(true),
+  reachable_(false),
+  estimate_(-1)
+{
+  try {
+    analyze(domain_expert, problem_expert);
+  } catch (const std::exception & e) {
+    error_ = e.what();
+    valid_ = false;
+  }
+}
+
+void
+RelaxedReachability::analyze(const std::string & domain, const std::string & problem)
+{
+  auto domain_expert = std::make_shared<DomainExpert>(domain);
+  ProblemExpert problem_expert(domain_expert);
+
+  if (!problem_expert.addProblem(problem)) {
+    error_ = "Invalid problem";
+    return;
+  }
+  valid_ = true;
+
+  analyze(domain_expert, problem_expert);
+}
+
+void
+RelaxedReachability::analyze(
+  const std::shared_ptr<DomainExpert> & domain_expert, ProblemExpert & problem_expert)
+{
+  for (const auto & type : domain_expert->getTypes()) {
+    for (const auto & constant : domain_expert->getConstants(type)) {
+      objects_[type].push_back(constant);
+      objects_["object"].push_back(constant);
+    }
+  }
+  for (const auto & instance : problem_expert.getInstances()) {
+    objects_[instance.type].push_back(instance.name);
+    objects_["object"].push_back(instance.name);
+  }
+
+  for (const auto & name : domain_expert->getActions()) {
+    auto action = domain_expert->getAction(name);
+    actions_.push_back(
+      make_schema(
+        action->parameters, collect_literals(action->preconditions),
+        collect_literals(action->effects)));
+  }
+
+  for (const auto & name : domain_expert->getDurativeActions()) {
+    auto action = domain_expert->getDurativeAction(name);
+
+    auto preconditions = collect_literals(action->at_start_requirements);
+    auto start_effects = collect_literals(action->at_start_effects);
+    auto effects = start_effects;
+
+    // Conditions after the start may be achieved by the action itself
+    for (const auto * tree : {&action->over_all_requirements, &action->at_end_requirements}) {
+      for (const auto & literal : collect_literals(*tree)) {
+        auto achieved = std::any_of(
+          start_effects.begin(), start_effects.end(),
+          [&literal](const plansys2_msgs::msg::Node & effect) {
+            return same_literal(literal, effect);
+          });
+        if (!achieved) {
+          preconditions.push_back(literal);
+        }
+      }
+    }
+
+    for (const auto & effect : collect_literals(action->at_end_effects)) {
+      effects.push_back(effect);
+    }
+
+    actions_.push_back(make_schema(action->parameters, preconditions, effects));
+  }
+
+  for (const auto & predicate : domain_expert->getDerivedPredicates()) {
+    for (auto derived : domain_expert->getDerivedPredicate(predicate.name)) {
+      // The conditions refer to the parameters by position, as the actions do
+      for (size_t i = 0; i < derived.predicate.parameters.size(); i++) {
+        derived.predicate.parameters[i].name = "?" + std::to_string(i);
+      }
+      derived_.push_back(
+        make_schema(
+          derived.predicate.parameters, collect_literals(derived.preconditions),
+          {derived.predicate}));
+    }
+  }
+
+  for (const auto & predicate : problem_expert.getPredicates()) {
+    std::vector<std::string> fact = {predicate.name};
+    for (const auto & param : predicate.parameters) {
+      fact.push_back(param.name);
+    }
+    add_fact(fact, 0);
+  }
+
+  auto goal = problem_expert.getGoal();
+
+  // Each layer applies the actions to the facts of the previous ones, then closes the
+  // derived predicates, until the goal holds or no new fact is reached
+  int level = 0;
+  bool changed = true;
+  while (true) {
+    while (changed) {
+      std::vector<std::vector<std::string>> produced;
+      std::vector<std::string> values;
+      for (const auto & rule : derived_) {
+        values.assign(rule.candidates.size(), "");
+        expand(rule, 0, values, produced);
+      }
+
+      changed = false;
+      for (const auto & fact : produced) {
+        changed = add_fact(fact, level) || changed;
+      }
+    }
+
+    if (goal.nodes.empty() || holds(goal, 0)) {
+      reachable_ = true;
+      estimate_ = level;
+      return;
+    }
+
+    std::vector<std::vector<std::string>> produced;
+    std::vector<std::string> values;
+    for (const auto & action : actions_) {
+      values.assign(action.candidates.size(), "");
+      expand(action, 0, values, produced);
+    }
+
+    level++;
+    for (const auto & fact : produced) {
+      changed = add_fact(fact, level) || changed;
+    }
+
+    if (!changed) {
+      break;
+    }
+  }
+
+  collect_unreached(goal, 0);
+}
+
+RelaxedReachability::Schema
+RelaxedReachability::make_schema(
+  const std::vector<plansys2_msgs::msg::Param> & parameters,
+  const std::vector<plansys2_msgs::msg::Node> & preconditions,
+  const std::vector<plansys2_msgs::msg::Node> & effects)
+{
+  Schema schema;
+
+  for (const auto & param : parameters) {
+    std::vector<std::string> candidates;
+    if (param.type.empty()) {
+      candidates = objects_["object"];
+    } else {
+      candidates = objects_[param.type];
+      for (const auto & sub_type : param.sub_types) {
+        const auto & objects = objects_[sub_type];
+        candidates.insert(candidates.end(), objects.begin(), objects.end());
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    schema.candidates.push_back(candidates);
+  }
+
+  for (const auto & node : preconditions) {
+    schema.preconditions.push_back(make_literal(node, parameters));
+  }
+  for (const auto & node : effects) {
+    schema.effects.push_back(make_literal(node, parameters));
+  }
+
+  // Join first the literals with more arguments, to bind the parameters as soon as possible
+  std::stable_sort(
+    schema.preconditions.begin(), schema.preconditions.end(),
+    [](const Literal & a, const Literal & b) {return a.args.size() > b.args.size();});
+
+  return schema;
+}
+
+RelaxedReachability::Literal
+RelaxedReachability::make_literal(
+  const plansys2_msgs::msg::Node & node,
+  const std::vector<plansys2_msgs::msg::Param> & parameters)
+{
+  Literal literal;
+  literal.name = node.name;
+
+  for (const auto & param : node.parameters) {
+    int index = -1;
+    for (size_t i = 0; i < parameters.size(); i++) {
+      if (parameters[i].name == param.name) {
+        index = i;
+      }
+    }
+    literal.args.push_back(index);
+    literal.objects.push_back(param.name);
+  }
+
+  return literal;
+}
+
+void
+RelaxedReachability::expand(
+  const Schema & schema, size_t literal, std::vector<std::string> & values,
+  std::vector<std::vector<std::string>> & produced) const
+{
+  if (literal == schema.preconditions.size()) {
+    emit(schema, 0, values, produced);
+    return;
+  }
+
+  const auto & precondition = schema.preconditions[literal];
+  auto it = facts_.find(precondition.name);
+  if (it == facts_.end()) {
+    return;
+  }
+
+  // Facts are only added between layers, so the vector is not modified while iterating
+  for (const auto & args : it->second) {
+    if (args.size() != precondition.args.size()) {
+      continue;
+    }
+
+    std::vector<int> bound;
+    bool match = true;
+    for (size_t i = 0; i < args.size() && match; i++) {
+      int index = precondition.args[i];
+      if (index < 0) {
+        match = precondition.objects[i] == args[i];
+      } else if (values[index].empty()) {
+        values[index] = args[i];
+        bound.push_back(index);
+      } else {
+        match = values[index] == args[i];
+      }
+    }
+
+    if (match) {
+      expand(schema, literal + 1, values, produced);
+    }
+
+    for (auto index : bound) {
+      values[index].clear();
+    }
+  }
+}
+
+void
+RelaxedReachability::emit(
+  const Schema & schema, size_t parameter, std::vector<std::string> & values,
+  std::vector<std::vector<std::string>> & produced) const
+{
+  // Parameters not fixed by any precondition range over the objects of their type
+  while (parameter < values.size() && !values[parameter].empty()) {
+    parameter++;
+  }
+
+  if (parameter < values.size()) {
+    for (const auto & object : schema.candidates[parameter]) {
+      values[parameter] = object;
+      emit(schema, parameter + 1, values, produced);
+    }
+    values[parameter].clear();
+    return;
+  }
+
+  for (const auto & effect : schema.effects) {
+    std::vector<std::string> fact = {effect.name};
+    for (size_t i = 0; i < effect.args.size(); i++) {
+      fact.push_back(effect.args[i] < 0 ? effect.objects[i] : values[effect.args[i]]);
+    }
+    produced.push_back(fact);
+  }
+}
+
+bool
+RelaxedReachability::add_fact(const std::vector<std::string> & fact, int level)
+{
+  std::vector<std::string> args(fact.begin() + 1, fact.end());
+  if (!levels_.emplace(fact_key(fact[0], args), level).second) {
+    return false;
+  }
+
+  facts_[fact[0]].push_back(args);
+  return true;
+}
+
+bool
+RelaxedReachability::holds(const plansys2_msgs::msg::Tree & tree, uint32_t node_id) const
+{
+  if (node_id >= tree.nodes.size()) {
+    return true;
+  }
+
+  const auto & node = tree.nodes[node_id];
+  switch (node.node_type) {
+    case plansys2_msgs::msg::Node::AND:
+      return std::all_of(
+        node.children.begin(), node.children.end(),
+        [this, &tree](uint32_t child) {return holds(tree, child);});
+    case plansys2_msgs::msg::Node::OR:
+      return node.children.empty() || std::any_of(
+        node.children.begin(), node.children.end(),
+        [this, &tree](uint32_t child) {return holds(tree, child);});
+    case plansys2_msgs::msg::Node::PREDICATE:
+      {
+        std::vector<std::string> args;
+        for (const auto & param : node.parameters) {
+          args.push_back(param.name);
+        }
+        return levels_.count(fact_key(node.name, args)) > 0;
+      }
+    default:
+      // Negations, quantifiers and numeric conditions are relaxed
+      return true;
+  }
+}
+
+void
+RelaxedReachability::collect_unreached(const plansys2_msgs::msg::Tree & tree, uint32_t node_id)
+{
+  if (node_id >= tree.nodes.size()) {
+    return;
+  }
+
+  const auto & node = tree.nodes[node_id];
+  if (node.node_type == plansys2_msgs::msg::Node::AND ||
+    node.node_type == plansys2_msgs::msg::Node::OR)
+  {
+    if (!holds(tree, node_id)) {
+      for (auto child : node.children) {
+        collect_unreached(tree, child);
+      }
+    }
+  } else if (node.node_type == plansys2_msgs::msg::Node::PREDICATE && !holds(tree, node_id)) {
+    std::vector<std::string> args;
+    for (const auto & param : node.parameters) {
+      args.push_back(param.name);
+    }
+    unreachable_goals_.push_back(fact_key(node.name, args));
+  }
+}
+
+}  // namespace plansys2
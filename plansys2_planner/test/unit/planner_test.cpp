@@ -17,6 +17,7 @@
 #include <memory>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include "ament_index_cpp/get_package_share_directory.hpp"
 
@@ -29,6 +30,10 @@
 #include "plansys2_problem_expert/ProblemExpertClient.hpp"
 #include "plansys2_planner/PlannerNode.hpp"
 #include "plansys2_planner/PlannerClient.hpp"
+#include "plansys2_planner/PlanBenchmark.hpp"
+#include "plansys2_planner/PlanLibrary.hpp"
+#include "plansys2_planner/PlanValidation.hpp"
+#include "plansys2_planner/RelaxedReachability.hpp"
 
 #include "pluginlib/class_loader.hpp"
 #include "pluginlib/class_list_macros.hpp"
@@ -198,6 +203,376 @@ TEST(planner_expert, generate_plan_with_domain_constants)
   t.join();
 }
 
+TEST(planner_expert, generate_plans_variants)
+{
+  auto test_node = rclcpp::Node::make_shared("test_node");
+  auto planner_node = std::make_shared<plansys2::PlannerNode>();
+  auto planner_client = std::make_shared<plansys2::PlannerClient>();
+
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_planner");
+
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  std::ifstream problem_ifs(pkgpath + "/pddl/problem_simple_1.pddl");
+  std::string problem_str((
+      std::istreambuf_iterator<char>(problem_ifs)),
+    std::istreambuf_iterator<char>());
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(planner_node->get_node_base_interface());
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  planner_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+  planner_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+
+  {
+    rclcpp::Rate rate(10);
+    auto start = test_node->now();
+    while ((test_node->now() - start).seconds() < 0.5) {
+      rate.sleep();
+    }
+  }
+
+  std::vector<plansys2_msgs::msg::PlanVariant> variants(4);
+
+  // The base problem: move, approach and talk
+  variants[0].id = "base";
+
+  // The robot is already near Jack, so it only talks
+  variants[1].id = "near";
+  variants[1].changes.resize(1);
+  variants[1].changes[0].type = plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE;
+  variants[1].changes[0].node = plansys2::Predicate("(robot_near_person leia jack)");
+
+  // Jack is nowhere, so the robot can not approach him
+  variants[2].id = "nowhere";
+  variants[2].changes.resize(1);
+  variants[2].changes[0].type = plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE;
+  variants[2].changes[0].node = plansys2::Predicate("(person_at jack bedroom)");
+
+  variants[3].id = "move";
+  variants[3].goal = plansys2::Goal("(and (robot_at leia bedroom))");
+
+  auto results = planner_client->getPlans(domain_str, problem_str, variants);
+  ASSERT_TRUE(results);
+  ASSERT_EQ(results.value().size(), 4u);
+
+  const auto & base = results.value()[0];
+  ASSERT_EQ(base.id, "base");
+  ASSERT_TRUE(base.success);
+  ASSERT_EQ(base.plan.items.size(), 3u);
+
+  const auto & near = results.value()[1];
+  ASSERT_TRUE(near.success);
+  ASSERT_EQ(near.plan.items.size(), 1u);
+  ASSERT_LT(near.cost, base.cost);
+
+  const auto & nowhere = results.value()[2];
+  ASSERT_FALSE(nowhere.success);
+  ASSERT_EQ(nowhere.error_info.rfind("Goal unreachable", 0), 0u);
+
+  const auto & move = results.value()[3];
+  ASSERT_TRUE(move.success);
+  ASSERT_EQ(move.plan.items.size(), 1u);
+  ASSERT_EQ(move.plan.items[0].action.rfind("(move leia kitchen bedroom)", 0), 0u);
+
+  auto costs = planner_client->getPlans(domain_str, problem_str, variants, true);
+  ASSERT_TRUE(costs);
+  ASSERT_TRUE(costs.value()[0].success);
+  ASSERT_TRUE(costs.value()[0].plan.items.empty());
+  ASSERT_DOUBLE_EQ(costs.value()[0].cost, base.cost);
+
+  // The previous plan is returned while what remains of it is valid
+  auto hinted = planner_client->getPlan(domain_str, problem_str, base.plan);
+  ASSERT_TRUE(hinted);
+  ASSERT_EQ(hinted.value(), base.plan);
+
+  std::string moved_str = problem_str;
+  moved_str.replace(moved_str.find("(robot_at leia kitchen)"), 23, "(robot_at leia bedroom)");
+  hinted = planner_client->getPlan(domain_str, moved_str, base.plan);
+  ASSERT_TRUE(hinted);
+  ASSERT_EQ(hinted.value().items.size(), 2u);
+
+  finish = true;
+  t.join();
+}
+
+TEST(planner_expert, plan_validation)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_planner");
+
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  std::ifstream problem_ifs(pkgpath + "/pddl/problem_simple_1.pddl");
+  std::string problem_str((
+      std::istreambuf_iterator<char>(problem_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+  ASSERT_TRUE(problem_expert.addProblem(problem_str));
+
+  plansys2_msgs::msg::Plan plan;
+  plan.items.resize(3);
+  plan.items[0].time = 0.0;
+  plan.items[0].action = "(move leia kitchen bedroom)";
+  plan.items[0].duration = 5.0;
+  plan.items[1].time = 5.001;
+  plan.items[1].action = "(approach leia bedroom jack)";
+  plan.items[1].duration = 5.0;
+  plan.items[2].time = 10.002;
+  plan.items[2].action = "(talk leia jack m1)";
+  plan.items[2].duration = 5.0;
+
+  std::string error_info;
+  ASSERT_TRUE(plansys2::validate_plan(domain_expert, problem_expert, plan, error_info));
+
+  // The fingerprint of the final state is the one of the problem once the plan is executed
+  plansys2_msgs::msg::StateFingerprint final_state;
+  ASSERT_TRUE(
+    plansys2::validate_plan(domain_expert, problem_expert, plan, error_info, final_state));
+  ASSERT_NE(final_state, problem_expert.getFingerprint());
+  {
+    plansys2::ProblemExpert executed(domain_expert);
+    ASSERT_TRUE(executed.addProblem(problem_str));
+    ASSERT_TRUE(executed.removePredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+    ASSERT_TRUE(executed.addPredicate(plansys2::Predicate("(robot_at leia bedroom)")));
+    ASSERT_TRUE(executed.addPredicate(plansys2::Predicate("(robot_near_person leia jack)")));
+    ASSERT_TRUE(executed.addPredicate(plansys2::Predicate("(robot_talk leia m1 jack)")));
+    ASSERT_EQ(final_state, executed.getFingerprint());
+
+    // Both fingerprints must be hashed with the same quantum to be compared
+    executed.setFingerprintQuantum(0.5);
+    ASSERT_TRUE(
+      plansys2::validate_plan(domain_expert, problem_expert, plan, error_info, final_state, 0.5));
+    ASSERT_EQ(final_state, executed.getFingerprint());
+  }
+
+  // Jack is approached before the robot arrives
+  auto early = plan;
+  early.items[1].time = 4.0;
+  ASSERT_FALSE(plansys2::validate_plan(domain_expert, problem_expert, early, error_info));
+  ASSERT_EQ(error_info, "Over all requirements of (approach leia bedroom jack) not met");
+
+  auto incomplete = plan;
+  incomplete.items.pop_back();
+  ASSERT_FALSE(plansys2::validate_plan(domain_expert, problem_expert, incomplete, error_info));
+  ASSERT_EQ(error_info, "Goal not achieved");
+
+  // The robot already moved, so only the rest of the plan is valid
+  ASSERT_TRUE(problem_expert.removePredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+  ASSERT_TRUE(problem_expert.addPredicate(plansys2::Predicate("(robot_at leia bedroom)")));
+  ASSERT_FALSE(plansys2::validate_plan(domain_expert, problem_expert, plan, error_info));
+
+  auto suffix = plansys2::find_valid_suffix(domain_expert, problem_expert, plan);
+  ASSERT_TRUE(suffix);
+  ASSERT_EQ(suffix.value().items.size(), 2u);
+  ASSERT_EQ(suffix.value().items[0].action, "(approach leia bedroom jack)");
+  ASSERT_FLOAT_EQ(suffix.value().items[0].time, 0.0);
+  ASSERT_FLOAT_EQ(suffix.value().items[1].time, 5.001);
+
+  ASSERT_TRUE(problem_expert.removePredicate(plansys2::Predicate("(person_at jack bedroom)")));
+  ASSERT_FALSE(plansys2::find_valid_suffix(domain_expert, problem_expert, plan));
+}
+
+TEST(planner_expert, plan_library)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_planner");
+
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  std::ifstream problem_ifs(pkgpath + "/pddl/problem_simple_1.pddl");
+  std::string problem_str((
+      std::istreambuf_iterator<char>(problem_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+  ASSERT_TRUE(problem_expert.addProblem(problem_str));
+
+  plansys2_msgs::msg::Plan plan;
+  plan.items.resize(3);
+  plan.items[0].time = 0.0;
+  plan.items[0].action = "(move leia kitchen bedroom)";
+  plan.items[0].duration = 5.0;
+  plan.items[1].time = 5.001;
+  plan.items[1].action = "(approach leia bedroom jack)";
+  plan.items[1].duration = 5.0;
+  plan.items[2].time = 10.002;
+  plan.items[2].action = "(talk leia jack m1)";
+  plan.items[2].duration = 5.0;
+
+  plansys2::PlanLibrary library(2);
+  ASSERT_TRUE(library.store(domain_expert, problem_expert, plan));
+  ASSERT_FALSE(library.store(domain_expert, problem_expert, plan));
+  ASSERT_EQ(library.size(), 1u);
+
+  // Same kind of problem, with other objects
+  plansys2::ProblemExpert other(domain_expert);
+  ASSERT_TRUE(
+    other.addProblem(
+      "(define (problem other) (:domain simple) "
+      "(:objects r2d2 - robot bob ann - person hall lab office - room m2 - message) "
+      "(:init (robot_at r2d2 lab) (person_at ann lab) (person_at bob office)) "
+      "(:goal (and (robot_talk r2d2 m2 bob))))"));
+
+  auto reused = library.retrieve(domain_expert, other);
+  ASSERT_TRUE(reused);
+  ASSERT_EQ(reused.value().items.size(), 3u);
+  ASSERT_EQ(reused.value().items[0].action, "(move r2d2 lab office)");
+  ASSERT_EQ(reused.value().items[1].action, "(approach r2d2 office bob)");
+  ASSERT_EQ(reused.value().items[2].action, "(talk r2d2 bob m2)");
+
+  // The robot and the person are in the same room, so the stored plan does not apply
+  plansys2::ProblemExpert near(domain_expert);
+  ASSERT_TRUE(
+    near.addProblem(
+      "(define (problem near) (:domain simple) "
+      "(:objects r2d2 - robot bob - person lab - room m2 - message) "
+      "(:init (robot_at r2d2 lab) (person_at bob lab)) "
+      "(:goal (and (robot_talk r2d2 m2 bob))))"));
+  ASSERT_FALSE(library.retrieve(domain_expert, near));
+
+  plansys2::ProblemExpert move(domain_expert);
+  ASSERT_TRUE(
+    move.addProblem(
+      "(define (problem move) (:domain simple) "
+      "(:objects r2d2 - robot bob - person lab office - room) "
+      "(:init (robot_at r2d2 lab) (person_at bob office)) "
+      "(:goal (and (robot_at r2d2 office))))"));
+  ASSERT_FALSE(library.retrieve(domain_expert, move));
+
+  plansys2_msgs::msg::Plan move_plan;
+  move_plan.items.resize(1);
+  move_plan.items[0].time = 0.0;
+  move_plan.items[0].action = "(move r2d2 lab office)";
+  move_plan.items[0].duration = 5.0;
+  ASSERT_TRUE(library.store(domain_expert, move, move_plan));
+  ASSERT_TRUE(library.retrieve(domain_expert, move));
+
+  // The library is full, so the first case is dropped. The newest case is tried first
+  move_plan.items.resize(2);
+  move_plan.items[1].time = 5.001;
+  move_plan.items[1].action = "(approach r2d2 office bob)";
+  move_plan.items[1].duration = 5.0;
+  ASSERT_TRUE(library.store(domain_expert, move, move_plan));
+  ASSERT_EQ(library.size(), 2u);
+  ASSERT_FALSE(library.retrieve(domain_expert, other));
+  ASSERT_EQ(library.retrieve(domain_expert, move).value().items.size(), 2u);
+
+  library.clear();
+  ASSERT_EQ(library.size(), 0u);
+  ASSERT_FALSE(library.retrieve(domain_expert, move));
+}
+
+TEST(planner_expert, relaxed_reachability)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_planner");
+
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  std::ifstream problem_ifs(pkgpath + "/pddl/problem_simple_1.pddl");
+  std::string problem_str((
+      std::istreambuf_iterator<char>(problem_ifs)),
+    std::istreambuf_iterator<char>());
+
+  // move, approach and talk
+  plansys2::RelaxedReachability reachable(domain_str, problem_str);
+  ASSERT_TRUE(reachable.isValid());
+  ASSERT_TRUE(reachable.getError().empty());
+  ASSERT_TRUE(reachable.isGoalReachable());
+  ASSERT_TRUE(reachable.getUnreachableGoals().empty());
+  ASSERT_EQ(reachable.getEstimate(), 3);
+
+  // Jack is in no room, so the robot can not approach him
+  std::string unsolvable_str =
+    "(define (problem simple_1) (:domain simple) "
+    "(:objects leia - robot jack - person kitchen - room m1 - message) "
+    "(:init (robot_at leia kitchen)) "
+    "(:goal (and (robot_talk leia m1 jack) (robot_at leia kitchen))))";
+
+  plansys2::RelaxedReachability unreachable(domain_str, unsolvable_str);
+  ASSERT_TRUE(unreachable.isValid());
+  ASSERT_FALSE(unreachable.isGoalReachable());
+  ASSERT_EQ(unreachable.getEstimate(), -1);
+  ASSERT_EQ(unreachable.getUnreachableGoals().size(), 1u);
+  ASSERT_EQ(unreachable.getUnreachableGoals()[0], "(robot_talk leia m1 jack)");
+
+  plansys2::RelaxedReachability invalid(domain_str, "");
+  ASSERT_FALSE(invalid.isValid());
+  ASSERT_FALSE(invalid.getError().empty());
+}
+
+TEST(planner_expert, benchmark_corpus)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_planner");
+
+  auto cases = plansys2::find_benchmark_cases(pkgpath + "/pddl");
+  ASSERT_EQ(cases.size(), 5u);
+  ASSERT_EQ(cases[0].name, "problem_simple_1");
+  ASSERT_EQ(cases[0].domain_path, pkgpath + "/pddl/domain_simple.pddl");
+  ASSERT_EQ(cases[0].problem_path, pkgpath + "/pddl/problem_simple_1.pddl");
+  ASSERT_EQ(cases[3].name, "problem_simple_constants_1");
+  ASSERT_EQ(cases[3].domain_path, pkgpath + "/pddl/domain_simple_constants.pddl");
+
+  ASSERT_TRUE(plansys2::find_benchmark_cases(pkgpath + "/none").empty());
+
+  plansys2_msgs::msg::Plan plan;
+  plan.items.resize(2);
+  plan.items[0].time = 0.0;
+  plan.items[0].duration = 5.0;
+  plan.items[1].time = 1.0;
+  plan.items[1].duration = 2.0;
+  ASSERT_DOUBLE_EQ(plansys2::get_makespan(plan), 5.0);
+
+  plansys2::BenchmarkResult solved;
+  solved.plugin = "plansys2/POPFPlanSolver";
+  solved.arguments = "-n, -t";
+  solved.benchmark_case = cases[0];
+  solved.status = "solved";
+  solved.solve_time = 0.5;
+  solved.plan_length = 2;
+  solved.makespan = 5.0;
+
+  plansys2::BenchmarkResult timeout = solved;
+  timeout.arguments = std::nullopt;
+  timeout.status = "timeout";
+
+  auto csv = plansys2::benchmark_report_csv({solved, timeout});
+  std::istringstream csv_lines(csv);
+  std::string header, row1, row2;
+  std::getline(csv_lines, header);
+  std::getline(csv_lines, row1);
+  std::getline(csv_lines, row2);
+  ASSERT_EQ(header.rfind("plugin,arguments,problem,", 0), 0u);
+  ASSERT_EQ(row1.rfind("plansys2/POPFPlanSolver,\"-n, -t\",problem_simple_1,", 0), 0u);
+  ASSERT_NE(row1.find(",solved,0.5,"), std::string::npos);
+  ASSERT_EQ(row1.substr(row1.size() - 4), ",2,5");
+  ASSERT_EQ(row2.substr(row2.size() - 2), ",,");
+
+  auto json = plansys2::benchmark_report_json({solved, timeout});
+  ASSERT_NE(json.find("\"arguments\": \"-n, -t\""), std::string::npos);
+  ASSERT_NE(json.find("\"arguments\": null"), std::string::npos);
+  ASSERT_NE(json.find("\"plan_length\": 2, \"makespan\": 5}"), std::string::npos);
+  ASSERT_NE(json.find("\"plan_length\": null, \"makespan\": null}"), std::string::npos);
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
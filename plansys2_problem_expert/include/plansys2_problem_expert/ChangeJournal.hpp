@@ -0,0 +1,83 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__CHANGEJOURNAL_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__CHANGEJOURNAL_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "plansys2_msgs/msg/knowledge_change.hpp"
+
+namespace plansys2
+{
+
+/// Bounded journal of the last changes of the knowledge.
+/**
+ * Every recorded change, or batch of changes, gets the next revision. Only the last
+ * capacity changes are kept, in a ring buffer, so a client that missed fewer changes than
+ * that can catch up from them instead of fetching the whole knowledge.
+ *
+ * Revisions start at the construction time in nanoseconds, so the revisions known by a
+ * client of a previous journal are never mistaken for revisions of this one.
+ */
+class ChangeJournal
+{
+public:
+  explicit ChangeJournal(size_t capacity = 1000);
+
+  /// Set the number of changes kept. Changes already recorded are discarded.
+  void setCapacity(size_t capacity);
+  size_t getCapacity() const {return buffer_.size();}
+
+  /// Last revision recorded.
+  uint64_t getRevision() const {return revision_;}
+
+  /// Record a change, assigning it the next revision.
+  /**
+   * \param[in] change The change. Its revision field is overwritten.
+   * \return The revision of the change.
+   */
+  uint64_t record(plansys2_msgs::msg::KnowledgeChange change);
+
+  /// Record a batch of changes, assigning all of them the next revision.
+  /**
+   * \param[in] changes The changes. Their revision field is overwritten.
+   * \return The revision of the changes, or the last revision if there are no changes.
+   */
+  uint64_t record(std::vector<plansys2_msgs::msg::KnowledgeChange> changes);
+
+  /// Get the changes after a revision.
+  /**
+   * \param[in] revision The last revision known by the client.
+   * \return The changes after revision, oldest first, or nothing if some of them are not
+   *         kept anymore (or revision is unknown) and the client must resync.
+   */
+  std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>>
+  getChangesSince(uint64_t revision) const;
+
+private:
+  void push(plansys2_msgs::msg::KnowledgeChange change);
+
+  std::vector<plansys2_msgs::msg::KnowledgeChange> buffer_;
+  size_t next_;
+  size_t size_;
+  uint64_t revision_;
+  uint64_t complete_since_;  // All the changes after this revision are kept
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__CHANGEJOURNAL_HPP_
@@ -0,0 +1,82 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__FACTEXPIRY_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__FACTEXPIRY_HPP_
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "plansys2_msgs/msg/node.hpp"
+
+namespace plansys2
+{
+
+/// Expiration times of the predicates and functions with a time-to-live.
+/**
+ * Expirations are kept in a min-heap, so finding the expired facts only visits those. When
+ * the expiration of a fact is changed, its previous entry stays in the heap and is
+ * discarded when it reaches the top. The heap is rebuilt when most of it is stale.
+ *
+ * Times are in nanoseconds of any clock, as long as the same one is used for all the calls.
+ */
+class FactExpiry
+{
+public:
+  /// Set when a fact expires, replacing its previous expiration.
+  void set(const plansys2_msgs::msg::Node & fact, std::chrono::nanoseconds expiration);
+
+  /// Make a fact permanent.
+  void clear(const plansys2_msgs::msg::Node & fact);
+
+  /// Make all the facts permanent.
+  void reset();
+
+  /// Extract the facts expired at a time.
+  /**
+   * \param[in] now The current time.
+   * \return The facts whose expiration is not after now, which are not tracked anymore.
+   */
+  std::vector<plansys2_msgs::msg::Node> expire(std::chrono::nanoseconds now);
+
+  /// Next expiration, if any fact expires.
+  std::optional<std::chrono::nanoseconds> next();
+
+  size_t size() const {return facts_.size();}
+
+private:
+  struct Entry
+  {
+    std::chrono::nanoseconds expiration;
+    std::string key;
+
+    bool operator>(const Entry & other) const {return expiration > other.expiration;}
+  };
+
+  void discardStale();
+
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;
+  std::unordered_map<
+    std::string, std::pair<std::chrono::nanoseconds, plansys2_msgs::msg::Node>> facts_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__FACTEXPIRY_HPP_
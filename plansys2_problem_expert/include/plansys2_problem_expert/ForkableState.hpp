@@ -0,0 +1,84 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__FORKABLESTATE_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__FORKABLESTATE_HPP_
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "plansys2_core/Types.hpp"
+#include "plansys2_msgs/msg/state_fingerprint.hpp"
+#include "plansys2_msgs/msg/tree.hpp"
+#include "plansys2_problem_expert/PersistentMap.hpp"
+
+namespace plansys2
+{
+
+/// Predicates and functions of a state that can be forked to reason about hypotheticals.
+/**
+ * The facts are kept in persistent maps, so fork() takes constant time, and each change
+ * of a fork costs O(log n) without affecting the state it was forked from or its other
+ * forks. Forks can be explored in parallel, one thread per fork.
+ *
+ * check and apply evaluate ground expressions with the evaluator of Utils.hpp, through an
+ * EvaluationState. EXISTS nodes are evaluated on a copy of the facts, so they take linear
+ * time.
+ */
+class ForkableState
+{
+public:
+  ForkableState() = default;
+  ForkableState(
+    const std::vector<plansys2::Predicate> & predicates,
+    const std::vector<plansys2::Function> & functions);
+
+  /// Get an independent copy of the state, in constant time.
+  ForkableState fork() const {return *this;}
+
+  bool existPredicate(const plansys2::Predicate & predicate) const;
+  bool addPredicate(const plansys2::Predicate & predicate);
+  bool removePredicate(const plansys2::Predicate & predicate);
+
+  std::optional<plansys2::Function> getFunction(const plansys2::Function & function) const;
+  void setFunction(const plansys2::Function & function);
+  bool removeFunction(const plansys2::Function & function);
+
+  std::vector<plansys2::Predicate> getPredicates() const;
+  std::vector<plansys2::Function> getFunctions() const;
+
+  /// Check a ground PDDL expression in the state.
+  bool check(const plansys2_msgs::msg::Tree & tree, uint32_t node_id = 0) const;
+
+  /// Apply the effects of a ground PDDL expression to the state.
+  /**
+   * \return false if a function is missing or a modifier divides by zero. The effects
+   *         applied before the failure are kept.
+   */
+  bool apply(const plansys2_msgs::msg::Tree & tree, uint32_t node_id = 0);
+
+  /// Fingerprint of the state with exact function values, see StateFingerprint.
+  const plansys2_msgs::msg::StateFingerprint & getFingerprint() const {return fingerprint_;}
+
+private:
+  PersistentMap<std::string, plansys2::Predicate> predicates_;
+  PersistentMap<std::string, plansys2::Function> functions_;
+  plansys2_msgs::msg::StateFingerprint fingerprint_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__FORKABLESTATE_HPP_
@@ -0,0 +1,205 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__PERSISTENTMAP_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__PERSISTENTMAP_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace plansys2
+{
+
+/// Ordered map whose copies share their contents.
+/**
+ * The map is an AVL tree of immutable nodes. Copying the map copies its root, and a write
+ * copies only the O(log n) nodes on the path to the changed key, sharing the rest of the
+ * tree with the other copies. Copies can be read and written from different threads, as
+ * long as each copy is used by a single thread.
+ */
+template<class Key, class Value>
+class PersistentMap
+{
+public:
+  /// Get the value of a key, or nullptr if the key is not in the map.
+  const Value * find(const Key & key) const
+  {
+    const Node * node = root_.get();
+    while (node != nullptr) {
+      if (key < node->key) {
+        node = node->left.get();
+      } else if (node->key < key) {
+        node = node->right.get();
+      } else {
+        return &node->value;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Set the value of a key.
+  /**
+   * \return true if the key was not in the map.
+   */
+  bool insert(const Key & key, const Value & value)
+  {
+    bool inserted = false;
+    root_ = insert(root_, key, value, inserted);
+    size_ += inserted ? 1 : 0;
+    return inserted;
+  }
+
+  /// Remove a key.
+  /**
+   * \return true if the key was in the map.
+   */
+  bool erase(const Key & key)
+  {
+    bool erased = false;
+    root_ = erase(root_, key, erased);
+    size_ -= erased ? 1 : 0;
+    return erased;
+  }
+
+  /// Call f(key, value) for every entry, ordered by key.
+  template<class F>
+  void for_each(F f) const {for_each(root_.get(), f);}
+
+  size_t size() const {return size_;}
+  bool empty() const {return size_ == 0;}
+
+private:
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+  struct Node
+  {
+    Key key;
+    Value value;
+    NodePtr left;
+    NodePtr right;
+    int height;
+  };
+
+  static int height(const NodePtr & node) {return node ? node->height : 0;}
+
+  static NodePtr make(const Key & key, const Value & value, NodePtr left, NodePtr right)
+  {
+    int node_height = std::max(height(left), height(right)) + 1;
+    return std::make_shared<const Node>(
+      Node{key, value, std::move(left), std::move(right), node_height});
+  }
+
+  static NodePtr balance(
+    const Key & key, const Value & value, const NodePtr & left, const NodePtr & right)
+  {
+    if (height(left) > height(right) + 1) {
+      if (height(left->left) >= height(left->right)) {
+        return make(left->key, left->value, left->left, make(key, value, left->right, right));
+      }
+      const auto & pivot = left->right;
+      return make(
+        pivot->key, pivot->value,
+        make(left->key, left->value, left->left, pivot->left),
+        make(key, value, pivot->right, right));
+    }
+
+    if (height(right) > height(left) + 1) {
+      if (height(right->right) >= height(right->left)) {
+        return make(
+          right->key, right->value, make(key, value, left, right->left), right->right);
+      }
+      const auto & pivot = right->left;
+      return make(
+        pivot->key, pivot->value,
+        make(key, value, left, pivot->left),
+        make(right->key, right->value, pivot->right, right->right));
+    }
+
+    return make(key, value, left, right);
+  }
+
+  static NodePtr insert(
+    const NodePtr & node, const Key & key, const Value & value, bool & inserted)
+  {
+    if (!node) {
+      inserted = true;
+      return make(key, value, nullptr, nullptr);
+    }
+
+    if (key < node->key) {
+      auto left = insert(node->left, key, value, inserted);
+      return balance(node->key, node->value, left, node->right);
+    } else if (node->key < key) {
+      auto right = insert(node->right, key, value, inserted);
+      return balance(node->key, node->value, node->left, right);
+    }
+    return make(key, value, node->left, node->right);
+  }
+
+  static NodePtr erase_min(const NodePtr & node, const Node *& min)
+  {
+    if (!node->left) {
+      min = node.get();
+      return node->right;
+    }
+    return balance(node->key, node->value, erase_min(node->left, min), node->right);
+  }
+
+  static NodePtr erase(const NodePtr & node, const Key & key, bool & erased)
+  {
+    if (!node) {
+      return node;
+    }
+
+    if (key < node->key) {
+      auto left = erase(node->left, key, erased);
+      return erased ? balance(node->key, node->value, left, node->right) : node;
+    } else if (node->key < key) {
+      auto right = erase(node->right, key, erased);
+      return erased ? balance(node->key, node->value, node->left, right) : node;
+    }
+
+    erased = true;
+    if (!node->left) {
+      return node->right;
+    }
+    if (!node->right) {
+      return node->left;
+    }
+    const Node * min = nullptr;
+    auto right = erase_min(node->right, min);
+    return balance(min->key, min->value, node->left, right);
+  }
+
+  template<class F>
+  static void for_each(const Node * node, F & f)
+  {
+    if (node != nullptr) {
+      for_each(node->left.get(), f);
+      f(node->key, node->value);
+      for_each(node->right.get(), f);
+    }
+  }
+
+  NodePtr root_;
+  size_t size_ {0};
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__PERSISTENTMAP_HPP_
@@ -0,0 +1,78 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__PREDICATEINDEX_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__PREDICATEINDEX_HPP_
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "plansys2_core/Types.hpp"
+
+namespace plansys2
+{
+
+/// Secondary indexes of the predicates, by name and by the argument in each position.
+/**
+ * Predicates are identified by their key, the name followed by the arguments separated by
+ * spaces. Queries return them ordered by key, so a query can be resumed after the key of
+ * the last predicate returned.
+ */
+class PredicateIndex
+{
+public:
+  void add(const plansys2::Predicate & predicate);
+  void remove(const plansys2::Predicate & predicate);
+  void clear();
+
+  /// Determine if a predicate, with objects as arguments, is in the index.
+  bool contains(const plansys2::Predicate & predicate) const;
+
+  /// Get the predicates matching a pattern.
+  /**
+   * \param[in] pattern A predicate whose arguments are objects, which must match, or
+   *            variables (starting with '?'), which match any object. A variable repeated
+   *            in several positions must match the same object in all of them.
+   * \param[in] max_results The maximum number of predicates returned, or 0 for no limit.
+   * \param[in] start_after Only predicates with a greater key are returned.
+   * \param[out] next_start_after The key to resume the query after, or empty if there are
+   *             no more matches.
+   * \return The matching predicates, ordered by key.
+   */
+  std::vector<plansys2::Predicate> query(
+    const plansys2::Predicate & pattern,
+    size_t max_results,
+    const std::string & start_after,
+    std::string & next_start_after) const;
+
+  static std::string key(const plansys2::Predicate & predicate);
+
+private:
+  static bool matches(
+    const plansys2::Predicate & predicate, const plansys2::Predicate & pattern);
+
+  std::map<std::string, plansys2::Predicate> predicates_;
+  std::unordered_map<std::string, std::set<std::string>> by_name_;
+  // Name -> position -> argument -> keys
+  std::unordered_map<std::string,
+    std::vector<std::unordered_map<std::string, std::set<std::string>>>> by_argument_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__PREDICATEINDEX_HPP_
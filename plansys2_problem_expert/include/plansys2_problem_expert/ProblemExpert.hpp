@@ -15,6 +15,7 @@
 #ifndef PLANSYS2_PROBLEM_EXPERT__PROBLEMEXPERT_HPP_
 #define PLANSYS2_PROBLEM_EXPERT__PROBLEMEXPERT_HPP_
 
+#include <chrono>
 #include <optional>
 #include <string>
 #include <vector>
@@ -25,7 +26,12 @@
 #include "plansys2_msgs/msg/tree.hpp"
 
 #include "plansys2_pddl_parser/Utils.hpp"
+#include "plansys2_problem_expert/ChangeJournal.hpp"
+#include "plansys2_problem_expert/FactExpiry.hpp"
+#include "plansys2_problem_expert/PredicateIndex.hpp"
 #include "plansys2_problem_expert/ProblemExpertInterface.hpp"
+#include "plansys2_problem_expert/Sharding.hpp"
+#include "plansys2_problem_expert/StateFingerprint.hpp"
 #include "plansys2_domain_expert/DomainExpert.hpp"
 
 namespace plansys2
@@ -46,6 +52,23 @@ public:
   bool removePredicate(const plansys2::Predicate & predicate);
   bool existPredicate(const plansys2::Predicate & predicate);
   std::optional<plansys2::Predicate> getPredicate(const std::string & expr);
+  std::vector<plansys2::Predicate> queryPredicates(const plansys2::Predicate & pattern);
+
+  /// Get the predicates matching a pattern, a page at a time.
+  /**
+   * Only the predicates in the knowledge are matched, not the derived ones.
+   *
+   * \param[in] pattern A predicate whose arguments are objects or variables, as "?w".
+   * \param[in] max_results The size of the page, or 0 to get all the matches at once.
+   * \param[in] start_after The next_start_after of the previous page, or empty.
+   * \param[out] next_start_after Where the next page starts, or empty after the last page.
+   * \return The page of matching predicates.
+   */
+  std::vector<plansys2::Predicate> queryPredicates(
+    const plansys2::Predicate & pattern,
+    size_t max_results,
+    const std::string & start_after,
+    std::string & next_start_after);
 
   std::vector<plansys2::Function> getFunctions();
   bool addFunction(const plansys2::Function & function);
@@ -53,6 +76,9 @@ public:
   bool existFunction(const plansys2::Function & function);
   bool updateFunction(const plansys2::Function & function);
   std::optional<plansys2::Function> getFunction(const std::string & expr);
+  std::optional<plansys2::Function> modifyFunction(const plansys2::Function & modifier);
+  std::optional<std::vector<plansys2::Function>> modifyFunctions(
+    const std::vector<plansys2::Function> & modifiers);
 
   plansys2::Goal getGoal();
   bool setGoal(const plansys2::Goal & goal);
@@ -64,6 +90,57 @@ public:
   std::string getProblem();
   bool addProblem(const std::string & problem_str);
 
+  uint64_t getRevision();
+  std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>> getChangesSince(
+    uint64_t revision);
+  void setJournalCapacity(size_t capacity);
+
+  /// Fingerprint of the current predicates and functions, see StateFingerprint.
+  plansys2_msgs::msg::StateFingerprint getFingerprint();
+
+  /// Set the quantum of the function values in the fingerprint, or 0 for exact values.
+  void setFingerprintQuantum(double function_quantum);
+
+  /// Apply a batch of updates of predicates and functions as a single revision.
+  /**
+   * ADD_PREDICATE and REMOVE_PREDICATE changes add or remove their predicate, and
+   * UPDATE_FUNCTION changes add or update their function. Other changes are ignored.
+   * Added predicates and updated functions with a ttl expire at stamp + ttl, and the others
+   * are permanent.
+   *
+   * \param[in] changes The updates, applied in order.
+   * \return The number of updates applied successfully.
+   */
+  size_t applyChanges(const std::vector<plansys2_msgs::msg::KnowledgeChange> & changes);
+
+  ConditionalUpdateResult applyChangesIf(
+    const std::vector<plansys2_msgs::msg::KnowledgeChange> & changes,
+    uint64_t expected_revision,
+    const plansys2_msgs::msg::Tree & condition,
+    uint64_t & revision);
+
+  /// Remove the predicates and functions expired at a time, as a single revision.
+  /**
+   * Facts expire as set by applyChanges. Any other update of a fact makes it permanent.
+   *
+   * \param[in] now The current time, in the clock of the stamps of the changes.
+   * \return The removed facts.
+   */
+  std::vector<plansys2_msgs::msg::Node> expireFacts(std::chrono::nanoseconds now);
+
+  /// Make this problem expert one of the shards of a partitioned knowledge.
+  /**
+   * addProblem only keeps the predicates and functions owned by this shard, as given by
+   * get_shard. Instances and goal are kept by every shard. Derived predicates are not
+   * inferred by the shards, as their preconditions may be owned by other shards, but by the
+   * sharded ProblemExpertClient.
+   *
+   * \param[in] shard_id The index of this shard.
+   * \param[in] num_shards The number of shards.
+   * \param[in] policy How the facts are partitioned.
+   */
+  void setShard(size_t shard_id, size_t num_shards, ShardingPolicy policy);
+
   bool existInstance(const std::string & name);
   bool isValidType(const std::string & type);
   bool isValidPredicate(const plansys2::Predicate & predicate);
@@ -84,10 +161,25 @@ private:
     const plansys2::Instance & instance);
   void removeInvalidGoals(const plansys2::Instance & instance);
 
+  std::vector<plansys2_msgs::msg::Derived> getDerivedPredicates();
+
+  void recordChange(uint8_t type, const plansys2::Instance & instance);
+  void recordChange(uint8_t type, const plansys2_msgs::msg::Node & node = {});
+  void recordChange(plansys2_msgs::msg::KnowledgeChange change);
+
   std::vector<plansys2::Instance> instances_;
   std::vector<plansys2::Predicate> predicates_;
+  PredicateIndex predicate_index_;
   std::vector<plansys2::Function> functions_;
   plansys2::Goal goal_;
+  ChangeJournal journal_;
+  StateFingerprint fingerprint_;
+  std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>> batch_changes_;
+  FactExpiry fact_expiry_;
+
+  size_t shard_id_;
+  size_t num_shards_;
+  ShardingPolicy sharding_policy_;
 
   std::shared_ptr<DomainExpert> domain_expert_;
 };
@@ -15,11 +15,17 @@
 #ifndef PLANSYS2_PROBLEM_EXPERT__PROBLEMEXPERTCLIENT_HPP_
 #define PLANSYS2_PROBLEM_EXPERT__PROBLEMEXPERTCLIENT_HPP_
 
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "plansys2_problem_expert/ProblemExpertInterface.hpp"
+#include "plansys2_problem_expert/Sharding.hpp"
+#include "plansys2_problem_expert/StateFingerprint.hpp"
+#include "plansys2_domain_expert/DomainExpertClient.hpp"
+#include "plansys2_core/ServiceMultiplexer.hpp"
 #include "plansys2_core/Types.hpp"
 
 #include "std_msgs/msg/string.hpp"
@@ -32,6 +38,7 @@
 #include "plansys2_msgs/srv/affect_node.hpp"
 #include "plansys2_msgs/srv/affect_param.hpp"
 #include "plansys2_msgs/srv/exist_node.hpp"
+#include "plansys2_msgs/srv/get_changes_since.hpp"
 #include "plansys2_msgs/srv/get_problem.hpp"
 #include "plansys2_msgs/srv/get_problem_goal.hpp"
 #include "plansys2_msgs/srv/get_problem_instance_details.hpp"
@@ -39,8 +46,12 @@
 #include "plansys2_msgs/srv/get_node_details.hpp"
 #include "plansys2_msgs/srv/get_states.hpp"
 #include "plansys2_msgs/srv/is_problem_goal_satisfied.hpp"
+#include "plansys2_msgs/srv/manage_knowledge_context.hpp"
+#include "plansys2_msgs/srv/modify_functions.hpp"
+#include "plansys2_msgs/srv/query_predicates.hpp"
 #include "plansys2_msgs/srv/remove_problem_goal.hpp"
 #include "plansys2_msgs/srv/clear_problem_knowledge.hpp"
+#include "plansys2_msgs/srv/conditional_update.hpp"
 
 #include "rclcpp/rclcpp.hpp"
 
@@ -52,6 +63,30 @@ class ProblemExpertClient : public ProblemExpertInterface
 public:
   ProblemExpertClient();
 
+  /// Client of the problem expert in a namespace.
+  explicit ProblemExpertClient(const std::string & problem_expert_namespace);
+
+  /// Client of a knowledge partitioned among several problem experts.
+  /**
+   * Each problem expert is a shard configured with its index in shard_namespaces, the
+   * number of shards and the same policy (parameters shard_id, num_shards and
+   * sharding_policy). Predicates and functions are routed to the shard owning them, as
+   * given by get_shard, and the queries of the whole state are gathered from all the shards
+   * concurrently. Instances are added to every shard, and the goal is kept by the first one.
+   *
+   * Derived predicates are inferred by this client over the facts of all the shards, as
+   * their preconditions may be owned by any shard. A batch of modifyFunctions is split by
+   * owning shard, and it is only atomic within each shard. getRevision and getChangesSince
+   * are not available, as each shard has its own journal, so clients always resync, and
+   * neither is applyChangesIf. getFingerprint combines the fingerprints of the shards.
+   *
+   * \param[in] shard_namespaces The namespaces of the problem experts, by shard index.
+   * \param[in] policy How the facts are partitioned.
+   */
+  ProblemExpertClient(
+    const std::vector<std::string> & shard_namespaces,
+    ShardingPolicy policy = ShardingPolicy::BY_SYMBOL);
+
   std::vector<plansys2::Instance> getInstances();
   bool addInstance(const plansys2::Instance & instance);
   bool removeInstance(const plansys2::Instance & instance);
@@ -62,6 +97,7 @@ public:
   bool removePredicate(const plansys2::Predicate & predicate);
   bool existPredicate(const plansys2::Predicate & predicate);
   std::optional<plansys2::Predicate> getPredicate(const std::string & predicate);
+  std::vector<plansys2::Predicate> queryPredicates(const plansys2::Predicate & pattern);
 
   std::vector<plansys2::Function> getFunctions();
   bool addFunction(const plansys2::Function & function);
@@ -69,6 +105,19 @@ public:
   bool existFunction(const plansys2::Function & function);
   bool updateFunction(const plansys2::Function & function);
   std::optional<plansys2::Function> getFunction(const std::string & function);
+  std::optional<plansys2::Function> modifyFunction(const plansys2::Function & modifier);
+
+  /// Apply a batch of function modifiers atomically: all of them, or none if one fails.
+  /**
+   * With a partitioned knowledge, the batch is split by the shard owning each function. There
+   * is no atomic update across shards, so if the part of a shard is rejected, the parts
+   * already applied in other shards are kept.
+   *
+   * \param[in] modifiers The function modifiers.
+   * \return The functions modified, or nullopt if the batch was rejected.
+   */
+  std::optional<std::vector<plansys2::Function>> modifyFunctions(
+    const std::vector<plansys2::Function> & modifiers);
 
   plansys2::Goal getGoal();
   bool setGoal(const plansys2::Goal & goal);
@@ -83,57 +132,122 @@ public:
 
   bool addProblem(const std::string & problem_str);
 
-  rclcpp::Time getUpdateTime() const {return update_time_;}
+  uint64_t getRevision();
+  std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>> getChangesSince(
+    uint64_t revision);
+  plansys2_msgs::msg::StateFingerprint getFingerprint();
+  ConditionalUpdateResult applyChangesIf(
+    const std::vector<plansys2_msgs::msg::KnowledgeChange> & changes,
+    uint64_t expected_revision,
+    const plansys2_msgs::msg::Tree & condition,
+    uint64_t & revision);
+
+  /// Select the knowledge context the next requests of this client work on.
+  /**
+   * Contexts other than the default one are only reachable through the multiplexed
+   * endpoint of the problem expert.
+   *
+   * \param[in] context The name of the context, or empty for the default one.
+   */
+  void setContext(const std::string & context);
+  const std::string & getContext() const {return context_;}
+
+  /// Create a knowledge context, empty, sharing the domain with the rest.
+  bool createContext(const std::string & context);
+
+  /// Remove a knowledge context and all its knowledge.
+  bool removeContext(const std::string & context);
+
+  /// Get the names of the knowledge contexts, besides the default one.
+  std::vector<std::string> getContexts();
+
+  rclcpp::Time getUpdateTime() const;
 
 private:
-  rclcpp::Client<plansys2_msgs::srv::AddProblem>::SharedPtr
+  ProblemExpertClient & getShardClient(const plansys2_msgs::msg::Node & fact);
+  bool forEachShard(std::function<bool(ProblemExpertClient &)> request);
+  template<class T>
+  std::vector<T> gatherFromShards(
+    std::function<std::vector<T>(ProblemExpertClient &)> request,
+    const std::vector<size_t> & shard_ids = {});
+  std::optional<std::vector<plansys2::Function>> modifyShardedFunctions(
+    const std::vector<plansys2::Function> & modifiers);
+  std::vector<plansys2::Predicate> getShardedPredicates();
+  bool existShardedPredicate(const plansys2::Predicate & predicate);
+  bool isGoalSatisfiedInShards(const plansys2::Goal & goal);
+  std::string getShardedProblem();
+  std::vector<plansys2_msgs::msg::Derived> getDerivedPredicates();
+  DomainExpertClient & getDomainClient();
+
+  std::optional<plansys2_msgs::srv::GetChangesSince::Response> requestChangesSince(
+    uint64_t revision);
+  std::optional<plansys2_msgs::srv::ManageKnowledgeContext::Response> manageContext(
+    uint8_t operation, const std::string & context);
+
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AddProblem>>
     add_problem_client_;
-  rclcpp::Client<plansys2_msgs::srv::AddProblemGoal>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AddProblemGoal>>
     add_problem_goal_client_;
-  rclcpp::Client<plansys2_msgs::srv::AffectParam>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AffectParam>>
     add_problem_instance_client_;
-  rclcpp::Client<plansys2_msgs::srv::AffectNode>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AffectNode>>
     add_problem_predicate_client_;
-  rclcpp::Client<plansys2_msgs::srv::AffectNode>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AffectNode>>
     add_problem_function_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetProblemGoal>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetProblemGoal>>
     get_problem_goal_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetProblemInstanceDetails>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetProblemInstanceDetails>>
     get_problem_instance_details_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetProblemInstances>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetProblemInstances>>
     get_problem_instances_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetNodeDetails>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetNodeDetails>>
     get_problem_predicate_details_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetStates>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetStates>>
     get_problem_predicates_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetNodeDetails>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::QueryPredicates>>
+    query_problem_predicates_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetNodeDetails>>
     get_problem_function_details_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetStates>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetStates>>
     get_problem_functions_client_;
-  rclcpp::Client<plansys2_msgs::srv::GetProblem>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetProblem>>
     get_problem_client_;
-  rclcpp::Client<plansys2_msgs::srv::RemoveProblemGoal>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::RemoveProblemGoal>>
     remove_problem_goal_client_;
-  rclcpp::Client<plansys2_msgs::srv::ClearProblemKnowledge>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::ClearProblemKnowledge>>
     clear_problem_knowledge_client_;
-  rclcpp::Client<plansys2_msgs::srv::AffectParam>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AffectParam>>
     remove_problem_instance_client_;
-  rclcpp::Client<plansys2_msgs::srv::AffectNode>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AffectNode>>
     remove_problem_predicate_client_;
-  rclcpp::Client<plansys2_msgs::srv::AffectNode>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AffectNode>>
     remove_problem_function_client_;
-  rclcpp::Client<plansys2_msgs::srv::ExistNode>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::ExistNode>>
     exist_problem_predicate_client_;
-  rclcpp::Client<plansys2_msgs::srv::ExistNode>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::ExistNode>>
     exist_problem_function_client_;
-  rclcpp::Client<plansys2_msgs::srv::AffectNode>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::AffectNode>>
     update_problem_function_client_;
-  rclcpp::Client<plansys2_msgs::srv::IsProblemGoalSatisfied>::SharedPtr
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::ModifyFunctions>>
+    modify_problem_functions_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::GetChangesSince>>
+    get_changes_since_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::IsProblemGoalSatisfied>>
     is_problem_goal_satisfied_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::ManageKnowledgeContext>>
+    manage_knowledge_context_client_;
+  std::shared_ptr<MultiplexedClient<plansys2_msgs::srv::ConditionalUpdate>>
+    conditional_update_client_;
   rclcpp::Subscription<std_msgs::msg::String>::SharedPtr problem_sub_;
 
   rclcpp::Node::SharedPtr node_;
+  std::shared_ptr<MultiplexedEndpoint> endpoint_;
   rclcpp::Time update_time_;
+  std::string context_;
+
+  std::vector<std::shared_ptr<ProblemExpertClient>> shards_;
+  ShardingPolicy sharding_policy_ {ShardingPolicy::BY_SYMBOL};
+  std::shared_ptr<DomainExpertClient> domain_client_;
 };
 
 }  // namespace plansys2
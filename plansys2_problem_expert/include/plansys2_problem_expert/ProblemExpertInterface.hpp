@@ -18,8 +18,10 @@
 #include <string>
 #include <vector>
 
+#include "plansys2_msgs/msg/knowledge_change.hpp"
 #include "plansys2_msgs/msg/node.hpp"
 #include "plansys2_msgs/msg/param.hpp"
+#include "plansys2_msgs/msg/state_fingerprint.hpp"
 #include "plansys2_msgs/msg/tree.hpp"
 
 #include "plansys2_core/Types.hpp"
@@ -27,6 +29,15 @@
 namespace plansys2
 {
 
+/// Outcome of a conditional update, with the values of ConditionalUpdate.srv.
+enum class ConditionalUpdateResult
+{
+  APPLIED = 0,
+  REVISION_CONFLICT = 1,
+  CONDITION_FAILED = 2,
+  INVALID_CHANGE = 3
+};
+
 class ProblemExpertInterface
 {
 public:
@@ -42,6 +53,8 @@ public:
   virtual bool removePredicate(const plansys2::Predicate & predicate) = 0;
   virtual bool existPredicate(const plansys2::Predicate & predicate) = 0;
   virtual std::optional<plansys2::Predicate> getPredicate(const std::string & expr) = 0;
+  virtual std::vector<plansys2::Predicate> queryPredicates(
+    const plansys2::Predicate & pattern) = 0;
 
   virtual std::vector<plansys2::Function> getFunctions() = 0;
   virtual bool addFunction(const plansys2::Function & function) = 0;
@@ -49,6 +62,10 @@ public:
   virtual bool existFunction(const plansys2::Function & function) = 0;
   virtual bool updateFunction(const plansys2::Function & function) = 0;
   virtual std::optional<plansys2::Function> getFunction(const std::string & expr) = 0;
+  virtual std::optional<plansys2::Function> modifyFunction(
+    const plansys2::Function & modifier) = 0;
+  virtual std::optional<std::vector<plansys2::Function>> modifyFunctions(
+    const std::vector<plansys2::Function> & modifiers) = 0;
 
   virtual plansys2::Goal getGoal() = 0;
   virtual bool setGoal(const plansys2::Goal & goal) = 0;
@@ -59,6 +76,31 @@ public:
 
   virtual std::string getProblem() = 0;
   virtual bool addProblem(const std::string & problem_str) = 0;
+
+  virtual uint64_t getRevision() = 0;
+  virtual std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>> getChangesSince(
+    uint64_t revision) = 0;
+  virtual plansys2_msgs::msg::StateFingerprint getFingerprint() = 0;
+
+  /// Apply a batch of updates atomically, only if the knowledge is as expected.
+  /**
+   * Writers do read-modify-write cycles without locks: they read the knowledge and its
+   * revision, and write conditioned on it, retrying from the returned revision on conflict.
+   * Nothing is applied unless every condition holds and every change is valid.
+   *
+   * \param[in] changes ADD_PREDICATE, REMOVE_PREDICATE and UPDATE_FUNCTION changes, applied
+   *            in order as a single revision, as applyChanges does.
+   * \param[in] expected_revision The revision the changes are based on, or 0 for any.
+   * \param[in] condition A PDDL expression that must hold, as (= (battery r1) 50), or empty.
+   * \param[out] revision The revision after the call: the new one, or the current one if the
+   *            changes were not applied.
+   * \return If the changes were applied, or why not.
+   */
+  virtual ConditionalUpdateResult applyChangesIf(
+    const std::vector<plansys2_msgs::msg::KnowledgeChange> & changes,
+    uint64_t expected_revision,
+    const plansys2_msgs::msg::Tree & condition,
+    uint64_t & revision) = 0;
 };
 
 }  // namespace plansys2
@@ -15,20 +15,26 @@
 #ifndef PLANSYS2_PROBLEM_EXPERT__PROBLEMEXPERTNODE_HPP_
 #define PLANSYS2_PROBLEM_EXPERT__PROBLEMEXPERTNODE_HPP_
 
+#include <map>
 #include <memory>
+#include <string>
 
+#include "plansys2_core/ServiceMultiplexer.hpp"
 #include "plansys2_problem_expert/ProblemExpert.hpp"
+#include "plansys2_problem_expert/UpdateCoalescer.hpp"
 
 #include "std_msgs/msg/string.hpp"
 #include "std_msgs/msg/empty.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "lifecycle_msgs/msg/transition.hpp"
 #include "plansys2_msgs/msg/knowledge.hpp"
+#include "plansys2_msgs/msg/knowledge_change.hpp"
 #include "plansys2_msgs/srv/affect_node.hpp"
 #include "plansys2_msgs/srv/affect_param.hpp"
 #include "plansys2_msgs/srv/add_problem.hpp"
 #include "plansys2_msgs/srv/add_problem_goal.hpp"
 #include "plansys2_msgs/srv/exist_node.hpp"
+#include "plansys2_msgs/srv/get_changes_since.hpp"
 #include "plansys2_msgs/srv/get_problem.hpp"
 #include "plansys2_msgs/srv/get_problem_goal.hpp"
 #include "plansys2_msgs/srv/get_problem_instance_details.hpp"
@@ -36,8 +42,12 @@
 #include "plansys2_msgs/srv/get_node_details.hpp"
 #include "plansys2_msgs/srv/get_states.hpp"
 #include "plansys2_msgs/srv/is_problem_goal_satisfied.hpp"
+#include "plansys2_msgs/srv/manage_knowledge_context.hpp"
+#include "plansys2_msgs/srv/modify_functions.hpp"
+#include "plansys2_msgs/srv/query_predicates.hpp"
 #include "plansys2_msgs/srv/remove_problem_goal.hpp"
 #include "plansys2_msgs/srv/clear_problem_knowledge.hpp"
+#include "plansys2_msgs/srv/conditional_update.hpp"
 
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
@@ -48,7 +58,15 @@ namespace plansys2
 class ProblemExpertNode : public rclcpp_lifecycle::LifecycleNode
 {
 public:
-  ProblemExpertNode();
+  /// Problem expert node.
+  /**
+   * \param[in] problem_expert_namespace The namespace of the node, as each shard of a
+   *   partitioned knowledge has its own.
+   * \param[in] options The options of the node.
+   */
+  explicit ProblemExpertNode(
+    const std::string & problem_expert_namespace = "",
+    const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
   using CallbackReturnT =
     rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
@@ -172,9 +190,64 @@ public:
     const std::shared_ptr<plansys2_msgs::srv::AffectNode::Request> request,
     const std::shared_ptr<plansys2_msgs::srv::AffectNode::Response> response);
 
+  void get_changes_since_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::GetChangesSince::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::GetChangesSince::Response> response);
+
+  void conditional_update_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::ConditionalUpdate::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::ConditionalUpdate::Response> response);
+
+  void manage_knowledge_context_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::ManageKnowledgeContext::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::ManageKnowledgeContext::Response> response);
+
+  void query_problem_predicates_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::QueryPredicates::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::QueryPredicates::Response> response);
+
+  void modify_problem_functions_service_callback(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const std::shared_ptr<plansys2_msgs::srv::ModifyFunctions::Request> request,
+    const std::shared_ptr<plansys2_msgs::srv::ModifyFunctions::Response> response);
+
 private:
+  void update_stream_callback(const plansys2_msgs::msg::KnowledgeChange::SharedPtr msg);
+  void apply_update_stream();
+
+  /// A knowledge context: a problem of the domain, with the topics where it is published.
+  struct KnowledgeContext
+  {
+    std::shared_ptr<ProblemExpert> problem_expert;
+    rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::Empty>::SharedPtr update_pub;
+    rclcpp_lifecycle::LifecyclePublisher<plansys2_msgs::msg::Knowledge>::SharedPtr
+      knowledge_pub;
+    rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::String>::SharedPtr problem_pub;
+  };
+
+  /// Make a context the current one, the one the service callbacks work on.
+  /**
+   * The selected context is shared by all the callbacks, so they must run one at a time, as
+   * they do in the default callback group of the node, which is mutually exclusive. The
+   * services and timers of the node are created in it, and this is asserted.
+   *
+   * \param[in] context The name of the context, or empty for the default one.
+   * \return If the context exists.
+   */
+  bool select_context(const std::string & context);
+  std::shared_ptr<ProblemExpert> create_problem_expert() const;
+  plansys2_msgs::msg::Knowledge::SharedPtr get_knowledge_as_msg(
+    ProblemExpert & problem_expert) const;
+
   std::shared_ptr<ProblemExpert> problem_expert_;
+  std::shared_ptr<DomainExpert> domain_expert_;
+  std::map<std::string, KnowledgeContext> contexts_;
 
+  std::shared_ptr<ServiceMultiplexer> multiplexer_;
   rclcpp::Service<plansys2_msgs::srv::AddProblem>::SharedPtr
     add_problem_service_;
   rclcpp::Service<plansys2_msgs::srv::AddProblemGoal>::SharedPtr
@@ -219,10 +292,24 @@ private:
     exist_problem_function_service_;
   rclcpp::Service<plansys2_msgs::srv::AffectNode>::SharedPtr
     update_problem_function_service_;
+  rclcpp::Service<plansys2_msgs::srv::ModifyFunctions>::SharedPtr
+    modify_problem_functions_service_;
+  rclcpp::Service<plansys2_msgs::srv::GetChangesSince>::SharedPtr
+    get_changes_since_service_;
+  rclcpp::Service<plansys2_msgs::srv::QueryPredicates>::SharedPtr
+    query_problem_predicates_service_;
+  rclcpp::Service<plansys2_msgs::srv::ManageKnowledgeContext>::SharedPtr
+    manage_knowledge_context_service_;
+  rclcpp::Service<plansys2_msgs::srv::ConditionalUpdate>::SharedPtr
+    conditional_update_service_;
 
   rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::Empty>::SharedPtr update_pub_;
   rclcpp_lifecycle::LifecyclePublisher<plansys2_msgs::msg::Knowledge>::SharedPtr knowledge_pub_;
   rclcpp_lifecycle::LifecyclePublisher<std_msgs::msg::String>::SharedPtr problem_pub_;
+
+  rclcpp::Subscription<plansys2_msgs::msg::KnowledgeChange>::SharedPtr update_stream_sub_;
+  rclcpp::TimerBase::SharedPtr update_stream_timer_;
+  UpdateCoalescer update_coalescer_;
 };
 
 }  // namespace plansys2
@@ -0,0 +1,58 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__SHARDING_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__SHARDING_HPP_
+
+#include <cstddef>
+#include <string>
+
+#include "plansys2_msgs/msg/node.hpp"
+
+namespace plansys2
+{
+
+/// How the facts of the knowledge are partitioned among several problem experts.
+enum class ShardingPolicy
+{
+  /// All the facts of a predicate or function symbol are in the same shard.
+  BY_SYMBOL,
+  /// Facts are partitioned by their first object. Facts with no objects fall back to
+  /// their symbol.
+  BY_OBJECT
+};
+
+/// Parse a sharding policy ("symbol" or "object").
+/**
+ * \param[in] policy The name of the policy.
+ * \return The policy, or BY_SYMBOL if the name is unknown.
+ */
+ShardingPolicy sharding_policy_from_string(const std::string & policy);
+
+/// Get the shard owning a predicate or function.
+/**
+ * The hash is stable across processes, so every client and every shard agree on the owner
+ * of a fact.
+ *
+ * \param[in] fact The predicate or function. Only its name and parameters are used.
+ * \param[in] num_shards The number of shards.
+ * \param[in] policy The sharding policy.
+ * \return The index of the shard, in [0, num_shards).
+ */
+size_t get_shard(
+  const plansys2_msgs::msg::Node & fact, size_t num_shards, ShardingPolicy policy);
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__SHARDING_HPP_
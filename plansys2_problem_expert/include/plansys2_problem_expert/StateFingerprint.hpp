@@ -0,0 +1,102 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__STATEFINGERPRINT_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__STATEFINGERPRINT_HPP_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "plansys2_core/Types.hpp"
+#include "plansys2_msgs/msg/knowledge_change.hpp"
+#include "plansys2_msgs/msg/state_fingerprint.hpp"
+
+namespace plansys2
+{
+
+/// Incremental 128-bit fingerprint of the predicates and functions of a state.
+/**
+ * The fingerprint is the XOR of a key for each fact, so adding or removing a fact updates
+ * it in constant time, and two states with the same facts get the same fingerprint no
+ * matter the order in which they were built. Keys are hashes of the facts with fixed
+ * seeds, so every process computes the same fingerprint for the same state.
+ *
+ * The key of a function includes its value quantized to a multiple of the quantum, or the
+ * exact value when the quantum is 0. Fingerprints are only comparable if computed with the
+ * same quantum. Instances and goals are not part of the state.
+ */
+class StateFingerprint
+{
+public:
+  explicit StateFingerprint(double function_quantum = 0.0);
+
+  /// Set the quantum of the function values. The state is cleared.
+  void setFunctionQuantum(double function_quantum);
+  double getFunctionQuantum() const {return function_quantum_;}
+
+  /// Add a predicate absent from the state, or remove a predicate in it.
+  void togglePredicate(const plansys2::Predicate & predicate);
+
+  /// Set the value of a function, replacing its previous value.
+  void setFunction(const plansys2::Function & function);
+  void removeFunction(const plansys2::Function & function);
+
+  /// Update the fingerprint with a change of the knowledge.
+  void apply(const plansys2_msgs::msg::KnowledgeChange & change);
+
+  void clear();
+
+  const plansys2_msgs::msg::StateFingerprint & get() const {return fingerprint_;}
+
+  /// Get the fingerprint of a whole state.
+  /**
+   * \param[in] predicates The predicates of the state, without duplicates.
+   * \param[in] functions The functions of the state, without duplicates.
+   * \param[in] function_quantum The quantum of the function values, or 0 for exact values.
+   * \return The fingerprint, the same as adding the facts one by one.
+   */
+  static plansys2_msgs::msg::StateFingerprint compute(
+    const std::vector<plansys2::Predicate> & predicates,
+    const std::vector<plansys2::Function> & functions,
+    double function_quantum = 0.0);
+
+  /// Get the fingerprint of the union of two disjoint states, as the shards of a knowledge.
+  static plansys2_msgs::msg::StateFingerprint combine(
+    const plansys2_msgs::msg::StateFingerprint & fingerprint_1,
+    const plansys2_msgs::msg::StateFingerprint & fingerprint_2);
+
+  /// Key of a predicate, to be combined with a fingerprint to add or remove it.
+  static plansys2_msgs::msg::StateFingerprint predicateKey(const plansys2::Predicate & predicate);
+
+  /// Key of a function with its current value.
+  static plansys2_msgs::msg::StateFingerprint functionKey(
+    const plansys2::Function & function, double function_quantum = 0.0);
+
+  /// Fingerprint as 32 hexadecimal digits.
+  static std::string toString(const plansys2_msgs::msg::StateFingerprint & fingerprint);
+
+private:
+  void toggle(const plansys2_msgs::msg::StateFingerprint & key);
+
+  double function_quantum_;
+  plansys2_msgs::msg::StateFingerprint fingerprint_;
+  // Key of the current value of each function, by function id
+  std::unordered_map<std::string, plansys2_msgs::msg::StateFingerprint> function_keys_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__STATEFINGERPRINT_HPP_
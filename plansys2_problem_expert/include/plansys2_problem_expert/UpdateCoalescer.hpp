@@ -0,0 +1,56 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_PROBLEM_EXPERT__UPDATECOALESCER_HPP_
+#define PLANSYS2_PROBLEM_EXPERT__UPDATECOALESCER_HPP_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "plansys2_msgs/msg/knowledge_change.hpp"
+
+namespace plansys2
+{
+
+/// Coalesces the updates of predicates and functions received during a window.
+/**
+ * Only the last update of each predicate or function is kept: the last value of a function,
+ * and whether a predicate was last added or removed, which is the net effect of all its
+ * updates. Updates are returned in the order each predicate or function was first updated.
+ */
+class UpdateCoalescer
+{
+public:
+  /// Add an update.
+  /**
+   * \param[in] change An ADD_PREDICATE, REMOVE_PREDICATE or UPDATE_FUNCTION change.
+   * \return false if the change is of any other type, and it is ignored.
+   */
+  bool add(const plansys2_msgs::msg::KnowledgeChange & change);
+
+  /// Get the coalesced updates and start a new window.
+  std::vector<plansys2_msgs::msg::KnowledgeChange> flush();
+
+  bool empty() const {return pending_.empty();}
+  size_t size() const {return pending_.size();}
+
+private:
+  std::vector<plansys2_msgs::msg::KnowledgeChange> pending_;
+  std::unordered_map<std::string, size_t> index_;
+};
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_PROBLEM_EXPERT__UPDATECOALESCER_HPP_
@@ -16,15 +16,19 @@
 #define PLANSYS2_PROBLEM_EXPERT__UTILS_HPP_
 
 #include <tuple>
+#include <limits>
 #include <memory>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <optional>
 #include <vector>
 #include <set>
 #include <utility>
 
 #include "plansys2_problem_expert/ProblemExpertClient.hpp"
 #include "plansys2_domain_expert/DomainExpertClient.hpp"
+#include "plansys2_msgs/msg/derived.hpp"
 #include "plansys2_msgs/msg/tree.hpp"
 
 namespace plansys2
@@ -67,6 +71,185 @@ std::tuple<bool, bool, double> evaluate(
   bool apply = false,
   uint32_t node_id = 0);
 
+/// Compute the result of a numeric function modifier.
+/**
+ * \param[in] modifier_type The modifier (ASSIGN, INCREASE, DECREASE, SCALE_UP, SCALE_DOWN).
+ * \param[in] value The current value of the function.
+ * \param[in] operand The value the function is modified by.
+ * \return The new value of the function, or nothing if the modifier is unknown or it
+ *         divides by zero.
+ */
+std::optional<double> modify_value(uint8_t modifier_type, double value, double operand);
+
+/// Objects of a problem, identified by consecutive integers.
+class ObjectTable
+{
+public:
+  using Id = uint32_t;
+
+  /// Get the identifier of an object, adding it to the table if it is not there yet.
+  Id id(const std::string & name);
+
+  const std::string & name(Id id) const {return names_[id];}
+  size_t size() const {return names_.size();}
+
+private:
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, Id> ids_;
+};
+
+/// A PDDL expression with its parameters resolved to variable indices.
+/**
+ * The variables of the expression are its free variables, in the given order, followed by
+ * the ones quantified by each EXISTS node, which are in the scope of its body only. Names are
+ * resolved once, when the tree is compiled. Parameters that are not variables are objects.
+ */
+struct LiftedTree
+{
+  explicit LiftedTree(
+    const plansys2_msgs::msg::Tree & tree,
+    const std::vector<std::string> & variables = {});
+
+  const plansys2_msgs::msg::Tree & tree;
+  std::vector<std::vector<int>> args;  // variable of each parameter of each node, or -1
+  std::vector<size_t> scope;  // number of variables in the scope of each node
+  size_t n_variables;  // size of the largest scope
+};
+
+/// Objects bound to the variables of a lifted PDDL expression.
+/**
+ * Variable i takes the object ids[i] of the table. A default constructed binding has no
+ * variables, and evaluates a ground expression: its parameters are objects.
+ */
+struct ParameterBinding
+{
+  static constexpr ObjectTable::Id UNBOUND = std::numeric_limits<ObjectTable::Id>::max();
+
+  ParameterBinding() = default;
+  ParameterBinding(const LiftedTree & lifted, ObjectTable & objects);
+
+  /// Name of the object a parameter of a node takes. Unbound variables keep their own name.
+  const std::string & resolve(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id, size_t param) const;
+
+  /// Copy of a node with its parameters replaced by the objects they take.
+  plansys2_msgs::msg::Node ground(const plansys2_msgs::msg::Tree & tree, uint32_t node_id) const;
+
+  const LiftedTree * lifted = nullptr;
+  ObjectTable * objects = nullptr;
+  std::vector<ObjectTable::Id> ids;
+};
+
+/// The state a PDDL expression is evaluated in, and its effects are applied to.
+/**
+ * Facts are looked up as a node of an expression and the binding of its parameters, so that
+ * lifted expressions are evaluated without grounding their leaves. Effects are applied with
+ * ground facts.
+ */
+class EvaluationState
+{
+public:
+  virtual ~EvaluationState() = default;
+
+  virtual bool existPredicate(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) = 0;
+  virtual std::optional<double> getFunctionValue(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) = 0;
+
+  virtual bool addPredicate(const plansys2::Predicate & predicate) = 0;
+  virtual bool removePredicate(const plansys2::Predicate & predicate) = 0;
+
+  /// Modify the value of a function, see modify_value.
+  /**
+   * \return The new value of the function, or nothing if it does not exist or the modifier
+   *         fails.
+   */
+  virtual std::optional<double> modifyFunction(
+    const plansys2::Function & function, uint8_t modifier_type, double operand) = 0;
+
+  /// Evaluate an EXISTS node, usually with evaluate_exists on a snapshot of the state.
+  virtual std::tuple<bool, bool, double> evaluateExists(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id, ParameterBinding & binding) = 0;
+};
+
+/// Evaluate a PDDL expression for a parameter binding.
+/**
+ * This is the evaluator all the other evaluate, check and apply functions use. The
+ * parameters of the leaves are resolved through the binding when they are looked up in the
+ * state, so a lifted tree can be evaluated for any number of bindings without grounding a
+ * copy of it. The variables quantified by EXISTS nodes are bound in the binding while they
+ * are searched, and unbound again before returning.
+ *
+ * \param[in] tree The PDDL expression.
+ * \param[in] binding The objects bound to the variables of the expression.
+ * \param[in] state The state to evaluate the expression in.
+ * \param[in] apply Apply the effects of the expression to the state.
+ * \param[in] node_id The root node of the expression to evaluate.
+ * \param[in] negate Invert the truth value.
+ * \return result <- tuple(bool, bool, double), as in evaluate.
+ */
+std::tuple<bool, bool, double> evaluate(
+  const plansys2_msgs::msg::Tree & tree,
+  ParameterBinding & binding,
+  EvaluationState & state,
+  bool apply = false,
+  uint32_t node_id = 0,
+  bool negate = false);
+
+/// Evaluate a lifted PDDL expression for a parameter binding, in a vector state.
+/**
+ * \param[in] tree The lifted PDDL expression.
+ * \param[in] binding The objects bound to the variables of the expression.
+ * \param[in] predicates Current predicates state.
+ * \param[in] functions Current functions state.
+ * \param[in] node_id The root node of the expression to evaluate.
+ * \param[in] negate Invert the truth value.
+ * \return result <- tuple(bool, bool, double), as in evaluate.
+ */
+std::tuple<bool, bool, double> evaluate(
+  const plansys2_msgs::msg::Tree & tree,
+  ParameterBinding & binding,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id = 0,
+  bool negate = false);
+
+/// Evaluate an EXISTS node of a PDDL expression tree.
+/**
+ * The quantified variables are bound incrementally by joining the positive literals of the
+ * quantified condition with the predicates of the state, starting by the most selective one.
+ * Variables not fixed by any literal only range over the instances of their declared type.
+ * The search stops at the first binding that satisfies the condition, without enumerating
+ * the cartesian product of the candidates.
+ *
+ * \param[in] tree The tree containing the EXISTS node.
+ * \param[in] instances Current instances. If empty, the objects of the predicates are used.
+ * \param[in] predicates Current predicates state.
+ * \param[in] functions Current functions state.
+ * \param[in] node_id The id of the EXISTS node.
+ * \param[in] binding Objects bound to the free variables of the EXISTS node.
+ * \return result <- tuple(bool, bool, double)
+ *         result(0) true if success
+ *         result(1) true if there is a binding that satisfies the condition
+ *         result(2) always 0
+ */
+std::tuple<bool, bool, double> evaluate_exists(
+  const plansys2_msgs::msg::Tree & tree,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id,
+  ParameterBinding & binding);
+
+std::tuple<bool, bool, double> evaluate_exists(
+  const plansys2_msgs::msg::Tree & tree,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id);
+
 /// Check a PDDL expression represented as a tree.
 /**
 * \param[in] node The root node of the PDDL expression.
@@ -86,6 +269,13 @@ bool check(
   std::vector<plansys2::Function> & functions,
   uint32_t node_id = 0);
 
+bool check(
+  const plansys2_msgs::msg::Tree & tree,
+  ParameterBinding & binding,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id = 0);
+
 /// Apply a PDDL expression represented as a tree.
 /**
  * \param[in] node The root node of the PDDL expression.
@@ -105,6 +295,37 @@ bool apply(
   std::vector<plansys2::Function> & functions,
   uint32_t node_id = 0);
 
+/// Infer the derived predicates that hold in a state.
+/**
+ * Each derived predicate is grounded with the instances of the types of its parameters, and
+ * it holds if its preconditions hold over the predicates and functions of the state.
+ *
+ * \param[in] derived_predicates The derived predicates of the domain.
+ * \param[in] instances The instances of the problem.
+ * \param[in] predicates The predicates of the state.
+ * \param[in] functions The functions of the state.
+ * \return The derived predicates that hold.
+ */
+std::vector<plansys2::Predicate> infer_derived_predicates(
+  const std::vector<plansys2_msgs::msg::Derived> & derived_predicates,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions);
+
+/// Check if a derived predicate holds in a state.
+/**
+ * \param[in] derived_predicates The definitions of the derived predicate.
+ * \param[in] predicate The ground derived predicate.
+ * \param[in] predicates The predicates of the state.
+ * \param[in] functions The functions of the state.
+ * \return If the preconditions of one of the definitions hold.
+ */
+bool check_derived_predicate(
+  const std::vector<plansys2_msgs::msg::Derived> & derived_predicates,
+  const plansys2::Predicate & predicate,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions);
+
 /// Parse the action expression and time (optional) from an input string.
 /**
 * \param[in] input The input string.
@@ -175,6 +396,22 @@ void  cart_product(
   std::vector<std::vector<std::string>>::const_iterator me,
   std::vector<std::vector<std::string>>::const_iterator end);
 
+/// Write a PDDL problem.
+/**
+ * \param[in] domain_str The PDDL domain the problem is for.
+ * \param[in] instances The objects of the problem. Constants of the domain are skipped.
+ * \param[in] predicates The predicates of the initial state.
+ * \param[in] functions The functions of the initial state.
+ * \param[in] goal The goal.
+ * \return The PDDL problem.
+ */
+std::string write_problem(
+  const std::string & domain_str,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  const plansys2::Goal & goal);
+
 }  // namespace plansys2
 
 
@@ -0,0 +1,114 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_problem_expert/ChangeJournal.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace plansys2
+{
+
+ChangeJournal::ChangeJournal(size_t capacity)
+: buffer_(capacity),
+  next_(0),
+  size_(0),
+  revision_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count()),
+  complete_since_(revision_)
+{
+}
+
+void
+ChangeJournal::setCapacity(size_t capacity)
+{
+  buffer_.clear();
+  buffer_.resize(capacity);
+  next_ = 0;
+  size_ = 0;
+  complete_since_ = revision_;
+}
+
+uint64_t
+ChangeJournal::record(plansys2_msgs::msg::KnowledgeChange change)
+{
+  change.revision = ++revision_;
+  push(std::move(change));
+
+  return revision_;
+}
+
+uint64_t
+ChangeJournal::record(std::vector<plansys2_msgs::msg::KnowledgeChange> changes)
+{
+  if (changes.empty()) {
+    return revision_;
+  }
+
+  ++revision_;
+  for (auto & change : changes) {
+    change.revision = revision_;
+    push(std::move(change));
+  }
+
+  return revision_;
+}
+
+void
+ChangeJournal::push(plansys2_msgs::msg::KnowledgeChange change)
+{
+  if (buffer_.empty()) {
+    complete_since_ = revision_;
+    return;
+  }
+
+  if (size_ == buffer_.size()) {
+    // The revision of the evicted change may have other changes left, so it is incomplete
+    complete_since_ = std::max(complete_since_, buffer_[next_].revision);
+  }
+
+  buffer_[next_] = std::move(change);
+  next_ = (next_ + 1) % buffer_.size();
+  size_ = std::min(size_ + 1, buffer_.size());
+}
+
+std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>>
+ChangeJournal::getChangesSince(uint64_t revision) const
+{
+  if (revision > revision_ || revision < complete_since_) {
+    return {};
+  }
+
+  size_t count = 0;
+  while (count < size_ &&
+    buffer_[(next_ + buffer_.size() - count - 1) % buffer_.size()].revision > revision)
+  {
+    count++;
+  }
+
+  std::vector<plansys2_msgs::msg::KnowledgeChange> ret;
+  ret.reserve(count);
+
+  size_t first = (next_ + buffer_.size() - count) % std::max<size_t>(buffer_.size(), 1);
+  for (size_t i = 0; i < count; i++) {
+    ret.push_back(buffer_[(first + i) % buffer_.size()]);
+  }
+
+  return ret;
+}
+
+}  // namespace plansys2
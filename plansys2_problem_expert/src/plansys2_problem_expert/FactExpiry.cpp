@@ -0,0 +1,110 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_problem_expert/FactExpiry.hpp"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plansys2
+{
+
+namespace
+{
+
+std::string fact_key(const plansys2_msgs::msg::Node & fact)
+{
+  std::string key = std::to_string(fact.node_type) + fact.name;
+  for (const auto & param : fact.parameters) {
+    key += " " + param.name;
+  }
+  return key;
+}
+
+}  // namespace
+
+void
+FactExpiry::set(const plansys2_msgs::msg::Node & fact, std::chrono::nanoseconds expiration)
+{
+  auto key = fact_key(fact);
+  heap_.push({expiration, key});
+  facts_[std::move(key)] = {expiration, fact};
+
+  if (heap_.size() > 2 * facts_.size() + 64) {
+    std::vector<Entry> entries;
+    entries.reserve(facts_.size());
+    for (const auto & [stored_key, stored] : facts_) {
+      entries.push_back({stored.first, stored_key});
+    }
+    heap_ = decltype(heap_)(std::greater<Entry>(), std::move(entries));
+  }
+}
+
+void
+FactExpiry::clear(const plansys2_msgs::msg::Node & fact)
+{
+  if (!facts_.empty()) {
+    facts_.erase(fact_key(fact));
+  }
+}
+
+void
+FactExpiry::reset()
+{
+  heap_ = {};
+  facts_.clear();
+}
+
+std::vector<plansys2_msgs::msg::Node>
+FactExpiry::expire(std::chrono::nanoseconds now)
+{
+  std::vector<plansys2_msgs::msg::Node> ret;
+
+  discardStale();
+  while (!heap_.empty() && heap_.top().expiration <= now) {
+    auto it = facts_.find(heap_.top().key);
+    ret.push_back(std::move(it->second.second));
+    facts_.erase(it);
+    heap_.pop();
+    discardStale();
+  }
+
+  return ret;
+}
+
+std::optional<std::chrono::nanoseconds>
+FactExpiry::next()
+{
+  discardStale();
+  if (heap_.empty()) {
+    return {};
+  }
+  return heap_.top().expiration;
+}
+
+void
+FactExpiry::discardStale()
+{
+  while (!heap_.empty()) {
+    auto it = facts_.find(heap_.top().key);
+    if (it != facts_.end() && it->second.first == heap_.top().expiration) {
+      return;
+    }
+    heap_.pop();
+  }
+}
+
+}  // namespace plansys2
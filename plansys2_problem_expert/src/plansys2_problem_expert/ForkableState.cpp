@@ -0,0 +1,241 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "plansys2_problem_expert/ForkableState.hpp"
+
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "plansys2_problem_expert/StateFingerprint.hpp"
+#include "plansys2_problem_expert/Utils.hpp"
+
+namespace plansys2
+{
+
+namespace
+{
+
+std::string fact_key(const plansys2_msgs::msg::Node & fact)
+{
+  std::string key = fact.name;
+  for (const auto & param : fact.parameters) {
+    key += " " + param.name;
+  }
+  return key;
+}
+
+}  // namespace
+
+ForkableState::ForkableState(
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions)
+{
+  for (const auto & predicate : predicates) {
+    addPredicate(predicate);
+  }
+  for (const auto & function : functions) {
+    setFunction(function);
+  }
+}
+
+bool
+ForkableState::existPredicate(const plansys2::Predicate & predicate) const
+{
+  return predicates_.find(fact_key(predicate)) != nullptr;
+}
+
+bool
+ForkableState::addPredicate(const plansys2::Predicate & predicate)
+{
+  auto key = fact_key(predicate);
+  if (predicates_.find(key) != nullptr) {
+    return false;
+  }
+
+  predicates_.insert(key, predicate);
+  fingerprint_ = StateFingerprint::combine(
+    fingerprint_, StateFingerprint::predicateKey(predicate));
+  return true;
+}
+
+bool
+ForkableState::removePredicate(const plansys2::Predicate & predicate)
+{
+  if (!predicates_.erase(fact_key(predicate))) {
+    return false;
+  }
+
+  fingerprint_ = StateFingerprint::combine(
+    fingerprint_, StateFingerprint::predicateKey(predicate));
+  return true;
+}
+
+std::optional<plansys2::Function>
+ForkableState::getFunction(const plansys2::Function & function) const
+{
+  auto current = functions_.find(fact_key(function));
+  if (current == nullptr) {
+    return {};
+  }
+  return *current;
+}
+
+void
+ForkableState::setFunction(const plansys2::Function & function)
+{
+  auto key = fact_key(function);
+  auto current = functions_.find(key);
+  if (current != nullptr) {
+    fingerprint_ = StateFingerprint::combine(
+      fingerprint_, StateFingerprint::functionKey(*current));
+  }
+
+  functions_.insert(key, function);
+  fingerprint_ = StateFingerprint::combine(
+    fingerprint_, StateFingerprint::functionKey(function));
+}
+
+bool
+ForkableState::removeFunction(const plansys2::Function & function)
+{
+  auto key = fact_key(function);
+  auto current = functions_.find(key);
+  if (current == nullptr) {
+    return false;
+  }
+
+  fingerprint_ = StateFingerprint::combine(
+    fingerprint_, StateFingerprint::functionKey(*current));
+  functions_.erase(key);
+  return true;
+}
+
+std::vector<plansys2::Predicate>
+ForkableState::getPredicates() const
+{
+  std::vector<plansys2::Predicate> ret;
+  ret.reserve(predicates_.size());
+  predicates_.for_each(
+    [&ret](const std::string &, const plansys2::Predicate & predicate) {
+      ret.push_back(predicate);
+    });
+  return ret;
+}
+
+std::vector<plansys2::Function>
+ForkableState::getFunctions() const
+{
+  std::vector<plansys2::Function> ret;
+  ret.reserve(functions_.size());
+  functions_.for_each(
+    [&ret](const std::string &, const plansys2::Function & function) {
+      ret.push_back(function);
+    });
+  return ret;
+}
+
+namespace
+{
+
+// Lookups and effects of the evaluator, on a forkable state
+class ForkableEvaluationState : public EvaluationState
+{
+public:
+  explicit ForkableEvaluationState(ForkableState & state)
+  : state_(state) {}
+
+  bool existPredicate(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) override
+  {
+    return state_.existPredicate(binding.ground(tree, node_id));
+  }
+
+  std::optional<double> getFunctionValue(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) override
+  {
+    auto function = state_.getFunction(binding.ground(tree, node_id));
+    if (!function) {
+      return {};
+    }
+    return function->value;
+  }
+
+  bool addPredicate(const plansys2::Predicate & predicate) override
+  {
+    state_.addPredicate(predicate);
+    return true;
+  }
+
+  bool removePredicate(const plansys2::Predicate & predicate) override
+  {
+    state_.removePredicate(predicate);
+    return true;
+  }
+
+  std::optional<double> modifyFunction(
+    const plansys2::Function & function, uint8_t modifier_type, double operand) override
+  {
+    auto current = state_.getFunction(function);
+    if (!current) {
+      return {};
+    }
+
+    auto modified = modify_value(modifier_type, current->value, operand);
+    if (modified) {
+      current->value = modified.value();
+      state_.setFunction(current.value());
+    }
+    return modified;
+  }
+
+  std::tuple<bool, bool, double> evaluateExists(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    ParameterBinding & binding) override
+  {
+    return evaluate_exists(
+      tree, {}, state_.getPredicates(), state_.getFunctions(), node_id, binding);
+  }
+
+private:
+  ForkableState & state_;
+};
+
+}  // namespace
+
+bool
+ForkableState::check(const plansys2_msgs::msg::Tree & tree, uint32_t node_id) const
+{
+  // The evaluator only changes the state when applying, and forking is constant time
+  auto state = fork();
+  ForkableEvaluationState evaluation_state(state);
+  ParameterBinding binding;
+  auto result = evaluate(tree, binding, evaluation_state, false, node_id);
+  return std::get<1>(result);
+}
+
+bool
+ForkableState::apply(const plansys2_msgs::msg::Tree & tree, uint32_t node_id)
+{
+  ForkableEvaluationState evaluation_state(*this);
+  ParameterBinding binding;
+  auto result = evaluate(tree, binding, evaluation_state, true, node_id);
+  return std::get<0>(result);
+}
+
+}  // namespace plansys2
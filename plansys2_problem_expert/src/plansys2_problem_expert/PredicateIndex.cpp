@@ -0,0 +1,177 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "plansys2_problem_expert/PredicateIndex.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace plansys2
+{
+
+std::string
+PredicateIndex::key(const plansys2::Predicate & predicate)
+{
+  std::string ret = predicate.name;
+  for (const auto & param : predicate.parameters) {
+    ret += " " + param.name;
+  }
+  return ret;
+}
+
+void
+PredicateIndex::add(const plansys2::Predicate & predicate)
+{
+  auto predicate_key = key(predicate);
+  if (!predicates_.emplace(predicate_key, predicate).second) {
+    return;
+  }
+
+  by_name_[predicate.name].insert(predicate_key);
+
+  auto & positions = by_argument_[predicate.name];
+  if (positions.size() < predicate.parameters.size()) {
+    positions.resize(predicate.parameters.size());
+  }
+  for (size_t i = 0; i < predicate.parameters.size(); i++) {
+    positions[i][predicate.parameters[i].name].insert(predicate_key);
+  }
+}
+
+bool
+PredicateIndex::contains(const plansys2::Predicate & predicate) const
+{
+  return predicates_.find(key(predicate)) != predicates_.end();
+}
+
+void
+PredicateIndex::remove(const plansys2::Predicate & predicate)
+{
+  auto predicate_key = key(predicate);
+  if (predicates_.erase(predicate_key) == 0) {
+    return;
+  }
+
+  auto name_it = by_name_.find(predicate.name);
+  name_it->second.erase(predicate_key);
+  if (name_it->second.empty()) {
+    by_name_.erase(name_it);
+    by_argument_.erase(predicate.name);
+    return;
+  }
+
+  auto & positions = by_argument_[predicate.name];
+  for (size_t i = 0; i < predicate.parameters.size(); i++) {
+    auto arg_it = positions[i].find(predicate.parameters[i].name);
+    arg_it->second.erase(predicate_key);
+    if (arg_it->second.empty()) {
+      positions[i].erase(arg_it);
+    }
+  }
+}
+
+void
+PredicateIndex::clear()
+{
+  predicates_.clear();
+  by_name_.clear();
+  by_argument_.clear();
+}
+
+std::vector<plansys2::Predicate>
+PredicateIndex::query(
+  const plansys2::Predicate & pattern,
+  size_t max_results,
+  const std::string & start_after,
+  std::string & next_start_after) const
+{
+  // start_after may be next_start_after itself, when resuming a query
+  const std::string resume_key = start_after;
+  next_start_after.clear();
+
+  auto name_it = by_name_.find(pattern.name);
+  if (name_it == by_name_.end()) {
+    return {};
+  }
+
+  // Scan the smallest index among the bound positions, or all the predicates of the name
+  const std::set<std::string> * candidates = &name_it->second;
+  const auto & positions = by_argument_.at(pattern.name);
+  for (size_t i = 0; i < pattern.parameters.size(); i++) {
+    const auto & arg = pattern.parameters[i].name;
+    if (arg.empty() || arg[0] == '?') {
+      continue;
+    }
+
+    if (i >= positions.size()) {
+      return {};
+    }
+    auto arg_it = positions[i].find(arg);
+    if (arg_it == positions[i].end()) {
+      return {};
+    }
+    if (arg_it->second.size() < candidates->size()) {
+      candidates = &arg_it->second;
+    }
+  }
+
+  std::vector<plansys2::Predicate> ret;
+  auto it = resume_key.empty() ? candidates->begin() : candidates->upper_bound(resume_key);
+  for (; it != candidates->end(); ++it) {
+    const auto & predicate = predicates_.at(*it);
+    if (!matches(predicate, pattern)) {
+      continue;
+    }
+
+    if (max_results > 0 && ret.size() == max_results) {
+      next_start_after = key(ret.back());
+      break;
+    }
+    ret.push_back(predicate);
+  }
+
+  return ret;
+}
+
+bool
+PredicateIndex::matches(
+  const plansys2::Predicate & predicate, const plansys2::Predicate & pattern)
+{
+  if (predicate.parameters.size() != pattern.parameters.size()) {
+    return false;
+  }
+
+  std::unordered_map<std::string, std::string> bindings;
+  for (size_t i = 0; i < pattern.parameters.size(); i++) {
+    const auto & arg = pattern.parameters[i].name;
+    const auto & object = predicate.parameters[i].name;
+
+    if (!arg.empty() && arg[0] != '?') {
+      if (arg != object) {
+        return false;
+      }
+    } else if (arg.size() > 1) {
+      auto [binding, inserted] = bindings.emplace(arg, object);
+      if (!inserted && binding->second != object) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+}  // namespace plansys2
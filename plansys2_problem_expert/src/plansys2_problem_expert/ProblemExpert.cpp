@@ -22,6 +22,7 @@
 #include <memory>
 #include <set>
 #include <map>
+#include <utility>
 
 #include "plansys2_core/Utils.hpp"
 #include "plansys2_pddl_parser/Domain.hpp"
@@ -34,10 +35,21 @@ namespace plansys2
 {
 
 ProblemExpert::ProblemExpert(std::shared_ptr<DomainExpert> & domain_expert)
-: domain_expert_(domain_expert)
+: shard_id_(0),
+  num_shards_(1),
+  sharding_policy_(ShardingPolicy::BY_SYMBOL),
+  domain_expert_(domain_expert)
 {
 }
 
+void
+ProblemExpert::setShard(size_t shard_id, size_t num_shards, ShardingPolicy policy)
+{
+  num_shards_ = std::max<size_t>(num_shards, 1);
+  shard_id_ = std::min(shard_id, num_shards_ - 1);
+  sharding_policy_ = policy;
+}
+
 bool
 ProblemExpert::addInstance(const plansys2::Instance & instance)
 {
@@ -64,6 +76,7 @@ ProblemExpert::addInstance(const plansys2::Instance & instance)
 
   if (!exist_instance) {
     instances_.push_back(lowercase_instance);
+    recordChange(plansys2_msgs::msg::KnowledgeChange::ADD_INSTANCE, lowercase_instance);
   }
 
   return true;
@@ -84,6 +97,7 @@ ProblemExpert::removeInstance(const plansys2::Instance & instance)
   while (!found && i < instances_.size()) {
     if (instances_[i].name == instance.name) {
       found = true;
+      recordChange(plansys2_msgs::msg::KnowledgeChange::REMOVE_INSTANCE, instances_[i]);
       instances_.erase(instances_.begin() + i);
     }
     i++;
@@ -123,48 +137,23 @@ ProblemExpert::getPredicates()
 {
   std::vector<plansys2::Predicate> ret = predicates_;
 
-  auto derived_predicates = domain_expert_->getDerivedPredicates();
-  for (auto derived_name : derived_predicates) {
+  // The facts a derived predicate depends on may be in other shards, so the sharded client
+  // infers them
+  if (num_shards_ == 1) {
+    auto derived = infer_derived_predicates(
+      getDerivedPredicates(), instances_, predicates_, functions_);
+    ret.insert(ret.end(), derived.begin(), derived.end());
+  }
+  return ret;
+}
+
+std::vector<plansys2_msgs::msg::Derived>
+ProblemExpert::getDerivedPredicates()
+{
+  std::vector<plansys2_msgs::msg::Derived> ret;
+  for (const auto & derived_name : domain_expert_->getDerivedPredicates()) {
     auto derived = domain_expert_->getDerivedPredicate(derived_name.name);
-    for (auto d : derived) {
-      std::vector<std::vector<std::string>> parameters_vector;
-      for (size_t i = 0; i < d.predicate.parameters.size(); i++) {
-        std::vector<std::string> p_vector;
-        std::for_each(
-          instances_.begin(), instances_.end(),
-          [&](auto instance) {
-            if (d.predicate.parameters[i].type == instance.type) {
-              p_vector.push_back(instance.name);
-            }
-          });
-        parameters_vector.push_back(p_vector);
-      }
-      std::vector<std::vector<std::string>> possible_parameters_values;
-      std::vector<std::string> aux;
-      plansys2::cart_product(
-        possible_parameters_values, aux, parameters_vector.begin(), parameters_vector.end());
-
-      for (auto parameters_values : possible_parameters_values) {
-        std::map<std::string, std::string> replace;
-        for (size_t i = 0; i < d.predicate.parameters.size(); i++) {
-          replace["?" + std::to_string(i)] = parameters_values[i];
-        }
-        auto tree_replaced = plansys2::replace_children_param(
-          d.preconditions, d.preconditions.nodes[0].node_id, replace);
-        bool result = check(tree_replaced, predicates_, functions_);
-        if (result) {
-          plansys2::Predicate inferred_predicate;
-          inferred_predicate.node_type = plansys2_msgs::msg::Node::PREDICATE;
-          inferred_predicate.name = d.predicate.name;
-          for (size_t i = 0; i < d.predicate.parameters.size(); i++) {
-            plansys2_msgs::msg::Param param;
-            param.name = replace.at("?" + std::to_string(i));
-            inferred_predicate.parameters.push_back(param);
-          }
-          ret.push_back(inferred_predicate);
-        }
-      }
-    }
+    ret.insert(ret.end(), derived.begin(), derived.end());
   }
   return ret;
 }
@@ -172,9 +161,13 @@ ProblemExpert::getPredicates()
 bool
 ProblemExpert::addPredicate(const plansys2::Predicate & predicate)
 {
+  fact_expiry_.clear(predicate);
+
   if (!existPredicate(predicate)) {
     if (isValidPredicate(predicate)) {
       predicates_.push_back(predicate);
+      predicate_index_.add(predicate);
+      recordChange(plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE, predicate);
       return true;
     } else {
       return false;
@@ -187,6 +180,8 @@ ProblemExpert::addPredicate(const plansys2::Predicate & predicate)
 bool
 ProblemExpert::removePredicate(const plansys2::Predicate & predicate)
 {
+  fact_expiry_.clear(predicate);
+
   bool found = false;
   int i = 0;
 
@@ -196,6 +191,8 @@ ProblemExpert::removePredicate(const plansys2::Predicate & predicate)
   while (!found && i < predicates_.size()) {
     if (parser::pddl::checkNodeEquality(predicates_[i], predicate)) {
       found = true;
+      recordChange(plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE, predicates_[i]);
+      predicate_index_.remove(predicates_[i]);
       predicates_.erase(predicates_.begin() + i);
     }
     i++;
@@ -227,6 +224,23 @@ ProblemExpert::getPredicate(const std::string & expr)
   }
 }
 
+std::vector<plansys2::Predicate>
+ProblemExpert::queryPredicates(const plansys2::Predicate & pattern)
+{
+  std::string next_start_after;
+  return predicate_index_.query(pattern, 0, "", next_start_after);
+}
+
+std::vector<plansys2::Predicate>
+ProblemExpert::queryPredicates(
+  const plansys2::Predicate & pattern,
+  size_t max_results,
+  const std::string & start_after,
+  std::string & next_start_after)
+{
+  return predicate_index_.query(pattern, max_results, start_after, next_start_after);
+}
+
 std::vector<plansys2::Function>
 ProblemExpert::getFunctions()
 {
@@ -236,9 +250,12 @@ ProblemExpert::getFunctions()
 bool
 ProblemExpert::addFunction(const plansys2::Function & function)
 {
+  fact_expiry_.clear(function);
+
   if (!existFunction(function)) {
     if (isValidFunction(function)) {
       functions_.push_back(function);
+      recordChange(plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION, function);
       return true;
     } else {
       return false;
@@ -251,6 +268,8 @@ ProblemExpert::addFunction(const plansys2::Function & function)
 bool
 ProblemExpert::removeFunction(const plansys2::Function & function)
 {
+  fact_expiry_.clear(function);
+
   bool found = false;
   int i = 0;
 
@@ -260,6 +279,7 @@ ProblemExpert::removeFunction(const plansys2::Function & function)
   while (!found && i < functions_.size()) {
     if (parser::pddl::checkNodeEquality(functions_[i], function)) {
       found = true;
+      recordChange(plansys2_msgs::msg::KnowledgeChange::REMOVE_FUNCTION, functions_[i]);
       functions_.erase(functions_.begin() + i);
     }
     i++;
@@ -271,10 +291,18 @@ ProblemExpert::removeFunction(const plansys2::Function & function)
 bool
 ProblemExpert::updateFunction(const plansys2::Function & function)
 {
+  fact_expiry_.clear(function);
+
   if (existFunction(function)) {
     if (isValidFunction(function)) {
-      removeFunction(function);
+      functions_.erase(
+        std::find_if(
+          functions_.begin(), functions_.end(),
+          [&](const plansys2::Function & stored) {
+            return parser::pddl::checkNodeEquality(stored, function);
+          }));
       functions_.push_back(function);
+      recordChange(plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION, function);
       return true;
     } else {
       return false;
@@ -307,6 +335,61 @@ ProblemExpert::getFunction(const std::string & expr)
   }
 }
 
+std::optional<plansys2::Function>
+ProblemExpert::modifyFunction(const plansys2::Function & modifier)
+{
+  auto result = modifyFunctions({modifier});
+
+  if (result) {
+    return result.value()[0];
+  } else {
+    return {};
+  }
+}
+
+std::optional<std::vector<plansys2::Function>>
+ProblemExpert::modifyFunctions(const std::vector<plansys2::Function> & modifiers)
+{
+  // Modifiers are applied in order over a copy of the affected values, and stored only
+  // if all of them succeed, so a batch is never applied partially.
+  std::vector<size_t> targets;
+  std::map<size_t, double> values;
+
+  for (const auto & modifier : modifiers) {
+    auto it = std::find_if(
+      functions_.begin(), functions_.end(),
+      [&](const plansys2::Function & function) {
+        return parser::pddl::checkNodeEquality(function, modifier);
+      });
+    if (it == functions_.end()) {
+      return {};
+    }
+
+    size_t target = std::distance(functions_.begin(), it);
+    auto current = values.find(target);
+    double value = (current != values.end()) ? current->second : it->value;
+
+    auto modified = modify_value(modifier.modifier_type, value, modifier.value);
+    if (!modified) {
+      return {};
+    }
+
+    targets.push_back(target);
+    values[target] = modified.value();
+  }
+
+  for (const auto & [target, value] : values) {
+    functions_[target].value = value;
+    recordChange(plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION, functions_[target]);
+  }
+
+  std::vector<plansys2::Function> ret;
+  for (auto target : targets) {
+    ret.push_back(functions_[target]);
+  }
+  return ret;
+}
+
 void
 ProblemExpert::removeInvalidPredicates(
   std::vector<plansys2::Predicate> & predicates,
@@ -319,6 +402,8 @@ ProblemExpert::removeInvalidPredicates(
           return param.name == instance.name;
         }) != rit->parameters.end())
     {
+      recordChange(plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE, *rit);
+      predicate_index_.remove(*rit);
       predicates.erase(std::next(rit).base());
     }
   }
@@ -336,6 +421,7 @@ ProblemExpert::removeInvalidFunctions(
           return param.name == instance.name;
         }) != rit->parameters.end())
     {
+      recordChange(plansys2_msgs::msg::KnowledgeChange::REMOVE_FUNCTION, *rit);
       functions.erase(std::next(rit).base());
     }
   }
@@ -444,12 +530,191 @@ ProblemExpert::clearKnowledge()
 {
   instances_.clear();
   predicates_.clear();
+  predicate_index_.clear();
   functions_.clear();
+  fact_expiry_.reset();
   clearGoal();
+  recordChange(plansys2_msgs::msg::KnowledgeChange::CLEAR_KNOWLEDGE);
 
   return true;
 }
 
+uint64_t
+ProblemExpert::getRevision()
+{
+  return journal_.getRevision();
+}
+
+std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>>
+ProblemExpert::getChangesSince(uint64_t revision)
+{
+  return journal_.getChangesSince(revision);
+}
+
+void
+ProblemExpert::setJournalCapacity(size_t capacity)
+{
+  journal_.setCapacity(capacity);
+}
+
+plansys2_msgs::msg::StateFingerprint
+ProblemExpert::getFingerprint()
+{
+  return fingerprint_.get();
+}
+
+void
+ProblemExpert::setFingerprintQuantum(double function_quantum)
+{
+  fingerprint_.setFunctionQuantum(function_quantum);
+  for (const auto & predicate : predicates_) {
+    fingerprint_.togglePredicate(predicate);
+  }
+  for (const auto & function : functions_) {
+    fingerprint_.setFunction(function);
+  }
+}
+
+size_t
+ProblemExpert::applyChanges(const std::vector<plansys2_msgs::msg::KnowledgeChange> & changes)
+{
+  batch_changes_ = std::vector<plansys2_msgs::msg::KnowledgeChange>();
+
+  size_t applied = 0;
+  for (const auto & change : changes) {
+    bool success = false;
+    bool expires = false;
+    switch (change.type) {
+      case plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE:
+        success = addPredicate(change.node);
+        expires = true;
+        break;
+      case plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE:
+        success = removePredicate(change.node);
+        break;
+      case plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION:
+        success = addFunction(change.node);
+        expires = true;
+        break;
+      default:
+        break;
+    }
+
+    if (success && expires && (change.ttl.sec != 0 || change.ttl.nanosec != 0)) {
+      fact_expiry_.set(
+        change.node,
+        std::chrono::seconds(change.stamp.sec) + std::chrono::nanoseconds(change.stamp.nanosec) +
+        std::chrono::seconds(change.ttl.sec) + std::chrono::nanoseconds(change.ttl.nanosec));
+    }
+
+    if (success) {
+      applied++;
+    }
+  }
+
+  journal_.record(std::move(batch_changes_.value()));
+  batch_changes_.reset();
+
+  return applied;
+}
+
+ConditionalUpdateResult
+ProblemExpert::applyChangesIf(
+  const std::vector<plansys2_msgs::msg::KnowledgeChange> & changes,
+  uint64_t expected_revision,
+  const plansys2_msgs::msg::Tree & condition,
+  uint64_t & revision)
+{
+  revision = journal_.getRevision();
+
+  if (expected_revision != 0 && expected_revision != revision) {
+    return ConditionalUpdateResult::REVISION_CONFLICT;
+  }
+
+  if (!condition.nodes.empty() && !check(condition, predicates_, functions_)) {
+    return ConditionalUpdateResult::CONDITION_FAILED;
+  }
+
+  // Changes are validated before applying any of them, so a batch is never partial
+  for (const auto & change : changes) {
+    bool valid = false;
+    switch (change.type) {
+      case plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE:
+      case plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE:
+        valid = isValidPredicate(change.node);
+        break;
+      case plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION:
+        valid = isValidFunction(change.node);
+        break;
+      default:
+        break;
+    }
+    if (!valid) {
+      return ConditionalUpdateResult::INVALID_CHANGE;
+    }
+  }
+
+  applyChanges(changes);
+  revision = journal_.getRevision();
+
+  return ConditionalUpdateResult::APPLIED;
+}
+
+std::vector<plansys2_msgs::msg::Node>
+ProblemExpert::expireFacts(std::chrono::nanoseconds now)
+{
+  auto expired = fact_expiry_.expire(now);
+  if (expired.empty()) {
+    return expired;
+  }
+
+  batch_changes_ = std::vector<plansys2_msgs::msg::KnowledgeChange>();
+
+  for (const auto & fact : expired) {
+    if (fact.node_type == plansys2_msgs::msg::Node::FUNCTION) {
+      removeFunction(fact);
+    } else {
+      removePredicate(fact);
+    }
+  }
+
+  journal_.record(std::move(batch_changes_.value()));
+  batch_changes_.reset();
+
+  return expired;
+}
+
+void
+ProblemExpert::recordChange(uint8_t type, const plansys2::Instance & instance)
+{
+  plansys2_msgs::msg::KnowledgeChange change;
+  change.type = type;
+  change.instance = instance;
+  recordChange(change);
+}
+
+void
+ProblemExpert::recordChange(uint8_t type, const plansys2_msgs::msg::Node & node)
+{
+  plansys2_msgs::msg::KnowledgeChange change;
+  change.type = type;
+  change.node = node;
+  recordChange(change);
+}
+
+void
+ProblemExpert::recordChange(plansys2_msgs::msg::KnowledgeChange change)
+{
+  fingerprint_.apply(change);
+  change.fingerprint = fingerprint_.get();
+
+  if (batch_changes_) {
+    batch_changes_->push_back(std::move(change));
+  } else {
+    journal_.record(std::move(change));
+  }
+}
+
 bool
 ProblemExpert::isValidType(const std::string & type)
 {
@@ -483,28 +748,12 @@ ProblemExpert::existInstance(const std::string & name)
 bool
 ProblemExpert::existPredicate(const plansys2::Predicate & predicate)
 {
-  bool found = false;
-  int i = 0;
+  bool found = predicate_index_.contains(predicate);
 
-  while (!found && i < predicates_.size()) {
-    if (parser::pddl::checkNodeEquality(predicates_[i], predicate)) {
-      found = true;
-    }
-    i++;
-  }
-
-  if (!found) {
-    std::vector<std::string> parameters_names;
-    std::for_each(
-      predicate.parameters.begin(), predicate.parameters.end(),
-      [&](auto p) {parameters_names.push_back(p.name);});
-    auto derived_predicates = domain_expert_->getDerivedPredicate(predicate.name, parameters_names);
-    for (auto derived : derived_predicates) {
-      if (check(derived.preconditions, predicates_, functions_)) {
-        found = true;
-        break;
-      }
-    }
+  // Static predicates are never derived, so the index is enough for them
+  if (!found && num_shards_ == 1 && !domain_expert_->isStaticPredicate(predicate.name)) {
+    found = check_derived_predicate(
+      domain_expert_->getDerivedPredicate(predicate.name), predicate, predicates_, functions_);
   }
 
   return found;
@@ -698,53 +947,7 @@ ProblemExpert::checkPredicateTreeTypes(
 std::string
 ProblemExpert::getProblem()
 {
-  parser::pddl::Domain domain(domain_expert_->getDomain());
-  parser::pddl::Instance problem(domain);
-
-  problem.name = "problem_1";
-
-  for (const auto & instance : instances_) {
-    bool is_constant = domain.getType(instance.type)->parseConstant(instance.name).first;
-    if (is_constant) {
-      std::cout << "Skipping adding constant to problem :object: " << instance.name << " " <<
-        instance.type << std::endl;
-    } else {
-      problem.addObject(instance.name, instance.type);
-    }
-  }
-
-  for (plansys2_msgs::msg::Node predicate : predicates_) {
-    StringVec v;
-
-    for (size_t i = 0; i < predicate.parameters.size(); i++) {
-      v.push_back(predicate.parameters[i].name);
-    }
-
-    std::transform(predicate.name.begin(), predicate.name.end(), predicate.name.begin(), ::tolower);
-
-    problem.addInit(predicate.name, v);
-  }
-
-  for (plansys2_msgs::msg::Node function : functions_) {
-    StringVec v;
-
-    for (size_t i = 0; i < function.parameters.size(); i++) {
-      v.push_back(function.parameters[i].name);
-    }
-
-    std::transform(
-      function.name.begin(), function.name.end(),
-      function.name.begin(), ::tolower);
-
-    problem.addInit(function.name, function.value, v);
-  }
-
-  const std::string gs = parser::pddl::toString(goal_);
-  problem.addGoal(gs);
-
-  std::ostringstream stream;
-  stream << problem;
-  return stream.str();
+  return write_problem(domain_expert_->getDomain(), instances_, predicates_, functions_, goal_);
 }
 
 bool
@@ -818,6 +1021,9 @@ ProblemExpert::addProblem(const std::string & problem_str)
     switch (tree_node->node_type) {
       case plansys2_msgs::msg::Node::PREDICATE: {
           plansys2::Predicate pred_node(*tree_node);
+          if (get_shard(pred_node, num_shards_, sharding_policy_) != shard_id_) {
+            break;
+          }
           std::cout << "Adding predicate: " <<
             parser::pddl::toString(tree, tree_node->node_id) << std::endl;
           if (!addPredicate(pred_node)) {
@@ -830,6 +1036,9 @@ ProblemExpert::addProblem(const std::string & problem_str)
         break;
       case plansys2_msgs::msg::Node::FUNCTION: {
           plansys2::Function func_node(*tree_node);
+          if (get_shard(func_node, num_shards_, sharding_policy_) != shard_id_) {
+            break;
+          }
           std::cout << "Adding function: " <<
             parser::pddl::toString(tree, tree_node->node_id) << std::endl;
           if (!addFunction(func_node)) {
@@ -19,70 +19,110 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <future>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <utility>
 
 #include "plansys2_pddl_parser/Utils.hpp"
+#include "plansys2_problem_expert/Utils.hpp"
 
 namespace plansys2
 {
 
 ProblemExpertClient::ProblemExpertClient()
+: ProblemExpertClient(std::string())
+{
+}
+
+ProblemExpertClient::ProblemExpertClient(
+  const std::vector<std::string> & shard_namespaces, ShardingPolicy policy)
+: sharding_policy_(policy)
 {
   node_ = rclcpp::Node::make_shared("problem_expert_client");
 
-  add_problem_client_ = node_->create_client<plansys2_msgs::srv::AddProblem>(
-    "problem_expert/add_problem");
-  add_problem_goal_client_ = node_->create_client<plansys2_msgs::srv::AddProblemGoal>(
-    "problem_expert/add_problem_goal");
-  add_problem_instance_client_ = node_->create_client<plansys2_msgs::srv::AffectParam>(
-    "problem_expert/add_problem_instance");
-  add_problem_predicate_client_ = node_->create_client<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/add_problem_predicate");
-  add_problem_function_client_ = node_->create_client<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/add_problem_function");
-  get_problem_goal_client_ = node_->create_client<plansys2_msgs::srv::GetProblemGoal>(
-    "problem_expert/get_problem_goal");
+  for (const auto & shard_namespace : shard_namespaces) {
+    shards_.push_back(std::make_shared<ProblemExpertClient>(shard_namespace));
+  }
+}
+
+ProblemExpertClient::ProblemExpertClient(const std::string & problem_expert_namespace)
+{
+  node_ = rclcpp::Node::make_shared("problem_expert_client", problem_expert_namespace);
+  endpoint_ = std::make_shared<MultiplexedEndpoint>(node_, "problem_expert");
+
+  add_problem_client_ = endpoint_->create_client<plansys2_msgs::srv::AddProblem>(
+    "add_problem");
+  add_problem_goal_client_ = endpoint_->create_client<plansys2_msgs::srv::AddProblemGoal>(
+    "add_problem_goal");
+  add_problem_instance_client_ = endpoint_->create_client<plansys2_msgs::srv::AffectParam>(
+    "add_problem_instance");
+  add_problem_predicate_client_ = endpoint_->create_client<plansys2_msgs::srv::AffectNode>(
+    "add_problem_predicate");
+  add_problem_function_client_ = endpoint_->create_client<plansys2_msgs::srv::AffectNode>(
+    "add_problem_function");
+  get_problem_goal_client_ = endpoint_->create_client<plansys2_msgs::srv::GetProblemGoal>(
+    "get_problem_goal");
   get_problem_instance_details_client_ =
-    node_->create_client<plansys2_msgs::srv::GetProblemInstanceDetails>(
-    "problem_expert/get_problem_instance");
-  get_problem_instances_client_ = node_->create_client<plansys2_msgs::srv::GetProblemInstances>(
-    "problem_expert/get_problem_instances");
+    endpoint_->create_client<plansys2_msgs::srv::GetProblemInstanceDetails>(
+    "get_problem_instance");
+  get_problem_instances_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::GetProblemInstances>(
+    "get_problem_instances");
   get_problem_predicate_details_client_ =
-    node_->create_client<plansys2_msgs::srv::GetNodeDetails>(
-    "problem_expert/get_problem_predicate");
-  get_problem_predicates_client_ = node_->create_client<plansys2_msgs::srv::GetStates>(
-    "problem_expert/get_problem_predicates");
+    endpoint_->create_client<plansys2_msgs::srv::GetNodeDetails>(
+    "get_problem_predicate");
+  get_problem_predicates_client_ = endpoint_->create_client<plansys2_msgs::srv::GetStates>(
+    "get_problem_predicates");
+  query_problem_predicates_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::QueryPredicates>(
+    "query_problem_predicates");
   get_problem_function_details_client_ =
-    node_->create_client<plansys2_msgs::srv::GetNodeDetails>(
-    "problem_expert/get_problem_function");
-  get_problem_functions_client_ = node_->create_client<plansys2_msgs::srv::GetStates>(
-    "problem_expert/get_problem_functions");
-  get_problem_client_ = node_->create_client<plansys2_msgs::srv::GetProblem>(
-    "problem_expert/get_problem");
-  remove_problem_goal_client_ = node_->create_client<plansys2_msgs::srv::RemoveProblemGoal>(
-    "problem_expert/remove_problem_goal");
-  clear_problem_knowledge_client_ = node_->create_client<plansys2_msgs::srv::ClearProblemKnowledge>(
-    "problem_expert/clear_problem_knowledge");
+    endpoint_->create_client<plansys2_msgs::srv::GetNodeDetails>(
+    "get_problem_function");
+  get_problem_functions_client_ = endpoint_->create_client<plansys2_msgs::srv::GetStates>(
+    "get_problem_functions");
+  get_problem_client_ = endpoint_->create_client<plansys2_msgs::srv::GetProblem>(
+    "get_problem");
+  remove_problem_goal_client_ = endpoint_->create_client<plansys2_msgs::srv::RemoveProblemGoal>(
+    "remove_problem_goal");
+  clear_problem_knowledge_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::ClearProblemKnowledge>(
+    "clear_problem_knowledge");
   remove_problem_instance_client_ =
-    node_->create_client<plansys2_msgs::srv::AffectParam>(
-    "problem_expert/remove_problem_instance");
+    endpoint_->create_client<plansys2_msgs::srv::AffectParam>(
+    "remove_problem_instance");
   remove_problem_predicate_client_ =
-    node_->create_client<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/remove_problem_predicate");
+    endpoint_->create_client<plansys2_msgs::srv::AffectNode>(
+    "remove_problem_predicate");
   remove_problem_function_client_ =
-    node_->create_client<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/remove_problem_function");
+    endpoint_->create_client<plansys2_msgs::srv::AffectNode>(
+    "remove_problem_function");
   exist_problem_predicate_client_ =
-    node_->create_client<plansys2_msgs::srv::ExistNode>(
-    "problem_expert/exist_problem_predicate");
+    endpoint_->create_client<plansys2_msgs::srv::ExistNode>(
+    "exist_problem_predicate");
   exist_problem_function_client_ =
-    node_->create_client<plansys2_msgs::srv::ExistNode>(
-    "problem_expert/exist_problem_function");
+    endpoint_->create_client<plansys2_msgs::srv::ExistNode>(
+    "exist_problem_function");
   update_problem_function_client_ =
-    node_->create_client<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/update_problem_function");
+    endpoint_->create_client<plansys2_msgs::srv::AffectNode>(
+    "update_problem_function");
+  modify_problem_functions_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::ModifyFunctions>(
+    "modify_problem_functions");
+  get_changes_since_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::GetChangesSince>(
+    "get_changes_since");
   is_problem_goal_satisfied_client_ =
-    node_->create_client<plansys2_msgs::srv::IsProblemGoalSatisfied>(
-    "problem_expert/is_problem_goal_satisfied");
+    endpoint_->create_client<plansys2_msgs::srv::IsProblemGoalSatisfied>(
+    "is_problem_goal_satisfied");
+  manage_knowledge_context_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::ManageKnowledgeContext>(
+    "manage_knowledge_context");
+  conditional_update_client_ =
+    endpoint_->create_client<plansys2_msgs::srv::ConditionalUpdate>(
+    "conditional_update");
 
   problem_sub_ = node_->create_subscription<std_msgs::msg::String>(
     "problem_expert/problem",
@@ -94,6 +134,10 @@ ProblemExpertClient::ProblemExpertClient()
 std::vector<plansys2::Instance>
 ProblemExpertClient::getInstances()
 {
+  if (!shards_.empty()) {
+    return shards_[0]->getInstances();
+  }
+
   while (!get_problem_instances_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return {};
@@ -132,6 +176,11 @@ ProblemExpertClient::getInstances()
 bool
 ProblemExpertClient::addInstance(const plansys2::Instance & instance)
 {
+  if (!shards_.empty()) {
+    return forEachShard(
+      [&](ProblemExpertClient & shard) {return shard.addInstance(instance);});
+  }
+
   while (!add_problem_instance_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -170,6 +219,11 @@ ProblemExpertClient::addInstance(const plansys2::Instance & instance)
 bool
 ProblemExpertClient::removeInstance(const plansys2::Instance & instance)
 {
+  if (!shards_.empty()) {
+    return forEachShard(
+      [&](ProblemExpertClient & shard) {return shard.removeInstance(instance);});
+  }
+
   while (!remove_problem_instance_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -209,6 +263,10 @@ ProblemExpertClient::removeInstance(const plansys2::Instance & instance)
 std::optional<plansys2::Instance>
 ProblemExpertClient::getInstance(const std::string & name)
 {
+  if (!shards_.empty()) {
+    return shards_[0]->getInstance(name);
+  }
+
   while (!get_problem_instance_details_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return {};
@@ -247,6 +305,10 @@ ProblemExpertClient::getInstance(const std::string & name)
 std::vector<plansys2::Predicate>
 ProblemExpertClient::getPredicates()
 {
+  if (!shards_.empty()) {
+    return getShardedPredicates();
+  }
+
   while (!get_problem_predicates_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return {};
@@ -281,9 +343,67 @@ ProblemExpertClient::getPredicates()
   }
 }
 
+std::vector<plansys2::Predicate>
+ProblemExpertClient::queryPredicates(const plansys2::Predicate & pattern)
+{
+  if (!shards_.empty()) {
+    return gatherFromShards<plansys2::Predicate>(
+      [&pattern](ProblemExpertClient & shard) {return shard.queryPredicates(pattern);});
+  }
+
+  while (!query_problem_predicates_client_->wait_for_service(std::chrono::seconds(5))) {
+    if (!rclcpp::ok()) {
+      return {};
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      query_problem_predicates_client_->get_service_name() <<
+        " service  client: waiting for service to appear...");
+  }
+
+  // Large results are fetched in pages, so no single response gets too big
+  const uint32_t page_size = 500;
+
+  std::vector<plansys2::Predicate> ret;
+  auto request = std::make_shared<plansys2_msgs::srv::QueryPredicates::Request>();
+  request->pattern = pattern;
+  request->max_results = page_size;
+
+  do {
+    auto future_result = query_problem_predicates_client_->async_send_request(request);
+
+    if (rclcpp::spin_until_future_complete(node_, future_result, std::chrono::seconds(1)) !=
+      rclcpp::FutureReturnCode::SUCCESS)
+    {
+      return {};
+    }
+
+    auto result = *future_result.get();
+
+    if (!result.success) {
+      RCLCPP_ERROR_STREAM(
+        node_->get_logger(),
+        query_problem_predicates_client_->get_service_name() << ": " <<
+          result.error_info);
+      return {};
+    }
+
+    for (const auto & predicate : result.predicates) {
+      ret.push_back(predicate);
+    }
+    request->start_after = result.next_start_after;
+  } while (!request->start_after.empty());
+
+  return ret;
+}
+
 bool
 ProblemExpertClient::addPredicate(const plansys2::Predicate & predicate)
 {
+  if (!shards_.empty()) {
+    return getShardClient(predicate).addPredicate(predicate);
+  }
+
   while (!add_problem_predicate_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -322,6 +442,10 @@ ProblemExpertClient::addPredicate(const plansys2::Predicate & predicate)
 bool
 ProblemExpertClient::removePredicate(const plansys2::Predicate & predicate)
 {
+  if (!shards_.empty()) {
+    return getShardClient(predicate).removePredicate(predicate);
+  }
+
   while (!remove_problem_predicate_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -360,6 +484,10 @@ ProblemExpertClient::removePredicate(const plansys2::Predicate & predicate)
 bool
 ProblemExpertClient::existPredicate(const plansys2::Predicate & predicate)
 {
+  if (!shards_.empty()) {
+    return existShardedPredicate(predicate);
+  }
+
   while (!exist_problem_predicate_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -389,6 +517,11 @@ ProblemExpertClient::existPredicate(const plansys2::Predicate & predicate)
 std::optional<plansys2::Predicate>
 ProblemExpertClient::getPredicate(const std::string & predicate)
 {
+  if (!shards_.empty()) {
+    return getShardClient(parser::pddl::fromStringPredicate(predicate)).getPredicate(
+      predicate);
+  }
+
   while (!get_problem_predicate_details_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return {};
@@ -427,6 +560,11 @@ ProblemExpertClient::getPredicate(const std::string & predicate)
 std::vector<plansys2::Function>
 ProblemExpertClient::getFunctions()
 {
+  if (!shards_.empty()) {
+    return gatherFromShards<plansys2::Function>(
+      [](ProblemExpertClient & shard) {return shard.getFunctions();});
+  }
+
   while (!get_problem_functions_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return {};
@@ -464,6 +602,10 @@ ProblemExpertClient::getFunctions()
 bool
 ProblemExpertClient::addFunction(const plansys2::Function & function)
 {
+  if (!shards_.empty()) {
+    return getShardClient(function).addFunction(function);
+  }
+
   while (!add_problem_function_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -505,6 +647,10 @@ ProblemExpertClient::addFunction(const plansys2::Function & function)
 bool
 ProblemExpertClient::removeFunction(const plansys2::Function & function)
 {
+  if (!shards_.empty()) {
+    return getShardClient(function).removeFunction(function);
+  }
+
   while (!remove_problem_function_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -543,6 +689,10 @@ ProblemExpertClient::removeFunction(const plansys2::Function & function)
 bool
 ProblemExpertClient::existFunction(const plansys2::Function & function)
 {
+  if (!shards_.empty()) {
+    return getShardClient(function).existFunction(function);
+  }
+
   while (!exist_problem_function_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -571,6 +721,10 @@ ProblemExpertClient::existFunction(const plansys2::Function & function)
 
 bool ProblemExpertClient::updateFunction(const plansys2::Function & function)
 {
+  if (!shards_.empty()) {
+    return getShardClient(function).updateFunction(function);
+  }
+
   while (!update_problem_function_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -609,6 +763,10 @@ bool ProblemExpertClient::updateFunction(const plansys2::Function & function)
 std::optional<plansys2::Function>
 ProblemExpertClient::getFunction(const std::string & function)
 {
+  if (!shards_.empty()) {
+    return getShardClient(parser::pddl::fromStringFunction(function)).getFunction(function);
+  }
+
   while (!get_problem_function_details_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return {};
@@ -645,9 +803,74 @@ ProblemExpertClient::getFunction(const std::string & function)
 }
 
 
+std::optional<plansys2::Function>
+ProblemExpertClient::modifyFunction(const plansys2::Function & modifier)
+{
+  if (!shards_.empty()) {
+    return getShardClient(modifier).modifyFunction(modifier);
+  }
+
+  auto result = modifyFunctions({modifier});
+
+  if (result && result.value().size() == 1) {
+    return result.value()[0];
+  } else {
+    return {};
+  }
+}
+
+std::optional<std::vector<plansys2::Function>>
+ProblemExpertClient::modifyFunctions(const std::vector<plansys2::Function> & modifiers)
+{
+  if (!shards_.empty()) {
+    return modifyShardedFunctions(modifiers);
+  }
+
+  while (!modify_problem_functions_client_->wait_for_service(std::chrono::seconds(5))) {
+    if (!rclcpp::ok()) {
+      return {};
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      modify_problem_functions_client_->get_service_name() <<
+        " service  client: waiting for service to appear...");
+  }
+
+  auto request = std::make_shared<plansys2_msgs::srv::ModifyFunctions::Request>();
+  request->functions = plansys2::convertVector<plansys2_msgs::msg::Node, plansys2::Function>(
+    modifiers);
+
+  auto future_result = modify_problem_functions_client_->async_send_request(request);
+
+  if (rclcpp::spin_until_future_complete(node_, future_result, std::chrono::seconds(1)) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+  {
+    return {};
+  }
+
+  auto result = *future_result.get();
+
+  if (result.success) {
+    update_time_ = node_->now();
+    return plansys2::convertVector<plansys2::Function, plansys2_msgs::msg::Node>(
+      result.functions);
+  } else {
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      modify_problem_functions_client_->get_service_name() << ": " <<
+        result.error_info);
+    return {};
+  }
+}
+
+
 plansys2::Goal
 ProblemExpertClient::getGoal()
 {
+  if (!shards_.empty()) {
+    return shards_[0]->getGoal();
+  }
+
   plansys2_msgs::msg::Tree ret;
 
   while (!get_problem_goal_client_->wait_for_service(std::chrono::seconds(5))) {
@@ -687,6 +910,10 @@ ProblemExpertClient::getGoal()
 bool
 ProblemExpertClient::setGoal(const plansys2::Goal & goal)
 {
+  if (!shards_.empty()) {
+    return shards_[0]->setGoal(goal);
+  }
+
   while (!add_problem_goal_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -725,6 +952,10 @@ ProblemExpertClient::setGoal(const plansys2::Goal & goal)
 bool
 ProblemExpertClient::isGoalSatisfied(const plansys2::Goal & goal)
 {
+  if (!shards_.empty()) {
+    return isGoalSatisfiedInShards(goal);
+  }
+
   while (!is_problem_goal_satisfied_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -762,6 +993,10 @@ ProblemExpertClient::isGoalSatisfied(const plansys2::Goal & goal)
 bool
 ProblemExpertClient::clearGoal()
 {
+  if (!shards_.empty()) {
+    return shards_[0]->clearGoal();
+  }
+
   while (!remove_problem_goal_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -799,6 +1034,10 @@ ProblemExpertClient::clearGoal()
 bool
 ProblemExpertClient::clearKnowledge()
 {
+  if (!shards_.empty()) {
+    return forEachShard([](ProblemExpertClient & shard) {return shard.clearKnowledge();});
+  }
+
   while (!clear_problem_knowledge_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -846,6 +1085,10 @@ ProblemExpertClient::getProblem(bool use_cache)
 std::string
 ProblemExpertClient::getProblem()
 {
+  if (!shards_.empty()) {
+    return getShardedProblem();
+  }
+
   while (!get_problem_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return {};
@@ -882,6 +1125,11 @@ ProblemExpertClient::getProblem()
 bool
 ProblemExpertClient::addProblem(const std::string & problem_str)
 {
+  if (!shards_.empty()) {
+    return forEachShard(
+      [&](ProblemExpertClient & shard) {return shard.addProblem(problem_str);});
+  }
+
   while (!add_problem_client_->wait_for_service(std::chrono::seconds(5))) {
     if (!rclcpp::ok()) {
       return false;
@@ -917,4 +1165,517 @@ ProblemExpertClient::addProblem(const std::string & problem_str)
   }
 }
 
+uint64_t
+ProblemExpertClient::getRevision()
+{
+  if (!shards_.empty()) {
+    // Each shard has its own journal, so there is no revision of the whole knowledge
+    return 0;
+  }
+
+  auto result = requestChangesSince(0);
+
+  if (result) {
+    return result.value().revision;
+  } else {
+    return 0;
+  }
+}
+
+std::optional<std::vector<plansys2_msgs::msg::KnowledgeChange>>
+ProblemExpertClient::getChangesSince(uint64_t revision)
+{
+  if (!shards_.empty()) {
+    return {};
+  }
+
+  auto result = requestChangesSince(revision);
+
+  if (result && !result.value().resync_needed) {
+    return result.value().changes;
+  } else {
+    return {};
+  }
+}
+
+plansys2_msgs::msg::StateFingerprint
+ProblemExpertClient::getFingerprint()
+{
+  if (!shards_.empty()) {
+    // The shards hold disjoint facts, so their fingerprints are combined as a single state
+    plansys2_msgs::msg::StateFingerprint ret;
+    for (auto & shard : shards_) {
+      ret = StateFingerprint::combine(ret, shard->getFingerprint());
+    }
+    return ret;
+  }
+
+  auto result = requestChangesSince(0);
+
+  if (result) {
+    return result.value().fingerprint;
+  } else {
+    return {};
+  }
+}
+
+ConditionalUpdateResult
+ProblemExpertClient::applyChangesIf(
+  const std::vector<plansys2_msgs::msg::KnowledgeChange> & changes,
+  uint64_t expected_revision,
+  const plansys2_msgs::msg::Tree & condition,
+  uint64_t & revision)
+{
+  revision = 0;
+
+  if (!shards_.empty()) {
+    RCLCPP_ERROR(node_->get_logger(), "Conditional updates not available with shards");
+    return ConditionalUpdateResult::INVALID_CHANGE;
+  }
+
+  while (!conditional_update_client_->wait_for_service(std::chrono::seconds(5))) {
+    if (!rclcpp::ok()) {
+      return ConditionalUpdateResult::INVALID_CHANGE;
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      conditional_update_client_->get_service_name() <<
+        " service  client: waiting for service to appear...");
+  }
+
+  auto request = std::make_shared<plansys2_msgs::srv::ConditionalUpdate::Request>();
+  request->changes = changes;
+  request->expected_revision = expected_revision;
+  request->condition = condition;
+
+  auto future_result = conditional_update_client_->async_send_request(request);
+
+  if (rclcpp::spin_until_future_complete(node_, future_result, std::chrono::seconds(1)) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+  {
+    return ConditionalUpdateResult::INVALID_CHANGE;
+  }
+
+  auto result = *future_result.get();
+  revision = result.revision;
+
+  if (result.success) {
+    return ConditionalUpdateResult::APPLIED;
+  } else if (result.result == plansys2_msgs::srv::ConditionalUpdate::Response::APPLIED ||
+    result.result == plansys2_msgs::srv::ConditionalUpdate::Response::INVALID_CHANGE)
+  {
+    // Not applied for any other reason, as the expert not being active
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      conditional_update_client_->get_service_name() << ": " <<
+        result.error_info);
+    return ConditionalUpdateResult::INVALID_CHANGE;
+  } else {
+    return static_cast<ConditionalUpdateResult>(result.result);
+  }
+}
+
+std::optional<plansys2_msgs::srv::GetChangesSince::Response>
+ProblemExpertClient::requestChangesSince(uint64_t revision)
+{
+  while (!get_changes_since_client_->wait_for_service(std::chrono::seconds(5))) {
+    if (!rclcpp::ok()) {
+      return {};
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      get_changes_since_client_->get_service_name() <<
+        " service  client: waiting for service to appear...");
+  }
+
+  auto request = std::make_shared<plansys2_msgs::srv::GetChangesSince::Request>();
+  request->revision = revision;
+
+  auto future_result = get_changes_since_client_->async_send_request(request);
+
+  if (rclcpp::spin_until_future_complete(node_, future_result, std::chrono::seconds(1)) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+  {
+    return {};
+  }
+
+  auto result = *future_result.get();
+
+  if (result.success) {
+    return result;
+  } else {
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      get_changes_since_client_->get_service_name() << ": " <<
+        result.error_info);
+    return {};
+  }
+}
+
+void
+ProblemExpertClient::setContext(const std::string & context)
+{
+  context_ = context;
+
+  if (!shards_.empty()) {
+    for (auto & shard : shards_) {
+      shard->setContext(context);
+    }
+    return;
+  }
+
+  endpoint_->set_context(context);
+
+  // The cached problem is the one published by the selected context
+  cached_problem_.clear();
+  problem_sub_ = node_->create_subscription<std_msgs::msg::String>(
+    context.empty() ? "problem_expert/problem" :
+    "problem_expert/contexts/" + context + "/problem",
+    rclcpp::QoS(100), [this](std_msgs::msg::String::SharedPtr msg) {
+      cached_problem_ = msg->data;
+    });
+}
+
+bool
+ProblemExpertClient::createContext(const std::string & context)
+{
+  if (!shards_.empty()) {
+    return forEachShard(
+      [&](ProblemExpertClient & shard) {return shard.createContext(context);});
+  }
+
+  return manageContext(
+    plansys2_msgs::srv::ManageKnowledgeContext::Request::CREATE, context).has_value();
+}
+
+bool
+ProblemExpertClient::removeContext(const std::string & context)
+{
+  if (!shards_.empty()) {
+    return forEachShard(
+      [&](ProblemExpertClient & shard) {return shard.removeContext(context);});
+  }
+
+  return manageContext(
+    plansys2_msgs::srv::ManageKnowledgeContext::Request::REMOVE, context).has_value();
+}
+
+std::vector<std::string>
+ProblemExpertClient::getContexts()
+{
+  if (!shards_.empty()) {
+    // Contexts are created and removed in every shard at once
+    return shards_.front()->getContexts();
+  }
+
+  auto result = manageContext(plansys2_msgs::srv::ManageKnowledgeContext::Request::LIST, "");
+
+  if (result) {
+    return result.value().contexts;
+  } else {
+    return {};
+  }
+}
+
+std::optional<plansys2_msgs::srv::ManageKnowledgeContext::Response>
+ProblemExpertClient::manageContext(uint8_t operation, const std::string & context)
+{
+  while (!manage_knowledge_context_client_->wait_for_service(std::chrono::seconds(5))) {
+    if (!rclcpp::ok()) {
+      return {};
+    }
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      manage_knowledge_context_client_->get_service_name() <<
+        " service  client: waiting for service to appear...");
+  }
+
+  auto request = std::make_shared<plansys2_msgs::srv::ManageKnowledgeContext::Request>();
+  request->operation = operation;
+  request->context = context;
+
+  auto future_result = manage_knowledge_context_client_->async_send_request(request);
+
+  if (rclcpp::spin_until_future_complete(node_, future_result, std::chrono::seconds(1)) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+  {
+    return {};
+  }
+
+  auto result = *future_result.get();
+
+  if (result.success) {
+    return result;
+  } else {
+    RCLCPP_ERROR_STREAM(
+      node_->get_logger(),
+      manage_knowledge_context_client_->get_service_name() << ": " <<
+        result.error_info);
+    return {};
+  }
+}
+
+rclcpp::Time
+ProblemExpertClient::getUpdateTime() const
+{
+  if (shards_.empty()) {
+    return update_time_;
+  }
+
+  rclcpp::Time ret = shards_[0]->getUpdateTime();
+  for (size_t i = 1; i < shards_.size(); i++) {
+    ret = std::max(ret, shards_[i]->getUpdateTime());
+  }
+  return ret;
+}
+
+ProblemExpertClient &
+ProblemExpertClient::getShardClient(const plansys2_msgs::msg::Node & fact)
+{
+  return *shards_[get_shard(fact, shards_.size(), sharding_policy_)];
+}
+
+bool
+ProblemExpertClient::forEachShard(std::function<bool(ProblemExpertClient &)> request)
+{
+  std::vector<std::future<bool>> results;
+  for (auto & shard : shards_) {
+    results.push_back(
+      std::async(std::launch::async, [&request, &shard] {return request(*shard);}));
+  }
+
+  bool success = true;
+  for (auto & result : results) {
+    success = result.get() && success;
+  }
+  return success;
+}
+
+template<class T>
+std::vector<T>
+ProblemExpertClient::gatherFromShards(
+  std::function<std::vector<T>(ProblemExpertClient &)> request,
+  const std::vector<size_t> & shard_ids)
+{
+  std::vector<std::future<std::vector<T>>> results;
+  if (shard_ids.empty()) {
+    for (auto & shard : shards_) {
+      results.push_back(
+        std::async(std::launch::async, [&request, &shard] {return request(*shard);}));
+    }
+  } else {
+    for (auto id : shard_ids) {
+      results.push_back(
+        std::async(std::launch::async, [&request, this, id] {return request(*shards_[id]);}));
+    }
+  }
+
+  std::vector<T> ret;
+  for (auto & result : results) {
+    auto shard_ret = result.get();
+    ret.insert(
+      ret.end(), std::make_move_iterator(shard_ret.begin()),
+      std::make_move_iterator(shard_ret.end()));
+  }
+  return ret;
+}
+
+std::optional<std::vector<plansys2::Function>>
+ProblemExpertClient::modifyShardedFunctions(const std::vector<plansys2::Function> & modifiers)
+{
+  if (modifiers.empty()) {
+    return std::vector<plansys2::Function>();
+  }
+
+  // The batch is split by owning shard. Each part is atomic in its shard, but there is no
+  // atomic update across shards, so the parts already applied are kept if a later one fails
+  std::map<size_t, std::vector<size_t>> shard_modifiers;
+  for (size_t i = 0; i < modifiers.size(); i++) {
+    shard_modifiers[get_shard(modifiers[i], shards_.size(), sharding_policy_)].push_back(i);
+  }
+
+  std::vector<plansys2::Function> ret(modifiers.size());
+  for (const auto & [shard_id, indexes] : shard_modifiers) {
+    std::vector<plansys2::Function> shard_batch;
+    for (auto i : indexes) {
+      shard_batch.push_back(modifiers[i]);
+    }
+
+    auto shard_ret = shards_[shard_id]->modifyFunctions(shard_batch);
+    if (!shard_ret || shard_ret.value().size() != indexes.size()) {
+      RCLCPP_ERROR_STREAM(
+        node_->get_logger(),
+        "modifyFunctions: the batch was rejected by shard " << shard_id);
+      return {};
+    }
+    for (size_t i = 0; i < indexes.size(); i++) {
+      ret[indexes[i]] = shard_ret.value()[i];
+    }
+  }
+
+  return ret;
+}
+
+std::vector<plansys2::Predicate>
+ProblemExpertClient::getShardedPredicates()
+{
+  auto predicates = gatherFromShards<plansys2::Predicate>(
+    [](ProblemExpertClient & shard) {return shard.getPredicates();});
+
+  auto derived_predicates = getDerivedPredicates();
+  if (!derived_predicates.empty()) {
+    auto functions = gatherFromShards<plansys2::Function>(
+      [](ProblemExpertClient & shard) {return shard.getFunctions();});
+    auto derived = infer_derived_predicates(
+      derived_predicates, shards_[0]->getInstances(), predicates, functions);
+    predicates.insert(predicates.end(), derived.begin(), derived.end());
+  }
+
+  return predicates;
+}
+
+bool
+ProblemExpertClient::existShardedPredicate(const plansys2::Predicate & predicate)
+{
+  if (getShardClient(predicate).existPredicate(predicate)) {
+    return true;
+  }
+
+  auto derived_predicates = getDomainClient().getDerivedPredicate(predicate.name);
+  if (derived_predicates.empty()) {
+    return false;
+  }
+
+  auto predicates = gatherFromShards<plansys2::Predicate>(
+    [](ProblemExpertClient & shard) {return shard.getPredicates();});
+  auto functions = gatherFromShards<plansys2::Function>(
+    [](ProblemExpertClient & shard) {return shard.getFunctions();});
+
+  return check_derived_predicate(derived_predicates, predicate, predicates, functions);
+}
+
+bool
+ProblemExpertClient::isGoalSatisfiedInShards(const plansys2::Goal & goal)
+{
+  std::vector<plansys2_msgs::msg::Node> facts;
+  parser::pddl::getPredicates(facts, goal);
+  parser::pddl::getFunctions(facts, goal);
+
+  // The derived predicates of the goal depend on facts of any shard
+  std::vector<plansys2_msgs::msg::Derived> derived_predicates;
+  for (const auto & derived : getDerivedPredicates()) {
+    bool in_goal = std::any_of(
+      facts.begin(), facts.end(), [&derived](const plansys2_msgs::msg::Node & fact) {
+        return fact.name == derived.predicate.name;
+      });
+    if (in_goal) {
+      derived_predicates.push_back(derived);
+    }
+  }
+
+  // Otherwise, only the shards that may own a fact of the goal are queried
+  std::vector<size_t> shard_ids;
+  if (sharding_policy_ == ShardingPolicy::BY_SYMBOL && derived_predicates.empty()) {
+    std::vector<bool> queried(shards_.size(), false);
+    for (const auto & fact : facts) {
+      queried[get_shard(fact, shards_.size(), sharding_policy_)] = true;
+    }
+    for (size_t i = 0; i < queried.size(); i++) {
+      if (queried[i]) {
+        shard_ids.push_back(i);
+      }
+    }
+
+    if (shard_ids.empty()) {
+      shard_ids.push_back(0);
+    }
+  }
+
+  auto predicates = gatherFromShards<plansys2::Predicate>(
+    [](ProblemExpertClient & shard) {return shard.getPredicates();}, shard_ids);
+  auto functions = gatherFromShards<plansys2::Function>(
+    [](ProblemExpertClient & shard) {return shard.getFunctions();}, shard_ids);
+
+  if (!derived_predicates.empty()) {
+    auto derived = infer_derived_predicates(
+      derived_predicates, shards_[0]->getInstances(), predicates, functions);
+    predicates.insert(predicates.end(), derived.begin(), derived.end());
+  }
+
+  return check(goal, predicates, functions);
+}
+
+std::vector<plansys2_msgs::msg::Derived>
+ProblemExpertClient::getDerivedPredicates()
+{
+  auto & domain_client = getDomainClient();
+
+  std::vector<plansys2_msgs::msg::Derived> ret;
+  for (const auto & derived_name : domain_client.getDerivedPredicates()) {
+    auto derived = domain_client.getDerivedPredicate(derived_name.name);
+    ret.insert(ret.end(), derived.begin(), derived.end());
+  }
+  return ret;
+}
+
+DomainExpertClient &
+ProblemExpertClient::getDomainClient()
+{
+  if (domain_client_ == nullptr) {
+    domain_client_ = std::make_shared<DomainExpertClient>();
+  }
+  return *domain_client_;
+}
+
+std::string
+ProblemExpertClient::getShardedProblem()
+{
+  auto & domain_client = getDomainClient();
+
+  // A shard client can only wait for one response at a time, so each shard is queried from
+  // a single thread
+  struct ShardKnowledge
+  {
+    std::vector<plansys2::Instance> instances;
+    std::vector<plansys2::Predicate> predicates;
+    std::vector<plansys2::Function> functions;
+    plansys2::Goal goal;
+  };
+
+  std::vector<std::future<ShardKnowledge>> results;
+  for (size_t i = 0; i < shards_.size(); i++) {
+    results.push_back(
+      std::async(
+        std::launch::async, [shard = shards_[i], first = i == 0] {
+          ShardKnowledge knowledge;
+          knowledge.predicates = shard->getPredicates();
+          knowledge.functions = shard->getFunctions();
+          if (first) {
+            knowledge.instances = shard->getInstances();
+            knowledge.goal = shard->getGoal();
+          }
+          return knowledge;
+        }));
+  }
+
+  ShardKnowledge problem;
+  for (size_t i = 0; i < results.size(); i++) {
+    auto knowledge = results[i].get();
+    if (i == 0) {
+      problem.instances = std::move(knowledge.instances);
+      problem.goal = std::move(knowledge.goal);
+    }
+    problem.predicates.insert(
+      problem.predicates.end(), std::make_move_iterator(knowledge.predicates.begin()),
+      std::make_move_iterator(knowledge.predicates.end()));
+    problem.functions.insert(
+      problem.functions.end(), std::make_move_iterator(knowledge.functions.begin()),
+      std::make_move_iterator(knowledge.functions.end()));
+  }
+
+  return write_problem(
+    domain_client.getDomain(), problem.instances, problem.predicates, problem.functions,
+    problem.goal);
+}
+
 }  // namespace plansys2
@@ -14,6 +14,11 @@
 
 #include "plansys2_problem_expert/ProblemExpertNode.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <map>
 #include <string>
 #include <memory>
 #include <vector>
@@ -42,165 +47,216 @@ std::vector<std::string> tokenize(const std::string & string, const std::string
 namespace plansys2
 {
 
-ProblemExpertNode::ProblemExpertNode()
-: rclcpp_lifecycle::LifecycleNode("problem_expert")
+ProblemExpertNode::ProblemExpertNode(
+  const std::string & problem_expert_namespace, const rclcpp::NodeOptions & options)
+: rclcpp_lifecycle::LifecycleNode("problem_expert", problem_expert_namespace, options)
 {
   declare_parameter("model_file", "");
   declare_parameter("problem_file", "");
-
-  add_problem_service_ = create_service<plansys2_msgs::srv::AddProblem>(
-    "problem_expert/add_problem",
+  declare_parameter("journal_capacity", 1000);
+  declare_parameter("shard_id", 0);
+  declare_parameter("num_shards", 1);
+  declare_parameter("sharding_policy", "symbol");
+  declare_parameter("update_window", 0.1);
+  declare_parameter("legacy_services", true);
+  declare_parameter("fingerprint_function_quantum", 0.0);
+
+  multiplexer_ = std::make_shared<ServiceMultiplexer>(
+    this, "problem_expert", get_parameter("legacy_services").as_bool());
+
+  add_problem_service_ = multiplexer_->add<plansys2_msgs::srv::AddProblem>(
+    this, "add_problem",
     std::bind(
       &ProblemExpertNode::add_problem_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  add_problem_goal_service_ = create_service<plansys2_msgs::srv::AddProblemGoal>(
-    "problem_expert/add_problem_goal",
+  add_problem_goal_service_ = multiplexer_->add<plansys2_msgs::srv::AddProblemGoal>(
+    this, "add_problem_goal",
     std::bind(
       &ProblemExpertNode::add_problem_goal_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  add_problem_instance_service_ = create_service<plansys2_msgs::srv::AffectParam>(
-    "problem_expert/add_problem_instance",
+  add_problem_instance_service_ = multiplexer_->add<plansys2_msgs::srv::AffectParam>(
+    this, "add_problem_instance",
     std::bind(
       &ProblemExpertNode::add_problem_instance_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  add_problem_predicate_service_ = create_service<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/add_problem_predicate",
+  add_problem_predicate_service_ = multiplexer_->add<plansys2_msgs::srv::AffectNode>(
+    this, "add_problem_predicate",
     std::bind(
       &ProblemExpertNode::add_problem_predicate_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  add_problem_function_service_ = create_service<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/add_problem_function",
+  add_problem_function_service_ = multiplexer_->add<plansys2_msgs::srv::AffectNode>(
+    this, "add_problem_function",
     std::bind(
       &ProblemExpertNode::add_problem_function_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  get_problem_goal_service_ = create_service<plansys2_msgs::srv::GetProblemGoal>(
-    "problem_expert/get_problem_goal",
+  get_problem_goal_service_ = multiplexer_->add<plansys2_msgs::srv::GetProblemGoal>(
+    this, "get_problem_goal",
     std::bind(
       &ProblemExpertNode::get_problem_goal_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
   get_problem_instance_details_service_ =
-    create_service<plansys2_msgs::srv::GetProblemInstanceDetails>(
-    "problem_expert/get_problem_instance",
+    multiplexer_->add<plansys2_msgs::srv::GetProblemInstanceDetails>(
+    this, "get_problem_instance",
     std::bind(
       &ProblemExpertNode::get_problem_instance_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  get_problem_instances_service_ = create_service<plansys2_msgs::srv::GetProblemInstances>(
-    "problem_expert/get_problem_instances",
+  get_problem_instances_service_ = multiplexer_->add<plansys2_msgs::srv::GetProblemInstances>(
+    this, "get_problem_instances",
     std::bind(
       &ProblemExpertNode::get_problem_instances_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
   get_problem_predicate_details_service_ =
-    create_service<plansys2_msgs::srv::GetNodeDetails>(
-    "problem_expert/get_problem_predicate", std::bind(
+    multiplexer_->add<plansys2_msgs::srv::GetNodeDetails>(
+    this, "get_problem_predicate", std::bind(
       &ProblemExpertNode::get_problem_predicate_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  get_problem_predicates_service_ = create_service<plansys2_msgs::srv::GetStates>(
-    "problem_expert/get_problem_predicates",
+  get_problem_predicates_service_ = multiplexer_->add<plansys2_msgs::srv::GetStates>(
+    this, "get_problem_predicates",
     std::bind(
       &ProblemExpertNode::get_problem_predicates_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
   get_problem_function_details_service_ =
-    create_service<plansys2_msgs::srv::GetNodeDetails>(
-    "problem_expert/get_problem_function", std::bind(
+    multiplexer_->add<plansys2_msgs::srv::GetNodeDetails>(
+    this, "get_problem_function", std::bind(
       &ProblemExpertNode::get_problem_function_details_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  get_problem_functions_service_ = create_service<plansys2_msgs::srv::GetStates>(
-    "problem_expert/get_problem_functions",
+  get_problem_functions_service_ = multiplexer_->add<plansys2_msgs::srv::GetStates>(
+    this, "get_problem_functions",
     std::bind(
       &ProblemExpertNode::get_problem_functions_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  get_problem_service_ = create_service<plansys2_msgs::srv::GetProblem>(
-    "problem_expert/get_problem", std::bind(
+  get_problem_service_ = multiplexer_->add<plansys2_msgs::srv::GetProblem>(
+    this, "get_problem", std::bind(
       &ProblemExpertNode::get_problem_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  is_problem_goal_satisfied_service_ = create_service<plansys2_msgs::srv::IsProblemGoalSatisfied>(
-    "problem_expert/is_problem_goal_satisfied", std::bind(
+  is_problem_goal_satisfied_service_ =
+    multiplexer_->add<plansys2_msgs::srv::IsProblemGoalSatisfied>(
+    this, "is_problem_goal_satisfied", std::bind(
       &ProblemExpertNode::is_problem_goal_satisfied_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  remove_problem_goal_service_ = create_service<plansys2_msgs::srv::RemoveProblemGoal>(
-    "problem_expert/remove_problem_goal",
+  remove_problem_goal_service_ = multiplexer_->add<plansys2_msgs::srv::RemoveProblemGoal>(
+    this, "remove_problem_goal",
     std::bind(
       &ProblemExpertNode::remove_problem_goal_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  clear_problem_knowledge_service_ = create_service<plansys2_msgs::srv::ClearProblemKnowledge>(
-    "problem_expert/clear_problem_knowledge",
+  clear_problem_knowledge_service_ = multiplexer_->add<plansys2_msgs::srv::ClearProblemKnowledge>(
+    this, "clear_problem_knowledge",
     std::bind(
       &ProblemExpertNode::clear_problem_knowledge_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  remove_problem_instance_service_ = create_service<plansys2_msgs::srv::AffectParam>(
-    "problem_expert/remove_problem_instance",
+  remove_problem_instance_service_ = multiplexer_->add<plansys2_msgs::srv::AffectParam>(
+    this, "remove_problem_instance",
     std::bind(
       &ProblemExpertNode::remove_problem_instance_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  remove_problem_predicate_service_ = create_service<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/remove_problem_predicate",
+  remove_problem_predicate_service_ = multiplexer_->add<plansys2_msgs::srv::AffectNode>(
+    this, "remove_problem_predicate",
     std::bind(
       &ProblemExpertNode::remove_problem_predicate_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  remove_problem_function_service_ = create_service<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/remove_problem_function",
+  remove_problem_function_service_ = multiplexer_->add<plansys2_msgs::srv::AffectNode>(
+    this, "remove_problem_function",
     std::bind(
       &ProblemExpertNode::remove_problem_function_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  exist_problem_predicate_service_ = create_service<plansys2_msgs::srv::ExistNode>(
-    "problem_expert/exist_problem_predicate",
+  exist_problem_predicate_service_ = multiplexer_->add<plansys2_msgs::srv::ExistNode>(
+    this, "exist_problem_predicate",
     std::bind(
       &ProblemExpertNode::exist_problem_predicate_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  exist_problem_function_service_ = create_service<plansys2_msgs::srv::ExistNode>(
-    "problem_expert/exist_problem_function",
+  exist_problem_function_service_ = multiplexer_->add<plansys2_msgs::srv::ExistNode>(
+    this, "exist_problem_function",
     std::bind(
       &ProblemExpertNode::exist_problem_function_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
-  update_problem_function_service_ = create_service<plansys2_msgs::srv::AffectNode>(
-    "problem_expert/update_problem_function",
+  update_problem_function_service_ = multiplexer_->add<plansys2_msgs::srv::AffectNode>(
+    this, "update_problem_function",
     std::bind(
       &ProblemExpertNode::update_problem_function_service_callback,
       this, std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3));
 
+  modify_problem_functions_service_ = multiplexer_->add<plansys2_msgs::srv::ModifyFunctions>(
+    this, "modify_problem_functions",
+    std::bind(
+      &ProblemExpertNode::modify_problem_functions_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+
+  get_changes_since_service_ = multiplexer_->add<plansys2_msgs::srv::GetChangesSince>(
+    this, "get_changes_since",
+    std::bind(
+      &ProblemExpertNode::get_changes_since_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+
+  query_problem_predicates_service_ = multiplexer_->add<plansys2_msgs::srv::QueryPredicates>(
+    this, "query_problem_predicates",
+    std::bind(
+      &ProblemExpertNode::query_problem_predicates_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+
+  conditional_update_service_ = multiplexer_->add<plansys2_msgs::srv::ConditionalUpdate>(
+    this, "conditional_update",
+    std::bind(
+      &ProblemExpertNode::conditional_update_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+
+  manage_knowledge_context_service_ =
+    multiplexer_->add<plansys2_msgs::srv::ManageKnowledgeContext>(
+    this, "manage_knowledge_context",
+    std::bind(
+      &ProblemExpertNode::manage_knowledge_context_service_callback,
+      this, std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3));
+
+  multiplexer_->set_context_selector(
+    std::bind(&ProblemExpertNode::select_context, this, std::placeholders::_1));
+
   problem_pub_ = create_publisher<std_msgs::msg::String>(
     "problem_expert/problem",
     rclcpp::QoS(100));
@@ -212,6 +268,11 @@ ProblemExpertNode::ProblemExpertNode()
   knowledge_pub_ = create_publisher<plansys2_msgs::msg::Knowledge>(
     "problem_expert/knowledge",
     rclcpp::QoS(100).transient_local());
+
+  update_stream_sub_ = create_subscription<plansys2_msgs::msg::KnowledgeChange>(
+    "problem_expert/update_stream",
+    rclcpp::QoS(1000),
+    std::bind(&ProblemExpertNode::update_stream_callback, this, std::placeholders::_1));
 }
 
 
@@ -234,17 +295,25 @@ ProblemExpertNode::on_configure(const rclcpp_lifecycle::State & state)
       std::istreambuf_iterator<char>(domain_first_ifs)),
     std::istreambuf_iterator<char>());
 
-  auto domain_expert = std::make_shared<DomainExpert>(domain_first_str);
+  domain_expert_ = std::make_shared<DomainExpert>(domain_first_str);
 
   for (size_t i = 1; i < model_files.size(); i++) {
     std::ifstream domain_ifs(model_files[i]);
     std::string domain_str((
         std::istreambuf_iterator<char>(domain_ifs)),
       std::istreambuf_iterator<char>());
-    domain_expert->extendDomain(domain_str);
+    domain_expert_->extendDomain(domain_str);
   }
 
-  problem_expert_ = std::make_shared<ProblemExpert>(domain_expert);
+  problem_expert_ = create_problem_expert();
+  contexts_.clear();
+  contexts_[""] = {problem_expert_, update_pub_, knowledge_pub_, problem_pub_};
+
+  auto update_window = std::chrono::duration<double>(
+    std::max(0.001, get_parameter("update_window").get_value<double>()));
+  update_stream_timer_ = create_wall_timer(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(update_window),
+    std::bind(&ProblemExpertNode::apply_update_stream, this));
 
   auto problem_file = get_parameter("problem_file").get_value<std::string>();
   if (!problem_file.empty()) {
@@ -259,13 +328,53 @@ ProblemExpertNode::on_configure(const rclcpp_lifecycle::State & state)
   return CallbackReturnT::SUCCESS;
 }
 
+std::shared_ptr<ProblemExpert>
+ProblemExpertNode::create_problem_expert() const
+{
+  // The domain, and the type index built from it, is shared by all the contexts
+  auto problem_expert = std::make_shared<ProblemExpert>(domain_expert_);
+  problem_expert->setJournalCapacity(
+    std::max(0, get_parameter("journal_capacity").get_value<int>()));
+  problem_expert->setShard(
+    std::max(0, get_parameter("shard_id").get_value<int>()),
+    std::max(1, get_parameter("num_shards").get_value<int>()),
+    sharding_policy_from_string(get_parameter("sharding_policy").get_value<std::string>()));
+  problem_expert->setFingerprintQuantum(
+    std::max(0.0, get_parameter("fingerprint_function_quantum").get_value<double>()));
+
+  return problem_expert;
+}
+
+bool
+ProblemExpertNode::select_context(const std::string & context)
+{
+  // The callbacks share the selected context, so they have to run one at a time
+  assert(
+    get_node_base_interface()->get_default_callback_group()->type() ==
+    rclcpp::CallbackGroupType::MutuallyExclusive);
+
+  auto it = contexts_.find(context);
+  if (it == contexts_.end()) {
+    return false;
+  }
+
+  problem_expert_ = it->second.problem_expert;
+  update_pub_ = it->second.update_pub;
+  knowledge_pub_ = it->second.knowledge_pub;
+  problem_pub_ = it->second.problem_pub;
+
+  return true;
+}
+
 CallbackReturnT
 ProblemExpertNode::on_activate(const rclcpp_lifecycle::State & state)
 {
   RCLCPP_INFO(get_logger(), "[%s] Activating...", get_name());
-  update_pub_->on_activate();
-  knowledge_pub_->on_activate();
-  problem_pub_->on_activate();
+  for (auto & context : contexts_) {
+    context.second.update_pub->on_activate();
+    context.second.knowledge_pub->on_activate();
+    context.second.problem_pub->on_activate();
+  }
   RCLCPP_INFO(get_logger(), "[%s] Activated", get_name());
   return CallbackReturnT::SUCCESS;
 }
@@ -274,9 +383,11 @@ CallbackReturnT
 ProblemExpertNode::on_deactivate(const rclcpp_lifecycle::State & state)
 {
   RCLCPP_INFO(get_logger(), "[%s] Deactivating...", get_name());
-  update_pub_->on_deactivate();
-  knowledge_pub_->on_deactivate();
-  problem_pub_->on_deactivate();
+  for (auto & context : contexts_) {
+    context.second.update_pub->on_deactivate();
+    context.second.knowledge_pub->on_deactivate();
+    context.second.problem_pub->on_deactivate();
+  }
   RCLCPP_INFO(get_logger(), "[%s] Deactivated", get_name());
 
   return CallbackReturnT::SUCCESS;
@@ -308,6 +419,61 @@ ProblemExpertNode::on_error(const rclcpp_lifecycle::State & state)
   return CallbackReturnT::SUCCESS;
 }
 
+void
+ProblemExpertNode::update_stream_callback(
+  const plansys2_msgs::msg::KnowledgeChange::SharedPtr msg)
+{
+  if ((msg->ttl.sec != 0 || msg->ttl.nanosec != 0) &&
+    msg->stamp.sec == 0 && msg->stamp.nanosec == 0)
+  {
+    msg->stamp = now();
+  }
+
+  if (!update_coalescer_.add(*msg)) {
+    RCLCPP_WARN(
+      get_logger(), "Ignoring streamed update of type %d: only predicates and functions",
+      msg->type);
+  }
+}
+
+void
+ProblemExpertNode::apply_update_stream()
+{
+  if (problem_expert_ == nullptr) {
+    return;
+  }
+
+  // The update stream feeds the default context, and facts with a time-to-live expire at the
+  // same rate in every context
+  auto stamp = std::chrono::nanoseconds(now().nanoseconds());
+  for (auto & [name, context] : contexts_) {
+    auto & problem_expert = *context.problem_expert;
+    auto revision = problem_expert.getRevision();
+
+    if (name.empty() && !update_coalescer_.empty()) {
+      auto updates = update_coalescer_.flush();
+      auto applied = problem_expert.applyChanges(updates);
+
+      if (applied < updates.size()) {
+        RCLCPP_WARN(
+          get_logger(), "%zu of %zu streamed updates not valid", updates.size() - applied,
+          updates.size());
+      }
+    }
+
+    problem_expert.expireFacts(stamp);
+
+    if (problem_expert.getRevision() != revision) {
+      context.update_pub->publish(std_msgs::msg::Empty());
+      context.knowledge_pub->publish(*get_knowledge_as_msg(problem_expert));
+
+      std_msgs::msg::String problem_msg;
+      problem_msg.data = problem_expert.getProblem();
+      context.problem_pub->publish(problem_msg);
+    }
+  }
+}
+
 void
 ProblemExpertNode::add_problem_service_callback(
   const std::shared_ptr<rmw_request_id_t> request_header,
@@ -332,6 +498,7 @@ ProblemExpertNode::add_problem_service_callback(
     } else {
       response->error_info = "Problem not valid";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -362,6 +529,7 @@ ProblemExpertNode::add_problem_goal_service_callback(
       response->success = false;
       response->error_info = "Malformed expression";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -387,6 +555,7 @@ ProblemExpertNode::add_problem_instance_service_callback(
     } else {
       response->error_info = "Instance not valid";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -413,6 +582,7 @@ ProblemExpertNode::add_problem_predicate_service_callback(
       response->error_info =
         "Predicate [" + parser::pddl::toString(request->node) + "] not valid";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -439,6 +609,7 @@ ProblemExpertNode::add_problem_function_service_callback(
       response->error_info =
         "Function [" + parser::pddl::toString(request->node) + "] not valid";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -455,6 +626,7 @@ ProblemExpertNode::get_problem_goal_service_callback(
   } else {
     response->success = true;
     response->tree = problem_expert_->getGoal();
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -477,6 +649,7 @@ ProblemExpertNode::get_problem_instance_details_service_callback(
       response->success = false;
       response->error_info = "Instance not found";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -494,6 +667,7 @@ ProblemExpertNode::get_problem_instances_service_callback(
     response->success = true;
     response->instances = plansys2::convertVector<plansys2_msgs::msg::Param, plansys2::Instance>(
       problem_expert_->getInstances());
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -516,6 +690,7 @@ ProblemExpertNode::get_problem_predicate_details_service_callback(
       response->success = false;
       response->error_info = "Predicate not found";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -533,6 +708,7 @@ ProblemExpertNode::get_problem_predicates_service_callback(
     response->success = true;
     response->states = plansys2::convertVector<plansys2_msgs::msg::Node, plansys2::Predicate>(
       problem_expert_->getPredicates());
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -555,6 +731,7 @@ ProblemExpertNode::get_problem_function_details_service_callback(
       response->success = false;
       response->error_info = "Function not found";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -572,6 +749,7 @@ ProblemExpertNode::get_problem_functions_service_callback(
     response->success = true;
     response->states = plansys2::convertVector<plansys2_msgs::msg::Node, plansys2::Function>(
       problem_expert_->getFunctions());
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -588,6 +766,7 @@ ProblemExpertNode::get_problem_service_callback(
   } else {
     response->success = true;
     response->problem = problem_expert_->getProblem();
+    response->fingerprint = problem_expert_->getFingerprint();
 
     std::cerr << "get_problem_service_callback [" << response->problem << "]" << std::endl;
   }
@@ -606,6 +785,7 @@ ProblemExpertNode::is_problem_goal_satisfied_service_callback(
   } else {
     response->success = true;
     response->satisfied = problem_expert_->isGoalSatisfied(request->tree);
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -632,6 +812,7 @@ ProblemExpertNode::remove_problem_goal_service_callback(
     } else {
       response->error_info = "Error clearing goal";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -658,6 +839,7 @@ ProblemExpertNode::clear_problem_knowledge_service_callback(
     } else {
       response->error_info = "Error clearing knowledge";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -685,6 +867,7 @@ ProblemExpertNode::remove_problem_instance_service_callback(
     } else {
       response->error_info = "Error removing instance";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -710,6 +893,7 @@ ProblemExpertNode::remove_problem_predicate_service_callback(
     } else {
       response->error_info = "Error removing predicate";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -730,6 +914,7 @@ ProblemExpertNode::remove_problem_function_service_callback(
     } else {
       response->error_info = "Error removing function";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -744,6 +929,7 @@ ProblemExpertNode::exist_problem_predicate_service_callback(
     RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
   } else {
     response->exist = problem_expert_->existPredicate(request->node);
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -758,6 +944,7 @@ ProblemExpertNode::exist_problem_function_service_callback(
     RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
   } else {
     response->exist = problem_expert_->existFunction(request->node);
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
@@ -778,29 +965,230 @@ ProblemExpertNode::update_problem_function_service_callback(
     } else {
       response->error_info = "Function not valid";
     }
+    response->fingerprint = problem_expert_->getFingerprint();
+  }
+}
+
+void
+ProblemExpertNode::get_changes_since_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::GetChangesSince::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::GetChangesSince::Response> response)
+{
+  if (problem_expert_ == nullptr) {
+    response->success = false;
+    response->error_info = "Requesting service in non-active state";
+    RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
+  } else {
+    response->success = true;
+    response->revision = problem_expert_->getRevision();
+    response->fingerprint = problem_expert_->getFingerprint();
+
+    auto changes = problem_expert_->getChangesSince(request->revision);
+    if (changes) {
+      response->resync_needed = false;
+      response->changes = changes.value();
+    } else {
+      response->resync_needed = true;
+    }
+  }
+}
+
+void
+ProblemExpertNode::conditional_update_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::ConditionalUpdate::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::ConditionalUpdate::Response> response)
+{
+  if (problem_expert_ == nullptr) {
+    response->success = false;
+    response->error_info = "Requesting service in non-active state";
+    RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
+    return;
+  }
+
+  auto result = problem_expert_->applyChangesIf(
+    request->changes, request->expected_revision, request->condition, response->revision);
+  response->result = static_cast<uint8_t>(result);
+  response->fingerprint = problem_expert_->getFingerprint();
+
+  switch (result) {
+    case ConditionalUpdateResult::APPLIED:
+      response->success = true;
+      if (!request->changes.empty()) {
+        update_pub_->publish(std_msgs::msg::Empty());
+        knowledge_pub_->publish(*get_knowledge_as_msg());
+
+        std_msgs::msg::String problem_msg;
+        problem_msg.data = problem_expert_->getProblem();
+        problem_pub_->publish(problem_msg);
+      }
+      break;
+    case ConditionalUpdateResult::REVISION_CONFLICT:
+      response->success = false;
+      response->error_info = "Revision changed";
+      break;
+    case ConditionalUpdateResult::CONDITION_FAILED:
+      response->success = false;
+      response->error_info = "Condition not satisfied";
+      break;
+    case ConditionalUpdateResult::INVALID_CHANGE:
+      response->success = false;
+      response->error_info = "Change not valid";
+      break;
+  }
+}
+
+void
+ProblemExpertNode::manage_knowledge_context_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::ManageKnowledgeContext::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::ManageKnowledgeContext::Response> response)
+{
+  using plansys2_msgs::srv::ManageKnowledgeContext;
+
+  if (problem_expert_ == nullptr) {
+    response->success = false;
+    response->error_info = "Requesting service in non-active state";
+    RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
+    return;
+  }
+
+  const auto & context = request->context;
+  bool valid_name = !context.empty() && !std::isdigit(static_cast<unsigned char>(context[0]));
+  for (char c : context) {
+    valid_name = valid_name && (std::isalnum(static_cast<unsigned char>(c)) || c == '_');
+  }
+
+  switch (request->operation) {
+    case ManageKnowledgeContext::Request::CREATE:
+      if (!valid_name) {
+        response->success = false;
+        response->error_info = "Invalid context name [" + context + "]";
+      } else if (contexts_.find(context) != contexts_.end()) {
+        response->success = false;
+        response->error_info = "Context " + context + " already exists";
+      } else {
+        // Each context publishes its updates under its own namespace
+        auto prefix = "problem_expert/contexts/" + context + "/";
+        KnowledgeContext new_context{
+          create_problem_expert(),
+          create_publisher<std_msgs::msg::Empty>(prefix + "update_notify", rclcpp::QoS(100)),
+          create_publisher<plansys2_msgs::msg::Knowledge>(
+            prefix + "knowledge", rclcpp::QoS(100).transient_local()),
+          create_publisher<std_msgs::msg::String>(prefix + "problem", rclcpp::QoS(100))};
+
+        if (get_current_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE) {
+          new_context.update_pub->on_activate();
+          new_context.knowledge_pub->on_activate();
+          new_context.problem_pub->on_activate();
+        }
+
+        contexts_[context] = new_context;
+        response->success = true;
+      }
+      break;
+    case ManageKnowledgeContext::Request::REMOVE:
+      // A context being used by the current request is kept alive until the request ends
+      if (context.empty() || contexts_.erase(context) == 0) {
+        response->success = false;
+        response->error_info = "Unknown context [" + context + "]";
+      } else {
+        response->success = true;
+      }
+      break;
+    case ManageKnowledgeContext::Request::LIST:
+      response->success = true;
+      break;
+    default:
+      response->success = false;
+      response->error_info = "Unknown operation " + std::to_string(request->operation);
+      return;
+  }
+
+  for (const auto & named_context : contexts_) {
+    if (!named_context.first.empty()) {
+      response->contexts.push_back(named_context.first);
+    }
+  }
+}
+
+void
+ProblemExpertNode::query_problem_predicates_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::QueryPredicates::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::QueryPredicates::Response> response)
+{
+  if (problem_expert_ == nullptr) {
+    response->success = false;
+    response->error_info = "Requesting service in non-active state";
+    RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
+  } else {
+    response->success = true;
+    response->predicates =
+      plansys2::convertVector<plansys2_msgs::msg::Node, plansys2::Predicate>(
+      problem_expert_->queryPredicates(
+        request->pattern, request->max_results, request->start_after,
+        response->next_start_after));
+    response->fingerprint = problem_expert_->getFingerprint();
+  }
+}
+
+void
+ProblemExpertNode::modify_problem_functions_service_callback(
+  const std::shared_ptr<rmw_request_id_t> request_header,
+  const std::shared_ptr<plansys2_msgs::srv::ModifyFunctions::Request> request,
+  const std::shared_ptr<plansys2_msgs::srv::ModifyFunctions::Response> response)
+{
+  if (problem_expert_ == nullptr) {
+    response->success = false;
+    response->error_info = "Requesting service in non-active state";
+    RCLCPP_WARN(get_logger(), "Requesting service in non-active state");
+  } else {
+    auto functions = problem_expert_->modifyFunctions(
+      plansys2::convertVector<plansys2::Function, plansys2_msgs::msg::Node>(
+        request->functions));
+    response->success = functions.has_value();
+    if (response->success) {
+      response->functions =
+        plansys2::convertVector<plansys2_msgs::msg::Node, plansys2::Function>(
+        functions.value());
+      update_pub_->publish(std_msgs::msg::Empty());
+    } else {
+      response->error_info = "Function not found or modifier not valid";
+    }
+    response->fingerprint = problem_expert_->getFingerprint();
   }
 }
 
 plansys2_msgs::msg::Knowledge::SharedPtr
 ProblemExpertNode::get_knowledge_as_msg() const
+{
+  return get_knowledge_as_msg(*problem_expert_);
+}
+
+plansys2_msgs::msg::Knowledge::SharedPtr
+ProblemExpertNode::get_knowledge_as_msg(ProblemExpert & problem_expert) const
 {
   auto ret_msgs = std::make_shared<plansys2_msgs::msg::Knowledge>();
 
-  for (const auto & instance : problem_expert_->getInstances()) {
+  for (const auto & instance : problem_expert.getInstances()) {
     ret_msgs->instances.push_back(instance.name);
   }
 
-  for (const auto & predicate : problem_expert_->getPredicates()) {
+  for (const auto & predicate : problem_expert.getPredicates()) {
     ret_msgs->predicates.push_back(parser::pddl::toString(predicate));
   }
 
-  for (const auto & function : problem_expert_->getFunctions()) {
+  for (const auto & function : problem_expert.getFunctions()) {
     ret_msgs->functions.push_back(parser::pddl::toString(function));
   }
 
-  auto goal = problem_expert_->getGoal();
+  auto goal = problem_expert.getGoal();
   ret_msgs->goal = parser::pddl::toString(goal);
 
+  ret_msgs->fingerprint = problem_expert.getFingerprint();
+
   return ret_msgs;
 }
 
@@ -0,0 +1,63 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_problem_expert/Sharding.hpp"
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+namespace plansys2
+{
+
+namespace
+{
+
+// FNV-1a, case insensitive as PDDL names are
+uint64_t hash_name(const std::string & name)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : name) {
+    hash ^= static_cast<uint64_t>(std::tolower(c));
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+ShardingPolicy
+sharding_policy_from_string(const std::string & policy)
+{
+  if (policy == "object") {
+    return ShardingPolicy::BY_OBJECT;
+  }
+  return ShardingPolicy::BY_SYMBOL;
+}
+
+size_t
+get_shard(const plansys2_msgs::msg::Node & fact, size_t num_shards, ShardingPolicy policy)
+{
+  if (num_shards <= 1) {
+    return 0;
+  }
+
+  if (policy == ShardingPolicy::BY_OBJECT && !fact.parameters.empty()) {
+    return hash_name(fact.parameters[0].name) % num_shards;
+  }
+
+  return hash_name(fact.name) % num_shards;
+}
+
+}  // namespace plansys2
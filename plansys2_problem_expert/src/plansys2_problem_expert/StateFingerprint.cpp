@@ -0,0 +1,206 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "plansys2_problem_expert/StateFingerprint.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace plansys2
+{
+
+namespace
+{
+
+uint64_t mix(uint64_t h)
+{
+  // Finalizer of MurmurHash3, so every bit of the input affects every bit of the output
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t hash(const std::string & data, uint64_t seed)
+{
+  // FNV-1a from a seeded offset
+  uint64_t h = 0xcbf29ce484222325ULL ^ mix(seed);
+  for (unsigned char c : data) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return mix(h ^ data.size());
+}
+
+plansys2_msgs::msg::StateFingerprint key(const std::string & fact)
+{
+  plansys2_msgs::msg::StateFingerprint ret;
+  ret.high = hash(fact, 0x9e3779b97f4a7c15ULL);
+  ret.low = hash(fact, 0xbf58476d1ce4e5b9ULL);
+  return ret;
+}
+
+std::string fact_id(const plansys2_msgs::msg::Node & fact)
+{
+  std::string id = std::to_string(fact.node_type) + fact.name;
+  for (const auto & param : fact.parameters) {
+    id += " " + param.name;
+  }
+  return id;
+}
+
+}  // namespace
+
+StateFingerprint::StateFingerprint(double function_quantum)
+: function_quantum_(function_quantum)
+{
+}
+
+void
+StateFingerprint::setFunctionQuantum(double function_quantum)
+{
+  function_quantum_ = function_quantum;
+  clear();
+}
+
+void
+StateFingerprint::togglePredicate(const plansys2::Predicate & predicate)
+{
+  toggle(predicateKey(predicate));
+}
+
+void
+StateFingerprint::setFunction(const plansys2::Function & function)
+{
+  auto new_key = functionKey(function, function_quantum_);
+  auto & current_key = function_keys_[fact_id(function)];
+
+  toggle(current_key);
+  toggle(new_key);
+  current_key = new_key;
+}
+
+void
+StateFingerprint::removeFunction(const plansys2::Function & function)
+{
+  auto it = function_keys_.find(fact_id(function));
+  if (it != function_keys_.end()) {
+    toggle(it->second);
+    function_keys_.erase(it);
+  }
+}
+
+void
+StateFingerprint::apply(const plansys2_msgs::msg::KnowledgeChange & change)
+{
+  switch (change.type) {
+    case plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE:
+    case plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE:
+      togglePredicate(change.node);
+      break;
+    case plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION:
+      setFunction(change.node);
+      break;
+    case plansys2_msgs::msg::KnowledgeChange::REMOVE_FUNCTION:
+      removeFunction(change.node);
+      break;
+    case plansys2_msgs::msg::KnowledgeChange::CLEAR_KNOWLEDGE:
+      clear();
+      break;
+    default:
+      break;
+  }
+}
+
+void
+StateFingerprint::clear()
+{
+  fingerprint_ = plansys2_msgs::msg::StateFingerprint();
+  function_keys_.clear();
+}
+
+plansys2_msgs::msg::StateFingerprint
+StateFingerprint::compute(
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  double function_quantum)
+{
+  StateFingerprint fingerprint(function_quantum);
+  for (const auto & predicate : predicates) {
+    fingerprint.togglePredicate(predicate);
+  }
+  for (const auto & function : functions) {
+    fingerprint.setFunction(function);
+  }
+  return fingerprint.get();
+}
+
+plansys2_msgs::msg::StateFingerprint
+StateFingerprint::combine(
+  const plansys2_msgs::msg::StateFingerprint & fingerprint_1,
+  const plansys2_msgs::msg::StateFingerprint & fingerprint_2)
+{
+  plansys2_msgs::msg::StateFingerprint ret;
+  ret.high = fingerprint_1.high ^ fingerprint_2.high;
+  ret.low = fingerprint_1.low ^ fingerprint_2.low;
+  return ret;
+}
+
+std::string
+StateFingerprint::toString(const plansys2_msgs::msg::StateFingerprint & fingerprint)
+{
+  std::ostringstream ss;
+  ss << std::hex << std::setfill('0') << std::setw(16) << fingerprint.high <<
+    std::setw(16) << fingerprint.low;
+  return ss.str();
+}
+
+plansys2_msgs::msg::StateFingerprint
+StateFingerprint::predicateKey(const plansys2::Predicate & predicate)
+{
+  return key(fact_id(predicate));
+}
+
+plansys2_msgs::msg::StateFingerprint
+StateFingerprint::functionKey(const plansys2::Function & function, double function_quantum)
+{
+  std::string value;
+  if (function_quantum > 0.0) {
+    value = std::to_string(std::llround(function.value / function_quantum));
+  } else {
+    // Exact bits of the value, with -0.0 taken as 0.0
+    double exact = function.value == 0.0 ? 0.0 : function.value;
+    uint64_t bits;
+    std::memcpy(&bits, &exact, sizeof(bits));
+    value = std::to_string(bits);
+  }
+
+  return key(fact_id(function) + " = " + value);
+}
+
+void
+StateFingerprint::toggle(const plansys2_msgs::msg::StateFingerprint & key)
+{
+  fingerprint_ = combine(fingerprint_, key);
+}
+
+}  // namespace plansys2
@@ -0,0 +1,65 @@
+// Copyright 2019 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_problem_expert/UpdateCoalescer.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plansys2
+{
+
+bool
+UpdateCoalescer::add(const plansys2_msgs::msg::KnowledgeChange & change)
+{
+  std::string key;
+  switch (change.type) {
+    case plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE:
+    case plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE:
+      key = "p";
+      break;
+    case plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION:
+      key = "f";
+      break;
+    default:
+      return false;
+  }
+
+  key += change.node.name;
+  for (const auto & param : change.node.parameters) {
+    key += " " + param.name;
+  }
+
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    index_.emplace(std::move(key), pending_.size());
+    pending_.push_back(change);
+  } else {
+    pending_[it->second] = change;
+  }
+
+  return true;
+}
+
+std::vector<plansys2_msgs::msg::KnowledgeChange>
+UpdateCoalescer::flush()
+{
+  std::vector<plansys2_msgs::msg::KnowledgeChange> ret;
+  ret.swap(pending_);
+  index_.clear();
+  return ret;
+}
+
+}  // namespace plansys2
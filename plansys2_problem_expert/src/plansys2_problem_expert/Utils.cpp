@@ -12,44 +12,382 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <iostream>
+#include <sstream>
 #include <tuple>
 #include <memory>
 #include <string>
 #include <vector>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <utility>
 
 #include "plansys2_problem_expert/Utils.hpp"
+#include "plansys2_pddl_parser/Domain.hpp"
+#include "plansys2_pddl_parser/Instance.hpp"
 #include "plansys2_pddl_parser/Utils.hpp"
 
 namespace plansys2
 {
 
+namespace
+{
+
+plansys2::Function make_modifier(
+  const plansys2_msgs::msg::Tree & tree, uint32_t node_id, double operand)
+{
+  plansys2::Function modifier = tree.nodes[tree.nodes[node_id].children[0]];
+  modifier.modifier_type = tree.nodes[node_id].modifier_type;
+  modifier.value = operand;
+  return modifier;
+}
+
+}  // namespace
+
+std::optional<double> modify_value(uint8_t modifier_type, double value, double operand)
+{
+  switch (modifier_type) {
+    case plansys2_msgs::msg::Node::ASSIGN:
+      return operand;
+    case plansys2_msgs::msg::Node::INCREASE:
+      return value + operand;
+    case plansys2_msgs::msg::Node::DECREASE:
+      return value - operand;
+    case plansys2_msgs::msg::Node::SCALE_UP:
+      return value * operand;
+    case plansys2_msgs::msg::Node::SCALE_DOWN:
+      // Division by zero not allowed.
+      if (std::abs(operand) > 1e-5) {
+        return value / operand;
+      }
+      return {};
+    default:
+      return {};
+  }
+}
+
+ObjectTable::Id
+ObjectTable::id(const std::string & name)
+{
+  auto [it, inserted] = ids_.emplace(name, names_.size());
+  if (inserted) {
+    names_.push_back(name);
+  }
+  return it->second;
+}
+
+namespace
+{
+
+int find_variable(const std::vector<std::string> & names, const std::string & name)
+{
+  for (size_t i = names.size(); i > 0; i--) {
+    if (names[i - 1] == name) {
+      return i - 1;
+    }
+  }
+  return -1;
+}
+
+void compile_node(LiftedTree & lifted, uint32_t node_id, std::vector<std::string> & names)
+{
+  const auto & node = lifted.tree.nodes[node_id];
+  lifted.scope[node_id] = names.size();
+
+  if (node.node_type == plansys2_msgs::msg::Node::EXISTS) {
+    for (size_t i = 0; i < node.parameters.size(); i++) {
+      lifted.args[node_id][i] = names.size();
+      names.push_back(node.parameters[i].name);
+    }
+    lifted.n_variables = std::max(lifted.n_variables, names.size());
+  } else {
+    for (size_t i = 0; i < node.parameters.size(); i++) {
+      lifted.args[node_id][i] = find_variable(names, node.parameters[i].name);
+    }
+  }
+
+  for (auto child_id : node.children) {
+    compile_node(lifted, child_id, names);
+  }
+  names.resize(lifted.scope[node_id]);
+}
+
+}  // namespace
+
+LiftedTree::LiftedTree(
+  const plansys2_msgs::msg::Tree & tree,
+  const std::vector<std::string> & variables)
+: tree(tree),
+  args(tree.nodes.size()),
+  scope(tree.nodes.size(), 0),
+  n_variables(variables.size())
+{
+  for (size_t i = 0; i < tree.nodes.size(); i++) {
+    args[i].assign(tree.nodes[i].parameters.size(), -1);
+  }
+
+  if (!tree.nodes.empty()) {
+    std::vector<std::string> names = variables;
+    compile_node(*this, 0, names);
+  }
+}
+
+ParameterBinding::ParameterBinding(const LiftedTree & lifted, ObjectTable & objects)
+: lifted(&lifted),
+  objects(&objects),
+  ids(lifted.n_variables, UNBOUND)
+{
+}
+
+const std::string &
+ParameterBinding::resolve(
+  const plansys2_msgs::msg::Tree & tree, uint32_t node_id, size_t param) const
+{
+  const auto & name = tree.nodes[node_id].parameters[param].name;
+  if (lifted == nullptr) {
+    return name;
+  }
+
+  int var = lifted->args[node_id][param];
+  if (var < 0 || ids[var] == UNBOUND) {
+    return name;
+  }
+  return objects->name(ids[var]);
+}
+
+plansys2_msgs::msg::Node
+ParameterBinding::ground(const plansys2_msgs::msg::Tree & tree, uint32_t node_id) const
+{
+  plansys2_msgs::msg::Node node = tree.nodes[node_id];
+  for (size_t i = 0; i < node.parameters.size(); i++) {
+    node.parameters[i].name = resolve(tree, node_id, i);
+  }
+  return node;
+}
+
+namespace
+{
+
+bool match_node(
+  const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+  const ParameterBinding & binding,
+  const plansys2_msgs::msg::Node & ground)
+{
+  const auto & node = tree.nodes[node_id];
+  if (node.node_type != ground.node_type || node.name != ground.name ||
+    node.parameters.size() != ground.parameters.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < node.parameters.size(); i++) {
+    if (binding.resolve(tree, node_id, i) != ground.parameters[i].name) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A state kept in vectors. It is read-only when it is built from const vectors.
+class VectorState : public EvaluationState
+{
+public:
+  VectorState(
+    const std::vector<plansys2::Predicate> & predicates,
+    const std::vector<plansys2::Function> & functions,
+    const std::vector<plansys2::Instance> & instances = no_instances())
+  : predicates_(predicates), functions_(functions), instances_(instances) {}
+
+  VectorState(
+    std::vector<plansys2::Predicate> & predicates,
+    std::vector<plansys2::Function> & functions)
+  : predicates_(predicates), functions_(functions), instances_(no_instances()),
+    mutable_predicates_(&predicates), mutable_functions_(&functions) {}
+
+  bool existPredicate(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) override
+  {
+    return std::any_of(
+      predicates_.begin(), predicates_.end(),
+      [&](const plansys2::Predicate & predicate) {
+        return match_node(tree, node_id, binding, predicate);
+      });
+  }
+
+  std::optional<double> getFunctionValue(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) override
+  {
+    auto it = std::find_if(
+      functions_.begin(), functions_.end(),
+      [&](const plansys2::Function & function) {
+        return match_node(tree, node_id, binding, function);
+      });
+    if (it == functions_.end()) {
+      return {};
+    }
+    return it->value;
+  }
+
+  bool addPredicate(const plansys2::Predicate & predicate) override
+  {
+    if (mutable_predicates_ == nullptr) {
+      return false;
+    }
+    auto it = std::find_if(
+      predicates_.begin(), predicates_.end(),
+      std::bind(&parser::pddl::checkNodeEquality, std::placeholders::_1, predicate));
+    if (it == predicates_.end()) {
+      mutable_predicates_->push_back(predicate);
+    }
+    return true;
+  }
+
+  bool removePredicate(const plansys2::Predicate & predicate) override
+  {
+    if (mutable_predicates_ == nullptr) {
+      return false;
+    }
+    auto it = std::find_if(
+      mutable_predicates_->begin(), mutable_predicates_->end(),
+      std::bind(&parser::pddl::checkNodeEquality, std::placeholders::_1, predicate));
+    if (it != mutable_predicates_->end()) {
+      mutable_predicates_->erase(it);
+    }
+    return true;
+  }
+
+  std::optional<double> modifyFunction(
+    const plansys2::Function & function, uint8_t modifier_type, double operand) override
+  {
+    if (mutable_functions_ == nullptr) {
+      return {};
+    }
+    auto it = std::find_if(
+      mutable_functions_->begin(), mutable_functions_->end(),
+      std::bind(&parser::pddl::checkNodeEquality, std::placeholders::_1, function));
+    if (it == mutable_functions_->end()) {
+      return {};
+    }
+    auto modified = modify_value(modifier_type, it->value, operand);
+    if (modified) {
+      it->value = modified.value();
+    }
+    return modified;
+  }
+
+  std::tuple<bool, bool, double> evaluateExists(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    ParameterBinding & binding) override
+  {
+    return evaluate_exists(tree, instances_, predicates_, functions_, node_id, binding);
+  }
+
+private:
+  static const std::vector<plansys2::Instance> & no_instances()
+  {
+    static const std::vector<plansys2::Instance> empty;
+    return empty;
+  }
+
+  const std::vector<plansys2::Predicate> & predicates_;
+  const std::vector<plansys2::Function> & functions_;
+  const std::vector<plansys2::Instance> & instances_;
+  std::vector<plansys2::Predicate> * mutable_predicates_ = nullptr;
+  std::vector<plansys2::Function> * mutable_functions_ = nullptr;
+};
+
+// The state of a problem expert, through its client
+class ClientState : public EvaluationState
+{
+public:
+  explicit ClientState(std::shared_ptr<plansys2::ProblemExpertClient> problem_client)
+  : problem_client_(problem_client) {}
+
+  bool existPredicate(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) override
+  {
+    return problem_client_->existPredicate(binding.ground(tree, node_id));
+  }
+
+  std::optional<double> getFunctionValue(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    const ParameterBinding & binding) override
+  {
+    auto function = problem_client_->getFunction(
+      parser::pddl::toString(binding.ground(tree, node_id)));
+    if (!function) {
+      return {};
+    }
+    return function.value().value;
+  }
+
+  bool addPredicate(const plansys2::Predicate & predicate) override
+  {
+    return problem_client_->addPredicate(predicate);
+  }
+
+  bool removePredicate(const plansys2::Predicate & predicate) override
+  {
+    return problem_client_->removePredicate(predicate);
+  }
+
+  std::optional<double> modifyFunction(
+    const plansys2::Function & function, uint8_t modifier_type, double operand) override
+  {
+    // The problem expert applies the modifier to its current value in a single request
+    plansys2::Function modifier = function;
+    modifier.modifier_type = modifier_type;
+    modifier.value = operand;
+
+    auto result = problem_client_->modifyFunction(modifier);
+    if (!result) {
+      return {};
+    }
+    return result.value().value;
+  }
+
+  std::tuple<bool, bool, double> evaluateExists(
+    const plansys2_msgs::msg::Tree & tree, uint32_t node_id,
+    ParameterBinding & binding) override
+  {
+    // Take a single snapshot of the problem instead of querying each grounding
+    auto predicates = problem_client_->getPredicates();
+    auto functions = problem_client_->getFunctions();
+    return evaluate_exists(
+      tree, problem_client_->getInstances(), predicates, functions, node_id, binding);
+  }
+
+private:
+  std::shared_ptr<plansys2::ProblemExpertClient> problem_client_;
+};
+
+}  // namespace
+
 std::tuple<bool, bool, double> evaluate(
   const plansys2_msgs::msg::Tree & tree,
-  std::shared_ptr<plansys2::ProblemExpertClient> problem_client,
-  std::vector<plansys2::Predicate> & predicates,
-  std::vector<plansys2::Function> & functions,
+  ParameterBinding & binding,
+  EvaluationState & state,
   bool apply,
-  bool use_state,
-  uint8_t node_id,
+  uint32_t node_id,
   bool negate)
 {
   if (tree.nodes.empty()) {  // No expression
     return std::make_tuple(true, true, 0);
   }
 
-  switch (tree.nodes[node_id].node_type) {
+  const auto & node = tree.nodes[node_id];
+
+  switch (node.node_type) {
     case plansys2_msgs::msg::Node::AND: {
         bool success = true;
         bool truth_value = true;
 
-        for (auto & child_id : tree.nodes[node_id].children) {
-          std::tuple<bool, bool, double> result =
-            evaluate(
-            tree, problem_client, predicates, functions, apply, use_state, child_id,
-            negate);
+        for (auto & child_id : node.children) {
+          auto result = evaluate(tree, binding, state, apply, child_id, negate);
           success = success && std::get<0>(result);
           truth_value = truth_value && std::get<1>(result);
         }
@@ -60,11 +398,8 @@ std::tuple<bool, bool, double> evaluate(
         bool success = true;
         bool truth_value = false;
 
-        for (auto & child_id : tree.nodes[node_id].children) {
-          std::tuple<bool, bool, double> result =
-            evaluate(
-            tree, problem_client, predicates, functions, apply, use_state, child_id,
-            negate);
+        for (auto & child_id : node.children) {
+          auto result = evaluate(tree, binding, state, apply, child_id, negate);
           success = success && std::get<0>(result);
           truth_value = truth_value || std::get<1>(result);
         }
@@ -72,172 +407,89 @@ std::tuple<bool, bool, double> evaluate(
       }
 
     case plansys2_msgs::msg::Node::NOT: {
-        return evaluate(
-          tree, problem_client, predicates, functions, apply, use_state,
-          tree.nodes[node_id].children[0],
-          !negate);
+        return evaluate(tree, binding, state, apply, node.children[0], !negate);
       }
 
     case plansys2_msgs::msg::Node::PREDICATE: {
-        bool success = true;
-        bool value = true;
-
         if (apply) {
-          if (use_state) {
-            auto it =
-              std::find_if(
-              predicates.begin(), predicates.end(),
-              std::bind(
-                &parser::pddl::checkNodeEquality, std::placeholders::_1,
-                tree.nodes[node_id]));
-            if (negate) {
-              if (it != predicates.end()) {
-                predicates.erase(it);
-              }
-              value = false;
-            } else {
-              if (it == predicates.end()) {
-                predicates.push_back(tree.nodes[node_id]);
-              }
-            }
-          } else {
-            if (negate) {
-              success = success && problem_client->removePredicate(tree.nodes[node_id]);
-              value = false;
-            } else {
-              success = success && problem_client->addPredicate(tree.nodes[node_id]);
-            }
-          }
-        } else {
-          // negate | exist | output
-          //   F    |   F   |   F
-          //   F    |   T   |   T
-          //   T    |   F   |   T
-          //   T    |   T   |   F
-          if (use_state) {
-            value = negate ^
-              (std::find_if(
-                predicates.begin(), predicates.end(),
-                std::bind(
-                  &parser::pddl::checkNodeEquality, std::placeholders::_1,
-                  tree.nodes[node_id])) != predicates.end());
-          } else {
-            value = negate ^ problem_client->existPredicate(tree.nodes[node_id]);
+          if (negate) {
+            bool success = state.removePredicate(binding.ground(tree, node_id));
+            return std::make_tuple(success, false, 0);
           }
+          bool success = state.addPredicate(binding.ground(tree, node_id));
+          return std::make_tuple(success, true, 0);
         }
 
-        return std::make_tuple(success, value, 0);
+        // negate | exist | output
+        //   F    |   F   |   F
+        //   F    |   T   |   T
+        //   T    |   F   |   T
+        //   T    |   T   |   F
+        return std::make_tuple(true, negate ^ state.existPredicate(tree, node_id, binding), 0);
       }
 
     case plansys2_msgs::msg::Node::FUNCTION: {
-        bool success = true;
-        double value = 0;
-
-        if (use_state) {
-          auto it =
-            std::find_if(
-            functions.begin(), functions.end(),
-            std::bind(
-              &parser::pddl::checkNodeEquality, std::placeholders::_1,
-              tree.nodes[node_id]));
-          if (it != functions.end()) {
-            value = it->value;
-          } else {
-            success = false;
-          }
-        } else {
-          std::optional<plansys2_msgs::msg::Node> func =
-            problem_client->getFunction(parser::pddl::toString(tree, node_id));
-
-          if (func.has_value()) {
-            value = func.value().value;
-          } else {
-            success = false;
-          }
+        auto value = state.getFunctionValue(tree, node_id, binding);
+        if (!value) {
+          return std::make_tuple(false, false, 0);
         }
-
-        return std::make_tuple(success, false, value);
+        return std::make_tuple(true, false, value.value());
       }
 
     case plansys2_msgs::msg::Node::EXPRESSION: {
-        std::tuple<bool, bool, double> left = evaluate(
-          tree, problem_client, predicates,
-          functions, apply, use_state, tree.nodes[node_id].children[0], negate);
-        std::tuple<bool, bool, double> right = evaluate(
-          tree, problem_client, predicates,
-          functions, apply, use_state, tree.nodes[node_id].children[1], negate);
+        auto left = evaluate(tree, binding, state, apply, node.children[0], negate);
+        auto right = evaluate(tree, binding, state, apply, node.children[1], negate);
 
         if (!std::get<0>(left) || !std::get<0>(right)) {
           return std::make_tuple(false, false, 0);
         }
 
-        switch (tree.nodes[node_id].expression_type) {
+        switch (node.expression_type) {
           case plansys2_msgs::msg::Node::COMP_GE:
-            if (std::get<2>(left) >= std::get<2>(right)) {
-              return std::make_tuple(true, negate ^ true, 0);
-            } else {
-              return std::make_tuple(true, negate ^ false, 0);
-            }
-            break;
+            return std::make_tuple(true, negate ^ (std::get<2>(left) >= std::get<2>(right)), 0);
           case plansys2_msgs::msg::Node::COMP_GT:
-            if (std::get<2>(left) > std::get<2>(right)) {
-              return std::make_tuple(true, negate ^ true, 0);
-            } else {
-              return std::make_tuple(true, negate ^ false, 0);
-            }
-            break;
+            return std::make_tuple(true, negate ^ (std::get<2>(left) > std::get<2>(right)), 0);
           case plansys2_msgs::msg::Node::COMP_LE:
-            if (std::get<2>(left) <= std::get<2>(right)) {
-              return std::make_tuple(true, negate ^ true, 0);
-            } else {
-              return std::make_tuple(true, negate ^ false, 0);
-            }
-            break;
+            return std::make_tuple(true, negate ^ (std::get<2>(left) <= std::get<2>(right)), 0);
           case plansys2_msgs::msg::Node::COMP_LT:
-            if (std::get<2>(left) < std::get<2>(right)) {
-              return std::make_tuple(true, negate ^ true, 0);
-            } else {
-              return std::make_tuple(true, negate ^ false, 0);
-            }
-            break;
+            return std::make_tuple(true, negate ^ (std::get<2>(left) < std::get<2>(right)), 0);
           case plansys2_msgs::msg::Node::COMP_EQ: {
               auto c_t = plansys2_msgs::msg::Node::CONSTANT;
               auto p_t = plansys2_msgs::msg::Node::PARAMETER;
-              auto n_t = plansys2_msgs::msg::Node::NUMBER;
-              auto c0 = tree.nodes[tree.nodes[node_id].children[0]];
-              auto c1 = tree.nodes[tree.nodes[node_id].children[1]];
-              auto c0_type = c0.node_type;
-              auto c1_type = c1.node_type;
-              if ((c0_type == c_t || c0_type == p_t) && (c1_type == c_t || c1_type == p_t)) {
-                std::string c0_name = (c0_type == p_t) ? c0.parameters[0].name : c0.name;
-                std::string c1_name = (c1_type == p_t) ? c1.parameters[0].name : c1.name;
-                return std::make_tuple(
-                  true,
-                  negate ^ ( c1_name == c0_name),
-                  0);
+              uint32_t c0_id = node.children[0];
+              uint32_t c1_id = node.children[1];
+              const auto & c0 = tree.nodes[c0_id];
+              const auto & c1 = tree.nodes[c1_id];
+              if ((c0.node_type == c_t || c0.node_type == p_t) &&
+                (c1.node_type == c_t || c1.node_type == p_t))
+              {
+                const auto & c0_name =
+                  (c0.node_type == p_t) ? binding.resolve(tree, c0_id, 0) : c0.name;
+                const auto & c1_name =
+                  (c1.node_type == p_t) ? binding.resolve(tree, c1_id, 0) : c1.name;
+                return std::make_tuple(true, negate ^ (c0_name == c1_name), 0);
               }
-              if (c0_type == n_t && c1_type == n_t) {
-                return std::make_tuple(true, negate ^ std::get<2>(left) == std::get<2>(right), 0);
+              // Numbers, functions and arithmetic expressions compare by value
+              if (c0.node_type != c_t && c0.node_type != p_t &&
+                c1.node_type != c_t && c1.node_type != p_t)
+              {
+                return std::make_tuple(
+                  true, negate ^ (std::get<2>(left) == std::get<2>(right)), 0);
               }
               break;
             }
           case plansys2_msgs::msg::Node::ARITH_MULT:
             return std::make_tuple(true, false, std::get<2>(left) * std::get<2>(right));
-            break;
           case plansys2_msgs::msg::Node::ARITH_DIV:
             if (std::abs(std::get<2>(right)) > 1e-5) {
               return std::make_tuple(true, false, std::get<2>(left) / std::get<2>(right));
-            } else {
-              // Division by zero not allowed.
-              return std::make_tuple(false, false, 0);
             }
-            break;
+            // Division by zero not allowed.
+            return std::make_tuple(false, false, 0);
           case plansys2_msgs::msg::Node::ARITH_ADD:
             return std::make_tuple(true, false, std::get<2>(left) + std::get<2>(right));
-            break;
           case plansys2_msgs::msg::Node::ARITH_SUB:
             return std::make_tuple(true, false, std::get<2>(left) - std::get<2>(right));
-            break;
           default:
             break;
         }
@@ -246,147 +498,367 @@ std::tuple<bool, bool, double> evaluate(
       }
 
     case plansys2_msgs::msg::Node::FUNCTION_MODIFIER: {
-        std::tuple<bool, bool, double> left = evaluate(
-          tree, problem_client, predicates,
-          functions, apply, use_state, tree.nodes[node_id].children[0], negate);
-        std::tuple<bool, bool, double> right = evaluate(
-          tree, problem_client,
-          predicates, functions, apply, use_state, tree.nodes[node_id].children[1],
-          negate);
-
-        if (!std::get<0>(left) || !std::get<0>(right)) {
+        auto right = evaluate(tree, binding, state, false, node.children[1], negate);
+        if (!std::get<0>(right)) {
           return std::make_tuple(false, false, 0);
         }
 
-        bool success = true;
-        double value = 0;
-
-        switch (tree.nodes[node_id].modifier_type) {
-          case plansys2_msgs::msg::Node::ASSIGN:
-            value = std::get<2>(right);
-            break;
-          case plansys2_msgs::msg::Node::INCREASE:
-            value = std::get<2>(left) + std::get<2>(right);
-            break;
-          case plansys2_msgs::msg::Node::DECREASE:
-            value = std::get<2>(left) - std::get<2>(right);
-            break;
-          case plansys2_msgs::msg::Node::SCALE_UP:
-            value = std::get<2>(left) * std::get<2>(right);
-            break;
-          case plansys2_msgs::msg::Node::SCALE_DOWN:
-            // Division by zero not allowed.
-            if (std::abs(std::get<2>(right)) > 1e-5) {
-              value = std::get<2>(left) / std::get<2>(right);
-            } else {
-              success = false;
-            }
-            break;
-          default:
-            success = false;
-            break;
+        if (apply) {
+          auto modified = state.modifyFunction(
+            binding.ground(tree, node.children[0]), node.modifier_type,
+            std::get<2>(right));
+          return std::make_tuple(modified.has_value(), false, modified.value_or(0));
         }
 
-        if (success && apply) {
-          uint8_t left_id = tree.nodes[node_id].children[0];
-          if (use_state) {
-            auto it =
-              std::find_if(
-              functions.begin(), functions.end(),
-              std::bind(
-                &parser::pddl::checkNodeEquality, std::placeholders::_1,
-                tree.nodes[left_id]));
-            if (it != functions.end()) {
-              it->value = value;
-            } else {
-              success = false;
-            }
-          } else {
-            std::stringstream ss;
-            ss << "(= " << parser::pddl::toString(tree, left_id) << " " << value << ")";
-            problem_client->updateFunction(parser::pddl::fromStringFunction(ss.str()));
-          }
+        auto left = evaluate(tree, binding, state, false, node.children[0], negate);
+        if (!std::get<0>(left)) {
+          return std::make_tuple(false, false, 0);
         }
 
-        return std::make_tuple(success, false, value);
+        auto modified = modify_value(node.modifier_type, std::get<2>(left), std::get<2>(right));
+        return std::make_tuple(modified.has_value(), false, modified.value_or(0));
       }
 
     case plansys2_msgs::msg::Node::NUMBER: {
-        return std::make_tuple(true, true, tree.nodes[node_id].value);
+        return std::make_tuple(true, true, node.value);
       }
 
     case plansys2_msgs::msg::Node::CONSTANT: {
-        if (tree.nodes[node_id].name.size() > 0) {
-          return std::make_tuple(true, true, 0);
-        }
-        return std::make_tuple(true, false, 0);
+        return std::make_tuple(true, node.name.size() > 0, 0);
       }
 
     case plansys2_msgs::msg::Node::PARAMETER: {
-        if (tree.nodes[node_id].parameters.size() > 0 &&
-          tree.nodes[node_id].parameters[0].name.front() != '?')
-        {
-          return std::make_tuple(true, true, 0);
-        }
+        bool bound = node.parameters.size() > 0 &&
+          binding.resolve(tree, node_id, 0).front() != '?';
+        return std::make_tuple(true, bound, 0);
       }
 
     case plansys2_msgs::msg::Node::EXISTS: {
-        std::vector<plansys2::Instance> instances;
-        if (use_state == false) {
-          instances = problem_client->getInstances();
-        } else {
-          for (auto predicate : predicates) {
-            std::for_each(
-              predicate.parameters.begin(), predicate.parameters.end(),
-              [&](auto p) {
-                if (std::find(instances.begin(), instances.end(), p) == instances.end()) {
-                  instances.push_back(p);
-                }
-              });
-          }
+        auto result = state.evaluateExists(tree, node_id, binding);
+        return std::make_tuple(std::get<0>(result), negate ^ std::get<1>(result), 0);
+      }
+
+    default:
+      std::cerr << "evaluate: Error parsing expresion [" <<
+        parser::pddl::toString(tree, node_id) << "]" << std::endl;
+  }
+
+  return std::make_tuple(false, false, 0);
+}
+
+namespace
+{
+
+struct ExistsLiteral
+{
+  uint32_t node_id;
+  std::vector<int> args;  // quantified variable of each argument, -1 if it is not quantified
+  std::vector<ObjectTable::Id> objects;  // object of each argument that is not quantified
+};
+
+struct ExistsSearch
+{
+  std::vector<std::vector<std::string>> allowed_types;
+  std::unordered_map<ObjectTable::Id, std::string> object_types;
+  std::unordered_map<std::string, std::vector<std::vector<ObjectTable::Id>>> facts;
+  std::vector<ExistsLiteral> literals;
+
+  // The quantified variables are bound in the caller binding, from offset on
+  ParameterBinding * binding;
+  size_t offset;
+  size_t n_vars;
+
+  std::vector<std::vector<ObjectTable::Id>> domains;
+  std::vector<bool> domain_ready;
+  const std::vector<plansys2::Instance> * instances;
+  const std::vector<plansys2::Predicate> * predicates;
+
+  const plansys2_msgs::msg::Tree * tree;
+  uint32_t body_id;
+  EvaluationState * state;
+
+  ObjectTable::Id & value(int var) {return binding->ids[offset + var];}
+};
+
+bool fits_type(const ExistsSearch & search, int var, ObjectTable::Id object)
+{
+  const auto & allowed = search.allowed_types[var];
+  if (allowed.empty()) {
+    return true;
+  }
+
+  auto it = search.object_types.find(object);
+  if (it == search.object_types.end() || it->second.empty()) {
+    // Objects with no known type (e.g. when evaluating a bare state) are not filtered out
+    return true;
+  }
+  return std::find(allowed.begin(), allowed.end(), it->second) != allowed.end();
+}
+
+const std::vector<ObjectTable::Id> & get_domain(ExistsSearch & search, int var)
+{
+  if (!search.domain_ready[var]) {
+    auto & objects = *search.binding->objects;
+    auto & domain = search.domains[var];
+    if (!search.instances->empty()) {
+      for (const auto & instance : *search.instances) {
+        auto object = objects.id(instance.name);
+        if (fits_type(search, var, object)) {
+          domain.push_back(object);
         }
-        std::vector<std::vector<std::string>> parameters_vector;
-        for (size_t i = 0; i < tree.nodes[node_id].parameters.size(); i++) {
-          std::vector<std::string> p_vector;
-          std::for_each(
-            instances.begin(), instances.end(),
-            [&](auto i) {p_vector.push_back(i.name);});
-          parameters_vector.push_back(p_vector);
+      }
+    } else {
+      std::set<std::string> names;
+      for (const auto & predicate : *search.predicates) {
+        for (const auto & param : predicate.parameters) {
+          names.insert(param.name);
         }
+      }
+      for (const auto & name : names) {
+        domain.push_back(objects.id(name));
+      }
+    }
+    search.domain_ready[var] = true;
+  }
+  return search.domains[var];
+}
+
+bool bind_free_variables(ExistsSearch & search, size_t var)
+{
+  while (var < search.n_vars && search.value(var) != ParameterBinding::UNBOUND) {
+    var++;
+  }
+  if (var == search.n_vars) {
+    return std::get<1>(
+      evaluate(*search.tree, *search.binding, *search.state, false, search.body_id));
+  }
 
-        std::vector<std::vector<std::string>> possible_parameters_values;
-        std::vector<std::string> aux;
-        plansys2::cart_product(
-          possible_parameters_values, aux, parameters_vector.begin(), parameters_vector.end());
+  for (auto object : get_domain(search, var)) {
+    search.value(var) = object;
+    if (bind_free_variables(search, var + 1)) {
+      return true;
+    }
+  }
+  search.value(var) = ParameterBinding::UNBOUND;
+  return false;
+}
 
-        for (auto parameters_values : possible_parameters_values) {
-          std::map<std::string, std::string> replace;
-          for (size_t i = 0; i < tree.nodes[node_id].parameters.size(); i++) {
-            replace[tree.nodes[node_id].parameters[i].name] = parameters_values[i];
-          }
-          auto tree_replaced = plansys2::replace_children_param(tree, node_id, replace);
-          std::tuple<bool, bool, double> result = evaluate(
-            tree_replaced,
-            problem_client,
-            predicates,
-            functions,
-            apply,
-            use_state,
-            tree_replaced.nodes[node_id].children[0],
-            negate);
-          if (std::get<1>(result)) {
-            return result;
-          }
+bool join_literals(ExistsSearch & search, size_t literal_id)
+{
+  if (literal_id == search.literals.size()) {
+    return bind_free_variables(search, 0);
+  }
+
+  const auto & literal = search.literals[literal_id];
+  auto facts_it = search.facts.find(search.tree->nodes[literal.node_id].name);
+  if (facts_it == search.facts.end()) {
+    return false;
+  }
+
+  std::vector<int> bound;
+  for (const auto & fact : facts_it->second) {
+    if (fact.size() != literal.args.size()) {
+      continue;
+    }
+
+    bool match = true;
+    for (size_t i = 0; match && i < literal.args.size(); i++) {
+      int var = literal.args[i];
+      if (var < 0) {
+        match = literal.objects[i] == fact[i];
+      } else if (search.value(var) != ParameterBinding::UNBOUND) {
+        match = search.value(var) == fact[i];
+      } else if (fits_type(search, var, fact[i])) {
+        search.value(var) = fact[i];
+        bound.push_back(var);
+      } else {
+        match = false;
+      }
+    }
+
+    if (match && join_literals(search, literal_id + 1)) {
+      return true;
+    }
+
+    for (auto var : bound) {
+      search.value(var) = ParameterBinding::UNBOUND;
+    }
+    bound.clear();
+  }
+  return false;
+}
+
+}  // namespace
+
+std::tuple<bool, bool, double> evaluate_exists(
+  const plansys2_msgs::msg::Tree & tree,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id,
+  ParameterBinding & binding)
+{
+  if (node_id >= tree.nodes.size() || tree.nodes[node_id].children.empty()) {
+    return std::make_tuple(false, false, 0);
+  }
+
+  if (binding.lifted == nullptr) {
+    // The parameters of a ground expression are objects, only the quantified ones need
+    // to be resolved to variables
+    LiftedTree lifted(tree);
+    ObjectTable objects;
+    ParameterBinding lifted_binding(lifted, objects);
+    return evaluate_exists(tree, instances, predicates, functions, node_id, lifted_binding);
+  }
+
+  const auto & vars = tree.nodes[node_id].parameters;
+  auto & objects = *binding.objects;
+  VectorState state(predicates, functions, instances);
+
+  ExistsSearch search;
+  search.instances = &instances;
+  search.predicates = &predicates;
+  search.tree = &tree;
+  search.body_id = tree.nodes[node_id].children[0];
+  search.state = &state;
+  search.binding = &binding;
+  search.offset = binding.lifted->scope[node_id];
+  search.n_vars = vars.size();
+  search.domains.resize(vars.size());
+  search.domain_ready.resize(vars.size(), false);
+
+  for (const auto & var : vars) {
+    std::vector<std::string> allowed;
+    if (!var.type.empty()) {
+      allowed.push_back(var.type);
+      allowed.insert(allowed.end(), var.sub_types.begin(), var.sub_types.end());
+    }
+    search.allowed_types.push_back(allowed);
+  }
+  for (const auto & instance : instances) {
+    search.object_types[objects.id(instance.name)] = instance.type;
+  }
+
+  // Positive literals that any witness has to satisfy: those reachable from the body
+  // only through AND nodes
+  std::vector<uint32_t> conjuncts = {search.body_id};
+  while (!conjuncts.empty()) {
+    uint32_t conjunct_id = conjuncts.back();
+    const auto & node = tree.nodes[conjunct_id];
+    conjuncts.pop_back();
+
+    if (node.node_type == plansys2_msgs::msg::Node::AND) {
+      conjuncts.insert(conjuncts.end(), node.children.begin(), node.children.end());
+    } else if (node.node_type == plansys2_msgs::msg::Node::PREDICATE) {
+      ExistsLiteral literal;
+      literal.node_id = conjunct_id;
+      for (size_t i = 0; i < node.parameters.size(); i++) {
+        int var = binding.lifted->args[conjunct_id][i];
+        if (var >= static_cast<int>(search.offset)) {
+          literal.args.push_back(var - search.offset);
+          literal.objects.push_back(ParameterBinding::UNBOUND);
+        } else {
+          literal.args.push_back(-1);
+          literal.objects.push_back(objects.id(binding.resolve(tree, conjunct_id, i)));
         }
-        return std::make_tuple(true, false, 0);
       }
+      search.literals.push_back(literal);
+      search.facts[node.name];
+    }
+  }
 
-    default:
-      std::cerr << "evaluate: Error parsing expresion [" <<
-        parser::pddl::toString(tree, node_id) << "]" << std::endl;
+  for (const auto & predicate : predicates) {
+    auto it = search.facts.find(predicate.name);
+    if (it != search.facts.end()) {
+      std::vector<ObjectTable::Id> fact;
+      for (const auto & param : predicate.parameters) {
+        fact.push_back(objects.id(param.name));
+      }
+      it->second.push_back(fact);
+    }
   }
 
-  return std::make_tuple(false, false, 0);
+  // Join order: prefer literals with arguments already fixed by a constant or by a previous
+  // literal, and among them the ones with fewer matching facts.
+  std::vector<ExistsLiteral> ordered;
+  std::vector<bool> fixed(vars.size(), false);
+  while (!search.literals.empty()) {
+    auto best = search.literals.end();
+    bool best_fixed = false;
+    size_t best_size = 0;
+    for (auto it = search.literals.begin(); it != search.literals.end(); ++it) {
+      bool has_fixed = std::any_of(
+        it->args.begin(), it->args.end(), [&](int var) {return var < 0 || fixed[var];});
+      size_t size = search.facts[tree.nodes[it->node_id].name].size();
+      if (best == search.literals.end() || (has_fixed && !best_fixed) ||
+        (has_fixed == best_fixed && size < best_size))
+      {
+        best = it;
+        best_fixed = has_fixed;
+        best_size = size;
+      }
+    }
+    for (auto var : best->args) {
+      if (var >= 0) {
+        fixed[var] = true;
+      }
+    }
+    ordered.push_back(*best);
+    search.literals.erase(best);
+  }
+  search.literals = ordered;
+
+  bool found = join_literals(search, 0);
+
+  // The search stops at the first witness, still bound
+  for (size_t var = 0; var < search.n_vars; var++) {
+    search.value(var) = ParameterBinding::UNBOUND;
+  }
+
+  return std::make_tuple(true, found, 0);
+}
+
+std::tuple<bool, bool, double> evaluate_exists(
+  const plansys2_msgs::msg::Tree & tree,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id)
+{
+  ParameterBinding binding;
+  return evaluate_exists(tree, instances, predicates, functions, node_id, binding);
+}
+
+std::tuple<bool, bool, double> evaluate(
+  const plansys2_msgs::msg::Tree & tree,
+  ParameterBinding & binding,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id,
+  bool negate)
+{
+  VectorState state(predicates, functions);
+  return evaluate(tree, binding, state, false, node_id, negate);
+}
+
+std::tuple<bool, bool, double> evaluate(
+  const plansys2_msgs::msg::Tree & tree,
+  std::shared_ptr<plansys2::ProblemExpertClient> problem_client,
+  std::vector<plansys2::Predicate> & predicates,
+  std::vector<plansys2::Function> & functions,
+  bool apply,
+  bool use_state,
+  uint8_t node_id,
+  bool negate)
+{
+  ParameterBinding binding;
+  if (use_state) {
+    VectorState state(predicates, functions);
+    return evaluate(tree, binding, state, apply, node_id, negate);
+  }
+
+  ClientState state(problem_client);
+  return evaluate(tree, binding, state, apply, node_id, negate);
 }
 
 std::tuple<bool, bool, double> evaluate(
@@ -432,14 +904,58 @@ bool check(
   return std::get<1>(ret);
 }
 
+bool check(
+  const plansys2_msgs::msg::Tree & tree,
+  ParameterBinding & binding,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  uint32_t node_id)
+{
+  std::tuple<bool, bool, double> ret = evaluate(tree, binding, predicates, functions, node_id);
+
+  return std::get<1>(ret);
+}
+
 bool apply(
   const plansys2_msgs::msg::Tree & tree,
   std::shared_ptr<plansys2::ProblemExpertClient> problem_client,
   uint32_t node_id)
 {
-  std::tuple<bool, bool, double> ret = evaluate(tree, problem_client, true, node_id);
+  if (tree.nodes.empty() || tree.nodes[node_id].node_type != plansys2_msgs::msg::Node::AND) {
+    std::tuple<bool, bool, double> ret = evaluate(tree, problem_client, true, node_id);
+    return std::get<0>(ret);
+  }
 
-  return std::get<0>(ret);
+  // The numeric effects of a conjunction are sent as a single batch. Their operands are
+  // evaluated before any effect is applied, so all of them see the same state.
+  std::vector<plansys2::Function> modifiers;
+  std::vector<uint32_t> others;
+  bool success = true;
+
+  for (auto child_id : tree.nodes[node_id].children) {
+    if (tree.nodes[child_id].node_type == plansys2_msgs::msg::Node::FUNCTION_MODIFIER) {
+      std::tuple<bool, bool, double> operand =
+        evaluate(tree, problem_client, false, tree.nodes[child_id].children[1]);
+      if (std::get<0>(operand)) {
+        modifiers.push_back(make_modifier(tree, child_id, std::get<2>(operand)));
+      } else {
+        success = false;
+      }
+    } else {
+      others.push_back(child_id);
+    }
+  }
+
+  for (auto child_id : others) {
+    std::tuple<bool, bool, double> ret = evaluate(tree, problem_client, true, child_id);
+    success = success && std::get<0>(ret);
+  }
+
+  if (!modifiers.empty()) {
+    success = problem_client->modifyFunctions(modifiers).has_value() && success;
+  }
+
+  return success;
 }
 
 bool apply(
@@ -453,6 +969,103 @@ bool apply(
   return std::get<0>(ret);
 }
 
+std::vector<plansys2::Predicate> infer_derived_predicates(
+  const std::vector<plansys2_msgs::msg::Derived> & derived_predicates,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions)
+{
+  std::vector<plansys2::Predicate> ret;
+
+  plansys2::ObjectTable objects;
+
+  for (const auto & d : derived_predicates) {
+    size_t n_params = d.predicate.parameters.size();
+
+    std::vector<std::vector<plansys2::ObjectTable::Id>> parameters_vector(n_params);
+    for (size_t i = 0; i < n_params; i++) {
+      for (const auto & instance : instances) {
+        if (d.predicate.parameters[i].type == instance.type) {
+          parameters_vector[i].push_back(objects.id(instance.name));
+        }
+      }
+    }
+    if (std::any_of(
+        parameters_vector.begin(), parameters_vector.end(),
+        [](const auto & values) {return values.empty();}))
+    {
+      continue;
+    }
+
+    // The preconditions are evaluated lifted, binding ?i to each combination in turn
+    std::vector<std::string> variables;
+    for (size_t i = 0; i < n_params; i++) {
+      variables.push_back("?" + std::to_string(i));
+    }
+    plansys2::LiftedTree lifted(d.preconditions, variables);
+    plansys2::ParameterBinding binding(lifted, objects);
+
+    std::vector<size_t> value_ids(n_params, 0);
+    bool done = false;
+    while (!done) {
+      for (size_t i = 0; i < n_params; i++) {
+        binding.ids[i] = parameters_vector[i][value_ids[i]];
+      }
+
+      if (check(d.preconditions, binding, predicates, functions)) {
+        plansys2::Predicate inferred_predicate;
+        inferred_predicate.node_type = plansys2_msgs::msg::Node::PREDICATE;
+        inferred_predicate.name = d.predicate.name;
+        for (size_t i = 0; i < n_params; i++) {
+          plansys2_msgs::msg::Param param;
+          param.name = objects.name(binding.ids[i]);
+          inferred_predicate.parameters.push_back(param);
+        }
+        ret.push_back(inferred_predicate);
+      }
+
+      size_t i = 0;
+      while (i < n_params && ++value_ids[i] == parameters_vector[i].size()) {
+        value_ids[i] = 0;
+        i++;
+      }
+      done = i == n_params;
+    }
+  }
+  return ret;
+}
+
+bool check_derived_predicate(
+  const std::vector<plansys2_msgs::msg::Derived> & derived_predicates,
+  const plansys2::Predicate & predicate,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions)
+{
+  plansys2::ObjectTable objects;
+  std::vector<std::string> variables;
+  for (size_t i = 0; i < predicate.parameters.size(); i++) {
+    variables.push_back("?" + std::to_string(i));
+    objects.id(predicate.parameters[i].name);
+  }
+
+  for (const auto & derived : derived_predicates) {
+    if (derived.predicate.parameters.size() != predicate.parameters.size()) {
+      continue;
+    }
+
+    plansys2::LiftedTree lifted(derived.preconditions, variables);
+    plansys2::ParameterBinding binding(lifted, objects);
+    for (size_t i = 0; i < predicate.parameters.size(); i++) {
+      binding.ids[i] = objects.id(predicate.parameters[i].name);
+    }
+    if (check(derived.preconditions, binding, predicates, functions)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 std::pair<std::string, int> parse_action(const std::string & input)
 {
   std::string action = parser::pddl::getReducedString(input);
@@ -552,4 +1165,60 @@ void cart_product(
   }
 }
 
+std::string write_problem(
+  const std::string & domain_str,
+  const std::vector<plansys2::Instance> & instances,
+  const std::vector<plansys2::Predicate> & predicates,
+  const std::vector<plansys2::Function> & functions,
+  const plansys2::Goal & goal)
+{
+  parser::pddl::Domain domain(domain_str);
+  parser::pddl::Instance problem(domain);
+
+  problem.name = "problem_1";
+
+  for (const auto & instance : instances) {
+    bool is_constant = domain.getType(instance.type)->parseConstant(instance.name).first;
+    if (is_constant) {
+      std::cout << "Skipping adding constant to problem :object: " << instance.name << " " <<
+        instance.type << std::endl;
+    } else {
+      problem.addObject(instance.name, instance.type);
+    }
+  }
+
+  for (plansys2_msgs::msg::Node predicate : predicates) {
+    StringVec v;
+
+    for (size_t i = 0; i < predicate.parameters.size(); i++) {
+      v.push_back(predicate.parameters[i].name);
+    }
+
+    std::transform(predicate.name.begin(), predicate.name.end(), predicate.name.begin(), ::tolower);
+
+    problem.addInit(predicate.name, v);
+  }
+
+  for (plansys2_msgs::msg::Node function : functions) {
+    StringVec v;
+
+    for (size_t i = 0; i < function.parameters.size(); i++) {
+      v.push_back(function.parameters[i].name);
+    }
+
+    std::transform(
+      function.name.begin(), function.name.end(),
+      function.name.begin(), ::tolower);
+
+    problem.addInit(function.name, function.value, v);
+  }
+
+  const std::string gs = parser::pddl::toString(goal);
+  problem.addGoal(gs);
+
+  std::ostringstream stream;
+  stream << problem;
+  return stream.str();
+}
+
 }  // namespace plansys2
@@ -12,9 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <string>
 #include <vector>
 #include <memory>
+#include <thread>
 
 #include "ament_index_cpp/get_package_share_directory.hpp"
 
@@ -31,6 +35,7 @@
 #include "plansys2_problem_expert/ProblemExpertClient.hpp"
 
 #include "plansys2_msgs/msg/knowledge.hpp"
+#include "plansys2_msgs/srv/expert_call.hpp"
 
 TEST(problem_expert_node, addget_instances)
 {
@@ -692,6 +697,319 @@ TEST(problem_expert_node, addget_goal_is_satisfied)
   t.join();
 }
 
+TEST(problem_expert_node, sharded_get_problem)
+{
+  auto test_node = rclcpp::Node::make_shared("test_problem_expert_node");
+  auto domain_node = std::make_shared<plansys2::DomainExpertNode>();
+
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  domain_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple.pddl"});
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(domain_node->get_node_base_interface());
+
+  const std::vector<std::string> shard_namespaces = {"shard_0", "shard_1", "shard_2"};
+  std::vector<std::shared_ptr<plansys2::ProblemExpertNode>> shard_nodes;
+  for (size_t i = 0; i < shard_namespaces.size(); i++) {
+    auto shard_node = std::make_shared<plansys2::ProblemExpertNode>(shard_namespaces[i]);
+    shard_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple.pddl"});
+    shard_node->set_parameter({"shard_id", static_cast<int>(i)});
+    shard_node->set_parameter({"num_shards", static_cast<int>(shard_namespaces.size())});
+    shard_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+    shard_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+    exe.add_node(shard_node->get_node_base_interface());
+    shard_nodes.push_back(shard_node);
+  }
+
+  auto problem_client = std::make_shared<plansys2::ProblemExpertClient>(shard_namespaces);
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("leia", "robot")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("jack", "person")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("bedroom", "room")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("kitchen", "room")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("m1", "message")));
+
+  ASSERT_TRUE(problem_client->addPredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+  ASSERT_TRUE(problem_client->addPredicate(plansys2::Predicate("(person_at jack bedroom)")));
+  ASSERT_TRUE(
+    problem_client->addPredicate(plansys2::Predicate("(robot_near_person leia jack)")));
+  ASSERT_TRUE(
+    problem_client->addFunction(plansys2::Function("(= (room_distance kitchen bedroom) 10)")));
+  ASSERT_TRUE(problem_client->setGoal(plansys2::Goal("(and (robot_talk leia m1 jack))")));
+
+  // Each fact is only kept by its shard
+  size_t num_predicates = 0;
+  for (const auto & shard_namespace : shard_namespaces) {
+    num_predicates += plansys2::ProblemExpertClient(shard_namespace).getPredicates().size();
+  }
+  ASSERT_EQ(num_predicates, 3u);
+
+  // The predicates, functions, instances and goal are gathered from all the shards at once
+  for (int i = 0; i < 5; i++) {
+    auto problem = problem_client->getProblem();
+    ASSERT_NE(problem.find("( robot_at leia kitchen )"), std::string::npos) << problem;
+    ASSERT_NE(problem.find("( person_at jack bedroom )"), std::string::npos) << problem;
+    ASSERT_NE(problem.find("( robot_near_person leia jack )"), std::string::npos) << problem;
+    ASSERT_NE(problem.find("room_distance kitchen bedroom"), std::string::npos) << problem;
+    ASSERT_NE(problem.find("leia - robot"), std::string::npos) << problem;
+    ASSERT_NE(problem.find("( robot_talk leia m1 jack )"), std::string::npos) << problem;
+  }
+
+  // A batch of modifiers is atomic in the shard owning its functions
+  plansys2::Function modifier =
+    parser::pddl::fromStringFunction("(= (room_distance kitchen bedroom) 5)");
+  modifier.modifier_type = plansys2_msgs::msg::Node::INCREASE;
+  auto modified = problem_client->modifyFunctions({modifier, modifier});
+  ASSERT_TRUE(modified);
+  ASSERT_EQ(modified.value().size(), 2u);
+  ASSERT_NEAR(
+    problem_client->getFunction("(room_distance kitchen bedroom)").value().value, 20, 1e-6);
+
+  finish = true;
+  t.join();
+}
+
+TEST(problem_expert_node, sharded_derived_predicates)
+{
+  auto test_node = rclcpp::Node::make_shared("test_problem_expert_node");
+  auto domain_node = std::make_shared<plansys2::DomainExpertNode>();
+
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  domain_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple_derived.pddl"});
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(domain_node->get_node_base_interface());
+
+  const std::vector<std::string> shard_namespaces = {"shard_0", "shard_1", "shard_2"};
+  std::vector<std::shared_ptr<plansys2::ProblemExpertNode>> shard_nodes;
+  for (size_t i = 0; i < shard_namespaces.size(); i++) {
+    auto shard_node = std::make_shared<plansys2::ProblemExpertNode>(shard_namespaces[i]);
+    shard_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple_derived.pddl"});
+    shard_node->set_parameter({"shard_id", static_cast<int>(i)});
+    shard_node->set_parameter({"num_shards", static_cast<int>(shard_namespaces.size())});
+    shard_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+    shard_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+    exe.add_node(shard_node->get_node_base_interface());
+    shard_nodes.push_back(shard_node);
+  }
+
+  auto problem_client = std::make_shared<plansys2::ProblemExpertClient>(shard_namespaces);
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("leia", "robot")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("jack", "person")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("bedroom", "room")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("kitchen", "room")));
+
+  ASSERT_TRUE(problem_client->addPredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+  ASSERT_TRUE(problem_client->addPredicate(plansys2::Predicate("(person_at jack bedroom)")));
+
+  // The shards keep only their facts, the derived ones are inferred by the client
+  size_t num_predicates = 0;
+  for (const auto & shard_namespace : shard_namespaces) {
+    num_predicates += plansys2::ProblemExpertClient(shard_namespace).getPredicates().size();
+  }
+  ASSERT_EQ(num_predicates, 2u);
+
+  ASSERT_TRUE(
+    problem_client->existPredicate(plansys2::Predicate("(inferred-robot_at leia kitchen)")));
+  ASSERT_TRUE(
+    problem_client->existPredicate(plansys2::Predicate("(inferred-person_at jack bedroom)")));
+  ASSERT_FALSE(
+    problem_client->existPredicate(plansys2::Predicate("(inferred-robot_at leia bedroom)")));
+
+  auto predicates = problem_client->getPredicates();
+  ASSERT_EQ(predicates.size(), 4u);
+  ASSERT_EQ(
+    std::count_if(
+      predicates.begin(), predicates.end(),
+      [](const plansys2::Predicate & predicate) {
+        return parser::pddl::toString(predicate) == "(inferred-robot_at leia kitchen)";
+      }), 1);
+
+  ASSERT_TRUE(
+    problem_client->isGoalSatisfied(plansys2::Goal("(and (inferred-robot_at leia kitchen))")));
+  ASSERT_FALSE(
+    problem_client->isGoalSatisfied(plansys2::Goal("(and (inferred-robot_at leia bedroom))")));
+
+  ASSERT_TRUE(problem_client->removePredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+  ASSERT_FALSE(
+    problem_client->existPredicate(plansys2::Predicate("(inferred-robot_at leia kitchen)")));
+  ASSERT_EQ(problem_client->getPredicates().size(), 2u);
+
+  finish = true;
+  t.join();
+}
+
+TEST(problem_expert_node, sharded_modify_functions)
+{
+  auto test_node = rclcpp::Node::make_shared("test_problem_expert_node");
+  auto domain_node = std::make_shared<plansys2::DomainExpertNode>();
+
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  domain_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple.pddl"});
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(domain_node->get_node_base_interface());
+
+  const std::vector<std::string> shard_namespaces = {"shard_0", "shard_1", "shard_2"};
+  std::vector<std::shared_ptr<plansys2::ProblemExpertNode>> shard_nodes;
+  for (size_t i = 0; i < shard_namespaces.size(); i++) {
+    auto shard_node = std::make_shared<plansys2::ProblemExpertNode>(shard_namespaces[i]);
+    shard_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple.pddl"});
+    shard_node->set_parameter({"shard_id", static_cast<int>(i)});
+    shard_node->set_parameter({"num_shards", static_cast<int>(shard_namespaces.size())});
+    shard_node->set_parameter({"sharding_policy", "object"});
+    shard_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+    shard_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+    exe.add_node(shard_node->get_node_base_interface());
+    shard_nodes.push_back(shard_node);
+  }
+
+  auto problem_client = std::make_shared<plansys2::ProblemExpertClient>(
+    shard_namespaces, plansys2::ShardingPolicy::BY_OBJECT);
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("bedroom", "room")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("kitchen", "room")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("bathroom", "room")));
+
+  plansys2::Function kitchen_bedroom =
+    parser::pddl::fromStringFunction("(= (room_distance kitchen bedroom) 10)");
+  plansys2::Function bathroom_kitchen =
+    parser::pddl::fromStringFunction("(= (room_distance bathroom kitchen) 4)");
+  ASSERT_NE(
+    plansys2::get_shard(kitchen_bedroom, 3, plansys2::ShardingPolicy::BY_OBJECT),
+    plansys2::get_shard(bathroom_kitchen, 3, plansys2::ShardingPolicy::BY_OBJECT));
+  ASSERT_TRUE(problem_client->addFunction(kitchen_bedroom));
+  ASSERT_TRUE(problem_client->addFunction(bathroom_kitchen));
+
+  // A batch spanning several shards is split by owner, keeping the order of the modifiers
+  kitchen_bedroom.modifier_type = plansys2_msgs::msg::Node::INCREASE;
+  kitchen_bedroom.value = 5;
+  bathroom_kitchen.modifier_type = plansys2_msgs::msg::Node::INCREASE;
+  bathroom_kitchen.value = 5;
+  auto modified = problem_client->modifyFunctions({kitchen_bedroom, bathroom_kitchen});
+  ASSERT_TRUE(modified);
+  ASSERT_EQ(modified.value().size(), 2u);
+  ASSERT_NEAR(modified.value()[0].value, 15, 1e-6);
+  ASSERT_NEAR(modified.value()[1].value, 9, 1e-6);
+  ASSERT_NEAR(
+    problem_client->getFunction("(room_distance kitchen bedroom)").value().value, 15, 1e-6);
+  ASSERT_NEAR(
+    problem_client->getFunction("(room_distance bathroom kitchen)").value().value, 9, 1e-6);
+
+  finish = true;
+  t.join();
+}
+
+TEST(problem_expert_node, knowledge_contexts)
+{
+  auto test_node = rclcpp::Node::make_shared("test_problem_expert_node");
+  auto domain_node = std::make_shared<plansys2::DomainExpertNode>();
+  auto problem_node = std::make_shared<plansys2::ProblemExpertNode>();
+
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  domain_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple.pddl"});
+  problem_node->set_parameter({"model_file", pkgpath + "/pddl/domain_simple.pddl"});
+
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+  problem_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+  domain_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+  problem_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_ACTIVATE);
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+  exe.add_node(test_node);
+  exe.add_node(domain_node->get_node_base_interface());
+  exe.add_node(problem_node->get_node_base_interface());
+
+  bool finish = false;
+  std::thread t([&]() {
+      while (!finish) {exe.spin_some();}
+    });
+
+  auto problem_client = std::make_shared<plansys2::ProblemExpertClient>();
+  auto context_client = std::make_shared<plansys2::ProblemExpertClient>();
+
+  // Create, list and remove
+  ASSERT_TRUE(problem_client->getContexts().empty());
+  ASSERT_TRUE(problem_client->createContext("what_if"));
+  ASSERT_FALSE(problem_client->createContext("what_if"));
+  ASSERT_FALSE(problem_client->createContext("1what_if"));
+  ASSERT_FALSE(problem_client->createContext("what-if"));
+  ASSERT_EQ(problem_client->getContexts(), std::vector<std::string>({"what_if"}));
+
+  // Each context has its own knowledge
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("leia", "robot")));
+  ASSERT_TRUE(problem_client->addInstance(plansys2::Instance("kitchen", "room")));
+  ASSERT_TRUE(problem_client->addPredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+
+  context_client->setContext("what_if");
+  ASSERT_TRUE(context_client->getInstances().empty());
+  ASSERT_TRUE(context_client->addInstance(plansys2::Instance("leia", "robot")));
+  ASSERT_TRUE(context_client->addInstance(plansys2::Instance("bedroom", "room")));
+  ASSERT_TRUE(context_client->addPredicate(plansys2::Predicate("(robot_at leia bedroom)")));
+
+  ASSERT_EQ(problem_client->getInstances().size(), 2u);
+  ASSERT_EQ(problem_client->getPredicates().size(), 1u);
+  ASSERT_TRUE(problem_client->existPredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+  ASSERT_FALSE(problem_client->existPredicate(plansys2::Predicate("(robot_at leia bedroom)")));
+
+  ASSERT_EQ(context_client->getInstances().size(), 2u);
+  ASSERT_EQ(context_client->getPredicates().size(), 1u);
+  ASSERT_TRUE(context_client->existPredicate(plansys2::Predicate("(robot_at leia bedroom)")));
+  ASSERT_FALSE(context_client->existPredicate(plansys2::Predicate("(robot_at leia kitchen)")));
+
+  // Requests to a context that does not exist fail
+  auto call_client = test_node->create_client<plansys2_msgs::srv::ExpertCall>(
+    "problem_expert/call");
+  ASSERT_TRUE(call_client->wait_for_service(std::chrono::seconds(1)));
+
+  auto call = std::make_shared<plansys2_msgs::srv::ExpertCall::Request>();
+  call->operation = "get_problem_instances";
+  call->context = "missing";
+  auto future_result = call_client->async_send_request(call);
+  ASSERT_EQ(future_result.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  auto result = future_result.get();
+  ASSERT_FALSE(result->success);
+  ASSERT_EQ(result->error_info, "Unknown context missing");
+
+  ASSERT_TRUE(problem_client->removeContext("what_if"));
+  ASSERT_FALSE(problem_client->removeContext("what_if"));
+  ASSERT_TRUE(problem_client->getContexts().empty());
+  ASSERT_FALSE(context_client->addInstance(plansys2::Instance("jack", "person")));
+
+  call->context = "what_if";
+  future_result = call_client->async_send_request(call);
+  ASSERT_EQ(future_result.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  ASSERT_EQ(future_result.get()->error_info, "Unknown context what_if");
+
+  // The default context is kept
+  ASSERT_EQ(problem_client->getPredicates().size(), 1u);
+
+  finish = true;
+  t.join();
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
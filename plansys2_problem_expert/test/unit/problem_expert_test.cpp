@@ -24,7 +24,11 @@
 #include "plansys2_msgs/msg/param.hpp"
 #include "plansys2_msgs/msg/tree.hpp"
 
+#include "plansys2_problem_expert/ForkableState.hpp"
+#include "plansys2_problem_expert/PredicateIndex.hpp"
 #include "plansys2_problem_expert/ProblemExpert.hpp"
+#include "plansys2_problem_expert/StateFingerprint.hpp"
+#include "plansys2_problem_expert/UpdateCoalescer.hpp"
 #include "plansys2_domain_expert/DomainExpert.hpp"
 
 TEST(problem_expert, addget_instances)
@@ -403,6 +407,599 @@ TEST(problem_expert, addget_functions)
   ASSERT_EQ(functions.size(), 1);
 }
 
+TEST(problem_expert, modify_functions)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_charging.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("r2d2", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp1", "waypoint")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp2", "waypoint")));
+  ASSERT_TRUE(problem_expert.addFunction(parser::pddl::fromStringFunction("(= (speed r2d2) 3)")));
+  ASSERT_TRUE(
+    problem_expert.addFunction(parser::pddl::fromStringFunction("(= (distance wp1 wp2) 15)")));
+
+  plansys2::Function increase_speed = parser::pddl::fromStringFunction("(= (speed r2d2) 2)");
+  increase_speed.modifier_type = plansys2_msgs::msg::Node::INCREASE;
+
+  auto speed = problem_expert.modifyFunction(increase_speed);
+  ASSERT_TRUE(speed);
+  ASSERT_EQ(speed.value().name, "speed");
+  ASSERT_NEAR(speed.value().value, 5, 1e-6);
+  ASSERT_NEAR(problem_expert.getFunction("(speed r2d2)").value().value, 5, 1e-6);
+
+  plansys2::Function scale_speed = parser::pddl::fromStringFunction("(= (speed r2d2) 2)");
+  scale_speed.modifier_type = plansys2_msgs::msg::Node::SCALE_UP;
+  plansys2::Function decrease_distance =
+    parser::pddl::fromStringFunction("(= (distance wp1 wp2) 5)");
+  decrease_distance.modifier_type = plansys2_msgs::msg::Node::DECREASE;
+
+  auto batch = problem_expert.modifyFunctions({scale_speed, decrease_distance, increase_speed});
+  ASSERT_TRUE(batch);
+  ASSERT_EQ(batch.value().size(), 3);
+  ASSERT_NEAR(batch.value()[1].value, 10, 1e-6);
+  ASSERT_NEAR(batch.value()[2].value, 12, 1e-6);
+  ASSERT_NEAR(problem_expert.getFunction("(speed r2d2)").value().value, 12, 1e-6);
+  ASSERT_NEAR(problem_expert.getFunction("(distance wp1 wp2)").value().value, 10, 1e-6);
+
+  // A batch with an invalid modifier leaves every function unchanged.
+  plansys2::Function scale_down_zero =
+    parser::pddl::fromStringFunction("(= (distance wp1 wp2) 0)");
+  scale_down_zero.modifier_type = plansys2_msgs::msg::Node::SCALE_DOWN;
+  ASSERT_FALSE(problem_expert.modifyFunctions({increase_speed, scale_down_zero}));
+  ASSERT_NEAR(problem_expert.getFunction("(speed r2d2)").value().value, 12, 1e-6);
+
+  plansys2::Function missing = parser::pddl::fromStringFunction("(= (distance wp2 wp1) 1)");
+  missing.modifier_type = plansys2_msgs::msg::Node::ASSIGN;
+  ASSERT_FALSE(problem_expert.modifyFunction(missing));
+  ASSERT_NEAR(problem_expert.getFunction("(distance wp1 wp2)").value().value, 10, 1e-6);
+}
+
+TEST(problem_expert, get_changes_since)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_charging.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+  problem_expert.setJournalCapacity(4);
+
+  auto initial_revision = problem_expert.getRevision();
+  ASSERT_TRUE(problem_expert.getChangesSince(initial_revision));
+  ASSERT_TRUE(problem_expert.getChangesSince(initial_revision).value().empty());
+  ASSERT_FALSE(problem_expert.getChangesSince(initial_revision + 1));
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("r2d2", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp1", "waypoint")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp1", "waypoint")));
+  ASSERT_TRUE(
+    problem_expert.addPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)")));
+  ASSERT_EQ(problem_expert.getRevision(), initial_revision + 3);
+
+  auto changes = problem_expert.getChangesSince(initial_revision);
+  ASSERT_TRUE(changes);
+  ASSERT_EQ(changes.value().size(), 3u);
+  ASSERT_EQ(changes.value()[0].type, plansys2_msgs::msg::KnowledgeChange::ADD_INSTANCE);
+  ASSERT_EQ(changes.value()[0].instance.name, "r2d2");
+  ASSERT_EQ(changes.value()[0].revision, initial_revision + 1);
+  ASSERT_EQ(changes.value()[2].type, plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE);
+  ASSERT_EQ(parser::pddl::toString(changes.value()[2].node), "(robot_at r2d2 wp1)");
+
+  // Removing an instance also removes the predicates that use it
+  ASSERT_TRUE(problem_expert.removeInstance(parser::pddl::fromStringParam("wp1", "waypoint")));
+
+  changes = problem_expert.getChangesSince(initial_revision + 3);
+  ASSERT_TRUE(changes);
+  ASSERT_EQ(changes.value().size(), 2u);
+  ASSERT_EQ(changes.value()[0].type, plansys2_msgs::msg::KnowledgeChange::REMOVE_INSTANCE);
+  ASSERT_EQ(changes.value()[1].type, plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE);
+
+  // The first change is not kept anymore, so the client must resync
+  ASSERT_FALSE(problem_expert.getChangesSince(initial_revision));
+  ASSERT_TRUE(problem_expert.getChangesSince(initial_revision + 1));
+  ASSERT_EQ(problem_expert.getChangesSince(initial_revision + 1).value().size(), 4u);
+
+  ASSERT_TRUE(problem_expert.clearKnowledge());
+  changes = problem_expert.getChangesSince(problem_expert.getRevision() - 1);
+  ASSERT_TRUE(changes);
+  ASSERT_EQ(changes.value().size(), 1u);
+  ASSERT_EQ(changes.value()[0].type, plansys2_msgs::msg::KnowledgeChange::CLEAR_KNOWLEDGE);
+}
+
+TEST(problem_expert, query_predicates)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("r2d2", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("c3po", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("paco", "person")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("kitchen", "room")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("bedroom", "room")));
+
+  ASSERT_TRUE(
+    problem_expert.addPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 kitchen)")));
+  ASSERT_TRUE(
+    problem_expert.addPredicate(parser::pddl::fromStringPredicate("(robot_at c3po bedroom)")));
+  ASSERT_TRUE(
+    problem_expert.addPredicate(parser::pddl::fromStringPredicate("(person_at paco kitchen)")));
+
+  auto result = problem_expert.queryPredicates(
+    parser::pddl::fromStringPredicate("(robot_at ?r ?ro)"));
+  ASSERT_EQ(result.size(), 2u);
+  ASSERT_EQ(parser::pddl::toString(result[0]), "(robot_at c3po bedroom)");
+  ASSERT_EQ(parser::pddl::toString(result[1]), "(robot_at r2d2 kitchen)");
+
+  result = problem_expert.queryPredicates(
+    parser::pddl::fromStringPredicate("(robot_at ?r kitchen)"));
+  ASSERT_EQ(result.size(), 1u);
+  ASSERT_EQ(parser::pddl::toString(result[0]), "(robot_at r2d2 kitchen)");
+
+  ASSERT_TRUE(
+    problem_expert.queryPredicates(
+      parser::pddl::fromStringPredicate("(robot_at c3po kitchen)")).empty());
+  ASSERT_TRUE(
+    problem_expert.queryPredicates(
+      parser::pddl::fromStringPredicate("(robot_near_person ?r ?p)")).empty());
+
+  // Pages are resumed after the last predicate returned
+  std::string next_start_after;
+  result = problem_expert.queryPredicates(
+    parser::pddl::fromStringPredicate("(robot_at ?r ?ro)"), 1, "", next_start_after);
+  ASSERT_EQ(result.size(), 1u);
+  ASSERT_EQ(parser::pddl::toString(result[0]), "(robot_at c3po bedroom)");
+  ASSERT_FALSE(next_start_after.empty());
+
+  result = problem_expert.queryPredicates(
+    parser::pddl::fromStringPredicate("(robot_at ?r ?ro)"), 1, next_start_after,
+    next_start_after);
+  ASSERT_EQ(result.size(), 1u);
+  ASSERT_EQ(parser::pddl::toString(result[0]), "(robot_at r2d2 kitchen)");
+  ASSERT_TRUE(next_start_after.empty());
+
+  ASSERT_TRUE(
+    problem_expert.removePredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 kitchen)")));
+  result = problem_expert.queryPredicates(
+    parser::pddl::fromStringPredicate("(?p ?x kitchen)"));
+  ASSERT_TRUE(result.empty());
+
+  result = problem_expert.queryPredicates(
+    parser::pddl::fromStringPredicate("(person_at ?p kitchen)"));
+  ASSERT_EQ(result.size(), 1u);
+
+  ASSERT_TRUE(problem_expert.clearKnowledge());
+  ASSERT_TRUE(
+    problem_expert.queryPredicates(
+      parser::pddl::fromStringPredicate("(person_at ?p ?ro)")).empty());
+
+  // A repeated variable must match the same object
+  plansys2::PredicateIndex index;
+  index.add(parser::pddl::fromStringPredicate("(connected a a)"));
+  index.add(parser::pddl::fromStringPredicate("(connected a b)"));
+  result = index.query(
+    parser::pddl::fromStringPredicate("(connected ?x ?x)"), 0, "", next_start_after);
+  ASSERT_EQ(result.size(), 1u);
+  ASSERT_EQ(parser::pddl::toString(result[0]), "(connected a a)");
+}
+
+TEST(problem_expert, state_fingerprint)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+
+  auto empty = problem_expert.getFingerprint();
+  ASSERT_EQ(plansys2::StateFingerprint::toString(empty), std::string(32, '0'));
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("r2d2", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("kitchen", "room")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("bedroom", "room")));
+  ASSERT_EQ(problem_expert.getFingerprint(), empty);
+
+  auto robot_at = parser::pddl::fromStringPredicate("(robot_at r2d2 kitchen)");
+  auto distance = parser::pddl::fromStringFunction("(room_distance kitchen bedroom 1.5)");
+
+  ASSERT_TRUE(problem_expert.addPredicate(robot_at));
+  auto with_predicate = problem_expert.getFingerprint();
+  ASSERT_NE(with_predicate, empty);
+
+  ASSERT_TRUE(problem_expert.addFunction(distance));
+  auto with_function = problem_expert.getFingerprint();
+  ASSERT_NE(with_function, with_predicate);
+
+  // The same facts in any order give the same fingerprint
+  ASSERT_EQ(
+    plansys2::StateFingerprint::compute({robot_at}, {distance}), with_function);
+
+  auto changes = problem_expert.getChangesSince(problem_expert.getRevision() - 1);
+  ASSERT_TRUE(changes);
+  ASSERT_EQ(changes.value().back().fingerprint, with_function);
+
+  distance.value = 2.0;
+  ASSERT_TRUE(problem_expert.updateFunction(distance));
+  ASSERT_NE(problem_expert.getFingerprint(), with_function);
+  distance.value = 1.5;
+  ASSERT_TRUE(problem_expert.updateFunction(distance));
+  ASSERT_EQ(problem_expert.getFingerprint(), with_function);
+
+  // Values in the same quantum are not told apart
+  problem_expert.setFingerprintQuantum(1.0);
+  auto quantized = problem_expert.getFingerprint();
+  distance.value = 1.6;
+  ASSERT_TRUE(problem_expert.updateFunction(distance));
+  ASSERT_EQ(problem_expert.getFingerprint(), quantized);
+  distance.value = 2.6;
+  ASSERT_TRUE(problem_expert.updateFunction(distance));
+  ASSERT_NE(problem_expert.getFingerprint(), quantized);
+  problem_expert.setFingerprintQuantum(0.0);
+
+  ASSERT_TRUE(problem_expert.removeFunction(distance));
+  ASSERT_EQ(problem_expert.getFingerprint(), with_predicate);
+  ASSERT_TRUE(problem_expert.removePredicate(robot_at));
+  ASSERT_EQ(problem_expert.getFingerprint(), empty);
+
+  ASSERT_TRUE(problem_expert.addPredicate(robot_at));
+  ASSERT_TRUE(problem_expert.removeInstance(parser::pddl::fromStringParam("kitchen", "room")));
+  ASSERT_EQ(problem_expert.getFingerprint(), empty);
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("kitchen", "room")));
+  ASSERT_TRUE(problem_expert.addPredicate(robot_at));
+  ASSERT_TRUE(problem_expert.clearKnowledge());
+  ASSERT_EQ(problem_expert.getFingerprint(), empty);
+}
+
+TEST(problem_expert, forkable_state)
+{
+  std::vector<plansys2::Predicate> predicates;
+  std::vector<plansys2::Function> functions;
+  predicates.push_back(parser::pddl::fromStringPredicate("(robot_at r2d2 kitchen)"));
+  predicates.push_back(parser::pddl::fromStringPredicate("(person_at paco bedroom)"));
+  functions.push_back(parser::pddl::fromStringFunction("(battery_level r2d2 10)"));
+
+  plansys2::ForkableState base(predicates, functions);
+  ASSERT_EQ(base.getPredicates().size(), 2u);
+  ASSERT_EQ(base.getFingerprint(), plansys2::StateFingerprint::compute(predicates, functions));
+
+  auto move = parser::pddl::fromString(
+    "(and (not (robot_at r2d2 kitchen)) (robot_at r2d2 bedroom) "
+    "(decrease (battery_level r2d2) 4))");
+  auto fork = base.fork();
+  ASSERT_TRUE(fork.apply(move));
+
+  ASSERT_TRUE(fork.check(parser::pddl::fromString("(and (robot_at r2d2 bedroom))")));
+  ASSERT_FALSE(fork.check(parser::pddl::fromString("(and (robot_at r2d2 kitchen))")));
+  ASSERT_TRUE(fork.check(parser::pddl::fromString("(and (< (battery_level r2d2) 7))")));
+  ASSERT_TRUE(
+    fork.check(parser::pddl::fromString("(exists (?1) (and (robot_at ?1 bedroom)))")));
+  ASSERT_FALSE(
+    fork.check(parser::pddl::fromString("(exists (?1) (and (person_at ?1 kitchen)))")));
+  ASSERT_NEAR(
+    fork.getFunction(parser::pddl::fromStringFunction("(battery_level r2d2)")).value().value,
+    6.0, 1e-6);
+  ASSERT_EQ(
+    fork.getFingerprint(),
+    plansys2::StateFingerprint::compute(fork.getPredicates(), fork.getFunctions()));
+
+  // The base state is not affected by its forks
+  ASSERT_TRUE(base.check(parser::pddl::fromString("(and (robot_at r2d2 kitchen))")));
+  ASSERT_FALSE(base.check(parser::pddl::fromString("(and (robot_at r2d2 bedroom))")));
+  ASSERT_NEAR(
+    base.getFunction(parser::pddl::fromStringFunction("(battery_level r2d2)")).value().value,
+    10.0, 1e-6);
+
+  auto back = fork.fork();
+  ASSERT_TRUE(
+    back.apply(
+      parser::pddl::fromString(
+        "(and (not (robot_at r2d2 bedroom)) (robot_at r2d2 kitchen) "
+        "(increase (battery_level r2d2) 4))")));
+  ASSERT_EQ(back.getFingerprint(), base.getFingerprint());
+  ASSERT_NE(fork.getFingerprint(), base.getFingerprint());
+
+  ASSERT_FALSE(fork.apply(parser::pddl::fromString("(and (increase (battery_level c3po) 1))")));
+
+  // Many changes keep the facts ordered and the forks independent
+  plansys2::ForkableState large;
+  for (int i = 0; i < 200; i++) {
+    large.addPredicate(
+      parser::pddl::fromStringPredicate("(visited wp" + std::to_string(1000 + i) + ")"));
+  }
+  auto pruned = large.fork();
+  for (int i = 0; i < 200; i += 2) {
+    ASSERT_TRUE(
+      pruned.removePredicate(
+        parser::pddl::fromStringPredicate("(visited wp" + std::to_string(1000 + i) + ")")));
+  }
+  ASSERT_EQ(large.getPredicates().size(), 200u);
+  auto remaining = pruned.getPredicates();
+  ASSERT_EQ(remaining.size(), 100u);
+  ASSERT_EQ(parser::pddl::toString(remaining.front()), "(visited wp1001)");
+  ASSERT_EQ(parser::pddl::toString(remaining.back()), "(visited wp1199)");
+}
+
+TEST(problem_expert, apply_coalesced_changes)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_charging.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+  problem_expert.setJournalCapacity(3);
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("r2d2", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp1", "waypoint")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp2", "waypoint")));
+  ASSERT_TRUE(
+    problem_expert.addPredicate(parser::pddl::fromStringPredicate("(patrolled wp2)")));
+
+  auto make_change = [](uint8_t type, const plansys2_msgs::msg::Node & node) {
+      plansys2_msgs::msg::KnowledgeChange change;
+      change.type = type;
+      change.node = node;
+      return change;
+    };
+
+  plansys2::UpdateCoalescer coalescer;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(
+      coalescer.add(
+        make_change(
+          plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION,
+          parser::pddl::fromStringFunction("(= (state_of_charge r2d2) " +
+          std::to_string(100 - i) + ")"))));
+    ASSERT_TRUE(
+      coalescer.add(
+        make_change(
+          i % 2 ? plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE :
+          plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+          parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)"))));
+    ASSERT_TRUE(
+      coalescer.add(
+        make_change(
+          i % 2 ? plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE :
+          plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE,
+          parser::pddl::fromStringPredicate("(patrolled wp2)"))));
+  }
+  ASSERT_FALSE(
+    coalescer.add(
+      make_change(
+        plansys2_msgs::msg::KnowledgeChange::REMOVE_FUNCTION,
+        parser::pddl::fromStringFunction("(= (speed r2d2) 1)"))));
+  ASSERT_EQ(coalescer.size(), 3u);
+
+  auto revision = problem_expert.getRevision();
+  auto updates = coalescer.flush();
+  ASSERT_TRUE(coalescer.empty());
+  ASSERT_EQ(updates.size(), 3u);
+  ASSERT_EQ(problem_expert.applyChanges(updates), 3u);
+
+  ASSERT_EQ(problem_expert.getRevision(), revision + 1);
+  ASSERT_EQ(problem_expert.getFunction("(state_of_charge r2d2)").value().value, 91);
+  ASSERT_FALSE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)")));
+  ASSERT_TRUE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(patrolled wp2)")));
+
+  // Only the function update is recorded, as the predicates did not change
+  auto changes = problem_expert.getChangesSince(revision);
+  ASSERT_TRUE(changes);
+  ASSERT_EQ(changes.value().size(), 1u);
+  ASSERT_EQ(changes.value()[0].type, plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION);
+  ASSERT_EQ(changes.value()[0].revision, revision + 1);
+
+  // A batch larger than the journal makes its own revision incomplete
+  ASSERT_TRUE(
+    coalescer.add(
+      make_change(
+        plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+        parser::pddl::fromStringPredicate("(robot_at r2d2 wp2)"))));
+  for (auto wp : {"wp1", "wp2"}) {
+    ASSERT_TRUE(
+      coalescer.add(
+        make_change(
+          plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+          parser::pddl::fromStringPredicate(std::string("(charger_at ") + wp + ")"))));
+  }
+  ASSERT_TRUE(
+    coalescer.add(
+      make_change(
+        plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE,
+        parser::pddl::fromStringPredicate("(patrolled wp2)"))));
+  ASSERT_EQ(problem_expert.applyChanges(coalescer.flush()), 4u);
+
+  ASSERT_EQ(problem_expert.getRevision(), revision + 2);
+  ASSERT_FALSE(problem_expert.getChangesSince(revision));
+  ASSERT_FALSE(problem_expert.getChangesSince(revision + 1));
+  ASSERT_TRUE(problem_expert.getChangesSince(revision + 2));
+}
+
+TEST(problem_expert, expire_facts)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_charging.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("r2d2", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp1", "waypoint")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp2", "waypoint")));
+
+  auto make_change = [](uint8_t type, const plansys2_msgs::msg::Node & node, int stamp, int ttl) {
+      plansys2_msgs::msg::KnowledgeChange change;
+      change.type = type;
+      change.node = node;
+      change.stamp.sec = stamp;
+      change.ttl.sec = ttl;
+      return change;
+    };
+
+  std::vector<plansys2_msgs::msg::KnowledgeChange> changes;
+  changes.push_back(
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+      parser::pddl::fromStringPredicate("(patrolled wp1)"), 10, 2));
+  changes.push_back(
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+      parser::pddl::fromStringPredicate("(patrolled wp2)"), 10, 5));
+  changes.push_back(
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION,
+      parser::pddl::fromStringFunction("(= (speed r2d2) 3)"), 10, 2));
+  changes.push_back(
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+      parser::pddl::fromStringPredicate("(charger_at wp1)"), 10, 0));
+  ASSERT_EQ(problem_expert.applyChanges(changes), 4u);
+
+  // Refreshing a fact extends it
+  changes.clear();
+  changes.push_back(
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+      parser::pddl::fromStringPredicate("(patrolled wp1)"), 11, 2));
+  ASSERT_EQ(problem_expert.applyChanges(changes), 1u);
+
+  ASSERT_TRUE(problem_expert.expireFacts(std::chrono::seconds(11)).empty());
+
+  auto revision = problem_expert.getRevision();
+  auto expired = problem_expert.expireFacts(std::chrono::seconds(12));
+  ASSERT_EQ(expired.size(), 1u);
+  ASSERT_EQ(parser::pddl::toString(expired[0]), "(speed r2d2)");
+  ASSERT_FALSE(problem_expert.getFunction("(speed r2d2)"));
+  ASSERT_EQ(problem_expert.getRevision(), revision + 1);
+
+  // Updating a fact without a ttl makes it permanent
+  ASSERT_TRUE(
+    problem_expert.addPredicate(parser::pddl::fromStringPredicate("(patrolled wp2)")));
+
+  revision = problem_expert.getRevision();
+  expired = problem_expert.expireFacts(std::chrono::seconds(100));
+  ASSERT_EQ(expired.size(), 1u);
+  ASSERT_EQ(parser::pddl::toString(expired[0]), "(patrolled wp1)");
+  ASSERT_EQ(problem_expert.getRevision(), revision + 1);
+  ASSERT_EQ(problem_expert.getChangesSince(revision).value().size(), 1u);
+
+  ASSERT_EQ(problem_expert.getPredicates().size(), 2u);
+  ASSERT_TRUE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(patrolled wp2)")));
+  ASSERT_TRUE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(charger_at wp1)")));
+}
+
+TEST(problem_expert, conditional_update)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_charging.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+  plansys2::ProblemExpert problem_expert(domain_expert);
+
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("r2d2", "robot")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp1", "waypoint")));
+  ASSERT_TRUE(problem_expert.addInstance(parser::pddl::fromStringParam("wp2", "waypoint")));
+  ASSERT_TRUE(
+    problem_expert.addPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)")));
+  ASSERT_TRUE(
+    problem_expert.addFunction(
+      parser::pddl::fromStringFunction("(= (state_of_charge r2d2) 50)")));
+
+  auto make_change = [](uint8_t type, const plansys2_msgs::msg::Node & node) {
+      plansys2_msgs::msg::KnowledgeChange change;
+      change.type = type;
+      change.node = node;
+      return change;
+    };
+
+  std::vector<plansys2_msgs::msg::KnowledgeChange> move = {
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::REMOVE_PREDICATE,
+      parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)")),
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+      parser::pddl::fromStringPredicate("(robot_at r2d2 wp2)")),
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::UPDATE_FUNCTION,
+      parser::pddl::fromStringFunction("(= (state_of_charge r2d2) 40)"))};
+
+  auto read_revision = problem_expert.getRevision();
+
+  // Another writer changes the knowledge after it was read
+  ASSERT_TRUE(problem_expert.addPredicate(parser::pddl::fromStringPredicate("(patrolled wp1)")));
+
+  uint64_t revision = 0;
+  ASSERT_EQ(
+    problem_expert.applyChangesIf(move, read_revision, {}, revision),
+    plansys2::ConditionalUpdateResult::REVISION_CONFLICT);
+  ASSERT_EQ(revision, problem_expert.getRevision());
+  ASSERT_TRUE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)")));
+
+  auto condition = parser::pddl::fromString(
+    "(and (robot_at r2d2 wp1) (= (state_of_charge r2d2) 60))");
+  ASSERT_EQ(
+    problem_expert.applyChangesIf(move, 0, condition, revision),
+    plansys2::ConditionalUpdateResult::CONDITION_FAILED);
+
+  // Nothing is applied if any change is not valid
+  auto invalid_move = move;
+  invalid_move.push_back(
+    make_change(
+      plansys2_msgs::msg::KnowledgeChange::ADD_PREDICATE,
+      parser::pddl::fromStringPredicate("(robot_at r2d2 wp3)")));
+  ASSERT_EQ(
+    problem_expert.applyChangesIf(invalid_move, revision, {}, revision),
+    plansys2::ConditionalUpdateResult::INVALID_CHANGE);
+  ASSERT_TRUE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)")));
+
+  // Retried from the current revision, the changes are applied as a single revision
+  read_revision = revision;
+  condition = parser::pddl::fromString(
+    "(and (robot_at r2d2 wp1) (= (state_of_charge r2d2) 50))");
+  ASSERT_EQ(
+    problem_expert.applyChangesIf(move, read_revision, condition, revision),
+    plansys2::ConditionalUpdateResult::APPLIED);
+  ASSERT_EQ(revision, read_revision + 1);
+  ASSERT_EQ(revision, problem_expert.getRevision());
+  ASSERT_FALSE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 wp1)")));
+  ASSERT_TRUE(
+    problem_expert.existPredicate(parser::pddl::fromStringPredicate("(robot_at r2d2 wp2)")));
+  ASSERT_EQ(problem_expert.getFunction("(state_of_charge r2d2)").value().value, 40);
+  ASSERT_EQ(problem_expert.getChangesSince(read_revision).value().size(), 3u);
+}
+
 TEST(problem_expert, addget_goals)
 {
   std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
@@ -631,6 +1228,63 @@ TEST(problem_expert, add_problem)
 }
 
 
+TEST(problem_expert, add_problem_sharded)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_simple.pddl");
+  std::string domain_str((
+      std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+
+  std::ifstream problem_ifs(pkgpath + "/pddl/problem_simple_1.pddl");
+  std::string problem_str((
+      std::istreambuf_iterator<char>(problem_ifs)),
+    std::istreambuf_iterator<char>());
+
+  auto domain_expert = std::make_shared<plansys2::DomainExpert>(domain_str);
+
+  for (auto policy : {plansys2::ShardingPolicy::BY_SYMBOL, plansys2::ShardingPolicy::BY_OBJECT}) {
+    const size_t num_shards = 3;
+    size_t num_predicates = 0;
+    size_t num_functions = 0;
+
+    for (size_t shard_id = 0; shard_id < num_shards; shard_id++) {
+      plansys2::ProblemExpert problem_expert(domain_expert);
+      problem_expert.setShard(shard_id, num_shards, policy);
+      ASSERT_TRUE(problem_expert.addProblem(problem_str));
+
+      ASSERT_EQ(problem_expert.getInstances().size(), 6);
+      ASSERT_FALSE(problem_expert.getGoal().nodes.empty());
+
+      for (const auto & predicate : problem_expert.getPredicates()) {
+        ASSERT_EQ(plansys2::get_shard(predicate, num_shards, policy), shard_id);
+      }
+      for (const auto & function : problem_expert.getFunctions()) {
+        ASSERT_EQ(plansys2::get_shard(function, num_shards, policy), shard_id);
+      }
+
+      num_predicates += problem_expert.getPredicates().size();
+      num_functions += problem_expert.getFunctions().size();
+    }
+
+    ASSERT_EQ(num_predicates, 2);
+    ASSERT_EQ(num_functions, 1);
+  }
+
+  auto predicate = parser::pddl::fromStringPredicate("(robot_at leia kitchen)");
+  ASSERT_EQ(
+    plansys2::get_shard(predicate, 4, plansys2::ShardingPolicy::BY_SYMBOL),
+    plansys2::get_shard(
+      parser::pddl::fromStringPredicate("(ROBOT_AT r2 bedroom)"), 4,
+      plansys2::ShardingPolicy::BY_SYMBOL));
+  ASSERT_EQ(
+    plansys2::get_shard(predicate, 4, plansys2::ShardingPolicy::BY_OBJECT),
+    plansys2::get_shard(
+      parser::pddl::fromStringPredicate("(person_at leia bedroom)"), 4,
+      plansys2::ShardingPolicy::BY_OBJECT));
+  ASSERT_EQ(plansys2::get_shard(predicate, 1, plansys2::ShardingPolicy::BY_OBJECT), 0);
+}
+
 TEST(problem_expert, add_problem_with_constants)
 {
   std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
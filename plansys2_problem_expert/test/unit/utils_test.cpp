@@ -954,6 +954,164 @@ TEST(utils, evaluate_exists_client)
   t.join();
 }
 
+TEST(utils, evaluate_exists_join)
+{
+  std::vector<plansys2::Predicate> predicates;
+  std::vector<plansys2::Function> functions;
+
+  for (int i = 0; i < 100; i++) {
+    predicates.push_back(
+      parser::pddl::fromStringPredicate(
+        "(robot_at rob" + std::to_string(i) + " room" + std::to_string(i % 10) + ")"));
+  }
+  predicates.push_back(parser::pddl::fromStringPredicate("(connected room3 room5)"));
+
+  std::string expression = "(exists (?1 ?2 ?3) (and (robot_at ?1 ?2)(connected ?2 ?3)))";
+  plansys2_msgs::msg::Tree goal;
+  parser::pddl::fromString(goal, expression);
+
+  ASSERT_EQ(
+    plansys2::evaluate(goal, predicates, functions),
+    std::make_tuple(true, true, 0));
+
+  expression = "(exists (?1 ?2) (and (robot_at ?1 ?2)(connected room5 ?2)))";
+  goal = parser::pddl::fromString(expression);
+
+  ASSERT_EQ(
+    plansys2::evaluate(goal, predicates, functions),
+    std::make_tuple(true, false, 0));
+
+  expression = "(not (exists (?1 ?2) (and (robot_at ?1 ?2)(connected room5 ?2))))";
+  goal = parser::pddl::fromString(expression);
+
+  ASSERT_EQ(
+    plansys2::evaluate(goal, predicates, functions),
+    std::make_tuple(true, true, 0));
+
+  expression = "(exists (?1) (and (robot_at rob3 ?1)(not (connected ?1 room5))))";
+  goal = parser::pddl::fromString(expression);
+
+  ASSERT_EQ(
+    plansys2::evaluate(goal, predicates, functions),
+    std::make_tuple(true, false, 0));
+
+  predicates.push_back(parser::pddl::fromStringPredicate("(robot_at rob3 room4)"));
+
+  ASSERT_EQ(
+    plansys2::evaluate(goal, predicates, functions),
+    std::make_tuple(true, true, 0));
+}
+
+TEST(utils, evaluate_exists_typed)
+{
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::string domain_file = pkgpath + "/pddl/domain_exists.pddl";
+
+  std::ifstream domain_ifs(domain_file);
+  std::string domain_str(
+    (std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+  parser::pddl::Domain domain(domain_str);
+
+  plansys2_msgs::msg::Tree goal;
+  parser::pddl::fromString(goal, "(exists (?1) (and (robot_at rob1 ?1)))");
+  goal.nodes[0].parameters[0].type = "room";
+
+  std::vector<plansys2::Instance> instances;
+  instances.push_back(plansys2::Instance("rob1", "robot"));
+  instances.push_back(plansys2::Instance("bedroom", "room"));
+
+  std::vector<plansys2::Predicate> predicates;
+  std::vector<plansys2::Function> functions;
+  predicates.push_back(parser::pddl::fromStringPredicate("(robot_at rob1 rob1)"));
+
+  ASSERT_EQ(
+    plansys2::evaluate_exists(goal, instances, predicates, functions, 0),
+    std::make_tuple(true, false, 0));
+
+  predicates.push_back(parser::pddl::fromStringPredicate("(robot_at rob1 bedroom)"));
+
+  ASSERT_EQ(
+    plansys2::evaluate_exists(goal, instances, predicates, functions, 0),
+    std::make_tuple(true, true, 0));
+
+  auto action = domain.actions.get("action_test2");
+  plansys2_msgs::msg::Tree tree;
+  action->pre->getTree(tree, domain);
+  ASSERT_EQ(tree.nodes[0].node_type, plansys2_msgs::msg::Node::EXISTS);
+  ASSERT_EQ(tree.nodes[0].parameters[0].type, "object");
+  ASSERT_NE(
+    std::find(
+      tree.nodes[0].parameters[0].sub_types.begin(),
+      tree.nodes[0].parameters[0].sub_types.end(), "room"),
+    tree.nodes[0].parameters[0].sub_types.end());
+}
+
+TEST(utils, evaluate_binding)
+{
+  std::vector<plansys2::Predicate> predicates;
+  std::vector<plansys2::Function> functions;
+
+  predicates.push_back(parser::pddl::fromStringPredicate("(robot_at rob1 bedroom)"));
+  predicates.push_back(parser::pddl::fromStringPredicate("(connected bedroom kitchen)"));
+  predicates.push_back(parser::pddl::fromStringPredicate("(charging_point_at bedroom)"));
+  functions.push_back(parser::pddl::fromStringFunction("(= (battery_level rob1) 50.0)"));
+
+  std::string expression = "(and (robot_at ?0 ?1)(connected ?1 ?2)(not (robot_at ?0 ?2)))";
+  plansys2_msgs::msg::Tree tree;
+  parser::pddl::fromString(tree, expression);
+
+  plansys2::ObjectTable objects;
+  plansys2::LiftedTree lifted(tree, {"?0", "?1", "?2"});
+  ASSERT_EQ(lifted.n_variables, 3u);
+  ASSERT_EQ(lifted.args[1], std::vector<int>({0, 1}));
+
+  plansys2::ParameterBinding binding(lifted, objects);
+  binding.ids = {objects.id("rob1"), objects.id("bedroom"), objects.id("kitchen")};
+
+  ASSERT_EQ(
+    plansys2::evaluate(tree, binding, predicates, functions),
+    std::make_tuple(true, true, 0));
+  ASSERT_TRUE(plansys2::check(tree, binding, predicates, functions));
+
+  binding.ids = {objects.id("rob1"), objects.id("kitchen"), objects.id("bedroom")};
+  ASSERT_FALSE(plansys2::check(tree, binding, predicates, functions));
+
+  ASSERT_EQ(parser::pddl::toString(tree), expression);
+
+  std::string pkgpath = ament_index_cpp::get_package_share_directory("plansys2_problem_expert");
+  std::ifstream domain_ifs(pkgpath + "/pddl/domain_exists.pddl");
+  std::string domain_str(
+    (std::istreambuf_iterator<char>(domain_ifs)),
+    std::istreambuf_iterator<char>());
+  parser::pddl::Domain domain(domain_str);
+
+  auto action = domain.actions.get("action_test");
+  plansys2_msgs::msg::Tree precondition;
+  action->pre->getTree(precondition, domain);
+
+  // The variable quantified by the EXISTS node follows the parameter of the action
+  plansys2::LiftedTree lifted_precondition(precondition, {"?0"});
+  ASSERT_EQ(lifted_precondition.n_variables, 2u);
+
+  plansys2::ParameterBinding action_binding(lifted_precondition, objects);
+  action_binding.ids[0] = objects.id("rob1");
+  ASSERT_EQ(
+    plansys2::evaluate(precondition, action_binding, predicates, functions),
+    std::make_tuple(true, true, 0));
+  ASSERT_EQ(action_binding.ids[1], plansys2::ParameterBinding::UNBOUND);
+
+  functions[0].value = 500.0;
+  ASSERT_EQ(
+    plansys2::evaluate(precondition, action_binding, predicates, functions),
+    std::make_tuple(true, false, 0));
+
+  action_binding.ids[0] = objects.id("rob2");
+  ASSERT_EQ(
+    plansys2::evaluate(precondition, action_binding, predicates, functions),
+    std::make_tuple(false, false, 0));
+}
+
 TEST(utils, get_subtrees)
 {
   std::vector<uint32_t> empty_expected;
@@ -0,0 +1,106 @@
+// Copyright 2023 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLANSYS2_SUPPORT_PY__PYTHONACTIONEXECUTORCLIENT_HPP_
+#define PLANSYS2_SUPPORT_PY__PYTHONACTIONEXECUTORCLIENT_HPP_
+
+#include <pybind11/pybind11.h>
+
+#include <memory>
+#include <string>
+
+#include "plansys2_executor/ActionExecutorClient.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace plansys2
+{
+
+/// Action performer whose work is done by a Python performer.
+/**
+ * The hub handling, argument matching and heartbeats are those of ActionExecutorClient,
+ * so Python is only entered, holding the GIL, to call do_work, on_activate and
+ * on_deactivate of the Python object. The Python object is a subclass of
+ * plansys2_support_py.ActionExecutorClient created while the performer host is set.
+ */
+class PythonActionExecutorClient : public ActionExecutorClient
+{
+public:
+  PythonActionExecutorClient(
+    const std::string & node_name,
+    const std::chrono::nanoseconds & rate,
+    pybind11::object performer);
+
+  ~PythonActionExecutorClient();
+
+  using ActionExecutorClient::send_feedback;
+  using ActionExecutorClient::finish;
+
+  pybind11::object declare_python_parameter(const std::string & name, pybind11::object value);
+  pybind11::object get_python_parameter(const std::string & name);
+
+protected:
+  void do_work() override;
+
+  CallbackReturnT on_activate(const rclcpp_lifecycle::State & state) override;
+  CallbackReturnT on_deactivate(const rclcpp_lifecycle::State & state) override;
+
+  CallbackReturnT call_transition(const char * callback);
+
+  pybind11::object performer_;
+};
+
+/// Entry point of the Python performers to the native performer host.
+/**
+ * The instance is stored in plansys2_support_py.ActionExecutorClient._performer_host, and
+ * forwards the calls of the Python performer to its PythonActionExecutorClient. Only the
+ * logger, the clock and the parameters of the node are available to the Python performer.
+ */
+class PerformerHost
+{
+public:
+  /// Create the native performer, called by the constructor of the Python performer.
+  void create_client(pybind11::object performer, const std::string & node_name, double rate);
+
+  /// Get the native performer created, and release it to the caller.
+  std::shared_ptr<PythonActionExecutorClient> release_client();
+
+  void send_feedback(float completion, const std::string & status);
+  void finish(bool success, float completion, const std::string & status);
+  rclcpp::Logger get_logger() const;
+  int64_t now() const;
+
+  pybind11::object declare_parameter(const std::string & name, pybind11::object value);
+  pybind11::object get_parameter(const std::string & name);
+  bool has_parameter(const std::string & name) const;
+
+private:
+  std::weak_ptr<PythonActionExecutorClient> client_;
+  std::shared_ptr<PythonActionExecutorClient> created_;
+};
+
+/// Create a Python performer, and the native performer that runs it.
+/**
+ * The Python interpreter must be running, and the GIL held.
+ * \param[in] module The Python module of the performer.
+ * \param[in] performer_class The class of the performer, constructed with no arguments.
+ * \return The native performer.
+ * \throws std::exception if the performer could not be created.
+ */
+std::shared_ptr<PythonActionExecutorClient> create_python_performer(
+  const std::string & module, const std::string & performer_class);
+
+}  // namespace plansys2
+
+#endif  // PLANSYS2_SUPPORT_PY__PYTHONACTIONEXECUTORCLIENT_HPP_
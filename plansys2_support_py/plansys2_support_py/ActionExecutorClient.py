@@ -16,14 +16,50 @@
 import rclpy
 import copy
 from rclpy.lifecycle import LifecycleNode, TransitionCallbackReturn, LifecycleState
+from rclpy.parameter import Parameter
+from rclpy.time import Time
 from rclpy.qos import QoSProfile, QoSReliabilityPolicy
 
 from plansys2_msgs.msg import ActionExecution, ActionPerformerStatus, ActionExecutionInfo
 from lifecycle_msgs.msg import State
 
+# Set by the native performer host (plansys2_support_py performer_host) before creating the
+# performer. In that case, the host does the hub handling, argument matching and heartbeats,
+# and only calls do_work and the activation callbacks of the performer.
+#
+# There is no rclpy node under the host, so only this subset of the node API is available:
+# get_name, get_logger, get_clock().now(), declare_parameter, get_parameter and
+# has_parameter, which use the native node. Creating publishers, subscriptions, timers,
+# clients or services raises a RuntimeError; such performers have to be run with rclpy.
+_performer_host = None
+
+
+class _HostClock:
+
+    def now(self):
+        return Time(nanoseconds=_performer_host.now())
+
+
+def _host_unsupported(name):
+    def method(self, *args, **kwargs):
+        if _performer_host is not None:
+            raise RuntimeError(
+                '{} is not available to performers run by performer_host, '
+                'run {} with rclpy instead'.format(name, type(self).__name__))
+        return getattr(LifecycleNode, name)(self, *args, **kwargs)
+    return method
+
+
 class ActionExecutorClient(LifecycleNode):
 
     def __init__(self, node_name, rate):
+        if _performer_host is not None:
+            self._node_name = node_name
+            self._rate = rate
+            self.current_arguments = []
+            _performer_host.create_client(self, node_name, rate)
+            return
+
         super().__init__(node_name)
 
         self.declare_parameter('action_name', '')
@@ -68,7 +104,46 @@ class ActionExecutorClient(LifecycleNode):
 
         return TransitionCallbackReturn.SUCCESS
     
+    def get_name(self):
+        if _performer_host is not None:
+            return self._node_name
+        return super().get_name()
+
+    def get_logger(self):
+        if _performer_host is not None:
+            return _performer_host.get_logger()
+        return super().get_logger()
+
+    def get_clock(self):
+        if _performer_host is not None:
+            return _HostClock()
+        return super().get_clock()
+
+    def declare_parameter(self, name, value=None, *args, **kwargs):
+        if _performer_host is not None:
+            return Parameter(name, value=_performer_host.declare_parameter(name, value))
+        return super().declare_parameter(name, value, *args, **kwargs)
+
+    def get_parameter(self, name):
+        if _performer_host is not None:
+            return Parameter(name, value=_performer_host.get_parameter(name))
+        return super().get_parameter(name)
+
+    def has_parameter(self, name):
+        if _performer_host is not None:
+            return _performer_host.has_parameter(name)
+        return super().has_parameter(name)
+
+    create_publisher = _host_unsupported('create_publisher')
+    create_subscription = _host_unsupported('create_subscription')
+    create_timer = _host_unsupported('create_timer')
+    create_client = _host_unsupported('create_client')
+    create_service = _host_unsupported('create_service')
+
     def on_activate(self, state: LifecycleState) -> TransitionCallbackReturn:
+        if _performer_host is not None:
+            return TransitionCallbackReturn.SUCCESS
+
         self.status.state = ActionPerformerStatus.RUNNING
         self.status.status_stamp = self.get_clock().now().to_msg()
         self.timer = self.create_timer(self.rate, self.do_work)
@@ -76,6 +151,9 @@ class ActionExecutorClient(LifecycleNode):
         return TransitionCallbackReturn.SUCCESS
     
     def on_deactivate(self, state: LifecycleState) -> TransitionCallbackReturn:
+        if _performer_host is not None:
+            return TransitionCallbackReturn.SUCCESS
+
         self.status.state = ActionPerformerStatus.READY
         self.status.status_stamp = self.get_clock().now().to_msg()
         self.timer.destroy()
@@ -129,6 +207,10 @@ class ActionExecutorClient(LifecycleNode):
         self.action_hub_pub.publish(msg_resp)
 
     def send_feedback(self, completion, status):
+        if _performer_host is not None:
+            _performer_host.send_feedback(completion, status)
+            return
+
         msg_resp = ActionExecution()
         msg_resp.type = ActionExecution.FEEDBACK
         msg_resp.node_id = self.get_name()
@@ -140,6 +222,10 @@ class ActionExecutorClient(LifecycleNode):
         self.action_hub_pub.publish(msg_resp)
 
     def finish(self, success, completion, status):
+        if _performer_host is not None:
+            _performer_host.finish(success, completion, status)
+            return
+
         if self._state_machine.current_state[0] == State.PRIMARY_STATE_ACTIVE:
             self.trigger_deactivate()
 
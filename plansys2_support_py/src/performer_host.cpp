@@ -0,0 +1,77 @@
+// Copyright 2023 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Runs a Python performer inside a native action performer:
+//
+//   ros2 run plansys2_support_py performer_host <python module> <performer class> [ROS args]
+//
+// The performer class is a subclass of plansys2_support_py.ActionExecutorClient. Its
+// constructor is called with no arguments, as the main of a Python performer would do.
+// There is no rclpy node, so the performer can only use the logger, the clock and the
+// parameters of the node (see plansys2_support_py/ActionExecutorClient.py).
+
+#include <pybind11/embed.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lifecycle_msgs/msg/transition.hpp"
+
+#include "plansys2_support_py/PythonActionExecutorClient.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace py = pybind11;
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+
+  std::vector<std::string> args = rclcpp::remove_ros_arguments(argc, argv);
+  if (args.size() < 3) {
+    std::cerr << "Usage: performer_host <python module> <performer class> [ROS args]" <<
+      std::endl;
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  py::scoped_interpreter interpreter;
+
+  std::shared_ptr<plansys2::PythonActionExecutorClient> node;
+
+  try {
+    node = plansys2::create_python_performer(args[1], args[2]);
+  } catch (const std::exception & e) {
+    // Python errors, failed conversions of Python values and errors creating the node
+    std::cerr << "Failed to create performer " << args[1] << "." << args[2] << ": " <<
+      e.what() << std::endl;
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  {
+    // Python is only entered from the callbacks of the performer
+    py::gil_scoped_release release;
+
+    node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+
+    rclcpp::spin(node->get_node_base_interface());
+  }
+
+  node = nullptr;
+  rclcpp::shutdown();
+
+  return 0;
+}
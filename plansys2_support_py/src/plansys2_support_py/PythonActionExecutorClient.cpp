@@ -0,0 +1,318 @@
+// Copyright 2023 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "plansys2_support_py/PythonActionExecutorClient.hpp"
+
+#include <pybind11/embed.h>
+#include <pybind11/stl.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace py = pybind11;
+
+PYBIND11_EMBEDDED_MODULE(plansys2_performer_host, m) {
+  py::class_<rclcpp::Logger>(m, "Logger")
+  .def(
+    "debug", [](const rclcpp::Logger & logger, const std::string & msg) {
+      RCLCPP_DEBUG(logger, "%s", msg.c_str());
+    })
+  .def(
+    "info", [](const rclcpp::Logger & logger, const std::string & msg) {
+      RCLCPP_INFO(logger, "%s", msg.c_str());
+    })
+  .def(
+    "warning", [](const rclcpp::Logger & logger, const std::string & msg) {
+      RCLCPP_WARN(logger, "%s", msg.c_str());
+    })
+  .def(
+    "warn", [](const rclcpp::Logger & logger, const std::string & msg) {
+      RCLCPP_WARN(logger, "%s", msg.c_str());
+    })
+  .def(
+    "error", [](const rclcpp::Logger & logger, const std::string & msg) {
+      RCLCPP_ERROR(logger, "%s", msg.c_str());
+    })
+  .def(
+    "fatal", [](const rclcpp::Logger & logger, const std::string & msg) {
+      RCLCPP_FATAL(logger, "%s", msg.c_str());
+    });
+
+  py::class_<plansys2::PerformerHost, std::shared_ptr<plansys2::PerformerHost>>(
+    m, "PerformerHost")
+  .def("create_client", &plansys2::PerformerHost::create_client)
+  .def("send_feedback", &plansys2::PerformerHost::send_feedback)
+  .def("finish", &plansys2::PerformerHost::finish)
+  .def("get_logger", &plansys2::PerformerHost::get_logger)
+  .def("now", &plansys2::PerformerHost::now)
+  .def("declare_parameter", &plansys2::PerformerHost::declare_parameter)
+  .def("get_parameter", &plansys2::PerformerHost::get_parameter)
+  .def("has_parameter", &plansys2::PerformerHost::has_parameter);
+}
+
+namespace plansys2
+{
+
+namespace
+{
+
+rclcpp::ParameterValue to_parameter_value(const py::handle & value)
+{
+  if (value.is_none()) {
+    return rclcpp::ParameterValue();
+  } else if (py::isinstance<py::bool_>(value)) {
+    return rclcpp::ParameterValue(value.cast<bool>());
+  } else if (py::isinstance<py::int_>(value)) {
+    return rclcpp::ParameterValue(value.cast<int64_t>());
+  } else if (py::isinstance<py::float_>(value)) {
+    return rclcpp::ParameterValue(value.cast<double>());
+  } else if (py::isinstance<py::str>(value)) {
+    return rclcpp::ParameterValue(value.cast<std::string>());
+  } else if (py::isinstance<py::list>(value) || py::isinstance<py::tuple>(value)) {
+    auto items = py::reinterpret_borrow<py::sequence>(value);
+    py::object first = items.size() > 0 ? py::object(items[0]) : py::str();
+    if (py::isinstance<py::str>(first)) {
+      return rclcpp::ParameterValue(items.cast<std::vector<std::string>>());
+    } else if (py::isinstance<py::bool_>(first)) {
+      return rclcpp::ParameterValue(items.cast<std::vector<bool>>());
+    } else if (py::isinstance<py::int_>(first)) {
+      return rclcpp::ParameterValue(items.cast<std::vector<int64_t>>());
+    } else if (py::isinstance<py::float_>(first)) {
+      return rclcpp::ParameterValue(items.cast<std::vector<double>>());
+    }
+  }
+
+  throw py::type_error("Unsupported parameter type " + std::string(py::str(value.get_type())));
+}
+
+py::object to_python(const rclcpp::ParameterValue & value)
+{
+  switch (value.get_type()) {
+    case rclcpp::ParameterType::PARAMETER_BOOL:
+      return py::cast(value.get<bool>());
+    case rclcpp::ParameterType::PARAMETER_INTEGER:
+      return py::cast(value.get<int64_t>());
+    case rclcpp::ParameterType::PARAMETER_DOUBLE:
+      return py::cast(value.get<double>());
+    case rclcpp::ParameterType::PARAMETER_STRING:
+      return py::cast(value.get<std::string>());
+    case rclcpp::ParameterType::PARAMETER_BYTE_ARRAY:
+      return py::cast(value.get<std::vector<uint8_t>>());
+    case rclcpp::ParameterType::PARAMETER_BOOL_ARRAY:
+      return py::cast(value.get<std::vector<bool>>());
+    case rclcpp::ParameterType::PARAMETER_INTEGER_ARRAY:
+      return py::cast(value.get<std::vector<int64_t>>());
+    case rclcpp::ParameterType::PARAMETER_DOUBLE_ARRAY:
+      return py::cast(value.get<std::vector<double>>());
+    case rclcpp::ParameterType::PARAMETER_STRING_ARRAY:
+      return py::cast(value.get<std::vector<std::string>>());
+    default:
+      return py::none();
+  }
+}
+
+}  // namespace
+
+using CallbackReturnT =
+  rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+
+PythonActionExecutorClient::PythonActionExecutorClient(
+  const std::string & node_name,
+  const std::chrono::nanoseconds & rate,
+  py::object performer)
+: ActionExecutorClient(node_name, rate),
+  performer_(std::move(performer))
+{
+}
+
+PythonActionExecutorClient::~PythonActionExecutorClient()
+{
+  py::gil_scoped_acquire gil;
+  performer_ = py::object();
+}
+
+void
+PythonActionExecutorClient::do_work()
+{
+  py::gil_scoped_acquire gil;
+
+  try {
+    performer_.attr("do_work")();
+  } catch (const py::error_already_set & e) {
+    RCLCPP_ERROR(get_logger(), "Python do_work failed: %s", e.what());
+  }
+}
+
+CallbackReturnT
+PythonActionExecutorClient::on_activate(const rclcpp_lifecycle::State & state)
+{
+  {
+    py::gil_scoped_acquire gil;
+    performer_.attr("current_arguments") = py::cast(get_arguments());
+  }
+
+  if (call_transition("on_activate") != CallbackReturnT::SUCCESS) {
+    return CallbackReturnT::FAILURE;
+  }
+
+  return ActionExecutorClient::on_activate(state);
+}
+
+CallbackReturnT
+PythonActionExecutorClient::on_deactivate(const rclcpp_lifecycle::State & state)
+{
+  auto ret = ActionExecutorClient::on_deactivate(state);
+
+  if (call_transition("on_deactivate") != CallbackReturnT::SUCCESS) {
+    return CallbackReturnT::FAILURE;
+  }
+
+  return ret;
+}
+
+CallbackReturnT
+PythonActionExecutorClient::call_transition(const char * callback)
+{
+  py::gil_scoped_acquire gil;
+
+  try {
+    auto result = performer_.attr(callback)(py::none());
+    auto transition_return =
+      py::module_::import("rclpy.lifecycle").attr("TransitionCallbackReturn");
+
+    if (result.is_none() || result.equal(transition_return.attr("SUCCESS"))) {
+      return CallbackReturnT::SUCCESS;
+    }
+  } catch (const py::error_already_set & e) {
+    RCLCPP_ERROR(get_logger(), "Python %s failed: %s", callback, e.what());
+  }
+
+  return CallbackReturnT::FAILURE;
+}
+
+py::object
+PythonActionExecutorClient::declare_python_parameter(
+  const std::string & name, py::object value)
+{
+  // Python performers declare the parameters of ActionExecutorClient again
+  if (!has_parameter(name)) {
+    declare_parameter(name, to_parameter_value(value));
+  }
+  return get_python_parameter(name);
+}
+
+py::object
+PythonActionExecutorClient::get_python_parameter(const std::string & name)
+{
+  return to_python(get_parameter(name).get_parameter_value());
+}
+
+void
+PerformerHost::create_client(py::object performer, const std::string & node_name, double rate)
+{
+  auto period = std::chrono::duration<double>(rate);
+  created_ = std::make_shared<PythonActionExecutorClient>(
+    node_name, std::chrono::duration_cast<std::chrono::nanoseconds>(period), performer);
+  client_ = created_;
+}
+
+std::shared_ptr<PythonActionExecutorClient>
+PerformerHost::release_client()
+{
+  return std::move(created_);
+}
+
+void
+PerformerHost::send_feedback(float completion, const std::string & status)
+{
+  if (auto client = client_.lock()) {
+    client->send_feedback(completion, status);
+  }
+}
+
+void
+PerformerHost::finish(bool success, float completion, const std::string & status)
+{
+  if (auto client = client_.lock()) {
+    client->finish(success, completion, status);
+  }
+}
+
+rclcpp::Logger
+PerformerHost::get_logger() const
+{
+  if (auto client = client_.lock()) {
+    return client->get_logger();
+  }
+  return rclcpp::get_logger("performer_host");
+}
+
+int64_t
+PerformerHost::now() const
+{
+  if (auto client = client_.lock()) {
+    return client->now().nanoseconds();
+  }
+  return rclcpp::Clock().now().nanoseconds();
+}
+
+py::object
+PerformerHost::declare_parameter(const std::string & name, py::object value)
+{
+  if (auto client = client_.lock()) {
+    return client->declare_python_parameter(name, value);
+  }
+  throw std::runtime_error("Performer host not ready");
+}
+
+py::object
+PerformerHost::get_parameter(const std::string & name)
+{
+  if (auto client = client_.lock()) {
+    return client->get_python_parameter(name);
+  }
+  throw std::runtime_error("Performer host not ready");
+}
+
+bool
+PerformerHost::has_parameter(const std::string & name) const
+{
+  if (auto client = client_.lock()) {
+    return client->has_parameter(name);
+  }
+  return false;
+}
+
+std::shared_ptr<PythonActionExecutorClient>
+create_python_performer(const std::string & module, const std::string & performer_class)
+{
+  auto host = std::make_shared<PerformerHost>();
+  py::module_::import("plansys2_performer_host");
+  py::module_::import("plansys2_support_py.ActionExecutorClient").attr("_performer_host") = host;
+
+  // The native performer is created by the constructor of ActionExecutorClient, so the
+  // performer can use its parameters from its own constructor
+  py::module_::import(module.c_str()).attr(performer_class.c_str())();
+
+  auto client = host->release_client();
+  if (!client) {
+    throw std::runtime_error("ActionExecutorClient constructor not called");
+  }
+  return client;
+}
+
+}  // namespace plansys2
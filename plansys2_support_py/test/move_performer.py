@@ -0,0 +1,46 @@
+# Copyright 2023 Intelligent Robotics Lab
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from plansys2_support_py.ActionExecutorClient import ActionExecutorClient
+
+# Arguments of each execution, and the errors of the unsupported node API
+executions = []
+errors = []
+
+
+class MovePerformer(ActionExecutorClient):
+
+    def __init__(self):
+        super().__init__('move_action', 0.1)
+        self.declare_parameter('steps', 3)
+        self.steps = self.get_parameter('steps').value
+        self.progress = 0
+
+        try:
+            self.create_timer(1.0, self.do_work)
+        except RuntimeError as e:
+            errors.append(str(e))
+
+    def on_activate(self, state):
+        self.progress = 0
+        self.start = self.get_clock().now()
+        executions.append(list(self.current_arguments))
+        return super().on_activate(state)
+
+    def do_work(self):
+        self.progress += 1
+        if self.progress < self.steps:
+            self.send_feedback(self.progress / self.steps, 'move running')
+        else:
+            self.finish(True, 1.0, 'move completed')
@@ -0,0 +1,143 @@
+// Copyright 2023 Intelligent Robotics Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <pybind11/embed.h>
+#include <pybind11/stl.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+
+#include "plansys2_executor/ActionExecutor.hpp"
+#include "plansys2_support_py/PythonActionExecutorClient.hpp"
+
+#include "lifecycle_msgs/msg/state.hpp"
+#include "lifecycle_msgs/msg/transition.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+
+#include "gtest/gtest.h"
+
+namespace py = pybind11;
+using namespace std::chrono_literals;
+
+TEST(performer_host, action_execution)
+{
+  auto test_node = rclcpp::Node::make_shared("test_node");
+  auto test_lf_node = rclcpp_lifecycle::LifecycleNode::make_shared("test_lf_node");
+
+  // test/move_performer.py
+  auto move_action_node = plansys2::create_python_performer("move_performer", "MovePerformer");
+  ASSERT_NE(move_action_node, nullptr);
+  ASSERT_STREQ(move_action_node->get_name(), "move_action");
+  ASSERT_EQ(move_action_node->get_parameter("steps").as_int(), 3);
+
+  auto move_performer = py::module_::import("move_performer");
+  auto errors = move_performer.attr("errors").cast<std::vector<std::string>>();
+  ASSERT_EQ(errors.size(), 1u);
+  ASSERT_NE(errors[0].find("create_timer"), std::string::npos);
+
+  auto move_action_executor = plansys2::ActionExecutor::make_shared(
+    "(move r2d2 steering_wheels_zone assembly_zone)", test_lf_node);
+
+  move_action_node->set_parameter({"action_name", "move"});
+
+  rclcpp::experimental::executors::EventsExecutor exe;
+
+  exe.add_node(test_node);
+  exe.add_node(test_lf_node->get_node_base_interface());
+  exe.add_node(move_action_node->get_node_base_interface());
+
+  std::vector<plansys2_msgs::msg::ActionExecution> action_execution_msgs;
+
+  auto action_hub_sub = test_node->create_subscription<plansys2_msgs::msg::ActionExecution>(
+    "/actions_hub", rclcpp::QoS(100).reliable(),
+    [&action_execution_msgs](const plansys2_msgs::msg::ActionExecution::SharedPtr msg) {
+      action_execution_msgs.push_back(*msg);
+    });
+
+  {
+    // The callbacks of the performer take the GIL from the spinning thread
+    py::gil_scoped_release release;
+
+    bool finish = false;
+    std::thread t([&]() {
+        while (!finish) {exe.spin_some();}
+      });
+
+    test_lf_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+    move_action_node->trigger_transition(lifecycle_msgs::msg::Transition::TRANSITION_CONFIGURE);
+
+    {
+      rclcpp::Rate rate(10);
+      auto start = test_node->now();
+      while ((test_node->now() - start).seconds() < 0.5) {
+        rate.sleep();
+      }
+    }
+
+    ASSERT_EQ(
+      move_action_node->get_current_state().id(),
+      lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+    {
+      rclcpp::Rate rate(10);
+      auto start = test_node->now();
+      while ((test_node->now() - start).seconds() < 5 &&
+        move_action_executor->get_internal_status() != plansys2::ActionExecutor::Status::SUCCESS)
+      {
+        move_action_executor->tick(test_node->now());
+        rate.sleep();
+      }
+    }
+
+    finish = true;
+    t.join();
+  }
+
+  ASSERT_EQ(
+    move_action_executor->get_internal_status(), plansys2::ActionExecutor::Status::SUCCESS);
+  ASSERT_EQ(
+    move_action_node->get_internal_status().state,
+    plansys2_msgs::msg::ActionPerformerStatus::READY);
+
+  ASSERT_GE(action_execution_msgs.size(), 6u);
+  ASSERT_EQ(action_execution_msgs[0].type, plansys2_msgs::msg::ActionExecution::REQUEST);
+  ASSERT_EQ(action_execution_msgs[1].type, plansys2_msgs::msg::ActionExecution::RESPONSE);
+  ASSERT_EQ(action_execution_msgs[2].type, plansys2_msgs::msg::ActionExecution::CONFIRM);
+  ASSERT_EQ(action_execution_msgs[3].type, plansys2_msgs::msg::ActionExecution::FEEDBACK);
+  ASSERT_EQ(action_execution_msgs[3].status, "move running");
+  ASSERT_EQ(action_execution_msgs.back().type, plansys2_msgs::msg::ActionExecution::FINISH);
+  ASSERT_EQ(action_execution_msgs.back().status, "move completed");
+  ASSERT_TRUE(action_execution_msgs.back().success);
+
+  auto executions =
+    move_performer.attr("executions").cast<std::vector<std::vector<std::string>>>();
+  ASSERT_EQ(executions.size(), 1u);
+  ASSERT_EQ(executions[0].size(), 3u);
+  ASSERT_EQ(executions[0][0], "r2d2");
+  ASSERT_EQ(executions[0][2], "assembly_zone");
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  rclcpp::init(argc, argv);
+
+  py::scoped_interpreter interpreter;
+
+  return RUN_ALL_TESTS();
+}